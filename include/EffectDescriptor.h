@@ -0,0 +1,391 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "effects_enum.h"
+#include <array>
+#include <cstdint>
+
+// Marks the texts for lupdate, without pulling Qt into the non-UI code
+#ifndef QT_TRANSLATE_NOOP
+#define QT_TRANSLATE_NOOP(scope, x) x
+#endif
+
+namespace plug
+{
+    // Translation context of the names and knob labels
+    inline constexpr const char* effectTranslationContext{"EffectDescriptor"};
+
+    // DSP an effect runs on; effects of the same family exclude each other
+    enum class EffectFamily
+    {
+        none,
+        stompbox,
+        modulation,
+        delay,
+        reverb
+    };
+
+    struct KnobDescriptor
+    {
+        const char* label;     // with mnemonic, nullptr if the knob is unused
+        const char* parameter; // name used in the accessibility texts
+        std::uint8_t defaultValue;
+        std::uint8_t maximum;
+
+        constexpr bool isUsed() const
+        {
+            return label != nullptr;
+        }
+    };
+
+    struct EffectDescriptor
+    {
+        effects id;
+        const char* name;
+        EffectFamily family;
+        std::array<KnobDescriptor, 6> knobs;
+
+        constexpr std::size_t knobCount() const
+        {
+            std::size_t count{0};
+
+            while ((count < knobs.size()) && knobs[count].isUsed())
+            {
+                ++count;
+            }
+            return count;
+        }
+    };
+
+
+    namespace detail
+    {
+        constexpr KnobDescriptor knob(const char* label, const char* parameter, std::uint8_t defaultValue, std::uint8_t maximum = 0xff)
+        {
+            return {label, parameter, defaultValue, maximum};
+        }
+
+        // Some effects set a default for knobs they don't use
+        constexpr KnobDescriptor unused(std::uint8_t defaultValue = 0x00)
+        {
+            return {nullptr, nullptr, defaultValue, 0xff};
+        }
+    }
+
+
+    // Knob layout of each effect model, indexed by the effects value
+    inline constexpr std::array<EffectDescriptor, 38> effectDescriptors = [] {
+        using detail::knob;
+        using detail::unused;
+
+        return std::array<EffectDescriptor, 38>{{
+            {effects::EMPTY, QT_TRANSLATE_NOOP("EffectDescriptor", "EMPTY"), EffectFamily::none,
+             {{unused(),
+               unused(),
+               unused(),
+               unused(),
+               unused(),
+               unused()}}},
+            {effects::OVERDRIVE, QT_TRANSLATE_NOOP("EffectDescriptor", "Overdrive"), EffectFamily::stompbox,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Gain"), "Gain", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "L&ow"), "Low tones", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Medium"), "Medium tones", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&High"), "High tones", 0x80),
+               unused()}}},
+            {effects::WAH, QT_TRANSLATE_NOOP("EffectDescriptor", "Wah"), EffectFamily::stompbox,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Mix"), "Mix", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Frequency"), "Frequency", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Heel Freq"), "Heel Frequency", 0x00),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Toe Freq"), "Toe Frequency", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "High &Q"), "High Q", 0x00),
+               unused()}}},
+            {effects::TOUCH_WAH, QT_TRANSLATE_NOOP("EffectDescriptor", "Touch Wah"), EffectFamily::stompbox,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Mix"), "Mix", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Sensivity"), "Sensivity", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Heel Freq"), "Heel Frequency", 0x00),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Toe Freq"), "Toe Frequency", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "High &Q"), "High Q", 0x00),
+               unused()}}},
+            {effects::FUZZ, QT_TRANSLATE_NOOP("EffectDescriptor", "Fuzz"), EffectFamily::stompbox,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Gain"), "Gain", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Octave"), "Octave", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "L&ow"), "Low tones", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&High"), "High tones", 0x80),
+               unused()}}},
+            {effects::FUZZ_TOUCH_WAH, QT_TRANSLATE_NOOP("EffectDescriptor", "Fuzz Touch Wah"), EffectFamily::stompbox,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Gain"), "Gain", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Sensivity"), "Sensivity", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Octave"), "Octave", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Peak"), "Peak", 0x80),
+               unused(0x80)}}},
+            {effects::SIMPLE_COMP, QT_TRANSLATE_NOOP("EffectDescriptor", "Simple Compressor"), EffectFamily::stompbox,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Type"), "Type", 0x01, 3),
+               unused(),
+               unused(),
+               unused(),
+               unused(),
+               unused()}}},
+            {effects::COMPRESSOR, QT_TRANSLATE_NOOP("EffectDescriptor", "Compressor"), EffectFamily::stompbox,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x8d),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Threshold"), "Threshold", 0x0f),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Ratio"), "Ratio", 0x4f),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Atta&ck"), "Attack", 0x7f),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Release"), "Release", 0x7f),
+               unused()}}},
+            {effects::SINE_CHORUS, QT_TRANSLATE_NOOP("EffectDescriptor", "Sine Chorus"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rate"), "Rate", 0x0e),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Depth"), "Depth", 0x19),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "A&vr Delay"), "Average Delay", 0x19),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "LR &Phase"), "LR Phase", 0x80),
+               unused()}}},
+            {effects::TRIANGLE_CHORUS, QT_TRANSLATE_NOOP("EffectDescriptor", "Triangle Chorus"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x5d),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rate"), "Rate", 0x0e),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Depth"), "Depth", 0x19),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "A&vr Delay"), "Average Delay", 0x19),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "LR &Phase"), "LR Phase", 0x80),
+               unused()}}},
+            {effects::SINE_FLANGER, QT_TRANSLATE_NOOP("EffectDescriptor", "Sine Flanger"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rate"), "Rate", 0x0e),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Depth"), "Depth", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "LR &Phase"), "LR Phase", 0x80),
+               unused()}}},
+            {effects::TRIANGLE_FLANGER, QT_TRANSLATE_NOOP("EffectDescriptor", "Triangle Flanger"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rate"), "Rate", 0x00),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Depth"), "Depth", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x33),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "LR &Phase"), "LR Phase", 0x41),
+               unused()}}},
+            {effects::VIBRATONE, QT_TRANSLATE_NOOP("EffectDescriptor", "Vibratone"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xf4),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rotor"), "Rotor", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Depth"), "Depth", 0x27),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0xad),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "LR &Phase"), "LR Phase", 0x82),
+               unused()}}},
+            {effects::VINTAGE_TREMOLO, QT_TRANSLATE_NOOP("EffectDescriptor", "Vintage Tremolo"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xdb),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rate"), "Rate", 0xad),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Duty Cycle"), "Duty Cycle", 0x63),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Atta&ck"), "Attack", 0xf4),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Relea&se"), "Release", 0xf1),
+               unused()}}},
+            {effects::SINE_TREMOLO, QT_TRANSLATE_NOOP("EffectDescriptor", "Sine Tremolo"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xdb),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rate"), "Rate", 0x99),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Duty Cycle"), "Duty Cycle", 0x7d),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "LFO &Clipping"), "LFO Clipping", 0x00),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Shape"), "Shape", 0x00),
+               unused()}}},
+            {effects::RING_MODULATOR, QT_TRANSLATE_NOOP("EffectDescriptor", "Ring Modulator"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Frequency"), "Frequency", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Depth"), "Depth", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Shape"), "Shape", 0x01, 1),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Phase"), "Phase", 0x80),
+               unused()}}},
+            {effects::STEP_FILTER, QT_TRANSLATE_NOOP("EffectDescriptor", "Step Filter"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rate"), "Rate", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Re&sonance"), "Resonance", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Mi&n Freq"), "Minimum Frequency", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Ma&x Freq"), "Maximum Frequency", 0x80),
+               unused()}}},
+            {effects::PHASER, QT_TRANSLATE_NOOP("EffectDescriptor", "Phaser"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xfd),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Rate"), "Rate", 0x00),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Depth"), "Depth", 0xfd),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0xb8),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Shape"), "Shape", 0x00, 1),
+               unused()}}},
+            {effects::PITCH_SHIFTER, QT_TRANSLATE_NOOP("EffectDescriptor", "Pitch Shifter"), EffectFamily::modulation,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xc7),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Pitch"), "Pitch", 0x3e),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Detune"), "Detune", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x00),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "P&redelay"), "Predelay", 0x00),
+               unused()}}},
+            {effects::MONO_DELAY, QT_TRANSLATE_NOOP("EffectDescriptor", "Mono Delay"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Brightness"), "Brightness", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "A&ttenuation"), "Attenuation", 0x80),
+               unused()}}},
+            {effects::MONO_ECHO_FILTER, QT_TRANSLATE_NOOP("EffectDescriptor", "Mono Echo Filter"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Fre&quency"), "Frequency", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Ressonance"), "Resonance", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&In Level"), "In Level", 0x80)}}},
+            {effects::STEREO_ECHO_FILTER, QT_TRANSLATE_NOOP("EffectDescriptor", "Stereo Echo Filter"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0xb3),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Fre&quency"), "Frequency", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Ressonance"), "Resonance", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&In Level"), "In Level", 0x80)}}},
+            {effects::MULTITAP_DELAY, QT_TRANSLATE_NOOP("EffectDescriptor", "Multitap Delay"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x66),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Brightness"), "Brightness", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Mode"), "Mode", 0x03, 3),
+               unused()}}},
+            {effects::PING_PONG_DELAY, QT_TRANSLATE_NOOP("EffectDescriptor", "Ping-Pong Delay"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Brightness"), "Brightness", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Stereo"), "Stereo", 0x80),
+               unused()}}},
+            {effects::DUCKING_DELAY, QT_TRANSLATE_NOOP("EffectDescriptor", "Ducking Delay"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Release"), "Release", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Threshold"), "Threshold", 0x80),
+               unused()}}},
+            {effects::REVERSE_DELAY, QT_TRANSLATE_NOOP("EffectDescriptor", "Reverse Delay"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&RFDBK"), "RFDBK", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x80),
+               unused()}}},
+            {effects::TAPE_DELAY, QT_TRANSLATE_NOOP("EffectDescriptor", "Tape Delay"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x7d),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0x1c),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x00),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Fl&utter"), "Flutter", 0x63),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Brightness"), "Brightness", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Stereo"), "Stereo", 0x00)}}},
+            {effects::STEREO_TAPE_DELAY, QT_TRANSLATE_NOOP("EffectDescriptor", "Stereo Tape Delay"), EffectFamily::delay,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x7d),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Delay"), "Delay", 0x88),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Feedback"), "Feedback", 0x1c),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "Fl&utter"), "Flutter", 0x63),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Separation"), "Separation", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Brightness"), "Brightness", 0x80)}}},
+            {effects::SMALL_HALL_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Small Hall Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x6e),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x5d),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x6e),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x91),
+               unused()}}},
+            {effects::LARGE_HALL_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Large Hall Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x4f),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x3e),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x05),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0xb0),
+               unused()}}},
+            {effects::SMALL_ROOM_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Small Room Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x80),
+               unused()}}},
+            {effects::LARGE_ROOM_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Large Room Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x80),
+               unused()}}},
+            {effects::SMALL_PLATE_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Small Plate Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x80),
+               unused()}}},
+            {effects::LARGE_PLATE_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Large Plate Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x38),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x91),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0xb6),
+               unused()}}},
+            {effects::AMBIENT_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Ambient Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x80),
+               unused()}}},
+            {effects::ARENA_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Arena Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x80),
+               unused()}}},
+            {effects::FENDER_63_SPRING_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Fender '63 Spring Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x80),
+               unused()}}},
+            {effects::FENDER_65_SPRING_REVERB, QT_TRANSLATE_NOOP("EffectDescriptor", "Fender '65 Spring Reverb"), EffectFamily::reverb,
+             {{knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Level"), "Level", 0x80),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Decay"), "Decay", 0x8b),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&well"), "Dwell", 0x49),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "D&iffusion"), "Diffusion", 0xff),
+               knob(QT_TRANSLATE_NOOP("EffectDescriptor", "&Tone"), "Tone", 0x80),
+               unused()}}}
+        }};
+    }();
+
+    constexpr const EffectDescriptor& describe(effects e)
+    {
+        return effectDescriptors[value(e)];
+    }
+
+    namespace detail
+    {
+        constexpr bool isIndexedByEffect()
+        {
+            for (std::size_t i = 0; i < effectDescriptors.size(); ++i)
+            {
+                if (value(effectDescriptors[i].id) != i)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static_assert(isIndexedByEffect(), "Effect descriptors have to be in order of the effects enum");
+    }
+}
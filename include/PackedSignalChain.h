@@ -0,0 +1,304 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace plug
+{
+    // Fixed layout representation of a SignalChain.
+    //
+    // All fields are single bytes, unused bytes are always zero, so two
+    // chains can be compared and hashed as plain memory. Effects are stored
+    // ordered by slot, so chains listing the same effects in a different
+    // order are packed the same. The name is limited to 32 bytes, the same
+    // as on the amp.
+
+    struct PackedAmp
+    {
+        std::uint8_t amp_num;
+        std::uint8_t gain;
+        std::uint8_t volume;
+        std::uint8_t treble;
+        std::uint8_t middle;
+        std::uint8_t bass;
+        std::uint8_t cabinet;
+        std::uint8_t noise_gate;
+        std::uint8_t master_vol;
+        std::uint8_t gain2;
+        std::uint8_t presence;
+        std::uint8_t threshold;
+        std::uint8_t depth;
+        std::uint8_t bias;
+        std::uint8_t sag;
+        std::uint8_t brightness;
+        std::uint8_t usb_gain;
+    };
+
+    struct PackedEffect
+    {
+        std::uint8_t fx_slot;
+        std::uint8_t effect_num;
+        std::uint8_t knob1;
+        std::uint8_t knob2;
+        std::uint8_t knob3;
+        std::uint8_t knob4;
+        std::uint8_t knob5;
+        std::uint8_t knob6;
+        std::uint8_t position;
+        std::uint8_t enabled;
+    };
+
+    struct alignas(64) PackedSignalChain
+    {
+        static constexpr std::size_t nameSize{32};
+
+        std::array<char, nameSize> name;
+        PackedAmp amp;
+        std::array<PackedEffect, 4> effects;
+        std::array<std::uint8_t, 39> reserved;
+    };
+
+    static_assert(std::is_trivially_copyable_v<PackedSignalChain>);
+    static_assert(sizeof(PackedAmp) == 17);
+    static_assert(sizeof(PackedEffect) == 10);
+    static_assert(sizeof(PackedSignalChain) == 128);
+
+
+    // Bits of the diff mask: bit 0 is the name, followed by one bit per
+    // byte of the amp and effect settings.
+    namespace diff
+    {
+        inline constexpr std::uint64_t name{1};
+        inline constexpr std::size_t ampBit{1};
+        inline constexpr std::size_t effectsBit{ampBit + sizeof(PackedAmp)};
+        inline constexpr std::uint64_t amp{((std::uint64_t{1} << sizeof(PackedAmp)) - 1) << ampBit};
+
+        constexpr std::uint64_t effect(std::size_t index)
+        {
+            return ((std::uint64_t{1} << sizeof(PackedEffect)) - 1) << (effectsBit + index * sizeof(PackedEffect));
+        }
+
+        constexpr std::uint64_t ampField(std::size_t offset)
+        {
+            return std::uint64_t{1} << (ampBit + offset);
+        }
+
+        constexpr std::uint64_t effectField(std::size_t index, std::size_t offset)
+        {
+            return std::uint64_t{1} << (effectsBit + index * sizeof(PackedEffect) + offset);
+        }
+    }
+
+
+    namespace detail
+    {
+        inline constexpr std::size_t packedSettingsOffset{PackedSignalChain::nameSize};
+        inline constexpr std::size_t packedBlocks{sizeof(PackedSignalChain) / 16};
+
+        inline const std::uint8_t* bytesOf(const PackedSignalChain& p)
+        {
+            return reinterpret_cast<const std::uint8_t*>(&p);
+        }
+
+#if defined(__SSE2__)
+        inline __m128i loadBlock(const PackedSignalChain& p, std::size_t block)
+        {
+            return _mm_load_si128(reinterpret_cast<const __m128i*>(bytesOf(p) + block * 16));
+        }
+
+        // One bit per byte of the block, set where a and b differ
+        inline std::uint64_t blockDiff(const PackedSignalChain& a, const PackedSignalChain& b, std::size_t block)
+        {
+            const auto equal = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(loadBlock(a, block), loadBlock(b, block))));
+            return static_cast<std::uint64_t>(~equal & 0xffff);
+        }
+
+        inline bool blocksEqual(const PackedSignalChain& a, const PackedSignalChain& b, std::size_t first)
+        {
+            __m128i acc = _mm_setzero_si128();
+
+            for (std::size_t i = first; i < packedBlocks; ++i)
+            {
+                acc = _mm_or_si128(acc, _mm_xor_si128(loadBlock(a, i), loadBlock(b, i)));
+            }
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) == 0xffff;
+        }
+
+        inline unsigned absoluteDifference(const PackedSignalChain& a, const PackedSignalChain& b, std::size_t first)
+        {
+            __m128i acc = _mm_setzero_si128();
+
+            for (std::size_t i = first; i < packedBlocks; ++i)
+            {
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(loadBlock(a, i), loadBlock(b, i)));
+            }
+            return static_cast<unsigned>(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+        }
+#else
+        inline std::uint64_t blockDiff(const PackedSignalChain& a, const PackedSignalChain& b, std::size_t block)
+        {
+            std::uint64_t mask{0};
+
+            for (std::size_t i = 0; i < 16; ++i)
+            {
+                mask |= static_cast<std::uint64_t>(bytesOf(a)[block * 16 + i] != bytesOf(b)[block * 16 + i]) << i;
+            }
+            return mask;
+        }
+
+        inline bool blocksEqual(const PackedSignalChain& a, const PackedSignalChain& b, std::size_t first)
+        {
+            return std::memcmp(bytesOf(a) + first * 16, bytesOf(b) + first * 16, (packedBlocks - first) * 16) == 0;
+        }
+
+        inline unsigned absoluteDifference(const PackedSignalChain& a, const PackedSignalChain& b, std::size_t first)
+        {
+            unsigned sum{0};
+
+            for (std::size_t i = first * 16; i < sizeof(PackedSignalChain); ++i)
+            {
+                sum += static_cast<unsigned>(std::abs(bytesOf(a)[i] - bytesOf(b)[i]));
+            }
+            return sum;
+        }
+#endif
+
+        // One bit per byte, set where a and b differ
+        inline std::array<std::uint64_t, 2> byteDiff(const PackedSignalChain& a, const PackedSignalChain& b)
+        {
+            return {{blockDiff(a, b, 0) | (blockDiff(a, b, 1) << 16) | (blockDiff(a, b, 2) << 32) | (blockDiff(a, b, 3) << 48),
+                     blockDiff(a, b, 4) | (blockDiff(a, b, 5) << 16) | (blockDiff(a, b, 6) << 32) | (blockDiff(a, b, 7) << 48)}};
+        }
+
+        inline std::uint64_t loadWord(const PackedSignalChain& p, std::size_t index)
+        {
+            std::uint64_t word{0};
+            std::memcpy(&word, bytesOf(p) + index * sizeof(word), sizeof(word));
+            return word;
+        }
+    }
+
+
+    inline PackedSignalChain pack(const SignalChain& chain)
+    {
+        PackedSignalChain p{};
+        const auto& name = chain.name();
+        std::copy_n(name.cbegin(), std::min(name.size(), p.name.size()), p.name.begin());
+
+        const auto& a = chain.amp();
+        p.amp = PackedAmp{value(a.amp_num), a.gain, a.volume, a.treble, a.middle, a.bass, value(a.cabinet), a.noise_gate, a.master_vol,
+                          a.gain2, a.presence, a.threshold, a.depth, a.bias, a.sag, static_cast<std::uint8_t>(a.brightness), a.usb_gain};
+
+        std::transform(chain.effects().cbegin(), chain.effects().cend(), p.effects.begin(), [](const fx_pedal_settings& e) {
+            return PackedEffect{e.fx_slot, value(e.effect_num), e.knob1, e.knob2, e.knob3, e.knob4, e.knob5, e.knob6,
+                                static_cast<std::uint8_t>(e.position), static_cast<std::uint8_t>(e.enabled)};
+        });
+        std::stable_sort(p.effects.begin(), p.effects.end(), [](const auto& x, const auto& y) { return x.fx_slot < y.fx_slot; });
+        return p;
+    }
+
+    inline SignalChain unpack(const PackedSignalChain& p)
+    {
+        const auto nameEnd = std::find(p.name.cbegin(), p.name.cend(), '\0');
+        const auto& a = p.amp;
+        const amp_settings amp{static_cast<amps>(a.amp_num), a.gain, a.volume, a.treble, a.middle, a.bass, static_cast<cabinets>(a.cabinet), a.noise_gate, a.master_vol,
+                               a.gain2, a.presence, a.threshold, a.depth, a.bias, a.sag, (a.brightness != 0), a.usb_gain};
+        std::array<fx_pedal_settings, 4> effects{};
+
+        std::transform(p.effects.cbegin(), p.effects.cend(), effects.begin(), [](const PackedEffect& e) {
+            return fx_pedal_settings{e.fx_slot, static_cast<plug::effects>(e.effect_num), e.knob1, e.knob2, e.knob3, e.knob4, e.knob5, e.knob6,
+                                     static_cast<Position>(e.position), (e.enabled != 0)};
+        });
+        return SignalChain{std::string{p.name.cbegin(), nameEnd}, amp, effects};
+    }
+
+
+    inline bool operator==(const PackedSignalChain& a, const PackedSignalChain& b)
+    {
+        return detail::blocksEqual(a, b, 0);
+    }
+
+    inline bool operator!=(const PackedSignalChain& a, const PackedSignalChain& b)
+    {
+        return (a == b) == false;
+    }
+
+    // Equality of all settings, ignoring the name
+    inline bool settingsEqual(const PackedSignalChain& a, const PackedSignalChain& b)
+    {
+        return detail::blocksEqual(a, b, detail::packedSettingsOffset / 16);
+    }
+
+    // Sum of the absolute differences of all setting bytes, ignoring the
+    // name. Model numbers count like any other value, so this is only a
+    // meaningful distance between presets using the same models.
+    inline unsigned settingsDistance(const PackedSignalChain& a, const PackedSignalChain& b)
+    {
+        return detail::absoluteDifference(a, b, detail::packedSettingsOffset / 16);
+    }
+
+    // Fields that differ between a and b, see plug::diff for the bits
+    inline std::uint64_t diffMask(const PackedSignalChain& a, const PackedSignalChain& b)
+    {
+        const auto mask = detail::byteDiff(a, b);
+        const std::uint64_t nameBits = mask[0] & ((std::uint64_t{1} << PackedSignalChain::nameSize) - 1);
+        const std::uint64_t settings = (mask[0] >> detail::packedSettingsOffset) | (mask[1] << (64 - detail::packedSettingsOffset));
+        const std::uint64_t used = (std::uint64_t{1} << (sizeof(PackedAmp) + sizeof(PackedSignalChain::effects))) - 1;
+
+        return (nameBits != 0 ? diff::name : 0) | ((settings & used) << diff::ampBit);
+    }
+
+    // Hash of all settings, ignoring the name
+    inline std::uint64_t contentHash(const PackedSignalChain& p)
+    {
+        constexpr std::uint64_t multiplier{0x9e3779b97f4a7c15};
+        constexpr std::size_t firstWord{detail::packedSettingsOffset / sizeof(std::uint64_t)};
+        constexpr std::size_t words{sizeof(PackedSignalChain) / sizeof(std::uint64_t)};
+        std::uint64_t even{0xcbf29ce484222325};
+        std::uint64_t odd{0x84222325cbf29ce4};
+
+        // Two independent lanes to shorten the dependency chain
+        for (std::size_t i = firstWord; i < words; i += 2)
+        {
+            even = (even ^ detail::loadWord(p, i)) * multiplier;
+            odd = (odd ^ detail::loadWord(p, i + 1)) * multiplier;
+        }
+        const std::uint64_t hash = (even ^ (odd >> 29) ^ (odd << 35)) * multiplier;
+        return hash ^ (hash >> 32);
+    }
+
+    inline std::uint64_t contentHash(const SignalChain& chain)
+    {
+        return contentHash(pack(chain));
+    }
+}
@@ -42,7 +42,7 @@ namespace plug
         }
 
 
-        std::string name() const
+        const std::string& name() const
         {
             return name_;
         }
@@ -52,7 +52,7 @@ namespace plug
             name_ = name;
         }
 
-        amp_settings amp() const
+        const amp_settings& amp() const
         {
             return amp_;
         }
@@ -62,7 +62,7 @@ namespace plug
             amp_ = amp;
         }
 
-        std::array<fx_pedal_settings, 4> effects() const
+        const std::array<fx_pedal_settings, 4>& effects() const
         {
             return effects_;
         }
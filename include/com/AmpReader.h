@@ -0,0 +1,126 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "data_structs.h"
+#include "com/Connection.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace plug::com
+{
+    struct UsbGainChange
+    {
+        std::uint8_t value;
+    };
+
+    struct NameChange
+    {
+        std::string name;
+    };
+
+    // Settings changed on the amp itself. The usb gain is sent as a packet
+    // of its own, the usb_gain of a changed amp_settings is not valid.
+    using StateChange = std::variant<amp_settings, UsbGainChange, fx_pedal_settings, NameChange>;
+
+    std::optional<StateChange> decodeStateChange(const std::vector<std::uint8_t>& packet);
+
+
+    // Connection that keeps a receive pending on the amp at all times.
+    //
+    // Incoming packets are classified by their header: responses to sent
+    // commands are queued for receive(), settings changed on the amp are
+    // decoded and passed to the subscribers. A packet counts as response
+    // only while one is expected, that is within the response timeout
+    // after a send or while receive() waits; stale responses are dropped
+    // on the next send. Subscribers are called on the reader thread.
+    //
+    // Until started, all calls are passed through to the connection.
+    class AmpReader : public Connection
+    {
+    public:
+        using Subscriber = std::function<void(const StateChange&)>;
+        using ErrorHandler = std::function<void(const std::exception&)>;
+
+        AmpReader(std::shared_ptr<Connection> connection, std::chrono::milliseconds responseTimeout);
+        AmpReader(const AmpReader&) = delete;
+        ~AmpReader() override;
+
+        void start();
+        void stop();
+        bool isRunning() const;
+
+        void close() override;
+        bool isOpen() const override;
+
+        std::vector<std::uint8_t> receive(std::size_t recvSize) override;
+
+        std::size_t subscribe(Subscriber subscriber);
+        void unsubscribe(std::size_t id);
+        void setErrorHandler(ErrorHandler handler);
+
+        std::size_t discarded() const;
+
+        AmpReader& operator=(const AmpReader&) = delete;
+
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Response
+        {
+            Clock::time_point received;
+            std::vector<std::uint8_t> data;
+        };
+
+        std::size_t sendImpl(std::uint8_t* data, std::size_t size) override;
+
+        void readLoop();
+        void route(std::vector<std::uint8_t> packet);
+        void publish(const StateChange& change);
+
+        const std::shared_ptr<Connection> connection_;
+        const std::chrono::milliseconds responseTimeout_;
+        mutable std::mutex mutex_;
+        std::condition_variable responseReady_;
+        std::deque<Response> responses_;
+        Clock::time_point expectedUntil_;
+        std::size_t waiting_;
+        std::size_t discarded_;
+        std::mutex subscriberMutex_;
+        std::vector<std::pair<std::size_t, Subscriber>> subscribers_;
+        std::size_t nextId_;
+        ErrorHandler errorHandler_;
+        std::atomic<bool> running_;
+        std::atomic<bool> reading_;
+        std::thread reader_;
+    };
+}
@@ -0,0 +1,132 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "com/CommandQueue.h"
+#include "com/ControlState.h"
+#include "com/ControlWriter.h"
+#include "SignalChain.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+namespace plug::com
+{
+    // Converts musical time into timeline offsets; bar 1, beat 1 is at zero.
+    struct Tempo
+    {
+        double beatsPerMinute;
+        unsigned beatsPerBar;
+
+        std::chrono::nanoseconds at(unsigned bar, double beat = 1.0) const;
+    };
+
+    // Parameter change at a timeline offset. With a ramp the value moves
+    // linearly from 'from' to change.value over the ramp duration.
+    struct AutomationEvent
+    {
+        std::chrono::nanoseconds at;
+        ControlEvent change;
+        std::chrono::nanoseconds ramp;
+        std::uint8_t from;
+    };
+
+    AutomationEvent setAt(std::chrono::nanoseconds at, ControlEvent change);
+    AutomationEvent rampAt(std::chrono::nanoseconds at, ControlEvent change, std::uint8_t from, std::chrono::nanoseconds duration);
+
+    // Event index (timeline order as passed to start()) and the delay between
+    // its scheduled time and the start of the amp write that carried it.
+    struct DispatchRecord
+    {
+        std::size_t event;
+        std::chrono::nanoseconds jitter;
+    };
+
+
+    // Plays a timeline of amp and effect changes on its own timer thread.
+    //
+    // The thread sleeps until shortly before an event is due and spins for
+    // the rest, then folds all due changes and the current ramp values into
+    // the settings and hands the changed blocks to a ControlWriter. The amp
+    // gets the changes as fast as it acknowledges them, never a backlog.
+    // Ramps are sampled every rampInterval. Preset loads can't be scheduled.
+    class AutomationScheduler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        AutomationScheduler(CommandQueue& queue, const SignalChain& current, std::chrono::nanoseconds rampInterval = std::chrono::milliseconds{10});
+        AutomationScheduler(const AutomationScheduler&) = delete;
+        ~AutomationScheduler();
+
+        void start(std::vector<AutomationEvent> timeline, Clock::time_point origin = Clock::now());
+        void stop();
+        bool isRunning() const;
+
+        // Blocks until all events were handed to the queue or stop() was called
+        void wait();
+
+        // Takes over changes made elsewhere (UI, OSC, preset loads), so they
+        // aren't reverted; only parameters with a running ramp keep following it
+        void update(const SignalChain& chain);
+
+        std::vector<DispatchRecord> dispatched() const;
+
+        AutomationScheduler& operator=(const AutomationScheduler&) = delete;
+
+
+    private:
+        struct Scheduled
+        {
+            std::size_t index;
+            AutomationEvent event;
+        };
+
+        struct Ramp
+        {
+            Clock::time_point begin;
+            Clock::time_point end;
+            ControlEvent change;
+            std::uint8_t from;
+            int last;
+        };
+
+        struct Dispatch;
+
+        void run(std::vector<Scheduled> timeline, Clock::time_point origin);
+        bool sleepUntil(Clock::time_point due);
+        static void updateRamps(std::vector<Ramp>& ramps, ControlState& state, Clock::time_point now);
+
+        std::chrono::nanoseconds rampInterval_;
+        std::shared_ptr<Dispatch> dispatch_;
+        ControlWriter writer_;
+        std::atomic<bool> running_;
+        std::mutex wakeMutex_;
+        std::condition_variable wakeUp_;
+        std::thread timer_;
+    };
+}
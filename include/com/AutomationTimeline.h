@@ -0,0 +1,39 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "com/AutomationScheduler.h"
+#include <string_view>
+#include <vector>
+
+namespace plug::com
+{
+    // Reads an automation timeline, one change per line. Parameters are
+    // addressed like OSC messages (see OscMessage.h), values are raw (0 - 255).
+    //
+    //   # comment
+    //   tempo <beats per minute> <beats per bar>     before the first change, default: 120 4
+    //   <bar>[:<beat>] <address> <value>             e.g. 33 /fx/2/knob1 200
+    //   <bar>[:<beat>] <address> <from>..<to> <n>s   e.g. 17:3 /amp/gain 120..180 2s
+    //
+    // Throws std::runtime_error naming the line of the first error.
+    std::vector<AutomationEvent> parseTimeline(std::string_view text);
+}
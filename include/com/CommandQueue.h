@@ -0,0 +1,138 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <cstdint>
+
+namespace plug::com
+{
+    class Mustang;
+
+    enum class CommandPriority : std::uint8_t
+    {
+        preset,
+        setting
+    };
+
+    // Pending commands with the same key are superseded by newer ones
+    using CommandKey = std::uint16_t;
+
+    inline constexpr CommandKey unkeyed{0};
+    inline constexpr CommandKey ampKey{1};
+
+    constexpr CommandKey effectKey(std::uint8_t slot)
+    {
+        return static_cast<CommandKey>(2 + (slot % 4));
+    }
+
+    // Full preset sends, only the latest pending one is worth sending
+    inline constexpr CommandKey presetKey{6};
+
+
+    // Outbound amp commands, sent by a single thread that owns the amp.
+    //
+    // Producers hand commands over through a lock-free stack, the consumer
+    // thread sorts them into its private queues: preset commands go ahead
+    // of settings, a newer keyed command replaces a pending one with the
+    // same key and a preset command drops all keyed settings queued before
+    // it. Unkeyed commands are never dropped. The Mustang instance must not
+    // be used by anyone else while the queue is running.
+    class CommandQueue
+    {
+    public:
+        using Command = std::function<void(Mustang&)>;
+        using ErrorHandler = std::function<void(const std::exception&)>;
+
+        explicit CommandQueue(Mustang& mustang);
+        CommandQueue(const CommandQueue&) = delete;
+        ~CommandQueue();
+
+        void start();
+        void stop();
+        bool isRunning() const;
+
+        void post(CommandPriority priority, CommandKey key, Command command);
+
+        template <class Function>
+        std::future<std::invoke_result_t<Function, Mustang&>> submit(CommandPriority priority, Function function)
+        {
+            using Result = std::invoke_result_t<Function, Mustang&>;
+            auto task = std::make_shared<std::packaged_task<Result(Mustang&)>>(std::move(function));
+            auto result = task->get_future();
+            post(priority, unkeyed, [task](Mustang& mustang) { (*task)(mustang); });
+            return result;
+        }
+
+        void setErrorHandler(ErrorHandler handler);
+        std::size_t superseded() const;
+
+        CommandQueue& operator=(const CommandQueue&) = delete;
+
+
+    private:
+        struct Node
+        {
+            CommandPriority priority;
+            CommandKey key;
+            Command command;
+            Node* next;
+        };
+
+        struct Pending
+        {
+            CommandKey key;
+            Command command;
+        };
+
+        using PendingList = std::list<Pending>;
+        static constexpr std::size_t priorities{2};
+
+        void run();
+        void collect();
+        void merge(Node& node);
+        bool hasPending() const;
+        void execute(Command& command);
+        void discard();
+
+        Mustang& mustang_;
+        std::atomic<Node*> incoming_;
+        std::array<PendingList, priorities> pending_;
+        std::array<std::unordered_map<CommandKey, PendingList::iterator>, priorities> keyed_;
+        std::atomic<std::size_t> superseded_;
+        ErrorHandler errorHandler_;
+        std::atomic<bool> running_;
+        std::atomic<bool> sleeping_;
+        std::mutex wakeMutex_;
+        std::condition_variable wakeUp_;
+        std::thread consumer_;
+    };
+}
@@ -0,0 +1,112 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include "data_structs.h"
+#include <array>
+#include <optional>
+#include <cstdint>
+
+namespace plug::com
+{
+    enum class ControlTarget : std::uint8_t
+    {
+        amp,
+        effect,
+        preset
+    };
+
+    enum class AmpParameter : std::uint8_t
+    {
+        model,
+        gain,
+        volume,
+        treble,
+        middle,
+        bass,
+        cabinet,
+        noiseGate,
+        masterVolume,
+        gain2,
+        presence,
+        threshold,
+        depth,
+        bias,
+        sag,
+        brightness,
+        usbGain
+    };
+
+    enum class EffectParameter : std::uint8_t
+    {
+        model,
+        knob1,
+        knob2,
+        knob3,
+        knob4,
+        knob5,
+        knob6,
+        position,
+        enabled
+    };
+
+    // A single parameter change; slot is the effect slot (0 - 3) for
+    // effect targets and the memory bank for preset targets.
+    struct ControlEvent
+    {
+        ControlTarget target;
+        std::uint8_t slot;
+        std::uint8_t parameter;
+        std::uint8_t value;
+    };
+
+
+    // Folds parameter changes into the current signal chain and keeps track
+    // of the blocks that have to be sent to the amp.
+    class ControlState
+    {
+    public:
+        explicit ControlState(const SignalChain& chain);
+
+        void apply(const ControlEvent& event);
+        void reset(const SignalChain& chain);
+
+        const amp_settings& amp() const;
+        const fx_pedal_settings& effect(std::size_t slot) const;
+
+        bool hasChanges() const;
+        bool ampChanged() const;
+        bool effectChanged(std::size_t slot) const;
+        std::optional<fx_pedal_settings> replacedEffect(std::size_t slot) const;
+        void clearChanges();
+
+    private:
+        void applyAmp(AmpParameter parameter, std::uint8_t value);
+        void applyEffect(std::size_t slot, EffectParameter parameter, std::uint8_t value);
+
+        amp_settings amp_;
+        std::array<fx_pedal_settings, 4> effects_;
+        bool ampChanged_;
+        std::array<bool, 4> effectChanged_;
+        std::array<std::optional<fx_pedal_settings>, 4> replaced_;
+    };
+}
@@ -0,0 +1,65 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "com/CommandQueue.h"
+#include "com/ControlState.h"
+#include "SignalChain.h"
+#include <functional>
+#include <memory>
+
+namespace plug::com
+{
+    // Sends the blocks changed in the current settings as keyed writes.
+    //
+    // A write still pending in the command queue is replaced by the newer
+    // one, writes carry the latest values when they run, not when they were
+    // posted. An effect replaced by one of another family runs on a different
+    // DSP, it's cleared by the next write of its slot.
+    class ControlWriter
+    {
+    public:
+        // updated is true if update() replaced the settings since the last write
+        using Changes = std::function<void(ControlState& state, bool updated)>;
+        // Called by the command queue thread as the write of the key starts
+        using DeliveryHandler = std::function<void(CommandKey key)>;
+
+        ControlWriter(CommandQueue& queue, const SignalChain& current, DeliveryHandler onDelivery = {});
+        ControlWriter(const ControlWriter&) = delete;
+
+        // Applies the changes to the current settings and posts the changed blocks
+        void write(const Changes& changes);
+
+        // Takes over changes made elsewhere (UI, amp, preset loads), so they
+        // aren't reverted by the next write
+        void update(const SignalChain& chain);
+
+        ControlWriter& operator=(const ControlWriter&) = delete;
+
+
+    private:
+        struct Outbox;
+
+        CommandQueue& queue_;
+        ControlState state_;
+        std::shared_ptr<Outbox> outbox_;
+    };
+}
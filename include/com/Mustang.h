@@ -23,6 +23,8 @@
 
 #include "SignalChain.h"
 #include "com/Connection.h"
+#include "com/Packet.h"
+#include <functional>
 #include <string_view>
 #include <vector>
 #include <memory>
@@ -32,6 +34,22 @@ namespace plug::com
 {
     using InitalData = std::tuple<SignalChain, std::vector<std::string>>;
 
+    // Raw packets of a preset as sent by the amp: name, amp, four effects
+    // (stompbox, modulation, delay, reverb) and usb gain.
+    using PresetData = std::array<PacketRawType, 7>;
+
+    SignalChain decode_data(const PresetData& data);
+    PresetData encode_data(const SignalChain& chain);
+
+    // Packets setting amp, four effects (by DSP family) and usb gain,
+    // ready to be sent as the current settings.
+    using SettingsData = std::array<PacketRawType, 6>;
+
+    SettingsData encode_settings(const SignalChain& chain);
+
+    // Called with the number of completed and total presets
+    using ProgressCallback = std::function<void(std::size_t, std::size_t)>;
+
     class Mustang
     {
     public:
@@ -44,6 +62,12 @@ namespace plug::com
         void set_amplifier(amp_settings value);
         void save_on_amp(std::string_view name, std::uint8_t slot);
         SignalChain load_memory_bank(std::uint8_t slot);
+        PresetData load_memory_bank_data(std::uint8_t slot);
+        void apply_preset_data(const PresetData& data);
+        void apply_settings(const std::vector<PacketRawType>& packets);
+        void apply_settings(const SettingsData& packets);
+        std::vector<PresetData> backup_presets(std::size_t count, const ProgressCallback& progress = {});
+        void restore_presets(const std::vector<PresetData>& presets, const ProgressCallback& progress = {});
         void save_effects(std::uint8_t slot, std::string_view name, const std::vector<fx_pedal_settings>& effects);
 
 
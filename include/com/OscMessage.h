@@ -0,0 +1,56 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "com/ControlState.h"
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace plug::com::osc
+{
+    using Argument = std::variant<std::int32_t, float, std::string, bool>;
+
+    struct Message
+    {
+        std::string address;
+        std::vector<Argument> arguments;
+    };
+
+
+    // Decodes an OSC packet; bundles are flattened into their messages.
+    // Malformed packets yield no messages.
+    std::vector<Message> parsePacket(const std::uint8_t* data, std::size_t size);
+    std::vector<std::uint8_t> serializeMessage(const Message& message);
+
+    // Address space:
+    //   /amp/<parameter> <value>      e.g. /amp/gain, /amp/noise_gate, /amp/model
+    //   /fx/<1-4>/<parameter> <value> e.g. /fx/2/knob3, /fx/1/model, /fx/4/enabled
+    //   /preset/load <slot>           e.g. /preset/load 17
+    //
+    // Integer values are taken as raw values (0 - 255), messages with
+    // integers out of range are dropped. Floats are normalized (0.0 - 1.0)
+    // and scaled to the full range.
+    std::optional<ControlEvent> toControlEvent(const Message& message);
+}
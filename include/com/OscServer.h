@@ -0,0 +1,85 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include "com/ControlState.h"
+#include "com/ControlWriter.h"
+#include "com/SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+namespace plug::com
+{
+    class CommandQueue;
+
+    // Receives OSC messages via UDP and applies them to the amp.
+    //
+    // The network thread only decodes and hands events over to the dispatch
+    // thread, which folds everything that queued up into the current settings
+    // and hands the changed blocks to a ControlWriter.
+    class OscServer
+    {
+    public:
+        using ErrorHandler = std::function<void(const std::exception&)>;
+
+        OscServer(CommandQueue& commands, const SignalChain& current, const std::string& address, std::uint16_t port);
+        OscServer(const OscServer&) = delete;
+        ~OscServer();
+
+        void start();
+        void stop();
+        bool isRunning() const;
+
+        std::uint16_t port() const;
+        void setErrorHandler(ErrorHandler handler);
+
+        // Takes over changes made elsewhere, so they aren't reverted
+        void update(const SignalChain& chain);
+
+        OscServer& operator=(const OscServer&) = delete;
+
+
+    private:
+        void receiveLoop();
+        void dispatchLoop();
+        void dispatch(std::vector<ControlEvent>& events);
+
+        static constexpr std::size_t queueSize{1024};
+
+        CommandQueue& commands_;
+        ControlWriter writer_;
+        int socket_;
+        std::uint16_t port_;
+        ErrorHandler errorHandler_;
+        SpscQueue<ControlEvent, queueSize> queue_;
+        std::atomic<bool> running_;
+        std::mutex wakeMutex_;
+        std::condition_variable wakeUp_;
+        std::thread receiver_;
+        std::thread dispatcher_;
+    };
+}
@@ -0,0 +1,71 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include "PackedSignalChain.h"
+#include "com/Mustang.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace plug::com
+{
+    // Settings packets of recently used signal chains.
+    //
+    // Entries are keyed by the content hash of the chain's settings (the
+    // name isn't part of the packets), a hit skips serialization entirely.
+    // The least recently used entry is evicted once the capacity is reached.
+    class PacketCache
+    {
+    public:
+        explicit PacketCache(std::size_t capacity);
+        PacketCache(const PacketCache&) = delete;
+
+        SettingsData get(const SignalChain& chain);
+        void clear();
+
+        std::size_t size() const;
+        std::size_t capacity() const;
+        std::size_t hits() const;
+        std::size_t misses() const;
+
+        PacketCache& operator=(const PacketCache&) = delete;
+
+
+    private:
+        struct Entry
+        {
+            std::uint64_t hash;
+            PackedSignalChain chain;
+            SettingsData packets;
+        };
+
+        using CacheList = std::list<Entry>;
+
+        std::size_t capacity_;
+        mutable std::mutex mutex_;
+        CacheList cache_;
+        std::unordered_map<std::uint64_t, CacheList::iterator> lookup_;
+        std::size_t hits_;
+        std::size_t misses_;
+    };
+}
@@ -0,0 +1,71 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include "com/Connection.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace plug::com
+{
+    // Connection answering like an amp, to run without hardware.
+    //
+    // The load command is answered with the preset names and the current
+    // preset, selecting a memory bank with the data of that preset; each
+    // other packet is acknowledged by a single response. A receive with
+    // nothing to answer returns an empty packet after the idle timeout,
+    // like a usb timeout.
+    class SimulatedAmp : public Connection
+    {
+    public:
+        // Takes 24 (Mustang I / II) or 100 presets, the first one is current
+        SimulatedAmp(std::vector<SignalChain> presets, std::chrono::milliseconds idleTimeout);
+        SimulatedAmp(const SimulatedAmp&) = delete;
+
+        void close() override;
+        bool isOpen() const override;
+
+        std::vector<std::uint8_t> receive(std::size_t recvSize) override;
+
+        SimulatedAmp& operator=(const SimulatedAmp&) = delete;
+
+
+    private:
+        std::size_t sendImpl(std::uint8_t* data, std::size_t size) override;
+
+        void respond(const std::vector<std::uint8_t>& packet);
+        void queuePreset(std::size_t slot);
+
+        const std::vector<SignalChain> presets_;
+        const std::chrono::milliseconds idleTimeout_;
+        mutable std::mutex mutex_;
+        std::condition_variable responseReady_;
+        std::deque<std::vector<std::uint8_t>> responses_;
+        std::size_t current_;
+        bool open_;
+    };
+
+    std::vector<SignalChain> simulatedPresets(std::size_t count);
+}
@@ -0,0 +1,77 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace plug::com
+{
+    // Bounded, wait-free single producer / single consumer ring buffer.
+    template <class T, std::size_t Capacity>
+    class SpscQueue
+    {
+    public:
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+        bool push(const T& value) noexcept
+        {
+            const auto tail = tail_.load(std::memory_order_relaxed);
+
+            if ((tail - head_.load(std::memory_order_acquire)) == Capacity)
+            {
+                return false;
+            }
+            buffer_[tail & mask] = value;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T& value) noexcept
+        {
+            const auto head = head_.load(std::memory_order_relaxed);
+
+            if (head == tail_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            value = buffer_[head & mask];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const noexcept
+        {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+
+
+    private:
+        static constexpr std::size_t mask{Capacity - 1};
+
+        alignas(64) std::atomic<std::size_t> head_{0};
+        alignas(64) std::atomic<std::size_t> tail_{0};
+        std::array<T, Capacity> buffer_{};
+    };
+}
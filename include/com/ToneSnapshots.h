@@ -0,0 +1,66 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include "com/Mustang.h"
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace plug::com
+{
+    // A/B/C/D snapshots for comparing tones.
+    //
+    // The settings packets of a snapshot are serialized once when it's
+    // stored. Recalling a snapshot sends only the DSP blocks that differ
+    // from the settings last sent, followed by a single apply.
+    class ToneSnapshots
+    {
+    public:
+        static inline constexpr std::size_t count{4};
+
+        void store(std::size_t index, const SignalChain& chain);
+        bool contains(std::size_t index) const;
+        const SignalChain& chain(std::size_t index) const;
+        std::optional<std::size_t> active() const;
+
+        std::vector<PacketRawType> delta(std::size_t index) const;
+        std::vector<PacketRawType> select(std::size_t index);
+        std::size_t recall(Mustang& amp, std::size_t index);
+
+        // Settings were changed by other means, the next recall sends all blocks
+        void invalidate();
+
+    private:
+        struct Snapshot
+        {
+            SignalChain chain;
+            SettingsData packets;
+        };
+
+        const Snapshot& get(std::size_t index) const;
+
+        std::array<std::optional<Snapshot>, count> snapshots_;
+        std::optional<SettingsData> current_;
+        std::optional<std::size_t> active_;
+    };
+}
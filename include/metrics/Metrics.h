@@ -0,0 +1,223 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+namespace plug::metrics
+{
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    namespace detail
+    {
+        inline constexpr std::size_t shardCount{8};
+
+        // Shard of the calling thread, assigned on first use
+        std::size_t shardIndex() noexcept;
+
+        struct alignas(64) CounterShard
+        {
+            std::atomic<std::uint64_t> value{0};
+        };
+    }
+
+
+    // Monotonic counter, each thread adds to its own cache line.
+    class Counter
+    {
+    public:
+        void add(std::uint64_t n = 1) noexcept
+        {
+            shards_[detail::shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        std::uint64_t value() const noexcept;
+
+    private:
+        std::array<detail::CounterShard, detail::shardCount> shards_{};
+    };
+
+
+    class Gauge
+    {
+    public:
+        void set(std::int64_t value) noexcept
+        {
+            value_.store(value, std::memory_order_relaxed);
+        }
+
+        void add(std::int64_t n) noexcept
+        {
+            value_.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        std::int64_t value() const noexcept
+        {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::int64_t> value_{0};
+    };
+
+
+    struct HistogramData
+    {
+        std::vector<double> bounds;
+        std::vector<std::uint64_t> counts; // Per bucket, the last one is +Inf
+        double sum;
+        std::uint64_t count;
+    };
+
+    // Histogram with fixed upper bucket bounds.
+    class Histogram
+    {
+    public:
+        static inline constexpr std::size_t maxBuckets{15};
+
+        explicit Histogram(std::vector<double> bounds);
+
+        void observe(double value) noexcept;
+
+        void observe(std::chrono::steady_clock::duration elapsed) noexcept
+        {
+            observe(std::chrono::duration<double>(elapsed).count());
+        }
+
+        HistogramData data() const;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<std::uint64_t>, maxBuckets + 1> counts{};
+            std::atomic<double> sum{0.0};
+        };
+
+        std::vector<double> bounds_;
+        std::array<Shard, detail::shardCount> shards_;
+    };
+
+    // Latency buckets from 100us to 2.5s
+    std::vector<double> latencyBuckets();
+
+
+    // Records the time until destruction, failures are counted if the
+    // scope is left by an exception.
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram& histogram, Counter* failures = nullptr) noexcept
+            : histogram_(histogram), failures_(failures), start_(std::chrono::steady_clock::now()), exceptions_(std::uncaught_exceptions())
+        {
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+
+        ~ScopedTimer()
+        {
+            histogram_.observe(std::chrono::steady_clock::now() - start_);
+
+            if ((failures_ != nullptr) && (std::uncaught_exceptions() > exceptions_))
+            {
+                failures_->add();
+            }
+        }
+
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Histogram& histogram_;
+        Counter* failures_;
+        std::chrono::steady_clock::time_point start_;
+        int exceptions_;
+    };
+
+
+    enum class Type
+    {
+        counter,
+        gauge,
+        histogram
+    };
+
+    struct Series
+    {
+        Labels labels;
+        double value;
+        HistogramData histogram;
+    };
+
+    struct Family
+    {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<Series> series;
+    };
+
+    // Named metrics with labels.
+    //
+    // Lookups take a lock, so they belong into setup code; the returned
+    // references stay valid for the lifetime of the registry and recording
+    // on them is lock-free.
+    class Registry
+    {
+    public:
+        static Registry& global();
+
+        Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+        Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+        Histogram& histogram(const std::string& name, const std::string& help, const Labels& labels = {}, const std::vector<double>& bounds = latencyBuckets());
+
+        std::vector<Family> collect() const;
+
+    private:
+        struct Metric
+        {
+            Labels labels;
+            std::unique_ptr<Counter> counter;
+            std::unique_ptr<Gauge> gauge;
+            std::unique_ptr<Histogram> histogram;
+        };
+
+        struct Entry
+        {
+            std::string help;
+            Type type;
+            std::vector<Metric> metrics;
+        };
+
+        Metric& find(const std::string& name, const std::string& help, Type type, const Labels& labels);
+
+        mutable std::mutex mutex_;
+        std::map<std::string, Entry> entries_;
+    };
+}
@@ -0,0 +1,66 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "metrics/Metrics.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+namespace plug::metrics
+{
+    // Prometheus text exposition format (version 0.0.4)
+    std::string formatPrometheus(const std::vector<Family>& families);
+
+    // Replaces the file atomically, e.g. for the node exporter's textfile collector
+    void writePrometheusFile(const Registry& registry, const std::string& path);
+
+
+    // Serves the metrics via HTTP on localhost.
+    class PrometheusServer
+    {
+    public:
+        PrometheusServer(const Registry& registry, std::uint16_t port);
+        PrometheusServer(const PrometheusServer&) = delete;
+        ~PrometheusServer();
+
+        void start();
+        void stop();
+        bool isRunning() const;
+
+        std::uint16_t port() const;
+
+        PrometheusServer& operator=(const PrometheusServer&) = delete;
+
+
+    private:
+        void serveLoop();
+        void serve(int client);
+
+        const Registry& registry_;
+        int socket_;
+        std::uint16_t port_;
+        std::atomic<bool> running_;
+        std::thread server_;
+    };
+}
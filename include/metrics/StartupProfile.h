@@ -0,0 +1,84 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace plug::metrics
+{
+    struct StartupPhase
+    {
+        const char* name;
+        std::chrono::nanoseconds start; // since the profile was enabled
+        std::chrono::nanoseconds duration;
+    };
+
+
+    // Timeline of the application startup, used by the startup benchmark.
+    // Nothing is recorded until the profile is enabled, phase names have
+    // to be string literals.
+    class StartupProfile
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static StartupProfile& global();
+
+        void enable(Clock::time_point epoch);
+        bool isEnabled() const;
+
+        void record(const char* name, Clock::time_point start, Clock::time_point end);
+        std::vector<StartupPhase> phases() const;
+
+    private:
+        std::atomic<bool> enabled_{false};
+        mutable std::mutex mutex_;
+        Clock::time_point epoch_{};
+        std::vector<StartupPhase> phases_;
+    };
+
+
+    // Records the enclosing scope as startup phase
+    class StartupScope
+    {
+    public:
+        explicit StartupScope(const char* name, StartupProfile& profile = StartupProfile::global());
+        StartupScope(const StartupScope&) = delete;
+        ~StartupScope();
+
+        StartupScope& operator=(const StartupScope&) = delete;
+
+    private:
+        StartupProfile& profile_;
+        const char* name_;
+        StartupProfile::Clock::time_point start_;
+    };
+
+
+    // Writes the phases as JSON object, times in milliseconds
+    void writeStartupReport(std::ostream& out, const std::vector<StartupPhase>& phases);
+    void writeStartupReport(const std::string& path, const std::vector<StartupPhase>& phases);
+}
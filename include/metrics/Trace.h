@@ -0,0 +1,91 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <cstdint>
+
+// Span tracing, enabled by the TRACING build option (PLUG_TRACING). The
+// macros compile to nothing otherwise. Names and categories have to be
+// string literals.
+#ifdef PLUG_TRACING
+#define PLUG_TRACE_CONCAT_IMPL(a, b) a##b
+#define PLUG_TRACE_CONCAT(a, b) PLUG_TRACE_CONCAT_IMPL(a, b)
+#define PLUG_TRACE_SPAN(category, name) const plug::metrics::TraceSpan PLUG_TRACE_CONCAT(plugTraceSpan, __LINE__){category, name}
+#else
+#define PLUG_TRACE_SPAN(category, name) static_cast<void>(0)
+#endif
+
+namespace plug::metrics
+{
+    struct TraceEvent
+    {
+        const char* category;
+        const char* name;
+        std::int64_t start; // ns since the first recorded span
+        std::int64_t duration;
+    };
+
+    namespace detail
+    {
+        std::int64_t traceNow() noexcept;
+
+        // Appends to the buffer of the calling thread; events are dropped
+        // if it's full
+        void recordTrace(const TraceEvent& event) noexcept;
+    }
+
+
+    class TraceSpan
+    {
+    public:
+        TraceSpan(const char* category, const char* name) noexcept
+            : category_(category), name_(name), start_(detail::traceNow())
+        {
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+
+        ~TraceSpan()
+        {
+            detail::recordTrace({category_, name_, start_, detail::traceNow() - start_});
+        }
+
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+    private:
+        const char* category_;
+        const char* name_;
+        std::int64_t start_;
+    };
+
+
+    // Maximum number of events per thread
+    inline constexpr std::size_t traceBufferCapacity{1 << 15};
+
+    std::size_t droppedTraceEvents();
+
+    // Chrome trace event format, can be opened by Perfetto and chrome://tracing
+    void writeChromeTrace(std::ostream& out);
+    void writeChromeTrace(const std::string& path);
+}
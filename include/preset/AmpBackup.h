@@ -0,0 +1,35 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "com/Mustang.h"
+#include <string>
+
+namespace plug::preset
+{
+    // Copies the first 'slots' presets of the amp into a new bank file.
+    // The file is only replaced once all presets have been received.
+    void backupToBank(com::Mustang& amp, std::size_t slots, const std::string& path, const com::ProgressCallback& progress = {});
+
+    // Writes all presets of a bank file to the amp, starting at slot 0.
+    // Returns the number of restored presets.
+    std::size_t restoreFromBank(com::Mustang& amp, const std::string& path, const com::ProgressCallback& progress = {});
+}
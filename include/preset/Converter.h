@@ -0,0 +1,74 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace plug::preset
+{
+    enum class Format
+    {
+        fuse,
+        bank,
+        jsonl
+    };
+
+    std::optional<Format> formatFromName(std::string_view name);
+    std::optional<Format> formatOfPath(const std::string& path);
+
+    struct ConversionReport
+    {
+        std::size_t files;
+        std::size_t presets;
+        std::size_t failed;
+        std::uint64_t bytesRead;
+        std::uint64_t bytesWritten;
+        std::chrono::steady_clock::duration elapsed;
+        std::vector<std::string> errors;
+    };
+
+    // Converts a preset file or a whole directory tree of *.fuse, *.bank and
+    // *.jsonl files into 'target'.
+    //
+    // FUSE output is written as a directory tree mirroring the input, bank
+    // and JSON Lines output as a single file in input order. Presets that
+    // fail to convert are reported and skipped. An output that is the input
+    // or lies inside the input directory is rejected.
+    ConversionReport convertPresets(const std::string& input, const std::string& output, Format target, std::size_t threads = 0);
+
+
+    struct SourcedPreset
+    {
+        std::string source;
+        SignalChain chain;
+    };
+
+    // Reads all presets of a file or directory tree in input order. The
+    // source is the relative path of the FUSE file convertPresets() would
+    // write. Presets that fail to parse are reported and skipped.
+    std::vector<SourcedPreset> readPresets(const std::string& input, ConversionReport& report, std::size_t threads = 0);
+}
@@ -0,0 +1,50 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "PackedSignalChain.h"
+#include "SignalChain.h"
+#include <vector>
+
+namespace plug::preset
+{
+    struct DuplicateCluster
+    {
+        std::vector<std::size_t> members; // ascending, the first one is kept
+        bool exact;
+        unsigned maxDistance;
+    };
+
+    // Groups presets using the same amp, cabinet and effect models whose
+    // settings are at most 'maxDistance' away from the first preset of the
+    // group (see settingsDistance()). A distance of 0 finds exact duplicates.
+    //
+    // Exact duplicates are grouped by their content hash. Near duplicates
+    // are only compared if they share a bucket of a locality sensitive hash
+    // over the amp controls and effect knobs; the buckets are sized so
+    // presets within the distance are missed with negligible probability,
+    // without comparing all pairs. Clusters are ordered by their first
+    // member.
+    std::vector<DuplicateCluster> findDuplicates(const std::vector<PackedSignalChain>& presets, unsigned maxDistance = 0);
+
+    // All presets that aren't in a cluster plus the first member of each
+    std::vector<std::size_t> uniquePresets(std::size_t count, const std::vector<DuplicateCluster>& clusters);
+}
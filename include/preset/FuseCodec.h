@@ -0,0 +1,41 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include <string>
+#include <string_view>
+
+namespace plug::preset
+{
+    // Reader / writer for FUSE preset files (*.fuse).
+    //
+    // The reader works in a single pass directly on the input buffer; tags
+    // and attributes are matched in place, only the preset name is copied.
+    // The output matches the files written by the FUSE software.
+
+    SignalChain parseFuse(std::string_view data);
+    SignalChain loadFuseFile(const std::string& path);
+
+    std::string writeFuse(const SignalChain& chain, std::string_view author = {});
+    void writeFuse(std::string& out, const SignalChain& chain, std::string_view author = {});
+    void saveFuseFile(const std::string& path, const SignalChain& chain, std::string_view author = {});
+}
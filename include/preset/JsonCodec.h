@@ -0,0 +1,39 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include <string>
+#include <string_view>
+
+namespace plug::preset
+{
+    // JSON representation of a preset, written as a single line so that
+    // collections can be stored as JSON Lines (*.jsonl).
+    //
+    // Field names follow amp_settings and fx_pedal_settings; models and
+    // cabinets are stored as their enum values.
+
+    SignalChain parseJson(std::string_view data);
+
+    std::string writeJson(const SignalChain& chain);
+    void writeJson(std::string& out, const SignalChain& chain);
+}
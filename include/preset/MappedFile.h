@@ -0,0 +1,51 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace plug::preset
+{
+    // Read only memory mapping of a whole file.
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string& path);
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        ~MappedFile();
+
+        const std::uint8_t* data() const;
+        std::size_t size() const;
+        std::string_view view() const;
+
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&&) = delete;
+
+
+    private:
+        void* data_;
+        std::size_t size_;
+    };
+}
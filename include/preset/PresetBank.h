@@ -0,0 +1,95 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include "com/Mustang.h"
+#include "preset/MappedFile.h"
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace plug::preset
+{
+    // Binary preset bank (*.bank).
+    //
+    // A bank is a 16 byte header ("PLBK", version, record size) followed by
+    // fixed size records. Each record holds the raw packets of a preset as
+    // sent by the amp, so it can be mapped into memory without parsing and
+    // passed to the amp without serializing the settings again.
+
+    struct BankRecord
+    {
+        com::PresetData packets;
+        std::array<char, 32> name;
+        std::array<std::uint8_t, 8> hash;
+
+        std::string_view getName() const;
+        std::uint64_t getHash() const;
+    };
+
+    BankRecord makeBankRecord(const com::PresetData& packets);
+    BankRecord makeBankRecord(const SignalChain& chain);
+    SignalChain decodeRecord(const BankRecord& record);
+
+
+    class PresetBank
+    {
+    public:
+        explicit PresetBank(const std::string& path);
+
+        std::size_t size() const;
+        const BankRecord& operator[](std::size_t index) const;
+        const BankRecord& at(std::size_t index) const;
+
+        const BankRecord* begin() const;
+        const BankRecord* end() const;
+
+
+    private:
+        MappedFile file_;
+        const BankRecord* records_;
+        std::size_t size_;
+    };
+
+
+    class PresetBankWriter
+    {
+    public:
+        explicit PresetBankWriter(const std::string& path);
+        PresetBankWriter(const PresetBankWriter&) = delete;
+        ~PresetBankWriter();
+
+        void append(const BankRecord& record);
+        void append(const com::PresetData& packets);
+        void append(const std::vector<BankRecord>& records);
+        std::size_t size() const;
+
+        PresetBankWriter& operator=(const PresetBankWriter&) = delete;
+
+
+    private:
+        int fd_;
+        std::size_t size_;
+    };
+}
@@ -0,0 +1,109 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "PackedSignalChain.h"
+#include "SignalChain.h"
+#include "preset/Converter.h"
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace plug::preset
+{
+    // Column numbers: one per byte of the packed amp and effect settings,
+    // effects are ordered by slot.
+    namespace column
+    {
+        inline constexpr std::size_t count{sizeof(PackedAmp) + 4 * sizeof(PackedEffect)};
+
+        constexpr std::size_t amp(std::size_t offset)
+        {
+            return offset;
+        }
+
+        constexpr std::size_t effect(std::size_t slot, std::size_t offset)
+        {
+            return sizeof(PackedAmp) + slot * sizeof(PackedEffect) + offset;
+        }
+    }
+
+    // One bit per row, 64 rows per word
+    using Selection = std::vector<std::uint64_t>;
+
+    enum class Compare
+    {
+        equal,
+        notEqual,
+        less,
+        lessEqual,
+        greater,
+        greaterEqual
+    };
+
+
+    // Preset settings stored column wise, for queries over whole archives.
+    //
+    // Each setting is a contiguous byte array across all presets, so a
+    // predicate only touches the columns it tests and is evaluated 16 rows
+    // at a time. Results are selections that can be combined before
+    // aggregating or fetching rows:
+    //
+    //   auto rows = columns.select(column::amp(offsetof(PackedAmp, gain)), Compare::greater, 200);
+    //   intersect(rows, columns.select(column::amp(offsetof(PackedAmp, sag)), Compare::equal, 2));
+    class PresetColumns
+    {
+    public:
+        void append(const SignalChain& chain, std::string source = {});
+        void reserve(std::size_t rows);
+        std::size_t size() const;
+
+        const std::vector<std::uint8_t>& column(std::size_t index) const;
+        const std::string& name(std::size_t row) const;
+        const std::string& source(std::size_t row) const;
+        SignalChain row(std::size_t row) const;
+
+        Selection all() const;
+        Selection between(std::size_t column, std::uint8_t low, std::uint8_t high) const;
+        Selection select(std::size_t column, Compare op, std::uint8_t value) const;
+
+        std::array<std::size_t, 256> histogram(std::size_t column, const Selection& rows) const;
+        std::optional<std::uint8_t> median(std::size_t column, const Selection& rows) const;
+
+
+    private:
+        std::array<std::vector<std::uint8_t>, column::count> columns_;
+        std::vector<std::string> names_;
+        std::vector<std::string> sources_;
+    };
+
+
+    void intersect(Selection& rows, const Selection& other);
+    void unite(Selection& rows, const Selection& other);
+    std::size_t count(const Selection& rows);
+    std::vector<std::size_t> indices(const Selection& rows);
+
+    // Loads a file or directory tree of *.fuse, *.bank (as written by the
+    // amp backup) and *.jsonl presets, see readPresets()
+    PresetColumns loadColumns(const std::string& input, ConversionReport& report, std::size_t threads = 0);
+}
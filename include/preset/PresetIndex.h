@@ -0,0 +1,139 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include "PackedSignalChain.h"
+#include "effects_enum.h"
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+namespace plug::preset
+{
+    struct IndexEntry
+    {
+        std::string path;
+        std::uint64_t size;
+        std::int64_t mtime;
+        std::string name;
+        amps amp;
+        cabinets cabinet;
+        std::array<effects, 4> effectModels;
+        std::uint8_t gain;
+        std::uint8_t volume;
+        std::uint8_t treble;
+        std::uint8_t middle;
+        std::uint8_t bass;
+        std::uint64_t hash;
+    };
+
+    struct ScanResult
+    {
+        std::size_t files;
+        std::size_t parsed;
+        std::size_t failed;
+        std::size_t removed;
+        bool cancelled;
+    };
+
+
+    // Changes between two snapshots of an index
+    struct IndexDiff
+    {
+        std::vector<IndexEntry> added;
+        std::vector<IndexEntry> changed;
+        std::vector<std::string> removed;
+        std::vector<std::pair<std::string, IndexEntry>> renamed; // old path, new entry
+    };
+
+
+    // Both lists have to be sorted by path, as returned by entries(). A file
+    // that disappeared while one with the same content showed up is
+    // reported as renamed.
+    IndexDiff diffEntries(const std::vector<IndexEntry>& before, const std::vector<IndexEntry>& after);
+
+
+    // Persistent index of all presets below a directory.
+    //
+    // Files are only parsed if they are new or their size / modification
+    // time changed since the last scan; this holds for files that failed to
+    // parse as well. Parsing is spread over a WorkStealingPool, the parser
+    // has to be safe to call concurrently.
+    // cancel() aborts the running and all following scans.
+    class PresetIndex
+    {
+    public:
+        using Parser = std::function<SignalChain(const std::string&)>;
+
+        explicit PresetIndex(Parser parser, std::size_t threads = 0);
+        PresetIndex(const PresetIndex&) = delete;
+
+        bool load(const std::string& indexFile);
+        void save(const std::string& indexFile) const;
+
+        ScanResult update(const std::string& directory);
+
+        // Rescans only the files directly inside the directory, as reported
+        // by file system change notifications. Subdirectories are scanned
+        // if they are new, entries of removed ones are dropped.
+        ScanResult updateDirectory(const std::string& directory);
+        void cancel();
+
+        std::vector<IndexEntry> entries() const;
+
+        PresetIndex& operator=(const PresetIndex&) = delete;
+
+
+    private:
+        struct Candidate
+        {
+            std::string path;
+            std::uint64_t size;
+            std::int64_t mtime;
+        };
+
+        struct Snapshot
+        {
+            std::vector<IndexEntry> entries;
+            std::vector<Candidate> failures;
+        };
+
+        static std::optional<Candidate> presetFile(const std::filesystem::directory_entry& file);
+        std::vector<Candidate> scanRecursive(const std::filesystem::path& directory) const;
+        Snapshot snapshot() const;
+        ScanResult merge(Snapshot previous, Snapshot current, const std::vector<Candidate>& found);
+
+        Parser parser_;
+        std::size_t threads_;
+        std::atomic<bool> cancelled_;
+        mutable std::mutex mutex_;
+        std::vector<IndexEntry> entries_;
+        std::vector<Candidate> failures_;
+    };
+}
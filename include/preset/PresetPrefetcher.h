@@ -0,0 +1,81 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace plug::preset
+{
+    // Parses presets ahead of time on a background thread.
+    //
+    // Each prefetch() request replaces the pending one, so paths that
+    // became irrelevant in the meantime are never parsed. Results are
+    // kept in a bounded cache, the least recently used entry is evicted.
+    class PresetPrefetcher
+    {
+    public:
+        using Parser = std::function<SignalChain(const std::string&)>;
+
+        PresetPrefetcher(Parser parser, std::size_t capacity);
+        PresetPrefetcher(const PresetPrefetcher&) = delete;
+        ~PresetPrefetcher();
+
+        void prefetch(const std::vector<std::string>& paths);
+        std::optional<SignalChain> get(const std::string& path);
+        SignalChain load(const std::string& path);
+        void clear();
+
+        // Drops the cached preset, e.g. after its file changed
+        void invalidate(const std::string& path);
+
+        PresetPrefetcher& operator=(const PresetPrefetcher&) = delete;
+
+
+    private:
+        using CacheList = std::list<std::pair<std::string, SignalChain>>;
+
+        void run();
+        void insert(const std::string& path, SignalChain chain);
+        bool contains(const std::string& path) const;
+
+        Parser parser_;
+        std::size_t capacity_;
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        std::deque<std::string> pending_;
+        CacheList cache_;
+        std::unordered_map<std::string, CacheList::iterator> lookup_;
+        std::size_t generation_;
+        bool running_;
+        std::thread worker_;
+    };
+}
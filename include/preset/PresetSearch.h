@@ -0,0 +1,124 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include "effects_enum.h"
+#include "preset/PresetIndex.h"
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace plug::preset
+{
+    // Searchable settings of a preset, effects are ordered by slot
+    struct PresetAttributes
+    {
+        amps amp;
+        cabinets cabinet;
+        std::array<effects, 4> effectModels;
+        std::uint8_t gain;
+        std::uint8_t volume;
+        std::uint8_t treble;
+        std::uint8_t middle;
+        std::uint8_t bass;
+    };
+
+    PresetAttributes attributesOf(const SignalChain& chain);
+    PresetAttributes attributesOf(const IndexEntry& entry);
+
+
+    enum class SearchSource
+    {
+        amp,
+        library
+    };
+
+    struct SearchResult
+    {
+        SearchSource source;
+        std::string key;
+        unsigned score;
+    };
+
+
+    // In-memory search over the names and settings of amp and library presets.
+    //
+    // Words of a query are matched fuzzy against the preset names, using an
+    // inverted index of name trigrams. Filters are answered from bitmaps per
+    // amp, cabinet and effect (per slot); all parts of a query have to match,
+    // "and" is optional:
+    //
+    //   clean amp=FENDER_65_TWIN_REVERB dsp=effect2 effect=tape_delay gain>180
+    //
+    // Filter fields are amp, cabinet, effect (any slot), fx1 - fx4 (effect
+    // in that slot), family (stompbox, modulation, delay or reverb effect in
+    // any slot), dsp (effect0 - effect3, the DSP running that family) and the
+    // numeric controls gain, volume, treble, middle and bass. Values are
+    // compared case insensitive, ignoring all non alphanumeric characters.
+    // Presets without known settings only match queries without filters.
+    // Documents are updated individually, there is no need for a rebuild.
+    class PresetSearch
+    {
+    public:
+        void insert(SearchSource source, const std::string& key, const std::string& name, const std::optional<PresetAttributes>& attributes);
+        void erase(SearchSource source, const std::string& key);
+        void clear(SearchSource source);
+        std::size_t size() const;
+
+        // Best matches first; throws std::invalid_argument on malformed filters
+        std::vector<SearchResult> search(std::string_view query, std::size_t limit = 200) const;
+
+
+    private:
+        using Bitmap = std::vector<std::uint64_t>;
+        using DocumentId = std::uint32_t;
+
+        struct Document
+        {
+            SearchSource source;
+            std::string key;
+            std::string name;
+            std::vector<std::uint32_t> trigrams;
+            std::optional<PresetAttributes> attributes;
+        };
+
+        DocumentId allocate();
+        void index(DocumentId id);
+        void unindex(DocumentId id);
+        Bitmap evaluate(std::string_view term) const;
+
+        std::vector<Document> documents_;
+        std::vector<DocumentId> free_;
+        std::unordered_map<std::string, DocumentId> ids_;
+        std::unordered_map<std::uint32_t, std::vector<DocumentId>> postings_;
+        Bitmap used_;
+        Bitmap hasAttributes_;
+        std::array<Bitmap, 12> amps_;
+        std::array<Bitmap, 13> cabinets_;
+        std::array<std::array<Bitmap, 38>, 4> effects_;
+        std::array<std::vector<std::uint8_t>, 5> controls_;
+    };
+}
@@ -0,0 +1,80 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace plug::preset
+{
+    // Thread pool with one task queue per worker.
+    //
+    // Workers take tasks from the back of their own queue and steal from
+    // the front of the others once it runs empty. Tasks submitted from a
+    // worker go to its own queue. The first exception thrown by a task is
+    // rethrown by wait().
+    class WorkStealingPool
+    {
+    public:
+        using Task = std::function<void()>;
+
+        explicit WorkStealingPool(std::size_t threads = 0);
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        ~WorkStealingPool();
+
+        void submit(Task task);
+        void wait();
+        std::size_t size() const;
+
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void run(std::size_t index);
+        bool popOwn(std::size_t index, Task& task);
+        bool steal(std::size_t index, Task& task);
+        void finish(std::exception_ptr error);
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        std::condition_variable done_;
+        std::atomic<std::size_t> queued_;
+        std::size_t pending_;
+        std::size_t next_;
+        std::exception_ptr error_;
+        bool running_;
+    };
+}
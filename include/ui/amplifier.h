@@ -86,6 +86,7 @@ namespace plug
 
         void load(amp_settings);
         void get_settings(amp_settings*);
+        void set_changed(bool);
         void enable_set_button(bool);
 
         void showAndActivate();
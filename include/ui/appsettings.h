@@ -0,0 +1,108 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ * Copyright (C) 2010-2016  piorekf <piorek@piorekf.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+class QWidget;
+
+namespace plug
+{
+
+    // In-memory copy of the user settings.
+    //
+    // The values are read from QSettings once at construction, changes
+    // are written back by a short single-shot timer (and on destruction),
+    // so the preset switching paths never touch the settings backend.
+    class AppSettings : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        static constexpr std::size_t quickPresetCount{10};
+
+        explicit AppSettings(QObject* parent = nullptr);
+        AppSettings(const AppSettings&) = delete;
+        ~AppSettings() override;
+
+        AppSettings& operator=(const AppSettings&) = delete;
+
+        // Reads the setting from the backend, usable before the application
+        // object exists (the organization and application names are set)
+        static bool read_connect_on_startup();
+
+        // Window geometry is only touched when a window opens or closes
+        static void restore_geometry(QWidget& window, const QString& key);
+        static void save_geometry(const QWidget& window, const QString& key);
+
+        bool connect_on_startup() const;
+        bool one_set_to_set_them_all() const;
+        bool keep_windows_open() const;
+        bool popup_changed_windows() const;
+        bool default_effect_values() const;
+        std::optional<int> quick_preset(std::size_t index) const;
+
+        // OSC control server, off while the port is 0; only set in the
+        // configuration file and read at startup
+        QString osc_address() const;
+        std::uint16_t osc_port() const;
+
+        void set_connect_on_startup(bool value);
+        void set_one_set_to_set_them_all(bool value);
+        void set_keep_windows_open(bool value);
+        void set_popup_changed_windows(bool value);
+        void set_default_effect_values(bool value);
+        void set_quick_preset(std::size_t index, std::optional<int> slot);
+
+    public slots:
+        void flush();
+
+    signals:
+        void changed();
+
+    private:
+        enum Flag : std::size_t
+        {
+            connectOnStartup,
+            oneSetToSetThemAll,
+            keepWindowsOpen,
+            popupChangedWindows,
+            defaultEffectValues,
+            flagCount
+        };
+
+        void set_flag(Flag flag, bool value);
+        void schedule_write();
+
+        std::array<bool, flagCount> flags;
+        std::array<bool, flagCount> dirtyFlags;
+        std::array<std::optional<int>, quickPresetCount> quickPresets;
+        std::array<bool, quickPresetCount> dirtyPresets;
+        QString oscAddress;
+        std::uint16_t oscPort;
+        QTimer writeTimer;
+    };
+}
@@ -49,8 +49,7 @@ namespace plug
         Effect& operator=(const Effect&) = delete;
 
     private:
-        void setTitleTexts(int slot, const QString& name);
-        void setDialValues(int d1, int d2, int d3, int d4, int d5, int d6);
+        void setTitleTexts(const QString& name);
 
         const std::unique_ptr<Ui::Effect> ui;
         std::uint8_t fx_slot;
@@ -78,6 +77,7 @@ namespace plug
         void set_knob6(int);
         void choose_fx(int);
         void off_switch(bool);
+        void toggle_off_switch();
         void enable_set_button(bool);
 
         // send settings to the amplifier
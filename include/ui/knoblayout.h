@@ -21,31 +21,26 @@
 
 #pragma once
 
-#include "data_structs.h"
-#include "effects_enum.h"
-#include <QFile>
-#include <QTextEdit>
-#include <QXmlStreamReader>
-#include <memory>
+#include <QString>
+#include <array>
+
+class QDial;
+class QLabel;
+class QSpinBox;
 
 namespace plug
 {
+    struct EffectDescriptor;
 
-    class LoadFromFile
+    struct KnobWidgets
     {
-    public:
-        LoadFromFile(QFile* file, QString* name, amp_settings* amp_settings, fx_pedal_settings fx_settings[4]);
-
-        void loadfile();
-
-    private:
-        QString* m_name;
-        amp_settings* m_amp_settings;
-        fx_pedal_settings* m_fx_settings;
-        const std::unique_ptr<QXmlStreamReader> m_xml;
-
-        void parseAmp();
-        void parseFX();
-        void parseFUSE();
+        QLabel* label;
+        QDial* dial;
+        QSpinBox* spinBox;
     };
+
+    // Shows the knobs of an effect: enables the used ones with their range
+    // and label and sets the accessibility texts, which start with the
+    // owner (e.g. "Effect's 2"). Unused dials are set to zero if resetUnused.
+    void layoutKnobs(const std::array<KnobWidgets, 6>& widgets, const EffectDescriptor& descriptor, const QString& owner, bool resetUnused);
 }
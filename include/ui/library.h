@@ -21,10 +21,19 @@
 
 #pragma once
 
+#include "preset/PresetIndex.h"
+#include "preset/PresetPrefetcher.h"
+#include "preset/PresetSearch.h"
 #include <QDialog>
+#include <QFileSystemWatcher>
 #include <QResizeEvent>
-#include <QFileInfoList>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <functional>
 #include <memory>
+#include <thread>
+#include <unordered_map>
 
 namespace Ui
 {
@@ -33,13 +42,15 @@ namespace Ui
 
 namespace plug
 {
+    class PresetNameModel;
+    class PresetFileModel;
 
     class Library : public QDialog
     {
         Q_OBJECT
 
     public:
-        explicit Library(const std::vector<std::string>& names, QWidget* parent = nullptr);
+        explicit Library(PresetNameModel& presets, QWidget* parent = nullptr);
         Library(const Library&) = delete;
         ~Library() override;
 
@@ -48,14 +59,42 @@ namespace plug
 
     private:
         const std::unique_ptr<Ui::Library> ui;
-        const std::unique_ptr<QFileInfoList> files;
+        PresetNameModel& amp_presets;
+        PresetFileModel* file_model;
+        QFileSystemWatcher* watcher;
+        QString directory;
+        QString selected_file;
+        QSet<QString> changed_directories;
+        bool scanning;
+        std::shared_ptr<preset::PresetIndex> index;
+        std::unordered_map<std::size_t, std::thread> indexers;
+        std::size_t next_indexer;
+        std::thread duplicate_finder;
+        std::size_t generation;
+        const std::unique_ptr<preset::PresetPrefetcher> prefetcher;
+        QTimer* load_timer;
+        QTimer* refresh_timer;
+        QTimer* search_timer;
+        preset::PresetSearch search;
         void resizeEvent(QResizeEvent*) override;
+        void run_indexer(std::function<void()> work);
+        void finish_indexer(std::size_t job);
+        void post(std::size_t current, std::function<void()> update);
+        void show_changes(const preset::IndexDiff& diff, const std::vector<preset::IndexEntry>* entries);
+        void watch(const QStringList& directories);
+        void finish_scan();
+        void index_amp_presets(int first, int last);
 
     private slots:
         void load_slot(int);
         void get_directory();
         void get_files(const QString&);
+        void directory_modified(const QString&);
+        void refresh_directories();
+        void apply_search();
+        void find_duplicates();
         void load_file(int);
+        void load_selected_file();
         void change_font_size(int);
         void change_font_family(QFont);
 
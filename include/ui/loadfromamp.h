@@ -42,10 +42,6 @@ namespace plug
         LoadFromAmp(const LoadFromAmp&) = delete;
         ~LoadFromAmp() override;
 
-        void load_names(const std::vector<std::string>& names);
-        void delete_items();
-        void change_name(int, QString*);
-
         LoadFromAmp& operator=(const LoadFromAmp&) = delete;
 
     private:
@@ -22,8 +22,18 @@
 #pragma once
 
 #include "data_structs.h"
+#include "SignalChain.h"
+#include "com/AmpReader.h"
 #include <QMainWindow>
+#include <array>
+#include <functional>
+#include <future>
 #include <memory>
+#include <optional>
+
+class QDialog;
+class QPlainTextEdit;
+class QShortcut;
 
 namespace Ui
 {
@@ -42,10 +52,23 @@ namespace plug
     class Library;
     class DefaultEffects;
     class QuickPresets;
+    class AppSettings;
+    class PresetNameModel;
 
     namespace com
     {
+        class Connection;
         class Mustang;
+        class ToneSnapshots;
+        class PacketCache;
+        class CommandQueue;
+        class OscServer;
+        class AutomationScheduler;
+    }
+
+    namespace metrics
+    {
+        class PrometheusServer;
     }
 }
 
@@ -58,12 +81,31 @@ namespace plug
         Q_OBJECT
 
     public:
+        using ConnectionFactory = std::function<std::shared_ptr<com::Connection>()>;
+
+        // Connected amp with its initial data; the reader isn't started yet
+        struct AmpConnection
+        {
+            std::shared_ptr<com::AmpReader> reader;
+            std::unique_ptr<com::Mustang> mustang;
+            SignalChain chain;
+            std::vector<std::string> presetNames;
+        };
+
+        // Connects on a worker thread, so it can run while the window is built
+        static std::future<AmpConnection> connect_amp_async(ConnectionFactory factory);
+
         explicit MainWindow(QWidget* parent = nullptr);
+        MainWindow(ConnectionFactory factory, std::future<AmpConnection> pending, QWidget* parent = nullptr);
         MainWindow(const MainWindow&) = delete;
         ~MainWindow() override;
 
         MainWindow& operator=(const MainWindow&) = delete;
 
+        AppSettings& app_settings();
+        PresetNameModel& preset_model();
+        bool is_connected() const;
+
     public slots:
         void start_amp();
         void stop_amp();
@@ -72,10 +114,10 @@ namespace plug
         void save_on_amp(char*, int);
         void load_from_amp(int);
         void enable_buttons();
-        void change_name(int, QString*);
         void save_effects(int, char*, int, bool, bool, bool);
         void set_index(int);
         void loadfile(QString filename = QString());
+        void load_preset(const SignalChain& chain);
         void get_settings(amp_settings*, fx_pedal_settings[4]);
         void change_title(const QString&);
         void update_firmware();
@@ -84,15 +126,28 @@ namespace plug
     private:
         const std::unique_ptr<Ui::MainWindow> ui;
 
+        const std::unique_ptr<AppSettings> appSettings;
+        const ConnectionFactory connectionFactory;
         QString current_name;
         std::vector<std::string> presetNames;
+        const std::unique_ptr<PresetNameModel> presetModel;
         bool connected;
+        bool updating_windows;
         std::unique_ptr<com::Mustang> amp_ops;
+        std::unique_ptr<com::CommandQueue> amp_queue;
+        std::unique_ptr<com::OscServer> oscServer;
+        std::unique_ptr<com::AutomationScheduler> automation;
+        std::unique_ptr<com::ToneSnapshots> snapshots;
+        std::unique_ptr<com::PacketCache> packetCache;
+
+        // Secondary windows are created on first use, until then the
+        // settings they would show are kept here
         Amplifier* amp;
-        Effect* effect1;
-        Effect* effect2;
-        Effect* effect3;
-        Effect* effect4;
+        std::array<Effect*, 4> effect_windows;
+        std::optional<amp_settings> amp_state;
+        std::array<std::optional<fx_pedal_settings>, 4> effect_states;
+        bool set_buttons_enabled;
+        int current_index;
         SaveOnAmp* save;
         LoadFromAmp* load;
         SaveEffects* seffects;
@@ -101,6 +156,38 @@ namespace plug
         std::unique_ptr<Library> library;
         std::unique_ptr<DefaultEffects> deffx;
         QuickPresets* quickpres;
+        std::array<QShortcut*, 10> quickPresetShortcuts;
+        QDialog* statistics;
+        QPlainTextEdit* statisticsText;
+        std::unique_ptr<metrics::PrometheusServer> metricsServer;
+
+        Amplifier* amp_window();
+        Effect* effect_window(std::size_t slot);
+        SaveOnAmp* save_window();
+        LoadFromAmp* load_window();
+        SaveEffects* save_effects_window();
+        Settings* settings_window();
+        SaveToFile* save_to_file_window();
+        QuickPresets* quick_presets_window();
+
+        amp_settings current_amp();
+        fx_pedal_settings current_effect(std::size_t slot);
+        void load_amp(const amp_settings& settings);
+        void load_effect(const fx_pedal_settings& settings);
+        void reset_changed();
+        void enable_set_buttons(bool value);
+        void update_preset_names();
+        void popup_windows(const SignalChain& chain);
+        void finish_start_amp(std::future<AmpConnection> pending);
+        static AmpConnection connect_amp(const ConnectionFactory& factory);
+        void apply_settings();
+        void load_quick_preset(std::size_t index);
+
+        void start_metrics_export();
+        void start_osc_server(const SignalChain& chain);
+        void sync_controls();
+        void update_windows(const SignalChain& chain);
+        void show_amp_change(const com::StateChange& change);
 
     private slots:
         void about();
@@ -111,6 +198,14 @@ namespace plug
         void show_amp();
         void show_library();
         void show_default_effects();
+        void show_statistics();
+        void update_statistics();
+        void play_automation();
+        void stop_automation();
+        void backup_amp();
+        void restore_amp();
+        void store_snapshot(int);
+        void recall_snapshot(int);
         void load_presets0();
         void load_presets1();
         void load_presets2();
@@ -0,0 +1,69 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "preset/PresetIndex.h"
+#include <QAbstractListModel>
+#include <QDir>
+#include <QString>
+#include <vector>
+
+namespace plug
+{
+
+    // Preset files of the library directory, sorted by their relative path.
+    //
+    // Changes of the index are applied as row inserts, removals and moves,
+    // so views keep their selection and scroll position.
+    class PresetFileModel : public QAbstractListModel
+    {
+        Q_OBJECT
+
+    public:
+        explicit PresetFileModel(QObject* parent = nullptr);
+
+        void reset(const QString& directory, const std::vector<preset::IndexEntry>& entries);
+        void apply(const preset::IndexDiff& diff);
+        void clear();
+
+        QString path(int row) const;
+
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    private:
+        struct File
+        {
+            QString label;
+            QString path;
+            QString name;
+        };
+
+        File makeFile(const preset::IndexEntry& entry) const;
+        int find(const QString& path) const;
+        int position(const File& file) const;
+        void insert(File file);
+        void remove(int row);
+
+        QDir root;
+        std::vector<File> files;
+    };
+}
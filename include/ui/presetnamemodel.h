@@ -0,0 +1,79 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SignalChain.h"
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QString>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace plug
+{
+
+    // Preset names of the connected amplifier, shared by all preset pickers.
+    //
+    // The "[slot] name" texts are formatted on demand, so attaching a view
+    // doesn't copy the names and a rename only updates the affected row.
+    class PresetNameModel : public QAbstractListModel
+    {
+        Q_OBJECT
+
+    public:
+        explicit PresetNameModel(QObject* parent = nullptr);
+
+        void set_names(const std::vector<std::string>& presetNames);
+        void set_name(int slot, const QString& name);
+        void clear();
+
+        // Settings of a slot are only known once it was loaded or saved
+        void set_chain(int slot, const SignalChain& chain);
+        std::optional<SignalChain> chain(int slot) const;
+        QString name(int slot) const;
+
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    private:
+        std::vector<QString> names;
+        std::vector<std::optional<SignalChain>> chains;
+    };
+
+
+    // Preset names followed by an "[Empty]" entry, for pickers where no
+    // preset is a valid choice
+    class OptionalPresetModel : public QAbstractListModel
+    {
+        Q_OBJECT
+
+    public:
+        explicit OptionalPresetModel(PresetNameModel& presets, QObject* parent = nullptr);
+
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    private:
+        // Windows owning this model may outlive the shared one
+        QPointer<PresetNameModel> source;
+    };
+}
@@ -22,7 +22,6 @@
 #pragma once
 
 #include <QDialog>
-#include <QSettings>
 #include <memory>
 
 namespace Ui
@@ -32,6 +31,8 @@ namespace Ui
 
 namespace plug
 {
+    class AppSettings;
+    class OptionalPresetModel;
 
     class QuickPresets : public QDialog
     {
@@ -40,10 +41,6 @@ namespace plug
     public:
         explicit QuickPresets(QWidget* parent = nullptr);
 
-        void load_names(const std::vector<std::string>& names);
-        void delete_items();
-        void change_name(int, QString*);
-
     protected:
         void changeEvent(QEvent* e) override;
 
@@ -60,6 +57,11 @@ namespace plug
         void setDefaultPreset9(int);
 
     private:
+        void select_quick_presets();
+        void set_quick_preset(std::size_t index, int slot);
+
         const std::unique_ptr<Ui::QuickPresets> ui;
+        AppSettings& settings;
+        OptionalPresetModel* choices;
     };
 }
@@ -42,9 +42,6 @@ namespace plug
         SaveOnAmp(const SaveOnAmp&) = delete;
         ~SaveOnAmp() override;
 
-        void load_names(const std::vector<std::string>& names);
-        void delete_items();
-
         SaveOnAmp& operator=(const SaveOnAmp&) = delete;
 
     public slots:
@@ -25,7 +25,6 @@
 #include <QDialog>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QXmlStreamWriter>
 #include <memory>
 
 namespace Ui
@@ -52,12 +51,5 @@ namespace plug
 
     private:
         const std::unique_ptr<Ui::SaveToFile> ui;
-        std::unique_ptr<QXmlStreamWriter> xml;
-
-        void writeAmp(amp_settings);
-        void manageWriteFX(fx_pedal_settings[4]);
-        void writeFX(fx_pedal_settings);
-        void writeFUSE();
-        void writeUSBGain(int);
     };
 }
@@ -22,7 +22,6 @@
 #pragma once
 
 #include <QDialog>
-#include <QSettings>
 #include <memory>
 
 namespace Ui
@@ -32,6 +31,7 @@ namespace Ui
 
 namespace plug
 {
+    class AppSettings;
 
     class Settings : public QDialog
     {
@@ -48,6 +48,9 @@ namespace plug
         void change_effectvalues(bool);
 
     private:
+        void show_settings();
+
         const std::unique_ptr<Ui::Settings> ui;
+        AppSettings& settings;
     };
 }
@@ -0,0 +1,124 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/Converter.h"
+#include "Version.h"
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    void printUsage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " [--threads N] --to fuse|bank|jsonl INPUT OUTPUT\n\n"
+                  << "Converts a preset file or a directory tree of *.fuse, *.bank and *.jsonl\n"
+                  << "files. FUSE output is written to the directory OUTPUT, bank and JSON Lines\n"
+                  << "output to the file OUTPUT.\n";
+    }
+
+    void printReport(const plug::preset::ConversionReport& report)
+    {
+        const double seconds = std::chrono::duration<double>(report.elapsed).count();
+        const double megabytes = static_cast<double>(report.bytesRead) / (1024.0 * 1024.0);
+
+        std::cout << report.files << " files, " << report.presets << " presets converted, " << report.failed << " failed\n"
+                  << megabytes << " MiB read, " << static_cast<double>(report.bytesWritten) / (1024.0 * 1024.0) << " MiB written in " << seconds << " s\n";
+
+        if (seconds > 0.0)
+        {
+            std::cout << static_cast<double>(report.files) / seconds << " files/s, "
+                      << static_cast<double>(report.presets) / seconds << " presets/s, "
+                      << megabytes / seconds << " MB/s\n";
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace plug::preset;
+
+    std::optional<Format> target;
+    std::size_t threads{0};
+    std::vector<std::string> paths;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg{argv[i]};
+
+            if ((arg == "--to") && ((i + 1) < argc))
+            {
+                target = formatFromName(argv[++i]);
+            }
+            else if ((arg == "--threads") && ((i + 1) < argc))
+            {
+                threads = std::stoul(argv[++i]);
+            }
+            else if (arg == "--version")
+            {
+                std::cout << "plug-convert " << plug::version() << "\n";
+                return 0;
+            }
+            else if ((arg == "--help") || (arg.substr(0, 2) == "--"))
+            {
+                printUsage(argv[0]);
+                return (arg == "--help" ? 0 : 2);
+            }
+            else
+            {
+                paths.emplace_back(arg);
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    if ((target.has_value() == false) || (paths.size() != 2))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        const auto report = convertPresets(paths[0], paths[1], *target, threads);
+
+        for (const auto& error : report.errors)
+        {
+            std::cerr << "Error: " << error << "\n";
+        }
+        printReport(report);
+        return (report.failed == 0 ? 0 : 1);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+}
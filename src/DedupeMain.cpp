@@ -0,0 +1,158 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/Converter.h"
+#include "preset/Duplicates.h"
+#include "preset/PresetBank.h"
+#include "Version.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    void printUsage(const char* program)
+    {
+        std::cerr << "Usage: " << program << " [--threads N] [--distance N] [--output BANK] INPUT\n\n"
+                  << "Finds duplicate presets in a preset file or a directory tree of *.fuse,\n"
+                  << "*.bank and *.jsonl files. With a distance, presets using the same models\n"
+                  << "whose settings differ by at most N in sum are reported as well. The\n"
+                  << "first preset of each group and all unique presets can be written to BANK.\n";
+    }
+
+    void printClusters(const std::vector<plug::preset::SourcedPreset>& presets, const std::vector<plug::preset::DuplicateCluster>& clusters)
+    {
+        for (std::size_t i = 0; i < clusters.size(); ++i)
+        {
+            const auto& cluster = clusters[i];
+            std::cout << "Group " << (i + 1) << (cluster.exact ? " (exact)" : " (distance <= " + std::to_string(cluster.maxDistance) + ")") << ":\n";
+
+            for (const auto member : cluster.members)
+            {
+                std::cout << (member == cluster.members.front() ? "  keep " : "       ") << presets[member].source
+                          << " \"" << presets[member].chain.name() << "\"\n";
+            }
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace plug::preset;
+
+    std::size_t threads{0};
+    unsigned distance{0};
+    std::string output;
+    std::vector<std::string> paths;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg{argv[i]};
+
+            if ((arg == "--threads") && ((i + 1) < argc))
+            {
+                threads = std::stoul(argv[++i]);
+            }
+            else if ((arg == "--distance") && ((i + 1) < argc))
+            {
+                distance = static_cast<unsigned>(std::stoul(argv[++i]));
+            }
+            else if ((arg == "--output") && ((i + 1) < argc))
+            {
+                output = argv[++i];
+            }
+            else if (arg == "--version")
+            {
+                std::cout << "plug-dedupe " << plug::version() << "\n";
+                return 0;
+            }
+            else if ((arg == "--help") || (arg.substr(0, 2) == "--"))
+            {
+                printUsage(argv[0]);
+                return (arg == "--help" ? 0 : 2);
+            }
+            else
+            {
+                paths.emplace_back(arg);
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    if (paths.size() != 1)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        ConversionReport report{0, 0, 0, 0, 0, {}, {}};
+        const auto presets = readPresets(paths[0], report, threads);
+
+        for (const auto& error : report.errors)
+        {
+            std::cerr << "Error: " << error << "\n";
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<plug::PackedSignalChain> packed;
+        packed.reserve(presets.size());
+        std::transform(presets.cbegin(), presets.cend(), std::back_inserter(packed), [](const auto& p) { return pack(p.chain); });
+
+        const auto clusters = findDuplicates(packed, distance);
+        const auto unique = uniquePresets(presets.size(), clusters);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printClusters(presets, clusters);
+        std::cout << presets.size() << " presets, " << clusters.size() << " groups, " << (presets.size() - unique.size())
+                  << " duplicates found in " << seconds << " s\n";
+
+        if (output.empty() == false)
+        {
+            std::filesystem::remove(output);
+            PresetBankWriter writer{output};
+
+            for (const auto index : unique)
+            {
+                writer.append(makeBankRecord(presets[index].chain));
+            }
+            std::cout << unique.size() << " presets written to " << output << "\n";
+        }
+        return (report.failed == 0 ? 0 : 1);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+}
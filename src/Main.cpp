@@ -20,22 +20,141 @@
  */
 
 #include "com/UsbContext.h"
+#include "com/ConnectionFactory.h"
 #include "com/Mustang.h"
+#include "com/SimulatedAmp.h"
+#include "ui/appsettings.h"
 #include "ui/mainwindow.h"
+#include "metrics/StartupProfile.h"
+#include "metrics/Trace.h"
 #include "Version.h"
 #include <QApplication>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <string_view>
+
+namespace
+{
+    inline constexpr std::size_t simulatedPresetCount{24};
+    inline constexpr std::chrono::milliseconds simulatedIdleTimeout{100};
+
+    // --simulate: use a simulated amp instead of the usb device
+    // --benchmark-startup[=FILE]: connect, write the startup report to
+    //   FILE (or stdout) and exit
+    struct Options
+    {
+        bool simulate{false};
+        bool benchmarkStartup{false};
+        std::optional<std::string> reportFile;
+    };
+
+    Options parseOptions(int argc, char* argv[])
+    {
+        constexpr std::string_view benchmarkOption{"--benchmark-startup"};
+        Options options{};
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg{argv[i]};
+
+            if (arg == "--simulate")
+            {
+                options.simulate = true;
+            }
+            else if (arg == benchmarkOption)
+            {
+                options.benchmarkStartup = true;
+            }
+            else if ((arg.substr(0, benchmarkOption.size() + 1) == std::string{benchmarkOption} + '=') && (arg.size() > benchmarkOption.size() + 1))
+            {
+                options.benchmarkStartup = true;
+                options.reportFile = std::string{arg.substr(benchmarkOption.size() + 1)};
+            }
+        }
+        return options;
+    }
+
+    plug::MainWindow::ConnectionFactory connectionFactory(const Options& options)
+    {
+        if (options.simulate == true)
+        {
+            return [] { return std::make_shared<plug::com::SimulatedAmp>(plug::com::simulatedPresets(simulatedPresetCount), simulatedIdleTimeout); };
+        }
+        return plug::com::createUsbConnection;
+    }
+
+    int benchmarkStartup(plug::MainWindow& window, const Options& options)
+    {
+        using plug::metrics::StartupProfile;
+
+        QCoreApplication::processEvents();
+
+        const auto phases = StartupProfile::global().phases();
+
+        if (options.reportFile.has_value())
+        {
+            plug::metrics::writeStartupReport(*options.reportFile, phases);
+        }
+        else
+        {
+            plug::metrics::writeStartupReport(std::cout, phases);
+        }
+        return window.is_connected() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
 
 int main(int argc, char* argv[])
 {
-    QApplication app{argc, argv};
+    using plug::metrics::StartupProfile;
+
+    const auto processStart = StartupProfile::Clock::now();
+    const Options options = parseOptions(argc, argv);
+
+    if (options.benchmarkStartup == true)
+    {
+        StartupProfile::global().enable(processStart);
+    }
+
     QCoreApplication::setOrganizationName("offa");
     QCoreApplication::setApplicationName("Plug");
     QCoreApplication::setApplicationVersion(QString::fromStdString(plug::version()));
 
+    auto phaseStart = StartupProfile::Clock::now();
     plug::com::usb::Context context{};
+    StartupProfile::global().record("usb_context", phaseStart, StartupProfile::Clock::now());
+
+    // Connecting runs in parallel to building the window, the benchmark
+    // connects regardless of the settings
+    const auto factory = connectionFactory(options);
+    std::future<plug::MainWindow::AmpConnection> pending;
 
-    plug::MainWindow window;
+    if ((options.benchmarkStartup == true) || plug::AppSettings::read_connect_on_startup())
+    {
+        pending = plug::MainWindow::connect_amp_async(factory);
+    }
+
+    phaseStart = StartupProfile::Clock::now();
+    QApplication app{argc, argv};
+    StartupProfile::global().record("qapplication", phaseStart, StartupProfile::Clock::now());
+
+    phaseStart = StartupProfile::Clock::now();
+    plug::MainWindow window{factory, std::move(pending)};
     window.show();
+    StartupProfile::global().record("main_window", phaseStart, StartupProfile::Clock::now());
+
+    if (options.benchmarkStartup == true)
+    {
+        return benchmarkStartup(window, options);
+    }
+
+    const int result = app.exec();
 
-    return app.exec();
+#ifdef PLUG_TRACING
+    const char* tracePath = std::getenv("PLUG_TRACE_FILE");
+    plug::metrics::writeChromeTrace(std::string{tracePath != nullptr ? tracePath : "plug-trace.json"});
+#endif
+    return result;
 }
@@ -0,0 +1,350 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/AmpReader.h"
+#include "com/Packet.h"
+#include "com/PacketSerializer.h"
+#include "metrics/Metrics.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace plug::com
+{
+    namespace
+    {
+        // Passes a raw buffer to Connection::send()
+        struct RawBuffer
+        {
+            std::uint8_t* data() const
+            {
+                return ptr;
+            }
+
+            std::size_t size() const
+            {
+                return length;
+            }
+
+            std::uint8_t* ptr;
+            std::size_t length;
+        };
+
+        metrics::Counter& responseTimeouts()
+        {
+            static auto& counter = metrics::Registry::global().counter("plug_amp_response_timeouts_total", "Amp responses not received within the timeout");
+            return counter;
+        }
+
+        bool isSettingsDsp(DSP dsp)
+        {
+            switch (dsp)
+            {
+                case DSP::amp:
+                case DSP::usbGain:
+                case DSP::effect0:
+                case DSP::effect1:
+                case DSP::effect2:
+                case DSP::effect3:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Packets the amp sends on its own when a control on the front panel
+        // is used don't carry the ready stage.
+        bool isFrontPanelChange(const Header& header)
+        {
+            return (header.getStage() == Stage::unknown) && (header.getType() == Type::data) && isSettingsDsp(header.getDSP());
+        }
+
+        std::optional<Header> headerOf(const std::vector<std::uint8_t>& packet)
+        {
+            if (packet.size() != packetRawTypeSize)
+            {
+                return std::nullopt;
+            }
+
+            Header::RawType bytes{};
+            std::copy_n(packet.cbegin(), bytes.size(), bytes.begin());
+            Header header{};
+            header.fromBytes(bytes);
+
+            try
+            {
+                // Throws on unknown values
+                header.getType();
+                header.getDSP();
+            }
+            catch (const std::domain_error&)
+            {
+                return std::nullopt;
+            }
+            return header;
+        }
+    }
+
+
+    std::optional<StateChange> decodeStateChange(const std::vector<std::uint8_t>& packet)
+    {
+        const auto header = headerOf(packet);
+
+        if (header.has_value() == false)
+        {
+            return std::nullopt;
+        }
+
+        PacketRawType data{};
+        std::copy(packet.cbegin(), packet.cend(), data.begin());
+
+        switch (header->getDSP())
+        {
+            case DSP::amp:
+            {
+                const auto amp = fromRawData<AmpPayload>(data);
+                return decodeAmpFromData(amp, amp);
+            }
+            case DSP::usbGain:
+                return UsbGainChange{fromRawData<AmpPayload>(data).getPayload().getUsbGain()};
+            case DSP::effect0:
+            case DSP::effect1:
+            case DSP::effect2:
+            case DSP::effect3:
+            {
+                const auto effect = fromRawData<EffectPayload>(data);
+                const auto slot = effect.getPayload().getSlot() % 4;
+                return decodeEffectsFromData({{effect, effect, effect, effect}})[slot];
+            }
+            case DSP::opSaveEffectName:
+                if (header->getType() == Type::operation)
+                {
+                    return NameChange{decodeNameFromData(fromRawData<NamePayload>(data))};
+                }
+                return std::nullopt;
+            default:
+                return std::nullopt;
+        }
+    }
+
+
+    AmpReader::AmpReader(std::shared_ptr<Connection> connection, std::chrono::milliseconds responseTimeout)
+        : connection_(std::move(connection)), responseTimeout_(responseTimeout), expectedUntil_(), waiting_(0), discarded_(0),
+          nextId_(0), errorHandler_(), running_(false), reading_(false)
+    {
+    }
+
+    AmpReader::~AmpReader()
+    {
+        stop();
+    }
+
+    void AmpReader::start()
+    {
+        if (running_.exchange(true) == true)
+        {
+            return;
+        }
+        reading_ = true;
+        reader_ = std::thread{&AmpReader::readLoop, this};
+    }
+
+    void AmpReader::stop()
+    {
+        running_ = false;
+
+        if (reader_.joinable() == true)
+        {
+            reader_.join();
+        }
+        responseReady_.notify_all();
+    }
+
+    bool AmpReader::isRunning() const
+    {
+        return reading_;
+    }
+
+    void AmpReader::close()
+    {
+        stop();
+        connection_->close();
+    }
+
+    bool AmpReader::isOpen() const
+    {
+        return connection_->isOpen();
+    }
+
+    std::vector<std::uint8_t> AmpReader::receive(std::size_t recvSize)
+    {
+        if (reading_ == false)
+        {
+            auto data = connection_->receive(recvSize);
+
+            if (data.empty() == true)
+            {
+                responseTimeouts().add();
+            }
+            return data;
+        }
+
+        std::unique_lock<std::mutex> lock{mutex_};
+        ++waiting_;
+        const bool ready = responseReady_.wait_for(lock, responseTimeout_, [this] { return (responses_.empty() == false) || (reading_ == false); });
+        --waiting_;
+        expectedUntil_ = Clock::now() + responseTimeout_;
+
+        if (ready == false)
+        {
+            responseTimeouts().add();
+            return {};
+        }
+        if (responses_.empty() == true)
+        {
+            return {};
+        }
+
+        auto data = std::move(responses_.front().data);
+        responses_.pop_front();
+        data.resize(std::min(data.size(), recvSize));
+        return data;
+    }
+
+    std::size_t AmpReader::subscribe(Subscriber subscriber)
+    {
+        std::lock_guard<std::mutex> lock{subscriberMutex_};
+        subscribers_.emplace_back(nextId_, std::move(subscriber));
+        return nextId_++;
+    }
+
+    void AmpReader::unsubscribe(std::size_t id)
+    {
+        std::lock_guard<std::mutex> lock{subscriberMutex_};
+        subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(), [id](const auto& s) { return s.first == id; }), subscribers_.end());
+    }
+
+    void AmpReader::setErrorHandler(ErrorHandler handler)
+    {
+        errorHandler_ = std::move(handler);
+    }
+
+    std::size_t AmpReader::discarded() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return discarded_;
+    }
+
+    std::size_t AmpReader::sendImpl(std::uint8_t* data, std::size_t size)
+    {
+        if (reading_ == true)
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            const auto now = Clock::now();
+            const auto stale = std::find_if(responses_.cbegin(), responses_.cend(), [this, now](const auto& r) { return (now - r.received) < responseTimeout_; });
+
+            discarded_ += static_cast<std::size_t>(std::distance(responses_.cbegin(), stale));
+            responses_.erase(responses_.cbegin(), stale);
+            expectedUntil_ = now + responseTimeout_;
+        }
+        return connection_->send(RawBuffer{data, size});
+    }
+
+    void AmpReader::readLoop()
+    {
+        while (running_ == true)
+        {
+            try
+            {
+                auto packet = connection_->receive(packetRawTypeSize);
+
+                if (packet.empty() == false)
+                {
+                    route(std::move(packet));
+                }
+            }
+            catch (const std::exception& ex)
+            {
+                if (errorHandler_)
+                {
+                    errorHandler_(ex);
+                }
+                break;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            reading_ = false;
+        }
+        responseReady_.notify_all();
+    }
+
+    void AmpReader::route(std::vector<std::uint8_t> packet)
+    {
+        const auto header = headerOf(packet);
+
+        if (header.has_value() && isFrontPanelChange(*header))
+        {
+            if (const auto change = decodeStateChange(packet); change)
+            {
+                publish(*change);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            const auto now = Clock::now();
+
+            if ((waiting_ > 0) || (now < expectedUntil_))
+            {
+                responses_.push_back(Response{now, std::move(packet)});
+                expectedUntil_ = now + responseTimeout_;
+                responseReady_.notify_one();
+                return;
+            }
+        }
+
+        // Nothing was requested, e.g. a preset selected on the amp
+        if (const auto change = decodeStateChange(packet); change)
+        {
+            publish(*change);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            ++discarded_;
+        }
+    }
+
+    void AmpReader::publish(const StateChange& change)
+    {
+        std::vector<std::pair<std::size_t, Subscriber>> subscribers;
+        {
+            std::lock_guard<std::mutex> lock{subscriberMutex_};
+            subscribers = subscribers_;
+        }
+
+        for (const auto& subscriber : subscribers)
+        {
+            subscriber.second(change);
+        }
+    }
+}
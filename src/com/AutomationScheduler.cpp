@@ -0,0 +1,265 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/AutomationScheduler.h"
+#include "com/Mustang.h"
+#include "metrics/Metrics.h"
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <cmath>
+
+namespace plug::com
+{
+    namespace
+    {
+        // The OS timer is only trusted up to this point, the rest is spun
+        inline constexpr std::chrono::milliseconds spinThreshold{2};
+        inline constexpr std::size_t keyCount{5};
+
+        CommandKey keyOf(const ControlEvent& change)
+        {
+            return (change.target == ControlTarget::amp ? ampKey : effectKey(change.slot));
+        }
+
+        bool sameParameter(const ControlEvent& a, const ControlEvent& b)
+        {
+            return (a.target == b.target) && (a.parameter == b.parameter) && ((a.target == ControlTarget::amp) || ((a.slot % 4) == (b.slot % 4)));
+        }
+
+        metrics::Histogram& jitterHistogram()
+        {
+            static auto& histogram = metrics::Registry::global().histogram("plug_automation_jitter_seconds", "Delay between scheduled and actual automation writes");
+            return histogram;
+        }
+    }
+
+
+    // Shared with the posted writes, which may outlive the scheduler
+    struct AutomationScheduler::Dispatch
+    {
+        struct Pending
+        {
+            std::size_t event;
+            Clock::time_point scheduled;
+        };
+
+        // Records all changes pending for the key as delivered now
+        void deliver(CommandKey key)
+        {
+            const auto now = Clock::now();
+            std::lock_guard<std::mutex> lock{mutex};
+            auto& keyPending = pending[static_cast<std::size_t>(key - ampKey)];
+
+            for (const auto& p : keyPending)
+            {
+                const auto jitter = now - p.scheduled;
+                jitterHistogram().observe(jitter);
+                records.push_back({p.event, std::chrono::duration_cast<std::chrono::nanoseconds>(jitter)});
+            }
+            keyPending.clear();
+        }
+
+        mutable std::mutex mutex;
+        std::array<std::vector<Pending>, keyCount> pending;
+        std::vector<DispatchRecord> records;
+    };
+
+
+    std::chrono::nanoseconds Tempo::at(unsigned bar, double beat) const
+    {
+        if ((beatsPerMinute <= 0.0) || (beatsPerBar == 0) || (bar == 0) || (beat < 1.0))
+        {
+            throw std::invalid_argument{"Invalid musical time"};
+        }
+        const double beats = static_cast<double>(bar - 1) * beatsPerBar + (beat - 1.0);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>{beats * 60.0 / beatsPerMinute});
+    }
+
+    AutomationEvent setAt(std::chrono::nanoseconds at, ControlEvent change)
+    {
+        return {at, change, std::chrono::nanoseconds::zero(), change.value};
+    }
+
+    AutomationEvent rampAt(std::chrono::nanoseconds at, ControlEvent change, std::uint8_t from, std::chrono::nanoseconds duration)
+    {
+        return {at, change, duration, from};
+    }
+
+
+    AutomationScheduler::AutomationScheduler(CommandQueue& queue, const SignalChain& current, std::chrono::nanoseconds rampInterval)
+        : rampInterval_(rampInterval), dispatch_(std::make_shared<Dispatch>()),
+          writer_(queue, current, [dispatch = dispatch_](CommandKey key) { dispatch->deliver(key); }), running_(false)
+    {
+    }
+
+    AutomationScheduler::~AutomationScheduler()
+    {
+        stop();
+    }
+
+    void AutomationScheduler::start(std::vector<AutomationEvent> timeline, Clock::time_point origin)
+    {
+        if (std::any_of(timeline.cbegin(), timeline.cend(), [](const auto& e) { return e.change.target == ControlTarget::preset; }))
+        {
+            throw std::invalid_argument{"Preset loads can't be automated"};
+        }
+
+        stop();
+
+        std::vector<Scheduled> scheduled;
+        scheduled.reserve(timeline.size());
+
+        for (std::size_t i = 0; i < timeline.size(); ++i)
+        {
+            scheduled.push_back({i, timeline[i]});
+        }
+        std::stable_sort(scheduled.begin(), scheduled.end(), [](const auto& a, const auto& b) { return a.event.at < b.event.at; });
+
+        running_ = true;
+        timer_ = std::thread{&AutomationScheduler::run, this, std::move(scheduled), origin};
+    }
+
+    void AutomationScheduler::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock{wakeMutex_};
+            running_ = false;
+        }
+        wakeUp_.notify_one();
+        wait();
+    }
+
+    bool AutomationScheduler::isRunning() const
+    {
+        return running_;
+    }
+
+    void AutomationScheduler::wait()
+    {
+        if (timer_.joinable() == true)
+        {
+            timer_.join();
+        }
+    }
+
+    void AutomationScheduler::update(const SignalChain& chain)
+    {
+        writer_.update(chain);
+    }
+
+    std::vector<DispatchRecord> AutomationScheduler::dispatched() const
+    {
+        std::lock_guard<std::mutex> lock{dispatch_->mutex};
+        return dispatch_->records;
+    }
+
+    void AutomationScheduler::run(std::vector<Scheduled> timeline, Clock::time_point origin)
+    {
+        std::vector<Ramp> ramps;
+        auto next = timeline.cbegin();
+        auto tick = Clock::time_point::max();
+
+        while ((next != timeline.cend()) || (ramps.empty() == false))
+        {
+            const auto due = (next != timeline.cend() ? std::min(tick, origin + next->event.at) : tick);
+
+            if (sleepUntil(due) == false)
+            {
+                return;
+            }
+
+            const auto now = Clock::now();
+
+            writer_.write([&](ControlState& state, bool updated) {
+                if (updated == true)
+                {
+                    // Running ramps write their parameter again on top of the new settings
+                    for (auto& ramp : ramps)
+                    {
+                        ramp.last = -1;
+                    }
+                }
+
+                for (; (next != timeline.cend()) && (origin + next->event.at <= now); ++next)
+                {
+                    const auto& event = next->event;
+                    const auto scheduled = origin + event.at;
+
+                    {
+                        std::lock_guard<std::mutex> lock{dispatch_->mutex};
+                        dispatch_->pending[keyOf(event.change) - ampKey].push_back({next->index, scheduled});
+                    }
+
+                    // A newer change of a parameter takes over from its ramp
+                    ramps.erase(std::remove_if(ramps.begin(), ramps.end(), [&event](const auto& r) { return sameParameter(r.change, event.change); }), ramps.end());
+
+                    if (event.ramp > std::chrono::nanoseconds::zero())
+                    {
+                        ramps.push_back({scheduled, scheduled + event.ramp, event.change, event.from, -1});
+                    }
+                    else
+                    {
+                        state.apply(event.change);
+                    }
+                }
+
+                updateRamps(ramps, state, now);
+            });
+
+            tick = (ramps.empty() == true ? Clock::time_point::max() : now + rampInterval_);
+        }
+        running_ = false;
+    }
+
+    bool AutomationScheduler::sleepUntil(Clock::time_point due)
+    {
+        if (due - Clock::now() > spinThreshold)
+        {
+            std::unique_lock<std::mutex> lock{wakeMutex_};
+            wakeUp_.wait_until(lock, due - spinThreshold, [this] { return running_ == false; });
+        }
+
+        while ((running_ == true) && (Clock::now() < due))
+        {
+            std::this_thread::yield();
+        }
+        return running_;
+    }
+
+    void AutomationScheduler::updateRamps(std::vector<Ramp>& ramps, ControlState& state, Clock::time_point now)
+    {
+        for (auto& ramp : ramps)
+        {
+            const double progress = (now >= ramp.end ? 1.0 : std::chrono::duration<double>(now - ramp.begin) / std::chrono::duration<double>(ramp.end - ramp.begin));
+            const int value = ramp.from + static_cast<int>(std::lround(progress * (ramp.change.value - ramp.from)));
+
+            if (value != ramp.last)
+            {
+                auto change = ramp.change;
+                change.value = static_cast<std::uint8_t>(value);
+                state.apply(change);
+                ramp.last = value;
+            }
+        }
+        ramps.erase(std::remove_if(ramps.begin(), ramps.end(), [now](const auto& r) { return now >= r.end; }), ramps.end());
+    }
+}
@@ -0,0 +1,184 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/AutomationTimeline.h"
+#include "com/OscMessage.h"
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace plug::com
+{
+    namespace
+    {
+        inline constexpr Tempo defaultTempo{120.0, 4};
+
+
+        std::vector<std::string_view> splitWords(std::string_view line)
+        {
+            std::vector<std::string_view> words;
+
+            while (line.empty() == false)
+            {
+                const auto begin = line.find_first_not_of(" \t\r");
+
+                if (begin == std::string_view::npos)
+                {
+                    break;
+                }
+                line.remove_prefix(begin);
+                const auto end = std::min(line.find_first_of(" \t\r"), line.size());
+                words.push_back(line.substr(0, end));
+                line.remove_prefix(end);
+            }
+            return words;
+        }
+
+        template <class T>
+        std::optional<T> parseNumber(std::string_view text)
+        {
+            T value{};
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+            if ((error != std::errc{}) || (end != text.data() + text.size()))
+            {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        std::optional<std::uint8_t> parseValue(std::string_view text)
+        {
+            const auto value = parseNumber<int>(text);
+
+            if ((value.has_value() == false) || (*value < 0) || (*value > 0xff))
+            {
+                return std::nullopt;
+            }
+            return static_cast<std::uint8_t>(*value);
+        }
+
+        std::chrono::nanoseconds parseTime(const Tempo& tempo, std::string_view text)
+        {
+            const auto separator = text.find(':');
+            const auto bar = parseNumber<unsigned>(text.substr(0, separator));
+            const auto beat = (separator == std::string_view::npos ? std::optional{1.0} : parseNumber<double>(text.substr(separator + 1)));
+
+            if ((bar.has_value() == false) || (beat.has_value() == false))
+            {
+                throw std::invalid_argument{"Invalid musical time"};
+            }
+            return tempo.at(*bar, *beat);
+        }
+
+        ControlEvent parseChange(std::string_view address, std::uint8_t value)
+        {
+            const auto change = osc::toControlEvent(osc::Message{std::string{address}, {std::int32_t{value}}});
+
+            if (change.has_value() == false)
+            {
+                throw std::invalid_argument{"Invalid parameter " + std::string{address}};
+            }
+            if (change->target == ControlTarget::preset)
+            {
+                throw std::invalid_argument{"Preset loads can't be automated"};
+            }
+            return *change;
+        }
+
+        AutomationEvent parseEvent(const Tempo& tempo, const std::vector<std::string_view>& words)
+        {
+            const auto at = parseTime(tempo, words[0]);
+
+            if (words.size() == 3)
+            {
+                const auto value = parseValue(words[2]);
+
+                if (value.has_value() == false)
+                {
+                    throw std::invalid_argument{"Invalid value"};
+                }
+                return setAt(at, parseChange(words[1], *value));
+            }
+
+            const auto range = words[2].find("..");
+            const auto from = parseValue(words[2].substr(0, range));
+            const auto to = (range == std::string_view::npos ? std::nullopt : parseValue(words[2].substr(range + 2)));
+            const auto seconds = ((words[3].size() > 1) && (words[3].back() == 's') ? parseNumber<double>(words[3].substr(0, words[3].size() - 1)) : std::nullopt);
+
+            if ((from.has_value() == false) || (to.has_value() == false) || (seconds.has_value() == false) || (*seconds <= 0.0))
+            {
+                throw std::invalid_argument{"Invalid ramp"};
+            }
+            const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>{*seconds});
+            return rampAt(at, parseChange(words[1], *to), *from, duration);
+        }
+    }
+
+
+    std::vector<AutomationEvent> parseTimeline(std::string_view text)
+    {
+        std::vector<AutomationEvent> timeline;
+        Tempo tempo{defaultTempo};
+        std::size_t lineNumber{0};
+
+        while (text.empty() == false)
+        {
+            const auto end = std::min(text.find('\n'), text.size());
+            const auto line = text.substr(0, std::min(text.find('#'), end));
+            text.remove_prefix(std::min(end + 1, text.size()));
+            ++lineNumber;
+
+            const auto words = splitWords(line);
+
+            try
+            {
+                if (words.empty() == true)
+                {
+                    continue;
+                }
+                if (words[0] == "tempo")
+                {
+                    const auto bpm = (words.size() == 3 ? parseNumber<double>(words[1]) : std::nullopt);
+                    const auto beatsPerBar = (words.size() == 3 ? parseNumber<unsigned>(words[2]) : std::nullopt);
+
+                    if ((timeline.empty() == false) || (bpm.has_value() == false) || (beatsPerBar.has_value() == false) || (*bpm <= 0.0) || (*beatsPerBar == 0))
+                    {
+                        throw std::invalid_argument{"Invalid tempo"};
+                    }
+                    tempo = Tempo{*bpm, *beatsPerBar};
+                    continue;
+                }
+                if ((words.size() != 3) && (words.size() != 4))
+                {
+                    throw std::invalid_argument{"Expected time, address and value"};
+                }
+                timeline.push_back(parseEvent(tempo, words));
+            }
+            catch (const std::invalid_argument& ex)
+            {
+                throw std::runtime_error{"Line " + std::to_string(lineNumber) + ": " + ex.what()};
+            }
+        }
+        return timeline;
+    }
+}
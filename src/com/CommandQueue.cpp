@@ -0,0 +1,226 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/CommandQueue.h"
+#include "com/Mustang.h"
+#include "metrics/Metrics.h"
+#include "metrics/Trace.h"
+#include <algorithm>
+
+namespace plug::com
+{
+    namespace
+    {
+        constexpr std::size_t indexOf(CommandPriority priority)
+        {
+            return static_cast<std::size_t>(priority);
+        }
+
+        metrics::Counter& supersededCounter()
+        {
+            static auto& counter = metrics::Registry::global().counter("plug_commands_superseded_total", "Queued amp commands replaced by newer ones");
+            return counter;
+        }
+    }
+
+
+    CommandQueue::CommandQueue(Mustang& mustang)
+        : mustang_(mustang), incoming_(nullptr), pending_(), keyed_(), superseded_(0), errorHandler_(), running_(false), sleeping_(false)
+    {
+    }
+
+    CommandQueue::~CommandQueue()
+    {
+        stop();
+        collect();
+        discard();
+    }
+
+    void CommandQueue::start()
+    {
+        if (running_.exchange(true) == true)
+        {
+            return;
+        }
+        consumer_ = std::thread{&CommandQueue::run, this};
+    }
+
+    void CommandQueue::stop()
+    {
+        if (running_.exchange(false) == false)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{wakeMutex_};
+        }
+        wakeUp_.notify_one();
+        consumer_.join();
+    }
+
+    bool CommandQueue::isRunning() const
+    {
+        return running_;
+    }
+
+    void CommandQueue::post(CommandPriority priority, CommandKey key, Command command)
+    {
+        auto node = new Node{priority, key, std::move(command), incoming_.load(std::memory_order_relaxed)};
+
+        while (incoming_.compare_exchange_weak(node->next, node, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+        {
+        }
+
+        // The consumer only needs a wake-up if it's about to sleep
+        if (sleeping_.load(std::memory_order_seq_cst) == true)
+        {
+            {
+                std::lock_guard<std::mutex> lock{wakeMutex_};
+            }
+            wakeUp_.notify_one();
+        }
+    }
+
+    void CommandQueue::setErrorHandler(ErrorHandler handler)
+    {
+        errorHandler_ = std::move(handler);
+    }
+
+    std::size_t CommandQueue::superseded() const
+    {
+        return superseded_;
+    }
+
+    void CommandQueue::run()
+    {
+        while (running_ == true)
+        {
+            collect();
+
+            if (hasPending() == false)
+            {
+                std::unique_lock<std::mutex> lock{wakeMutex_};
+                sleeping_.store(true, std::memory_order_seq_cst);
+                wakeUp_.wait(lock, [this] { return (incoming_.load(std::memory_order_seq_cst) != nullptr) || (running_ == false); });
+                sleeping_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            // New commands are sorted in before each command is sent
+            auto& queue = *std::find_if(pending_.begin(), pending_.end(), [](const auto& p) { return p.empty() == false; });
+            const auto priority = static_cast<std::size_t>(std::distance(pending_.data(), &queue));
+            auto command = std::move(queue.front().command);
+
+            if (queue.front().key != unkeyed)
+            {
+                keyed_[priority].erase(queue.front().key);
+            }
+            queue.pop_front();
+            execute(command);
+        }
+        discard();
+    }
+
+    void CommandQueue::collect()
+    {
+        Node* node = incoming_.exchange(nullptr, std::memory_order_acquire);
+        Node* ordered{nullptr};
+
+        // Stack order is newest first
+        while (node != nullptr)
+        {
+            Node* next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+        }
+
+        while (ordered != nullptr)
+        {
+            std::unique_ptr<Node> current{ordered};
+            ordered = current->next;
+            merge(*current);
+        }
+    }
+
+    void CommandQueue::merge(Node& node)
+    {
+        const auto priority = indexOf(node.priority);
+
+        if (node.priority == CommandPriority::preset)
+        {
+            // Settings queued before a preset change are obsolete
+            auto& settings = pending_[indexOf(CommandPriority::setting)];
+            const auto before = settings.size();
+            settings.remove_if([](const Pending& p) { return p.key != unkeyed; });
+            keyed_[indexOf(CommandPriority::setting)].clear();
+            superseded_ += before - settings.size();
+            supersededCounter().add(before - settings.size());
+        }
+
+        if (node.key != unkeyed)
+        {
+            if (const auto itr = keyed_[priority].find(node.key); itr != keyed_[priority].end())
+            {
+                itr->second->command = std::move(node.command);
+                ++superseded_;
+                supersededCounter().add();
+                return;
+            }
+        }
+
+        auto& queue = pending_[priority];
+        queue.push_back(Pending{node.key, std::move(node.command)});
+
+        if (node.key != unkeyed)
+        {
+            keyed_[priority][node.key] = std::prev(queue.end());
+        }
+    }
+
+    bool CommandQueue::hasPending() const
+    {
+        return std::any_of(pending_.cbegin(), pending_.cend(), [](const auto& p) { return p.empty() == false; });
+    }
+
+    void CommandQueue::execute(Command& command)
+    {
+        PLUG_TRACE_SPAN("queue", "CommandQueue::execute");
+
+        try
+        {
+            command(mustang_);
+        }
+        catch (const std::exception& ex)
+        {
+            if (errorHandler_)
+            {
+                errorHandler_(ex);
+            }
+        }
+    }
+
+    void CommandQueue::discard()
+    {
+        std::for_each(pending_.begin(), pending_.end(), [](auto& p) { p.clear(); });
+        std::for_each(keyed_.begin(), keyed_.end(), [](auto& k) { k.clear(); });
+    }
+}
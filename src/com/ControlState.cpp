@@ -0,0 +1,206 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/ControlState.h"
+#include <algorithm>
+
+namespace plug::com
+{
+    ControlState::ControlState(const SignalChain& chain)
+        : amp_(), effects_(), ampChanged_(false), effectChanged_(), replaced_()
+    {
+        reset(chain);
+    }
+
+    void ControlState::apply(const ControlEvent& event)
+    {
+        switch (event.target)
+        {
+            case ControlTarget::amp:
+                applyAmp(static_cast<AmpParameter>(event.parameter), event.value);
+                break;
+            case ControlTarget::effect:
+                applyEffect(event.slot % effects_.size(), static_cast<EffectParameter>(event.parameter), event.value);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void ControlState::reset(const SignalChain& chain)
+    {
+        amp_ = chain.amp();
+
+        for (std::size_t i = 0; i < effects_.size(); ++i)
+        {
+            effects_[i] = fx_pedal_settings{};
+            effects_[i].fx_slot = static_cast<std::uint8_t>(i);
+            effects_[i].effect_num = effects::EMPTY;
+            effects_[i].position = Position::input;
+        }
+
+        for (const auto& effect : chain.effects())
+        {
+            effects_[effect.fx_slot % effects_.size()] = effect;
+        }
+        clearChanges();
+    }
+
+    const amp_settings& ControlState::amp() const
+    {
+        return amp_;
+    }
+
+    const fx_pedal_settings& ControlState::effect(std::size_t slot) const
+    {
+        return effects_[slot];
+    }
+
+    bool ControlState::hasChanges() const
+    {
+        return ampChanged_ || std::any_of(effectChanged_.cbegin(), effectChanged_.cend(), [](bool changed) { return changed; });
+    }
+
+    bool ControlState::ampChanged() const
+    {
+        return ampChanged_;
+    }
+
+    bool ControlState::effectChanged(std::size_t slot) const
+    {
+        return effectChanged_[slot];
+    }
+
+    std::optional<fx_pedal_settings> ControlState::replacedEffect(std::size_t slot) const
+    {
+        return replaced_[slot];
+    }
+
+    void ControlState::clearChanges()
+    {
+        ampChanged_ = false;
+        effectChanged_.fill(false);
+        replaced_.fill(std::nullopt);
+    }
+
+    void ControlState::applyAmp(AmpParameter parameter, std::uint8_t value)
+    {
+        switch (parameter)
+        {
+            case AmpParameter::model:
+                amp_.amp_num = static_cast<amps>(value);
+                break;
+            case AmpParameter::gain:
+                amp_.gain = value;
+                break;
+            case AmpParameter::volume:
+                amp_.volume = value;
+                break;
+            case AmpParameter::treble:
+                amp_.treble = value;
+                break;
+            case AmpParameter::middle:
+                amp_.middle = value;
+                break;
+            case AmpParameter::bass:
+                amp_.bass = value;
+                break;
+            case AmpParameter::cabinet:
+                amp_.cabinet = static_cast<cabinets>(value);
+                break;
+            case AmpParameter::noiseGate:
+                amp_.noise_gate = value;
+                break;
+            case AmpParameter::masterVolume:
+                amp_.master_vol = value;
+                break;
+            case AmpParameter::gain2:
+                amp_.gain2 = value;
+                break;
+            case AmpParameter::presence:
+                amp_.presence = value;
+                break;
+            case AmpParameter::threshold:
+                amp_.threshold = value;
+                break;
+            case AmpParameter::depth:
+                amp_.depth = value;
+                break;
+            case AmpParameter::bias:
+                amp_.bias = value;
+                break;
+            case AmpParameter::sag:
+                amp_.sag = value;
+                break;
+            case AmpParameter::brightness:
+                amp_.brightness = (value != 0);
+                break;
+            case AmpParameter::usbGain:
+                amp_.usb_gain = value;
+                break;
+            default:
+                return;
+        }
+        ampChanged_ = true;
+    }
+
+    void ControlState::applyEffect(std::size_t slot, EffectParameter parameter, std::uint8_t value)
+    {
+        auto& effect = effects_[slot];
+
+        switch (parameter)
+        {
+            case EffectParameter::model:
+                if ((replaced_[slot].has_value() == false) && (effect.effect_num != static_cast<effects>(value)))
+                {
+                    replaced_[slot] = effect;
+                }
+                effect.effect_num = static_cast<effects>(value);
+                break;
+            case EffectParameter::knob1:
+                effect.knob1 = value;
+                break;
+            case EffectParameter::knob2:
+                effect.knob2 = value;
+                break;
+            case EffectParameter::knob3:
+                effect.knob3 = value;
+                break;
+            case EffectParameter::knob4:
+                effect.knob4 = value;
+                break;
+            case EffectParameter::knob5:
+                effect.knob5 = value;
+                break;
+            case EffectParameter::knob6:
+                effect.knob6 = value;
+                break;
+            case EffectParameter::position:
+                effect.position = (value != 0 ? Position::effectsLoop : Position::input);
+                break;
+            case EffectParameter::enabled:
+                effect.enabled = (value != 0);
+                break;
+            default:
+                return;
+        }
+        effectChanged_[slot] = true;
+    }
+}
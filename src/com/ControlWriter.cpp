@@ -0,0 +1,160 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/ControlWriter.h"
+#include "com/Mustang.h"
+#include "EffectDescriptor.h"
+#include <array>
+#include <mutex>
+#include <optional>
+
+namespace plug::com
+{
+    // Shared with the posted commands, which may outlive the writer.
+    // Holds the latest settings, the writes read them when they run.
+    struct ControlWriter::Outbox
+    {
+        struct EffectWrite
+        {
+            std::optional<fx_pedal_settings> cleared;
+            fx_pedal_settings effect;
+        };
+
+        explicit Outbox(DeliveryHandler handler)
+            : onDelivery(std::move(handler))
+        {
+        }
+
+        amp_settings deliverAmp()
+        {
+            delivered(ampKey);
+            std::lock_guard<std::mutex> lock{mutex};
+            return amp;
+        }
+
+        EffectWrite deliverEffect(std::size_t slot)
+        {
+            delivered(effectKey(static_cast<std::uint8_t>(slot)));
+            std::lock_guard<std::mutex> lock{mutex};
+
+            EffectWrite write{std::nullopt, effects[slot]};
+            write.cleared.swap(clears[slot]);
+            return write;
+        }
+
+        void delivered(CommandKey key) const
+        {
+            if (onDelivery)
+            {
+                onDelivery(key);
+            }
+        }
+
+        // The lock is held by the caller
+        void store(const ControlState& state)
+        {
+            amp = state.amp();
+
+            for (std::size_t i = 0; i < effects.size(); ++i)
+            {
+                effects[i] = state.effect(i);
+            }
+        }
+
+        const DeliveryHandler onDelivery;
+        std::mutex mutex;
+        amp_settings amp;
+        std::array<fx_pedal_settings, 4> effects;
+        std::array<std::optional<fx_pedal_settings>, 4> clears;
+        std::optional<SignalChain> updated;
+    };
+
+
+    ControlWriter::ControlWriter(CommandQueue& queue, const SignalChain& current, DeliveryHandler onDelivery)
+        : queue_(queue), state_(current), outbox_(std::make_shared<Outbox>(std::move(onDelivery)))
+    {
+        outbox_->store(state_);
+    }
+
+    void ControlWriter::write(const Changes& changes)
+    {
+        std::lock_guard<std::mutex> lock{outbox_->mutex};
+        const bool updated = outbox_->updated.has_value();
+
+        if (updated == true)
+        {
+            state_.reset(*outbox_->updated);
+            outbox_->updated.reset();
+        }
+
+        changes(state_, updated);
+
+        if (state_.ampChanged() == true)
+        {
+            queue_.post(CommandPriority::setting, ampKey, [outbox = outbox_](Mustang& mustang) { mustang.set_amplifier(outbox->deliverAmp()); });
+        }
+
+        for (std::size_t i = 0; i < outbox_->effects.size(); ++i)
+        {
+            if (state_.effectChanged(i) == false)
+            {
+                continue;
+            }
+
+            const auto& effect = state_.effect(i);
+
+            // The first replaced effect is still on the amp until a write of the slot ran
+            if (const auto replaced = state_.replacedEffect(i); replaced && (describe(replaced->effect_num).family != EffectFamily::none) && (describe(replaced->effect_num).family != describe(effect.effect_num).family))
+            {
+                if (outbox_->clears[i].has_value() == false)
+                {
+                    outbox_->clears[i] = replaced;
+                    outbox_->clears[i]->enabled = false;
+                }
+            }
+
+            queue_.post(CommandPriority::setting, effectKey(static_cast<std::uint8_t>(i)), [outbox = outbox_, slot = i](Mustang& mustang) {
+                const auto write = outbox->deliverEffect(slot);
+
+                if (write.cleared.has_value() == true)
+                {
+                    mustang.set_effect(*write.cleared);
+                }
+                mustang.set_effect(write.effect);
+            });
+        }
+
+        outbox_->store(state_);
+        state_.clearChanges();
+    }
+
+    void ControlWriter::update(const SignalChain& chain)
+    {
+        const ControlState synced{chain};
+        std::lock_guard<std::mutex> lock{outbox_->mutex};
+
+        // Writes still queued carry the new values, the state is rebased
+        // before the next changes. The new settings are on the amp already,
+        // nothing is left to clear.
+        outbox_->store(synced);
+        outbox_->clears = {};
+        outbox_->updated = chain;
+    }
+}
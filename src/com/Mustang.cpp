@@ -23,11 +23,157 @@
 #include "com/PacketSerializer.h"
 #include "com/CommunicationException.h"
 #include "com/Packet.h"
+#include "metrics/Metrics.h"
+#include "metrics/StartupProfile.h"
+#include "metrics/Trace.h"
 #include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
 
 namespace plug::com
 {
-    SignalChain decode_data(const std::array<PacketRawType, 7>& data)
+    namespace
+    {
+        // Number of requests in flight during backup and restore
+        inline constexpr std::size_t pipelineDepth{8};
+        inline constexpr std::size_t maxSlots{256};
+
+        SettingsData settingsPackets(const PresetData& data)
+        {
+            constexpr std::array<DSP, 6> targets{{DSP::amp, DSP::effect0, DSP::effect1, DSP::effect2, DSP::effect3, DSP::usbGain}};
+            SettingsData packets{{}};
+
+            for (std::size_t i = 0; i < targets.size(); ++i)
+            {
+                auto packet = fromRawData<EmptyPayload>(data[i + 1]);
+                Header header = packet.getHeader();
+                header.setStage(Stage::ready);
+                header.setType(Type::data);
+                header.setDSP(targets[i]);
+                header.setSlot(0x00);
+                header.setUnknown(0x00, 0x01, 0x01);
+                packet.setHeader(header);
+                packets[i] = packet.getBytes();
+            }
+            return packets;
+        }
+
+        // Whether the packet is at its place in the data sent for a slot:
+        // name, amp, the four effect DSPs (none if empty) and USB gain.
+        bool isPresetPacket(const std::vector<std::uint8_t>& packet, std::size_t index, std::uint8_t slot)
+        {
+            if (packet.size() != packetRawTypeSize)
+            {
+                return false;
+            }
+
+            Header::RawType bytes{};
+            std::copy_n(packet.cbegin(), bytes.size(), bytes.begin());
+            Header header{};
+            header.fromBytes(bytes);
+
+            try
+            {
+                const auto dsp = header.getDSP();
+
+                switch (index)
+                {
+                    case 0:
+                        return ((dsp == DSP::opSave) || (dsp == DSP::opSaveEffectName)) && (header.getSlot() == slot);
+                    case 1:
+                        return dsp == DSP::amp;
+                    case 6:
+                        return dsp == DSP::usbGain;
+                    default:
+                        return (dsp == DSP::none) || (dsp == DSP::effect0) || (dsp == DSP::effect1) || (dsp == DSP::effect2) || (dsp == DSP::effect3);
+                }
+            }
+            catch (const std::domain_error&)
+            {
+                return false;
+            }
+        }
+
+        // All packets and the apply command are sent before the first ack is
+        // read, so the change takes effect within a single round trip
+        template <class Iterator>
+        void sendSettings(Connection& conn, Iterator first, Iterator last)
+        {
+            if (first == last)
+            {
+                return;
+            }
+
+            PLUG_TRACE_SPAN("protocol", "sendSettings");
+            const auto count = static_cast<std::size_t>(std::distance(first, last));
+            std::for_each(first, last, [&conn](const auto& packet) { conn.send(packet); });
+            conn.send(serializeApplyCommand().getBytes());
+
+            for (std::size_t i = 0; i < count + 1; ++i)
+            {
+                conn.receive(packetRawTypeSize);
+            }
+        }
+
+        enum class Operation
+        {
+            start,
+            setEffect,
+            setAmplifier,
+            save,
+            load,
+            applyPreset,
+            applySettings,
+            backup,
+            restore,
+            saveEffects
+        };
+
+        inline constexpr std::array<const char*, 10> operationNames{{"start", "set_effect", "set_amplifier", "save", "load",
+                                                                      "apply_preset", "apply_settings", "backup", "restore", "save_effects"}};
+
+        struct OperationMetrics
+        {
+            metrics::Histogram* latency;
+            metrics::Counter* errors;
+        };
+
+        metrics::ScopedTimer timeOperation(Operation op)
+        {
+            static const auto table = [] {
+                auto& registry = metrics::Registry::global();
+                std::array<OperationMetrics, operationNames.size()> entries{};
+
+                for (std::size_t i = 0; i < entries.size(); ++i)
+                {
+                    const metrics::Labels labels{{"operation", operationNames[i]}};
+                    entries[i] = {&registry.histogram("plug_amp_operation_seconds", "Duration of amp operations", labels),
+                                  &registry.counter("plug_amp_operation_errors_total", "Failed amp operations", labels)};
+                }
+                return entries;
+            }();
+
+            const auto& entry = table[static_cast<std::size_t>(op)];
+            return metrics::ScopedTimer{*entry.latency, entry.errors};
+        }
+
+        metrics::Gauge& connectedGauge()
+        {
+            static auto& gauge = metrics::Registry::global().gauge("plug_amp_connected", "Whether an amp is connected");
+            return gauge;
+        }
+
+        void reportProgress(const ProgressCallback& progress, std::size_t done, std::size_t total)
+        {
+            if (progress)
+            {
+                progress(done, total);
+            }
+        }
+    }
+
+    SignalChain decode_data(const PresetData& data)
     {
         const auto name = decodeNameFromData(fromRawData<NamePayload>(data[0]));
         const auto amp = decodeAmpFromData(fromRawData<AmpPayload>(data[1]), fromRawData<AmpPayload>(data[6]));
@@ -37,6 +183,53 @@ namespace plug::com
         return SignalChain{name, amp, effects};
     }
 
+    PresetData encode_data(const SignalChain& chain)
+    {
+        constexpr std::array<DSP, 4> families{{DSP::effect0, DSP::effect1, DSP::effect2, DSP::effect3}};
+        PresetData data{{}};
+        std::array<bool, 4> used{{}};
+        std::vector<PacketRawType> unassigned;
+
+        data[0] = serializeName(0, chain.name()).getBytes();
+        data[1] = serializeAmpSettings(chain.amp()).getBytes();
+        data[6] = serializeAmpSettingsUsbGain(chain.amp()).getBytes();
+
+        // Effects are ordered by DSP like the data sent by the amp
+        for (const auto& effect : chain.effects())
+        {
+            const auto packet = serializeEffectSettings(effect);
+            const auto family = std::find(families.cbegin(), families.cend(), packet.getHeader().getDSP());
+            const auto index = static_cast<std::size_t>(std::distance(families.cbegin(), family));
+
+            if ((family != families.cend()) && (used[index] == false))
+            {
+                data[index + 2] = packet.getBytes();
+                used[index] = true;
+            }
+            else
+            {
+                unassigned.push_back(packet.getBytes());
+            }
+        }
+
+        auto next = unassigned.cbegin();
+
+        for (std::size_t i = 0; (i < used.size()) && (next != unassigned.cend()); ++i)
+        {
+            if (used[i] == false)
+            {
+                data[i + 2] = *next++;
+            }
+        }
+        return data;
+    }
+
+    SettingsData encode_settings(const SignalChain& chain)
+    {
+        PLUG_TRACE_SPAN("protocol", "encode_settings");
+        return settingsPackets(encode_data(chain));
+    }
+
     std::vector<std::uint8_t> receivePacket(Connection& conn)
     {
         return conn.receive(packetRawTypeSize);
@@ -45,6 +238,7 @@ namespace plug::com
 
     void sendCommand(Connection& conn, const PacketRawType& packet)
     {
+        PLUG_TRACE_SPAN("protocol", "sendCommand");
         conn.send(packet);
         receivePacket(conn);
     }
@@ -54,9 +248,9 @@ namespace plug::com
         sendCommand(conn, serializeApplyCommand().getBytes());
     }
 
-    std::array<PacketRawType, 7> loadBankData(Connection& conn, std::uint8_t slot)
+    PresetData loadBankData(Connection& conn, std::uint8_t slot)
     {
-        std::array<PacketRawType, 7> data{{}};
+        PresetData data{{}};
 
         const auto loadCommand = serializeLoadSlotCommand(slot);
         auto n = conn.send(loadCommand.getBytes());
@@ -82,23 +276,33 @@ namespace plug::com
 
     InitalData Mustang::start_amp()
     {
+        static auto& connects = metrics::Registry::global().counter("plug_amp_connects_total", "Connections to the amp");
+        const auto timer = timeOperation(Operation::start);
+        PLUG_TRACE_SPAN("mustang", "Mustang::start_amp");
+
         if (conn->isOpen() == false)
         {
             throw CommunicationException{"Device not connected"};
         }
 
         initializeAmp();
-
-        return loadData();
+        auto data = loadData();
+        connects.add();
+        connectedGauge().set(1);
+        return data;
     }
 
     void Mustang::stop_amp()
     {
         conn->close();
+        connectedGauge().set(0);
     }
 
     void Mustang::set_effect(fx_pedal_settings value)
     {
+        const auto timer = timeOperation(Operation::setEffect);
+        PLUG_TRACE_SPAN("mustang", "Mustang::set_effect");
+
         const auto clearEffectPacket = serializeClearEffectSettings(value);
         sendCommand(*conn, clearEffectPacket.getBytes());
         sendApplyCommand(*conn);
@@ -113,6 +317,9 @@ namespace plug::com
 
     void Mustang::set_amplifier(amp_settings value)
     {
+        const auto timer = timeOperation(Operation::setAmplifier);
+        PLUG_TRACE_SPAN("mustang", "Mustang::set_amplifier");
+
         const auto settingsPacket = serializeAmpSettings(value);
         sendCommand(*conn, settingsPacket.getBytes());
         sendApplyCommand(*conn);
@@ -124,6 +331,9 @@ namespace plug::com
 
     void Mustang::save_on_amp(std::string_view name, std::uint8_t slot)
     {
+        const auto timer = timeOperation(Operation::save);
+        PLUG_TRACE_SPAN("mustang", "Mustang::save_on_amp");
+
         const auto data = serializeName(slot, name).getBytes();
         sendCommand(*conn, data);
         loadBankData(*conn, slot);
@@ -131,11 +341,150 @@ namespace plug::com
 
     SignalChain Mustang::load_memory_bank(std::uint8_t slot)
     {
-        return decode_data(loadBankData(*conn, slot));
+        return decode_data(load_memory_bank_data(slot));
+    }
+
+    PresetData Mustang::load_memory_bank_data(std::uint8_t slot)
+    {
+        const auto timer = timeOperation(Operation::load);
+        PLUG_TRACE_SPAN("mustang", "Mustang::load_memory_bank_data");
+
+        return loadBankData(*conn, slot);
+    }
+
+    void Mustang::apply_preset_data(const PresetData& data)
+    {
+        const auto timer = timeOperation(Operation::applyPreset);
+        PLUG_TRACE_SPAN("mustang", "Mustang::apply_preset_data");
+
+        for (const auto& packet : settingsPackets(data))
+        {
+            sendCommand(*conn, packet);
+            sendApplyCommand(*conn);
+        }
+    }
+
+    void Mustang::apply_settings(const std::vector<PacketRawType>& packets)
+    {
+        const auto timer = timeOperation(Operation::applySettings);
+        PLUG_TRACE_SPAN("mustang", "Mustang::apply_settings");
+
+        sendSettings(*conn, packets.cbegin(), packets.cend());
+    }
+
+    void Mustang::apply_settings(const SettingsData& packets)
+    {
+        const auto timer = timeOperation(Operation::applySettings);
+        PLUG_TRACE_SPAN("mustang", "Mustang::apply_settings");
+
+        sendSettings(*conn, packets.cbegin(), packets.cend());
+    }
+
+    std::vector<PresetData> Mustang::backup_presets(std::size_t count, const ProgressCallback& progress)
+    {
+        const auto timer = timeOperation(Operation::backup);
+        PLUG_TRACE_SPAN("mustang", "Mustang::backup_presets");
+
+        if (count > maxSlots)
+        {
+            throw std::invalid_argument{"Invalid number of presets: " + std::to_string(count)};
+        }
+
+        std::vector<PresetData> presets(count);
+        std::size_t requested{0};
+        std::optional<std::vector<std::uint8_t>> lookahead;
+
+        for (std::size_t slot = 0; slot < count; ++slot)
+        {
+            while ((requested < count) && (requested < slot + pipelineDepth))
+            {
+                conn->send(serializeLoadSlotCommand(static_cast<std::uint8_t>(requested)).getBytes());
+                ++requested;
+            }
+
+            for (std::size_t i = 0; i < presets[slot].size(); ++i)
+            {
+                const auto recvData = (lookahead.has_value() ? *std::exchange(lookahead, std::nullopt) : receivePacket(*conn));
+
+                if (recvData.empty() == true)
+                {
+                    throw CommunicationException{"Incomplete data of preset " + std::to_string(slot)};
+                }
+                if (isPresetPacket(recvData, i, static_cast<std::uint8_t>(slot)) == false)
+                {
+                    throw CommunicationException{"Unexpected data for preset " + std::to_string(slot)};
+                }
+                std::copy(recvData.cbegin(), recvData.cend(), presets[slot][i].begin());
+            }
+
+            // The slot ends with an empty packet, unless the data of the next
+            // requested slot follows right away
+            if (auto next = receivePacket(*conn); next.empty() == false)
+            {
+                lookahead = std::move(next);
+            }
+            reportProgress(progress, slot + 1, count);
+        }
+
+        if (lookahead.has_value() == true)
+        {
+            throw CommunicationException{"Unexpected data after preset " + std::to_string(count - 1)};
+        }
+        return presets;
+    }
+
+    void Mustang::restore_presets(const std::vector<PresetData>& presets, const ProgressCallback& progress)
+    {
+        const auto timer = timeOperation(Operation::restore);
+        PLUG_TRACE_SPAN("mustang", "Mustang::restore_presets");
+
+        if (presets.size() > maxSlots)
+        {
+            throw std::invalid_argument{"Invalid number of presets: " + std::to_string(presets.size())};
+        }
+
+        const auto applyCommand = serializeApplyCommand().getBytes();
+        std::size_t pending{0};
+        auto send = [this, &pending](const PacketRawType& packet) {
+            conn->send(packet);
+
+            if (++pending > pipelineDepth)
+            {
+                receivePacket(*conn);
+                --pending;
+            }
+        };
+
+        for (std::size_t slot = 0; slot < presets.size(); ++slot)
+        {
+            const auto& data = presets[slot];
+            const auto name = decodeNameFromData(fromRawData<NamePayload>(data[0]));
+
+            for (const auto& packet : settingsPackets(data))
+            {
+                send(packet);
+            }
+            send(applyCommand);
+            send(serializeName(static_cast<std::uint8_t>(slot), name).getBytes());
+
+            if ((slot + 1) < presets.size())
+            {
+                reportProgress(progress, slot + 1, presets.size());
+            }
+        }
+
+        for (; pending > 0; --pending)
+        {
+            receivePacket(*conn);
+        }
+        reportProgress(progress, presets.size(), presets.size());
     }
 
     void Mustang::save_effects(std::uint8_t slot, std::string_view name, const std::vector<fx_pedal_settings>& effects)
     {
+        const auto timer = timeOperation(Operation::saveEffects);
+        PLUG_TRACE_SPAN("mustang", "Mustang::save_effects");
+
         const auto saveNamePacket = serializeSaveEffectName(slot, name, effects);
         sendCommand(*conn, saveNamePacket.getBytes());
 
@@ -147,6 +496,7 @@ namespace plug::com
 
     InitalData Mustang::loadData()
     {
+        const metrics::StartupScope phase{"load_data"};
         std::vector<std::array<std::uint8_t, 64>> recieved_data;
 
         const auto loadCommand = serializeLoadCommand();
@@ -171,7 +521,7 @@ namespace plug::com
         });
         auto presetNames = decodePresetListFromData(presetListData);
 
-        std::array<PacketRawType, 7> presetData{{}};
+        PresetData presetData{{}};
         std::copy(std::next(recieved_data.cbegin(), max_to_receive), std::next(recieved_data.cbegin(), max_to_receive + 7), presetData.begin());
 
         return {decode_data(presetData), presetNames};
@@ -179,6 +529,7 @@ namespace plug::com
 
     void Mustang::initializeAmp()
     {
+        const metrics::StartupScope phase{"initialize_amp"};
         const auto packets = serializeInitCommand();
         std::for_each(packets.cbegin(), packets.cend(), [this](const auto& p) { sendCommand(*conn, p.getBytes()); });
     }
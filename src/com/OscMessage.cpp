@@ -0,0 +1,447 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/OscMessage.h"
+#include "effects_enum.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace plug::com::osc
+{
+    namespace
+    {
+        inline constexpr std::string_view bundleTag{"#bundle"};
+        inline constexpr std::size_t maxBundleDepth{4};
+
+        struct AmpAddress
+        {
+            std::string_view name;
+            AmpParameter parameter;
+        };
+
+        inline constexpr std::array<AmpAddress, 17> ampAddresses{{{"model", AmpParameter::model},
+                                                                  {"gain", AmpParameter::gain},
+                                                                  {"volume", AmpParameter::volume},
+                                                                  {"treble", AmpParameter::treble},
+                                                                  {"middle", AmpParameter::middle},
+                                                                  {"bass", AmpParameter::bass},
+                                                                  {"cabinet", AmpParameter::cabinet},
+                                                                  {"noise_gate", AmpParameter::noiseGate},
+                                                                  {"master_vol", AmpParameter::masterVolume},
+                                                                  {"gain2", AmpParameter::gain2},
+                                                                  {"presence", AmpParameter::presence},
+                                                                  {"threshold", AmpParameter::threshold},
+                                                                  {"depth", AmpParameter::depth},
+                                                                  {"bias", AmpParameter::bias},
+                                                                  {"sag", AmpParameter::sag},
+                                                                  {"brightness", AmpParameter::brightness},
+                                                                  {"usb_gain", AmpParameter::usbGain}}};
+
+        struct EffectAddress
+        {
+            std::string_view name;
+            EffectParameter parameter;
+        };
+
+        inline constexpr std::array<EffectAddress, 9> effectAddresses{{{"model", EffectParameter::model},
+                                                                       {"knob1", EffectParameter::knob1},
+                                                                       {"knob2", EffectParameter::knob2},
+                                                                       {"knob3", EffectParameter::knob3},
+                                                                       {"knob4", EffectParameter::knob4},
+                                                                       {"knob5", EffectParameter::knob5},
+                                                                       {"knob6", EffectParameter::knob6},
+                                                                       {"position", EffectParameter::position},
+                                                                       {"enabled", EffectParameter::enabled}}};
+
+
+        constexpr std::size_t padded(std::size_t size)
+        {
+            return (size + 3) & ~std::size_t{3};
+        }
+
+        class Reader
+        {
+        public:
+            Reader(const std::uint8_t* data, std::size_t size)
+                : data_(data), size_(size), pos_(0)
+            {
+            }
+
+            bool atEnd() const
+            {
+                return pos_ >= size_;
+            }
+
+            std::optional<std::string> readString()
+            {
+                const auto begin = std::next(data_, static_cast<std::ptrdiff_t>(pos_));
+                const auto end = std::next(data_, static_cast<std::ptrdiff_t>(size_));
+                const auto terminator = std::find(begin, end, '\0');
+
+                if (terminator == end)
+                {
+                    return std::nullopt;
+                }
+
+                std::string value(begin, terminator);
+                const auto length = padded(value.size() + 1);
+
+                if (length > remaining())
+                {
+                    return std::nullopt;
+                }
+                pos_ += length;
+                return value;
+            }
+
+            std::optional<std::uint32_t> readUint32()
+            {
+                if (remaining() < 4)
+                {
+                    return std::nullopt;
+                }
+                const auto* p = std::next(data_, static_cast<std::ptrdiff_t>(pos_));
+                pos_ += 4;
+                return (std::uint32_t{p[0]} << 24) | (std::uint32_t{p[1]} << 16) | (std::uint32_t{p[2]} << 8) | std::uint32_t{p[3]};
+            }
+
+            bool skip(std::size_t n)
+            {
+                if (n > (size_ - pos_))
+                {
+                    return false;
+                }
+                pos_ += n;
+                return true;
+            }
+
+            const std::uint8_t* current() const
+            {
+                return std::next(data_, static_cast<std::ptrdiff_t>(pos_));
+            }
+
+            std::size_t remaining() const
+            {
+                return size_ - pos_;
+            }
+
+        private:
+            const std::uint8_t* data_;
+            std::size_t size_;
+            std::size_t pos_;
+        };
+
+
+        std::optional<Message> parseMessage(Reader& reader)
+        {
+            auto address = reader.readString();
+
+            if (!address || address->empty() || (address->front() != '/'))
+            {
+                return std::nullopt;
+            }
+
+            Message message{std::move(*address), {}};
+
+            if (reader.atEnd())
+            {
+                return message;
+            }
+
+            const auto tags = reader.readString();
+
+            if (!tags || tags->empty() || (tags->front() != ','))
+            {
+                return std::nullopt;
+            }
+
+            for (auto itr = std::next(tags->cbegin()); itr != tags->cend(); ++itr)
+            {
+                switch (*itr)
+                {
+                    case 'i':
+                    {
+                        const auto value = reader.readUint32();
+                        if (!value)
+                        {
+                            return std::nullopt;
+                        }
+                        message.arguments.emplace_back(static_cast<std::int32_t>(*value));
+                        break;
+                    }
+                    case 'f':
+                    {
+                        const auto value = reader.readUint32();
+                        if (!value)
+                        {
+                            return std::nullopt;
+                        }
+                        float f{0.0f};
+                        std::memcpy(&f, &(*value), sizeof(f));
+                        message.arguments.emplace_back(f);
+                        break;
+                    }
+                    case 's':
+                    {
+                        auto value = reader.readString();
+                        if (!value)
+                        {
+                            return std::nullopt;
+                        }
+                        message.arguments.emplace_back(std::move(*value));
+                        break;
+                    }
+                    case 'T':
+                        message.arguments.emplace_back(true);
+                        break;
+                    case 'F':
+                        message.arguments.emplace_back(false);
+                        break;
+                    default:
+                        return std::nullopt;
+                }
+            }
+            return message;
+        }
+
+        bool parseElement(const std::uint8_t* data, std::size_t size, std::vector<Message>& messages, std::size_t depth)
+        {
+            Reader reader{data, size};
+
+            if ((size >= bundleTag.size() + 1) && (std::memcmp(data, bundleTag.data(), bundleTag.size() + 1) == 0))
+            {
+                constexpr std::size_t timeTagSize{8};
+
+                if ((depth >= maxBundleDepth) || !reader.skip(padded(bundleTag.size() + 1) + timeTagSize))
+                {
+                    return false;
+                }
+
+                while (!reader.atEnd())
+                {
+                    const auto elementSize = reader.readUint32();
+
+                    if (!elementSize || (*elementSize > reader.remaining()) || !parseElement(reader.current(), *elementSize, messages, depth + 1))
+                    {
+                        return false;
+                    }
+                    reader.skip(*elementSize);
+                }
+                return true;
+            }
+
+            auto message = parseMessage(reader);
+
+            if (!message)
+            {
+                return false;
+            }
+            messages.push_back(std::move(*message));
+            return true;
+        }
+
+
+        void appendString(std::vector<std::uint8_t>& buffer, std::string_view value)
+        {
+            buffer.insert(buffer.end(), value.cbegin(), value.cend());
+            buffer.resize(buffer.size() + padded(value.size() + 1) - value.size(), '\0');
+        }
+
+        void appendUint32(std::vector<std::uint8_t>& buffer, std::uint32_t value)
+        {
+            buffer.push_back(static_cast<std::uint8_t>(value >> 24));
+            buffer.push_back(static_cast<std::uint8_t>(value >> 16));
+            buffer.push_back(static_cast<std::uint8_t>(value >> 8));
+            buffer.push_back(static_cast<std::uint8_t>(value));
+        }
+
+
+        std::optional<std::uint8_t> toValue(const Argument& argument)
+        {
+            if (const auto i = std::get_if<std::int32_t>(&argument))
+            {
+                if ((*i < 0) || (*i > 255))
+                {
+                    return std::nullopt;
+                }
+                return static_cast<std::uint8_t>(*i);
+            }
+            if (const auto f = std::get_if<float>(&argument))
+            {
+                if (std::isnan(*f))
+                {
+                    return std::nullopt;
+                }
+                return static_cast<std::uint8_t>(std::lround(std::clamp(*f, 0.0f, 1.0f) * 255.0f));
+            }
+            if (const auto b = std::get_if<bool>(&argument))
+            {
+                return static_cast<std::uint8_t>(*b ? 1 : 0);
+            }
+            return std::nullopt;
+        }
+
+        std::vector<std::string_view> splitAddress(std::string_view address)
+        {
+            std::vector<std::string_view> parts;
+
+            while (!address.empty())
+            {
+                address.remove_prefix(1);
+                const auto end = std::min(address.find('/'), address.size());
+                parts.push_back(address.substr(0, end));
+                address.remove_prefix(end);
+            }
+            return parts;
+        }
+
+        std::optional<ControlEvent> toAmpEvent(std::string_view name, std::uint8_t value)
+        {
+            const auto itr = std::find_if(ampAddresses.cbegin(), ampAddresses.cend(), [name](const auto& a) { return a.name == name; });
+
+            if (itr == ampAddresses.cend())
+            {
+                return std::nullopt;
+            }
+            if (((itr->parameter == AmpParameter::model) && (value > plug::value(amps::METAL_2000))) ||
+                ((itr->parameter == AmpParameter::cabinet) && (value > plug::value(cabinets::cabSS112))))
+            {
+                return std::nullopt;
+            }
+            return ControlEvent{ControlTarget::amp, 0, static_cast<std::uint8_t>(itr->parameter), value};
+        }
+
+        std::optional<ControlEvent> toEffectEvent(std::string_view slot, std::string_view name, std::uint8_t value)
+        {
+            if ((slot.size() != 1) || (slot[0] < '1') || (slot[0] > '4'))
+            {
+                return std::nullopt;
+            }
+
+            const auto itr = std::find_if(effectAddresses.cbegin(), effectAddresses.cend(), [name](const auto& a) { return a.name == name; });
+
+            if ((itr == effectAddresses.cend()) ||
+                ((itr->parameter == EffectParameter::model) && (value > plug::value(effects::FENDER_65_SPRING_REVERB))))
+            {
+                return std::nullopt;
+            }
+            return ControlEvent{ControlTarget::effect, static_cast<std::uint8_t>(slot[0] - '1'), static_cast<std::uint8_t>(itr->parameter), value};
+        }
+    }
+
+
+    std::vector<Message> parsePacket(const std::uint8_t* data, std::size_t size)
+    {
+        std::vector<Message> messages;
+
+        if ((size == 0) || ((size % 4) != 0) || !parseElement(data, size, messages, 0))
+        {
+            return {};
+        }
+        return messages;
+    }
+
+    std::vector<std::uint8_t> serializeMessage(const Message& message)
+    {
+        std::vector<std::uint8_t> buffer;
+        std::string tags{","};
+
+        for (const auto& argument : message.arguments)
+        {
+            if (std::holds_alternative<std::int32_t>(argument))
+            {
+                tags += 'i';
+            }
+            else if (std::holds_alternative<float>(argument))
+            {
+                tags += 'f';
+            }
+            else if (std::holds_alternative<std::string>(argument))
+            {
+                tags += 's';
+            }
+            else
+            {
+                tags += (std::get<bool>(argument) ? 'T' : 'F');
+            }
+        }
+
+        appendString(buffer, message.address);
+        appendString(buffer, tags);
+
+        for (const auto& argument : message.arguments)
+        {
+            if (const auto i = std::get_if<std::int32_t>(&argument))
+            {
+                appendUint32(buffer, static_cast<std::uint32_t>(*i));
+            }
+            else if (const auto f = std::get_if<float>(&argument))
+            {
+                std::uint32_t raw{0};
+                std::memcpy(&raw, f, sizeof(raw));
+                appendUint32(buffer, raw);
+            }
+            else if (const auto s = std::get_if<std::string>(&argument))
+            {
+                appendString(buffer, *s);
+            }
+        }
+        return buffer;
+    }
+
+    std::optional<ControlEvent> toControlEvent(const Message& message)
+    {
+        if (message.arguments.empty())
+        {
+            return std::nullopt;
+        }
+
+        const auto value = toValue(message.arguments.front());
+
+        if (!value)
+        {
+            return std::nullopt;
+        }
+
+        const auto parts = splitAddress(message.address);
+
+        if ((parts.size() == 2) && (parts[0] == "amp"))
+        {
+            return toAmpEvent(parts[1], *value);
+        }
+        if ((parts.size() == 3) && (parts[0] == "fx"))
+        {
+            return toEffectEvent(parts[1], parts[2], *value);
+        }
+        if ((parts.size() == 2) && (parts[0] == "preset") && (parts[1] == "load"))
+        {
+            constexpr std::uint8_t maxSlot{99};
+
+            if (!std::holds_alternative<std::int32_t>(message.arguments.front()) || (*value > maxSlot))
+            {
+                return std::nullopt;
+            }
+            return ControlEvent{ControlTarget::preset, *value, 0, 0};
+        }
+        return std::nullopt;
+    }
+}
@@ -0,0 +1,226 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/OscServer.h"
+#include "com/OscMessage.h"
+#include "com/CommandQueue.h"
+#include "com/Mustang.h"
+#include "com/CommunicationException.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace plug::com
+{
+    namespace
+    {
+        inline constexpr int pollTimeoutMs{100};
+        inline constexpr std::size_t maxDatagramSize{65536};
+
+        CommunicationException socketError(const std::string& what)
+        {
+            return CommunicationException{"OSC " + what + ": " + std::strerror(errno)};
+        }
+    }
+
+
+    OscServer::OscServer(CommandQueue& commands, const SignalChain& current, const std::string& address, std::uint16_t port)
+        : commands_(commands), writer_(commands, current), socket_(-1), port_(0), errorHandler_(), queue_(), running_(false)
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+
+        if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1)
+        {
+            throw CommunicationException{"OSC invalid address: " + address};
+        }
+
+        socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+        if (socket_ < 0)
+        {
+            throw socketError("socket");
+        }
+
+        if (::bind(socket_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            const auto error = socketError("bind");
+            ::close(socket_);
+            throw error;
+        }
+
+        socklen_t length{sizeof(addr)};
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&addr), &length);
+        port_ = ntohs(addr.sin_port);
+    }
+
+    OscServer::~OscServer()
+    {
+        stop();
+        ::close(socket_);
+    }
+
+    void OscServer::start()
+    {
+        if (running_.exchange(true) == true)
+        {
+            return;
+        }
+        dispatcher_ = std::thread{&OscServer::dispatchLoop, this};
+        receiver_ = std::thread{&OscServer::receiveLoop, this};
+    }
+
+    void OscServer::stop()
+    {
+        if (running_.exchange(false) == false)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{wakeMutex_};
+        }
+        wakeUp_.notify_one();
+
+        receiver_.join();
+        dispatcher_.join();
+    }
+
+    bool OscServer::isRunning() const
+    {
+        return running_;
+    }
+
+    std::uint16_t OscServer::port() const
+    {
+        return port_;
+    }
+
+    void OscServer::setErrorHandler(ErrorHandler handler)
+    {
+        errorHandler_ = std::move(handler);
+    }
+
+    void OscServer::update(const SignalChain& chain)
+    {
+        writer_.update(chain);
+    }
+
+    void OscServer::receiveLoop()
+    {
+        std::vector<std::uint8_t> buffer(maxDatagramSize);
+        pollfd fd{socket_, POLLIN, 0};
+
+        while (running_ == true)
+        {
+            if (::poll(&fd, 1, pollTimeoutMs) <= 0)
+            {
+                continue;
+            }
+
+            const auto received = ::recv(socket_, buffer.data(), buffer.size(), 0);
+
+            if (received <= 0)
+            {
+                continue;
+            }
+
+            bool queued{false};
+
+            for (const auto& message : osc::parsePacket(buffer.data(), static_cast<std::size_t>(received)))
+            {
+                if (const auto event = osc::toControlEvent(message); event)
+                {
+                    queued |= queue_.push(*event);
+                }
+            }
+
+            if (queued == true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock{wakeMutex_};
+                }
+                wakeUp_.notify_one();
+            }
+        }
+    }
+
+    void OscServer::dispatchLoop()
+    {
+        std::vector<ControlEvent> events;
+        events.reserve(queueSize);
+
+        while (running_ == true)
+        {
+            {
+                std::unique_lock<std::mutex> lock{wakeMutex_};
+                wakeUp_.wait(lock, [this] { return (queue_.empty() == false) || (running_ == false); });
+            }
+
+            ControlEvent event{};
+
+            while (queue_.pop(event) == true)
+            {
+                events.push_back(event);
+            }
+
+            if (events.empty() == true)
+            {
+                continue;
+            }
+
+            try
+            {
+                dispatch(events);
+            }
+            catch (const std::exception& ex)
+            {
+                if (errorHandler_)
+                {
+                    errorHandler_(ex);
+                }
+            }
+            events.clear();
+        }
+    }
+
+    void OscServer::dispatch(std::vector<ControlEvent>& events)
+    {
+        // A preset load replaces everything queued before it
+        const auto preset = std::find_if(events.crbegin(), events.crend(), [](const auto& e) { return e.target == ControlTarget::preset; });
+        auto begin = events.cbegin();
+
+        if (preset != events.crend())
+        {
+            // Later changes apply on top of the loaded preset
+            writer_.update(commands_.submit(CommandPriority::preset, [slot = preset->slot](Mustang& mustang) { return mustang.load_memory_bank(slot); }).get());
+            begin = preset.base();
+        }
+
+        writer_.write([begin, end = events.cend()](ControlState& state, bool) { std::for_each(begin, end, [&state](const auto& e) { state.apply(e); }); });
+    }
+}
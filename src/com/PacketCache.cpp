@@ -0,0 +1,115 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/PacketCache.h"
+#include "metrics/Metrics.h"
+#include <stdexcept>
+
+namespace plug::com
+{
+    namespace
+    {
+        metrics::Counter& cacheRequests(bool hit)
+        {
+            static auto& hits = metrics::Registry::global().counter("plug_packet_cache_requests_total", "Packet cache lookups", {{"result", "hit"}});
+            static auto& misses = metrics::Registry::global().counter("plug_packet_cache_requests_total", "Packet cache lookups", {{"result", "miss"}});
+            return (hit ? hits : misses);
+        }
+    }
+
+
+    PacketCache::PacketCache(std::size_t capacity)
+        : capacity_(capacity), hits_(0), misses_(0)
+    {
+        if (capacity_ == 0)
+        {
+            throw std::invalid_argument{"Cache capacity must not be zero"};
+        }
+    }
+
+    SettingsData PacketCache::get(const SignalChain& chain)
+    {
+        const auto packed = pack(chain);
+        const auto hash = contentHash(packed);
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (const auto itr = lookup_.find(hash); itr != lookup_.end())
+        {
+            auto entry = itr->second;
+
+            // Different settings with the same hash replace the entry
+            if (settingsEqual(entry->chain, packed) == false)
+            {
+                ++misses_;
+                cacheRequests(false).add();
+                *entry = Entry{hash, packed, encode_settings(chain)};
+            }
+            else
+            {
+                ++hits_;
+                cacheRequests(true).add();
+            }
+            cache_.splice(cache_.begin(), cache_, entry);
+            return entry->packets;
+        }
+
+        ++misses_;
+        cacheRequests(false).add();
+        cache_.push_front(Entry{hash, packed, encode_settings(chain)});
+        lookup_[hash] = cache_.begin();
+
+        if (cache_.size() > capacity_)
+        {
+            lookup_.erase(cache_.back().hash);
+            cache_.pop_back();
+        }
+        return cache_.front().packets;
+    }
+
+    void PacketCache::clear()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        cache_.clear();
+        lookup_.clear();
+    }
+
+    std::size_t PacketCache::size() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return cache_.size();
+    }
+
+    std::size_t PacketCache::capacity() const
+    {
+        return capacity_;
+    }
+
+    std::size_t PacketCache::hits() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return hits_;
+    }
+
+    std::size_t PacketCache::misses() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return misses_;
+    }
+}
@@ -0,0 +1,187 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/SimulatedAmp.h"
+#include "com/CommunicationException.h"
+#include "com/Mustang.h"
+#include "com/Packet.h"
+#include "com/PacketSerializer.h"
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace plug::com
+{
+    namespace
+    {
+        inline constexpr std::size_t smallAmpPresets{24};
+        inline constexpr std::size_t bigAmpPresets{100};
+
+        std::vector<std::uint8_t> toVector(const PacketRawType& packet)
+        {
+            return {packet.cbegin(), packet.cend()};
+        }
+
+        std::optional<Header> headerOf(const std::vector<std::uint8_t>& packet)
+        {
+            if (packet.size() < std::tuple_size_v<Header::RawType>)
+            {
+                return std::nullopt;
+            }
+
+            Header::RawType bytes{};
+            std::copy_n(packet.cbegin(), bytes.size(), bytes.begin());
+            Header header{};
+            header.fromBytes(bytes);
+
+            try
+            {
+                // Throws on unknown values
+                header.getType();
+                header.getDSP();
+            }
+            catch (const std::domain_error&)
+            {
+                return std::nullopt;
+            }
+            return header;
+        }
+    }
+
+
+    SimulatedAmp::SimulatedAmp(std::vector<SignalChain> presets, std::chrono::milliseconds idleTimeout)
+        : presets_(std::move(presets)), idleTimeout_(idleTimeout), current_(0), open_(true)
+    {
+        if ((presets_.size() != smallAmpPresets) && (presets_.size() != bigAmpPresets))
+        {
+            throw std::invalid_argument{"Unsupported number of presets: " + std::to_string(presets_.size())};
+        }
+    }
+
+    void SimulatedAmp::close()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            open_ = false;
+            responses_.clear();
+        }
+        responseReady_.notify_all();
+    }
+
+    bool SimulatedAmp::isOpen() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return open_;
+    }
+
+    std::vector<std::uint8_t> SimulatedAmp::receive([[maybe_unused]] std::size_t recvSize)
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+
+        if (responseReady_.wait_for(lock, idleTimeout_, [this] { return (responses_.empty() == false) || (open_ == false); }) == false)
+        {
+            return {};
+        }
+        if (open_ == false)
+        {
+            throw CommunicationException{"Device not connected"};
+        }
+
+        auto packet = std::move(responses_.front());
+        responses_.pop_front();
+        return packet;
+    }
+
+    std::size_t SimulatedAmp::sendImpl(std::uint8_t* data, std::size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            if (open_ == false)
+            {
+                throw CommunicationException{"Device not connected"};
+            }
+            respond({data, std::next(data, static_cast<std::ptrdiff_t>(size))});
+        }
+        responseReady_.notify_all();
+        return size;
+    }
+
+    void SimulatedAmp::respond(const std::vector<std::uint8_t>& packet)
+    {
+        const auto header = headerOf(packet);
+
+        if (header.has_value() && (header->getType() == Type::load))
+        {
+            for (std::size_t slot = 0; slot < presets_.size(); ++slot)
+            {
+                const auto name = toVector(serializeName(static_cast<std::uint8_t>(slot), presets_[slot].name()).getBytes());
+                responses_.push_back(name);
+                responses_.push_back(name);
+            }
+            queuePreset(current_);
+        }
+        else if (header.has_value() && (header->getType() == Type::operation) && (header->getDSP() == DSP::opSelectMemBank))
+        {
+            current_ = std::min<std::size_t>(header->getSlot(), presets_.size() - 1);
+            queuePreset(current_);
+        }
+        else
+        {
+            responses_.push_back(packet);
+        }
+    }
+
+    void SimulatedAmp::queuePreset(std::size_t slot)
+    {
+        const auto& chain = presets_[slot];
+        auto data = encode_data(chain);
+        data[0] = serializeName(static_cast<std::uint8_t>(slot), chain.name()).getBytes();
+        std::transform(data.cbegin(), data.cend(), std::back_inserter(responses_), toVector);
+
+        // An empty packet ends the transfer
+        responses_.emplace_back();
+    }
+
+
+    std::vector<SignalChain> simulatedPresets(std::size_t count)
+    {
+        std::vector<SignalChain> presets;
+        presets.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            amp_settings amp{};
+            amp.amp_num = static_cast<amps>(i % 12);
+            amp.volume = 0x80;
+            amp.gain = static_cast<std::uint8_t>(i * 10);
+            amp.depth = 0x80; // Reported by the amp unless the noise gate is custom
+            std::array<fx_pedal_settings, 4> effects{};
+
+            for (std::size_t slot = 0; slot < effects.size(); ++slot)
+            {
+                effects[slot].fx_slot = static_cast<std::uint8_t>(slot);
+            }
+            presets.emplace_back("Simulated " + std::to_string(i + 1), amp, effects);
+        }
+        return presets;
+    }
+}
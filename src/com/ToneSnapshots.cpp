@@ -0,0 +1,111 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/ToneSnapshots.h"
+#include <stdexcept>
+#include <string>
+
+namespace plug::com
+{
+    void ToneSnapshots::store(std::size_t index, const SignalChain& chain)
+    {
+        if (index >= count)
+        {
+            throw std::out_of_range{"Invalid snapshot: " + std::to_string(index)};
+        }
+        snapshots_[index] = Snapshot{chain, encode_settings(chain)};
+
+        if (active_ == index)
+        {
+            active_.reset();
+        }
+    }
+
+    bool ToneSnapshots::contains(std::size_t index) const
+    {
+        return (index < count) && snapshots_[index].has_value();
+    }
+
+    const SignalChain& ToneSnapshots::chain(std::size_t index) const
+    {
+        return get(index).chain;
+    }
+
+    std::optional<std::size_t> ToneSnapshots::active() const
+    {
+        return active_;
+    }
+
+    std::vector<PacketRawType> ToneSnapshots::delta(std::size_t index) const
+    {
+        const auto& target = get(index).packets;
+        std::vector<PacketRawType> packets;
+
+        for (std::size_t i = 0; i < target.size(); ++i)
+        {
+            if ((current_.has_value() == false) || ((*current_)[i] != target[i]))
+            {
+                packets.push_back(target[i]);
+            }
+        }
+        return packets;
+    }
+
+    // Packets for recalling the snapshot, which is active from now on
+    std::vector<PacketRawType> ToneSnapshots::select(std::size_t index)
+    {
+        auto packets = delta(index);
+        current_ = get(index).packets;
+        active_ = index;
+        return packets;
+    }
+
+    std::size_t ToneSnapshots::recall(Mustang& amp, std::size_t index)
+    {
+        const auto packets = select(index);
+
+        try
+        {
+            amp.apply_settings(packets);
+        }
+        catch (...)
+        {
+            // Unknown amp state if sending fails halfway
+            invalidate();
+            throw;
+        }
+        return packets.size();
+    }
+
+    void ToneSnapshots::invalidate()
+    {
+        current_.reset();
+        active_.reset();
+    }
+
+    const ToneSnapshots::Snapshot& ToneSnapshots::get(std::size_t index) const
+    {
+        if (contains(index) == false)
+        {
+            throw std::out_of_range{"No snapshot stored: " + std::to_string(index)};
+        }
+        return *snapshots_[index];
+    }
+}
@@ -20,7 +20,10 @@
 
 #include "com/UsbComm.h"
 #include "com/CommunicationException.h"
+#include "metrics/Metrics.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <libusb-1.0/libusb.h>
 
@@ -30,6 +33,69 @@ namespace plug::com
     {
         inline constexpr std::uint8_t endpointSend{0x01};
         inline constexpr std::uint8_t endpointRecv{0x81};
+
+
+        // Raw header values, the last entry collects unknown values
+        inline constexpr std::array<std::pair<std::uint8_t, const char*>, 4> packetTypes{{{0x01, "operation"},
+                                                                                         {0x03, "data"},
+                                                                                         {0xc3, "init0"},
+                                                                                         {0xc1, "load"}}};
+        inline constexpr std::array<std::pair<std::uint8_t, const char*>, 10> packetDsps{{{0x00, "none"},
+                                                                                         {0x05, "amp"},
+                                                                                         {0x0d, "usbGain"},
+                                                                                         {0x06, "effect0"},
+                                                                                         {0x07, "effect1"},
+                                                                                         {0x08, "effect2"},
+                                                                                         {0x09, "effect3"},
+                                                                                         {0x03, "opSave"},
+                                                                                         {0x04, "opSaveEffectName"},
+                                                                                         {0x01, "opSelectMemBank"}}};
+
+        enum class Direction
+        {
+            out,
+            in
+        };
+
+        template <std::size_t n>
+        std::size_t indexOf(const std::array<std::pair<std::uint8_t, const char*>, n>& names, std::uint8_t value)
+        {
+            const auto itr = std::find_if(names.cbegin(), names.cend(), [value](const auto& entry) { return entry.first == value; });
+            return std::distance(names.cbegin(), itr);
+        }
+
+        template <std::size_t n>
+        const char* nameOf(const std::array<std::pair<std::uint8_t, const char*>, n>& names, std::size_t index)
+        {
+            return (index < names.size() ? names[index].second : "unknown");
+        }
+
+        // Counters are registered on first use, only seen combinations are exported
+        void countPacket(Direction direction, const std::uint8_t* data, std::size_t size)
+        {
+            using CounterTable = std::array<std::array<std::array<std::atomic<metrics::Counter*>, packetDsps.size() + 1>, packetTypes.size() + 1>, 2>;
+            static CounterTable counters{};
+
+            if (size < 3)
+            {
+                return;
+            }
+
+            const std::size_t type = indexOf(packetTypes, data[1]);
+            const std::size_t dsp = indexOf(packetDsps, data[2]);
+            auto& slot = counters[static_cast<std::size_t>(direction)][type][dsp];
+            metrics::Counter* counter = slot.load(std::memory_order_acquire);
+
+            if (counter == nullptr)
+            {
+                counter = &metrics::Registry::global().counter("plug_packets_total", "Packets exchanged with the amp",
+                                                               {{"direction", (direction == Direction::out ? "out" : "in")},
+                                                                {"type", nameOf(packetTypes, type)},
+                                                                {"dsp", nameOf(packetDsps, dsp)}});
+                slot.store(counter, std::memory_order_release);
+            }
+            counter->add();
+        }
     }
 
     UsbComm::UsbComm(usb::Device device)
@@ -50,11 +116,15 @@ namespace plug::com
 
     std::vector<std::uint8_t> UsbComm::receive(std::size_t recvSize)
     {
-        return device_.receive(endpointRecv, recvSize);
+        auto data = device_.receive(endpointRecv, recvSize);
+        countPacket(Direction::in, data.data(), data.size());
+        return data;
     }
 
     std::size_t UsbComm::sendImpl(std::uint8_t* data, std::size_t size)
     {
-        return device_.write(endpointSend, data, size);
+        const auto sent = device_.write(endpointSend, data, size);
+        countPacket(Direction::out, data, size);
+        return sent;
     }
 }
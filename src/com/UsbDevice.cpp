@@ -20,8 +20,11 @@
 
 #include "com/UsbDevice.h"
 #include "com/UsbException.h"
+#include "metrics/Metrics.h"
+#include "metrics/Trace.h"
 #include <array>
 #include <chrono>
+#include <string>
 #include <libusb-1.0/libusb.h>
 
 namespace plug::com::usb
@@ -29,6 +32,42 @@ namespace plug::com::usb
     namespace
     {
         inline constexpr std::chrono::milliseconds usbTimeout{500};
+
+
+        struct TransferMetrics
+        {
+            metrics::Counter& bytesOut;
+            metrics::Counter& bytesIn;
+            metrics::Histogram& writeLatency;
+            metrics::Histogram& receiveLatency;
+            metrics::Counter& timeouts;
+            metrics::Counter& opens;
+        };
+
+        TransferMetrics& transferMetrics()
+        {
+            auto& registry = metrics::Registry::global();
+            static TransferMetrics m{
+                registry.counter("plug_usb_bytes_total", "Bytes transferred via USB", {{"direction", "out"}}),
+                registry.counter("plug_usb_bytes_total", "Bytes transferred via USB", {{"direction", "in"}}),
+                registry.histogram("plug_usb_transfer_seconds", "USB transfer latency", {{"direction", "out"}}),
+                registry.histogram("plug_usb_transfer_seconds", "USB transfer latency", {{"direction", "in"}}),
+                registry.counter("plug_usb_timeouts_total", "USB writes timed out"),
+                registry.counter("plug_usb_device_opens_total", "USB devices opened")};
+            return m;
+        }
+
+        UsbException countedError(int code)
+        {
+            if (code == LIBUSB_ERROR_TIMEOUT)
+            {
+                transferMetrics().timeouts.add();
+            }
+
+            UsbException error{code};
+            metrics::Registry::global().counter("plug_usb_errors_total", "USB errors by libusb error code", {{"code", error.name()}}).add();
+            return error;
+        }
     }
 
     namespace detail
@@ -57,7 +96,7 @@ namespace plug::com::usb
 
         if (const int result = libusb_open(device_.get(), &h); result != LIBUSB_SUCCESS)
         {
-            throw UsbException{result};
+            throw countedError(result);
         }
         handle_.reset(h);
 
@@ -68,8 +107,9 @@ namespace plug::com::usb
 
         if (const int result = libusb_claim_interface(handle_.get(), 0); result != LIBUSB_SUCCESS)
         {
-            throw UsbException{result};
+            throw countedError(result);
         }
+        transferMetrics().opens.add();
     }
 
     void Device::close()
@@ -106,23 +146,39 @@ namespace plug::com::usb
 
     std::size_t Device::write(std::uint8_t endpoint, std::uint8_t* data, std::size_t dataSize)
     {
+        PLUG_TRACE_SPAN("usb", "libusb write");
+        auto& m = transferMetrics();
+        metrics::ScopedTimer timer{m.writeLatency};
         int transfered{0};
 
         if (const auto result = libusb_interrupt_transfer(handle_.get(), endpoint, data, dataSize, &transfered, usbTimeout.count()); result != LIBUSB_SUCCESS)
         {
-            throw UsbException{result};
+            throw countedError(result);
         }
+        m.bytesOut.add(transfered);
         return transfered;
     }
 
     std::vector<std::uint8_t> Device::receive(std::uint8_t endpoint, std::size_t dataSize)
     {
+        PLUG_TRACE_SPAN("usb", "libusb receive");
+        auto& m = transferMetrics();
+        const auto start = std::chrono::steady_clock::now();
         std::vector<std::uint8_t> buffer(dataSize);
         int transfered{0};
 
-        if (const auto result = libusb_interrupt_transfer(handle_.get(), endpoint, buffer.data(), dataSize, &transfered, usbTimeout.count()); (result != LIBUSB_SUCCESS) && (result != LIBUSB_ERROR_TIMEOUT))
+        // A timeout is the normal outcome of an idle read; whether a response
+        // was missing is only known by the caller waiting for it
+        if (const auto result = libusb_interrupt_transfer(handle_.get(), endpoint, buffer.data(), dataSize, &transfered, usbTimeout.count());
+            (result != LIBUSB_SUCCESS) && (result != LIBUSB_ERROR_TIMEOUT))
         {
-            throw UsbException{result};
+            throw countedError(result);
+        }
+
+        if (transfered > 0)
+        {
+            m.receiveLatency.observe(std::chrono::steady_clock::now() - start);
+            m.bytesIn.add(transfered);
         }
         buffer.resize(transfered);
         return buffer;
@@ -0,0 +1,184 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics/Metrics.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace plug::metrics
+{
+    namespace detail
+    {
+        std::size_t shardIndex() noexcept
+        {
+            static std::atomic<std::size_t> next{0};
+            thread_local const std::size_t index{next.fetch_add(1, std::memory_order_relaxed) % shardCount};
+            return index;
+        }
+    }
+
+
+    std::uint64_t Counter::value() const noexcept
+    {
+        return std::accumulate(shards_.cbegin(), shards_.cend(), std::uint64_t{0}, [](std::uint64_t sum, const auto& shard) {
+            return sum + shard.value.load(std::memory_order_relaxed);
+        });
+    }
+
+
+    Histogram::Histogram(std::vector<double> bounds)
+        : bounds_(std::move(bounds)), shards_()
+    {
+        if ((bounds_.size() > maxBuckets) || (std::is_sorted(bounds_.cbegin(), bounds_.cend()) == false))
+        {
+            throw std::invalid_argument{"Invalid histogram buckets"};
+        }
+    }
+
+    void Histogram::observe(double value) noexcept
+    {
+        auto& shard = shards_[detail::shardIndex()];
+        const auto bucket = static_cast<std::size_t>(std::distance(bounds_.cbegin(), std::lower_bound(bounds_.cbegin(), bounds_.cend(), value)));
+        shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+
+        double sum = shard.sum.load(std::memory_order_relaxed);
+
+        while (shard.sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed) == false)
+        {
+        }
+    }
+
+    HistogramData Histogram::data() const
+    {
+        HistogramData result{bounds_, std::vector<std::uint64_t>(bounds_.size() + 1, 0), 0.0, 0};
+
+        for (const auto& shard : shards_)
+        {
+            for (std::size_t i = 0; i < result.counts.size(); ++i)
+            {
+                result.counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+            }
+            result.sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        result.count = std::accumulate(result.counts.cbegin(), result.counts.cend(), std::uint64_t{0});
+        return result;
+    }
+
+    std::vector<double> latencyBuckets()
+    {
+        return {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5};
+    }
+
+
+    Registry& Registry::global()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    Counter& Registry::counter(const std::string& name, const std::string& help, const Labels& labels)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto& metric = find(name, help, Type::counter, labels);
+
+        if (metric.counter == nullptr)
+        {
+            metric.counter = std::make_unique<Counter>();
+        }
+        return *metric.counter;
+    }
+
+    Gauge& Registry::gauge(const std::string& name, const std::string& help, const Labels& labels)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto& metric = find(name, help, Type::gauge, labels);
+
+        if (metric.gauge == nullptr)
+        {
+            metric.gauge = std::make_unique<Gauge>();
+        }
+        return *metric.gauge;
+    }
+
+    Histogram& Registry::histogram(const std::string& name, const std::string& help, const Labels& labels, const std::vector<double>& bounds)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto& metric = find(name, help, Type::histogram, labels);
+
+        if (metric.histogram == nullptr)
+        {
+            metric.histogram = std::make_unique<Histogram>(bounds);
+        }
+        return *metric.histogram;
+    }
+
+    std::vector<Family> Registry::collect() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        std::vector<Family> families;
+        families.reserve(entries_.size());
+
+        for (const auto& [name, entry] : entries_)
+        {
+            Family family{name, entry.help, entry.type, {}};
+
+            for (const auto& metric : entry.metrics)
+            {
+                Series series{metric.labels, 0.0, {}};
+
+                switch (entry.type)
+                {
+                    case Type::counter:
+                        series.value = static_cast<double>(metric.counter->value());
+                        break;
+                    case Type::gauge:
+                        series.value = static_cast<double>(metric.gauge->value());
+                        break;
+                    case Type::histogram:
+                        series.histogram = metric.histogram->data();
+                        break;
+                }
+                family.series.push_back(std::move(series));
+            }
+            families.push_back(std::move(family));
+        }
+        return families;
+    }
+
+    Registry::Metric& Registry::find(const std::string& name, const std::string& help, Type type, const Labels& labels)
+    {
+        auto& entry = entries_.try_emplace(name, Entry{help, type, {}}).first->second;
+
+        if (entry.type != type)
+        {
+            throw std::invalid_argument{"Metric registered with a different type: " + name};
+        }
+
+        const auto itr = std::find_if(entry.metrics.begin(), entry.metrics.end(), [&labels](const auto& m) { return m.labels == labels; });
+
+        if (itr != entry.metrics.end())
+        {
+            return *itr;
+        }
+        entry.metrics.push_back(Metric{labels, nullptr, nullptr, nullptr});
+        return entry.metrics.back();
+    }
+}
@@ -0,0 +1,314 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics/PrometheusExporter.h"
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace plug::metrics
+{
+    namespace
+    {
+        inline constexpr int pollTimeoutMs{100};
+        inline constexpr std::size_t maxRequestSize{4096};
+
+        std::string typeName(Type type)
+        {
+            switch (type)
+            {
+                case Type::counter:
+                    return "counter";
+                case Type::gauge:
+                    return "gauge";
+                default:
+                    return "histogram";
+            }
+        }
+
+        std::string formatValue(double value)
+        {
+            if (std::isinf(value))
+            {
+                return (value > 0 ? "+Inf" : "-Inf");
+            }
+
+            std::array<char, 32> buffer{{}};
+            std::snprintf(buffer.data(), buffer.size(), "%.17g", value);
+            return buffer.data();
+        }
+
+        void appendEscaped(std::string& out, const std::string& value)
+        {
+            for (const char c : value)
+            {
+                switch (c)
+                {
+                    case '\\':
+                        out += "\\\\";
+                        break;
+                    case '"':
+                        out += "\\\"";
+                        break;
+                    case '\n':
+                        out += "\\n";
+                        break;
+                    default:
+                        out += c;
+                        break;
+                }
+            }
+        }
+
+        void appendLabels(std::string& out, const Labels& labels, const char* extraName = nullptr, const std::string& extraValue = {})
+        {
+            if (labels.empty() && (extraName == nullptr))
+            {
+                return;
+            }
+
+            out += '{';
+            bool first{true};
+
+            for (const auto& [name, value] : labels)
+            {
+                out += (first ? "" : ",");
+                out += name + "=\"";
+                appendEscaped(out, value);
+                out += '"';
+                first = false;
+            }
+
+            if (extraName != nullptr)
+            {
+                out += (first ? "" : ",");
+                out += std::string{extraName} + "=\"" + extraValue + "\"";
+            }
+            out += '}';
+        }
+
+        void appendHistogram(std::string& out, const std::string& name, const Series& series)
+        {
+            const auto& data = series.histogram;
+            std::uint64_t cumulative{0};
+
+            for (std::size_t i = 0; i < data.counts.size(); ++i)
+            {
+                cumulative += data.counts[i];
+                const double bound = (i < data.bounds.size() ? data.bounds[i] : INFINITY);
+                out += name + "_bucket";
+                appendLabels(out, series.labels, "le", formatValue(bound));
+                out += ' ' + std::to_string(cumulative) + '\n';
+            }
+
+            out += name + "_sum";
+            appendLabels(out, series.labels);
+            out += ' ' + formatValue(data.sum) + '\n';
+            out += name + "_count";
+            appendLabels(out, series.labels);
+            out += ' ' + std::to_string(data.count) + '\n';
+        }
+
+        void sendAll(int client, const std::string& data)
+        {
+            std::size_t sent{0};
+
+            while (sent < data.size())
+            {
+                const auto n = ::send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+
+                if (n <= 0)
+                {
+                    return;
+                }
+                sent += static_cast<std::size_t>(n);
+            }
+        }
+
+        std::runtime_error socketError(const std::string& what)
+        {
+            return std::runtime_error{"Metrics " + what + ": " + std::strerror(errno)};
+        }
+    }
+
+
+    std::string formatPrometheus(const std::vector<Family>& families)
+    {
+        std::string out;
+
+        for (const auto& family : families)
+        {
+            out += "# HELP " + family.name + ' ' + family.help + '\n';
+            out += "# TYPE " + family.name + ' ' + typeName(family.type) + '\n';
+
+            for (const auto& series : family.series)
+            {
+                if (family.type == Type::histogram)
+                {
+                    appendHistogram(out, family.name, series);
+                }
+                else
+                {
+                    out += family.name;
+                    appendLabels(out, series.labels);
+                    out += ' ' + formatValue(series.value) + '\n';
+                }
+            }
+        }
+        return out;
+    }
+
+    void writePrometheusFile(const Registry& registry, const std::string& path)
+    {
+        const std::string temp = path + ".tmp";
+        {
+            std::ofstream out{temp, std::ios::binary | std::ios::trunc};
+            out << formatPrometheus(registry.collect());
+
+            if (out.good() == false)
+            {
+                throw std::runtime_error{"Can't write metrics to " + temp};
+            }
+        }
+        std::filesystem::rename(temp, path);
+    }
+
+
+    PrometheusServer::PrometheusServer(const Registry& registry, std::uint16_t port)
+        : registry_(registry), socket_(-1), port_(0), running_(false)
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socket_ = ::socket(AF_INET, SOCK_STREAM, 0);
+
+        if (socket_ < 0)
+        {
+            throw socketError("socket");
+        }
+
+        const int reuse{1};
+        ::setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        if ((::bind(socket_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) || (::listen(socket_, 4) != 0))
+        {
+            const auto error = socketError("bind");
+            ::close(socket_);
+            throw error;
+        }
+
+        socklen_t length{sizeof(addr)};
+        ::getsockname(socket_, reinterpret_cast<sockaddr*>(&addr), &length);
+        port_ = ntohs(addr.sin_port);
+    }
+
+    PrometheusServer::~PrometheusServer()
+    {
+        stop();
+        ::close(socket_);
+    }
+
+    void PrometheusServer::start()
+    {
+        if (running_.exchange(true) == true)
+        {
+            return;
+        }
+        server_ = std::thread{&PrometheusServer::serveLoop, this};
+    }
+
+    void PrometheusServer::stop()
+    {
+        if (running_.exchange(false) == false)
+        {
+            return;
+        }
+        server_.join();
+    }
+
+    bool PrometheusServer::isRunning() const
+    {
+        return running_;
+    }
+
+    std::uint16_t PrometheusServer::port() const
+    {
+        return port_;
+    }
+
+    void PrometheusServer::serveLoop()
+    {
+        pollfd fd{socket_, POLLIN, 0};
+
+        while (running_ == true)
+        {
+            if (::poll(&fd, 1, pollTimeoutMs) <= 0)
+            {
+                continue;
+            }
+
+            const int client = ::accept(socket_, nullptr, nullptr);
+
+            if (client >= 0)
+            {
+                serve(client);
+                ::close(client);
+            }
+        }
+    }
+
+    void PrometheusServer::serve(int client)
+    {
+        std::string request;
+        std::array<char, 512> buffer{{}};
+        pollfd fd{client, POLLIN, 0};
+
+        while ((request.find("\r\n\r\n") == std::string::npos) && (request.size() < maxRequestSize) && (::poll(&fd, 1, pollTimeoutMs) > 0))
+        {
+            const auto n = ::recv(client, buffer.data(), buffer.size(), 0);
+
+            if (n <= 0)
+            {
+                break;
+            }
+            request.append(buffer.data(), static_cast<std::size_t>(n));
+        }
+
+        const bool found = (request.rfind("GET /metrics ", 0) == 0) || (request.rfind("GET / ", 0) == 0);
+        const std::string body = (found ? formatPrometheus(registry_.collect()) : std::string{"Not Found\n"});
+        const std::string header = std::string{found ? "HTTP/1.1 200 OK\r\n" : "HTTP/1.1 404 Not Found\r\n"}
+                                   + "Content-Type: text/plain; version=0.0.4\r\n"
+                                   + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                                   + "Connection: close\r\n\r\n";
+        sendAll(client, header + body);
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics/StartupProfile.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace plug::metrics
+{
+    namespace
+    {
+        // Not locale dependent, QApplication sets the locale from the environment
+        void writeMillis(std::ostream& out, std::chrono::nanoseconds value)
+        {
+            const auto us = std::chrono::duration_cast<std::chrono::microseconds>(value).count();
+            out << (us / 1000) << '.';
+            const auto fraction = std::to_string(1000 + us % 1000);
+            out << fraction.substr(1);
+        }
+    }
+
+
+    StartupProfile& StartupProfile::global()
+    {
+        static StartupProfile profile;
+        return profile;
+    }
+
+    void StartupProfile::enable(Clock::time_point epoch)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        epoch_ = epoch;
+        phases_.clear();
+        enabled_.store(true, std::memory_order_release);
+    }
+
+    bool StartupProfile::isEnabled() const
+    {
+        return enabled_.load(std::memory_order_acquire);
+    }
+
+    void StartupProfile::record(const char* name, Clock::time_point start, Clock::time_point end)
+    {
+        if (isEnabled() == false)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        phases_.push_back({name, start - epoch_, end - start});
+    }
+
+    std::vector<StartupPhase> StartupProfile::phases() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return phases_;
+    }
+
+
+    StartupScope::StartupScope(const char* name, StartupProfile& profile)
+        : profile_(profile), name_(name), start_(StartupProfile::Clock::now())
+    {
+    }
+
+    StartupScope::~StartupScope()
+    {
+        profile_.record(name_, start_, StartupProfile::Clock::now());
+    }
+
+
+    void writeStartupReport(std::ostream& out, const std::vector<StartupPhase>& phases)
+    {
+        std::chrono::nanoseconds total{0};
+        const char* separator = "";
+
+        out << "{\"phases\":[";
+
+        for (const auto& phase : phases)
+        {
+            out << separator << "\n{\"name\":\"" << phase.name << "\",\"start_ms\":";
+            writeMillis(out, phase.start);
+            out << ",\"duration_ms\":";
+            writeMillis(out, phase.duration);
+            out << '}';
+            total = std::max(total, phase.start + phase.duration);
+            separator = ",";
+        }
+        out << "\n],\"total_ms\":";
+        writeMillis(out, total);
+        out << "}\n";
+    }
+
+    void writeStartupReport(const std::string& path, const std::vector<StartupPhase>& phases)
+    {
+        std::ofstream out{path, std::ios::trunc};
+        writeStartupReport(out, phases);
+
+        if (out.good() == false)
+        {
+            throw std::runtime_error{"Can't write startup report to " + path};
+        }
+    }
+}
@@ -0,0 +1,182 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics/Trace.h"
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace plug::metrics
+{
+    namespace
+    {
+        // Written by the owning thread only; readers see the events up to
+        // size, which is published after each event
+        struct ThreadBuffer
+        {
+            explicit ThreadBuffer(std::size_t threadId)
+                : id(threadId), events(std::make_unique<TraceEvent[]>(traceBufferCapacity))
+            {
+            }
+
+            const std::size_t id;
+            std::unique_ptr<TraceEvent[]> events;
+            std::atomic<std::size_t> size{0};
+            std::atomic<std::size_t> dropped{0};
+        };
+
+        // Buffers are kept until exit, so events of finished threads remain
+        struct BufferList
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        };
+
+        BufferList& bufferList()
+        {
+            static BufferList list;
+            return list;
+        }
+
+        ThreadBuffer& threadBuffer()
+        {
+            thread_local ThreadBuffer* buffer = [] {
+                auto& list = bufferList();
+                std::lock_guard<std::mutex> lock{list.mutex};
+                list.buffers.push_back(std::make_unique<ThreadBuffer>(list.buffers.size() + 1));
+                return list.buffers.back().get();
+            }();
+            return *buffer;
+        }
+
+        void writeEscaped(std::ostream& out, const char* value)
+        {
+            for (; *value != '\0'; ++value)
+            {
+                const char c = *value;
+
+                if ((c == '"') || (c == '\\'))
+                {
+                    out << '\\' << c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    std::array<char, 8> buffer{{}};
+                    std::snprintf(buffer.data(), buffer.size(), "\\u%04x", c);
+                    out << buffer.data();
+                }
+                else
+                {
+                    out << c;
+                }
+            }
+        }
+
+        void writeMicros(std::ostream& out, std::int64_t ns)
+        {
+            out << (ns / 1000) << '.';
+            const auto fraction = std::to_string(1000 + ns % 1000);
+            out << fraction.substr(1);
+        }
+    }
+
+    namespace detail
+    {
+        std::int64_t traceNow() noexcept
+        {
+            static const auto epoch = std::chrono::steady_clock::now();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+        }
+
+        void recordTrace(const TraceEvent& event) noexcept
+        {
+            auto& buffer = threadBuffer();
+            const auto index = buffer.size.load(std::memory_order_relaxed);
+
+            if (index == traceBufferCapacity)
+            {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            buffer.events[index] = event;
+            buffer.size.store(index + 1, std::memory_order_release);
+        }
+    }
+
+
+    std::size_t droppedTraceEvents()
+    {
+        auto& list = bufferList();
+        std::lock_guard<std::mutex> lock{list.mutex};
+        std::size_t dropped{0};
+
+        for (const auto& buffer : list.buffers)
+        {
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+    void writeChromeTrace(std::ostream& out)
+    {
+        auto& list = bufferList();
+        std::lock_guard<std::mutex> lock{list.mutex};
+        const char* separator = "";
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        for (const auto& buffer : list.buffers)
+        {
+            const auto size = buffer->size.load(std::memory_order_acquire);
+
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                const auto& event = buffer->events[i];
+                out << separator << "\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"cat\":\"";
+                writeEscaped(out, event.category);
+                out << "\",\"name\":\"";
+                writeEscaped(out, event.name);
+                out << "\",\"ts\":";
+                writeMicros(out, event.start);
+                out << ",\"dur\":";
+                writeMicros(out, event.duration);
+                out << '}';
+                separator = ",";
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    void writeChromeTrace(const std::string& path)
+    {
+        std::ofstream out{path, std::ios::trunc};
+        writeChromeTrace(out);
+
+        if (out.good() == false)
+        {
+            throw std::runtime_error{"Can't write trace to " + path};
+        }
+    }
+}
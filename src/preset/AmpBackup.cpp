@@ -0,0 +1,54 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/AmpBackup.h"
+#include "preset/PresetBank.h"
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+
+namespace plug::preset
+{
+    namespace fs = std::filesystem;
+
+    void backupToBank(com::Mustang& amp, std::size_t slots, const std::string& path, const com::ProgressCallback& progress)
+    {
+        const auto presets = amp.backup_presets(slots, progress);
+        const auto tmpPath = path + ".tmp";
+        fs::remove(tmpPath);
+
+        {
+            PresetBankWriter writer{tmpPath};
+            std::for_each(presets.cbegin(), presets.cend(), [&writer](const auto& p) { writer.append(p); });
+        }
+        fs::rename(tmpPath, path);
+    }
+
+    std::size_t restoreFromBank(com::Mustang& amp, const std::string& path, const com::ProgressCallback& progress)
+    {
+        const PresetBank bank{path};
+        std::vector<com::PresetData> presets;
+        presets.reserve(bank.size());
+        std::transform(bank.begin(), bank.end(), std::back_inserter(presets), [](const auto& record) { return record.packets; });
+
+        amp.restore_presets(presets, progress);
+        return presets.size();
+    }
+}
@@ -0,0 +1,526 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/Converter.h"
+#include "preset/FuseCodec.h"
+#include "preset/JsonCodec.h"
+#include "preset/MappedFile.h"
+#include "preset/PresetBank.h"
+#include "preset/WorkStealingPool.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace plug::preset
+{
+    namespace fs = std::filesystem;
+
+    namespace
+    {
+        inline constexpr std::size_t bankChunkSize{256};
+        inline constexpr std::size_t jsonChunkSize{1024 * 1024};
+
+        // Presets read by one task together with the name of their output file
+        struct Item
+        {
+            fs::path target;
+            SignalChain chain;
+        };
+
+        struct ChunkOutput
+        {
+            std::string text;
+            std::vector<BankRecord> records;
+            std::size_t presets{0};
+            std::uint64_t bytes{0};
+        };
+
+        using Reader = std::function<void(std::vector<Item>&, std::vector<std::string>&)>;
+
+
+        std::string lowerExtension(const fs::path& path)
+        {
+            std::string extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+            return extension;
+        }
+
+        std::string fileName(std::size_t index, const std::string& name)
+        {
+            std::ostringstream out;
+            out << std::setw(4) << std::setfill('0') << index;
+
+            if (name.empty() == false)
+            {
+                std::string sanitized{name};
+                std::replace_if(
+                    sanitized.begin(), sanitized.end(), [](unsigned char c) { return (c < 0x20) || (std::string_view{"/\\:*?\"<>|"}.find(static_cast<char>(c)) != std::string_view::npos); }, '_');
+                out << ' ' << sanitized;
+            }
+            out << ".fuse";
+            return out.str();
+        }
+
+        void createDirectories(const fs::path& path)
+        {
+            std::error_code ec;
+            fs::create_directories(path, ec);
+
+            if (ec && (fs::is_directory(path) == false))
+            {
+                throw std::runtime_error{"Unable to create " + path.string() + ": " + ec.message()};
+            }
+        }
+
+
+        // Commits chunk outputs in input order, regardless of completion order
+        class OrderedSink
+        {
+        public:
+            using Writer = std::function<std::uint64_t(ChunkOutput&)>;
+
+            OrderedSink(std::size_t chunks, Writer writer)
+                : ready_(chunks), next_(0), bytes_(0), writer_(std::move(writer))
+            {
+            }
+
+            void commit(std::size_t index, ChunkOutput output)
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                ready_[index] = std::move(output);
+
+                while ((next_ < ready_.size()) && ready_[next_])
+                {
+                    bytes_ += writer_(*ready_[next_]);
+                    ready_[next_].reset();
+                    ++next_;
+                }
+            }
+
+            std::uint64_t bytes() const
+            {
+                return bytes_;
+            }
+
+        private:
+            std::mutex mutex_;
+            std::vector<std::optional<ChunkOutput>> ready_;
+            std::size_t next_;
+            std::uint64_t bytes_;
+            Writer writer_;
+        };
+
+
+        class Planner
+        {
+        public:
+            Planner(const fs::path& root, ConversionReport& report)
+                : root_(root), report_(report)
+            {
+            }
+
+            void add(const fs::path& path)
+            {
+                const auto format = formatOfPath(path.string());
+
+                if (format.has_value() == false)
+                {
+                    return;
+                }
+
+                try
+                {
+                    report_.bytesRead += fs::file_size(path);
+                    ++report_.files;
+
+                    switch (*format)
+                    {
+                        case Format::fuse:
+                            addFuse(path);
+                            break;
+                        case Format::bank:
+                            addBank(path);
+                            break;
+                        case Format::jsonl:
+                            addJson(path);
+                            break;
+                    }
+                }
+                catch (const std::exception& ex)
+                {
+                    ++report_.failed;
+                    report_.errors.push_back(path.string() + ": " + ex.what());
+                }
+            }
+
+            std::vector<Reader>& readers()
+            {
+                return readers_;
+            }
+
+        private:
+            fs::path relative(const fs::path& path) const
+            {
+                return (path == root_ ? path.filename() : path.lexically_relative(root_));
+            }
+
+            void addFuse(const fs::path& path)
+            {
+                readers_.push_back([path, target = relative(path)](std::vector<Item>& items, std::vector<std::string>& errors) {
+                    try
+                    {
+                        items.push_back(Item{target, loadFuseFile(path.string())});
+                    }
+                    catch (const std::exception& ex)
+                    {
+                        errors.push_back(path.string() + ": " + ex.what());
+                    }
+                });
+            }
+
+            void addBank(const fs::path& path)
+            {
+                const auto bank = std::make_shared<const PresetBank>(path.string());
+                const auto dir = relative(path).replace_extension();
+
+                for (std::size_t begin = 0; begin < bank->size(); begin += bankChunkSize)
+                {
+                    const auto end = std::min(begin + bankChunkSize, bank->size());
+
+                    readers_.push_back([bank, dir, path, begin, end](std::vector<Item>& items, std::vector<std::string>& errors) {
+                        for (std::size_t i = begin; i < end; ++i)
+                        {
+                            try
+                            {
+                                const auto& record = (*bank)[i];
+                                items.push_back(Item{dir / fileName(i, std::string{record.getName()}), decodeRecord(record)});
+                            }
+                            catch (const std::exception& ex)
+                            {
+                                errors.push_back(path.string() + ": record " + std::to_string(i) + ": " + ex.what());
+                            }
+                        }
+                    });
+                }
+            }
+
+            void addJson(const fs::path& path)
+            {
+                const auto file = std::make_shared<const MappedFile>(path.string());
+                const auto data = file->view();
+                const auto dir = relative(path).replace_extension();
+                std::size_t line{0};
+
+                for (std::size_t begin = 0; begin < data.size();)
+                {
+                    auto end = data.find('\n', std::min(begin + jsonChunkSize, data.size() - 1));
+                    end = (end == std::string_view::npos ? data.size() : end + 1);
+                    const auto chunk = data.substr(begin, end - begin);
+                    const auto lines = static_cast<std::size_t>(std::count(chunk.cbegin(), chunk.cend(), '\n'));
+
+                    readers_.push_back([file, chunk, dir, path, line](std::vector<Item>& items, std::vector<std::string>& errors) {
+                        std::size_t number{line};
+
+                        for (std::size_t pos = 0; pos < chunk.size(); ++number)
+                        {
+                            auto next = chunk.find('\n', pos);
+                            next = (next == std::string_view::npos ? chunk.size() : next);
+                            const auto text = chunk.substr(pos, next - pos);
+                            pos = next + 1;
+
+                            if (text.find_first_not_of(" \t\r") == std::string_view::npos)
+                            {
+                                continue;
+                            }
+
+                            try
+                            {
+                                auto chain = parseJson(text);
+                                auto target = dir / fileName(number, chain.name());
+                                items.push_back(Item{std::move(target), std::move(chain)});
+                            }
+                            catch (const std::exception& ex)
+                            {
+                                errors.push_back(path.string() + ": line " + std::to_string(number + 1) + ": " + ex.what());
+                            }
+                        }
+                    });
+                    line += lines;
+                    begin = end;
+                }
+            }
+
+            fs::path root_;
+            ConversionReport& report_;
+            std::vector<Reader> readers_;
+        };
+
+
+        std::uint64_t writeFile(const fs::path& path, const std::string& data)
+        {
+            std::ofstream out{path, std::ios::binary | std::ios::trunc};
+
+            if ((out.is_open() == false) || (out.write(data.data(), static_cast<std::streamsize>(data.size())).flush().good() == false))
+            {
+                throw std::runtime_error{"Unable to write " + path.string()};
+            }
+            return data.size();
+        }
+
+        // The input is still mapped while the output is written, so the
+        // output must neither be the input nor be located inside of it
+        void checkOutput(const fs::path& root, const fs::path& output)
+        {
+            std::error_code ec;
+            const auto in = fs::weakly_canonical(root, ec);
+            const auto out = fs::weakly_canonical(output, ec);
+            const bool inside = fs::is_directory(in, ec) && (std::mismatch(in.begin(), in.end(), out.begin(), out.end()).first == in.end());
+
+            if (fs::equivalent(root, output, ec) || (in == out) || inside)
+            {
+                throw std::runtime_error{"Output overlaps the input: " + output.string()};
+            }
+        }
+
+        void planInput(const fs::path& root, Planner& planner)
+        {
+            if (fs::exists(root) == false)
+            {
+                throw std::runtime_error{"No such file or directory: " + root.string()};
+            }
+
+            if (fs::is_directory(root))
+            {
+                std::vector<fs::path> files;
+
+                for (const auto& entry : fs::recursive_directory_iterator{root, fs::directory_options::skip_permission_denied})
+                {
+                    if (entry.is_regular_file())
+                    {
+                        files.push_back(entry.path());
+                    }
+                }
+                std::sort(files.begin(), files.end());
+                std::for_each(files.cbegin(), files.cend(), [&planner](const auto& f) { planner.add(f); });
+            }
+            else
+            {
+                planner.add(root);
+            }
+        }
+    }
+
+
+    std::optional<Format> formatFromName(std::string_view name)
+    {
+        if (name == "fuse")
+        {
+            return Format::fuse;
+        }
+        if (name == "bank")
+        {
+            return Format::bank;
+        }
+        if (name == "jsonl")
+        {
+            return Format::jsonl;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Format> formatOfPath(const std::string& path)
+    {
+        const auto extension = lowerExtension(path);
+
+        if ((extension.size() < 2) || (extension.front() != '.'))
+        {
+            return std::nullopt;
+        }
+        return formatFromName(std::string_view{extension}.substr(1));
+    }
+
+    ConversionReport convertPresets(const std::string& input, const std::string& output, Format target, std::size_t threads)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const fs::path root{input};
+        ConversionReport report{0, 0, 0, 0, 0, {}, {}};
+        Planner planner{root, report};
+        planInput(root, planner);
+        checkOutput(root, fs::path{output});
+
+        auto& readers = planner.readers();
+        std::unique_ptr<PresetBankWriter> bankWriter;
+        std::ofstream jsonOut;
+        std::function<ChunkOutput(std::vector<Item>&)> encode;
+
+        switch (target)
+        {
+            case Format::fuse:
+                createDirectories(output);
+                encode = [out = fs::path{output}](std::vector<Item>& items) {
+                    ChunkOutput result;
+                    std::string buffer;
+
+                    for (auto& item : items)
+                    {
+                        const auto path = (out / item.target).replace_extension(".fuse");
+                        createDirectories(path.parent_path());
+                        buffer.clear();
+                        writeFuse(buffer, item.chain);
+                        result.bytes += writeFile(path, buffer);
+                        ++result.presets;
+                    }
+                    return result;
+                };
+                break;
+
+            case Format::bank:
+                fs::remove(output);
+                bankWriter = std::make_unique<PresetBankWriter>(output);
+                encode = [](std::vector<Item>& items) {
+                    ChunkOutput result;
+                    result.records.reserve(items.size());
+                    std::transform(items.cbegin(), items.cend(), std::back_inserter(result.records), [](const auto& item) { return makeBankRecord(item.chain); });
+                    result.presets = items.size();
+                    return result;
+                };
+                break;
+
+            case Format::jsonl:
+                jsonOut.open(output, std::ios::binary | std::ios::trunc);
+
+                if (jsonOut.is_open() == false)
+                {
+                    throw std::runtime_error{"Unable to write " + output};
+                }
+                encode = [](std::vector<Item>& items) {
+                    ChunkOutput result;
+
+                    for (const auto& item : items)
+                    {
+                        writeJson(result.text, item.chain);
+                        result.text.push_back('\n');
+                    }
+                    result.presets = items.size();
+                    return result;
+                };
+                break;
+        }
+
+        OrderedSink sink{readers.size(), [target, &bankWriter, &jsonOut](ChunkOutput& chunk) -> std::uint64_t {
+                             switch (target)
+                             {
+                                 case Format::bank:
+                                     bankWriter->append(chunk.records);
+                                     return chunk.records.size() * sizeof(BankRecord);
+                                 case Format::jsonl:
+                                     if (jsonOut.write(chunk.text.data(), static_cast<std::streamsize>(chunk.text.size())).good() == false)
+                                     {
+                                         throw std::runtime_error{"Unable to write JSON output"};
+                                     }
+                                     return chunk.text.size();
+                                 default:
+                                     return chunk.bytes;
+                             }
+                         }};
+        std::mutex reportMutex;
+
+        {
+            WorkStealingPool pool{threads};
+
+            for (std::size_t i = 0; i < readers.size(); ++i)
+            {
+                pool.submit([i, &readers, &encode, &sink, &report, &reportMutex] {
+                    std::vector<Item> items;
+                    std::vector<std::string> errors;
+                    readers[i](items, errors);
+                    auto result = encode(items);
+                    const auto presets = result.presets;
+                    sink.commit(i, std::move(result));
+
+                    std::lock_guard<std::mutex> lock{reportMutex};
+                    report.presets += presets;
+                    report.failed += errors.size();
+                    std::move(errors.begin(), errors.end(), std::back_inserter(report.errors));
+                });
+            }
+            pool.wait();
+        }
+
+        if (jsonOut.is_open() && (jsonOut.flush().good() == false))
+        {
+            throw std::runtime_error{"Unable to write " + output};
+        }
+
+        report.bytesWritten = sink.bytes();
+        report.elapsed = std::chrono::steady_clock::now() - start;
+        return report;
+    }
+
+    std::vector<SourcedPreset> readPresets(const std::string& input, ConversionReport& report, std::size_t threads)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        Planner planner{fs::path{input}, report};
+        planInput(fs::path{input}, planner);
+
+        auto& readers = planner.readers();
+        std::vector<std::vector<Item>> chunks(readers.size());
+        std::mutex reportMutex;
+
+        {
+            WorkStealingPool pool{threads};
+
+            for (std::size_t i = 0; i < readers.size(); ++i)
+            {
+                pool.submit([i, &readers, &chunks, &report, &reportMutex] {
+                    std::vector<std::string> errors;
+                    readers[i](chunks[i], errors);
+
+                    std::lock_guard<std::mutex> lock{reportMutex};
+                    report.presets += chunks[i].size();
+                    report.failed += errors.size();
+                    std::move(errors.begin(), errors.end(), std::back_inserter(report.errors));
+                });
+            }
+            pool.wait();
+        }
+
+        std::vector<SourcedPreset> presets;
+        presets.reserve(report.presets);
+
+        for (auto& chunk : chunks)
+        {
+            for (auto& item : chunk)
+            {
+                presets.push_back(SourcedPreset{item.target.generic_string(), std::move(item.chain)});
+            }
+        }
+
+        report.elapsed = std::chrono::steady_clock::now() - start;
+        return presets;
+    }
+}
@@ -0,0 +1,210 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/Duplicates.h"
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <unordered_map>
+#include <cstddef>
+
+namespace plug::preset
+{
+    namespace
+    {
+        inline constexpr std::size_t bands{8};
+        inline constexpr unsigned cellWidthFactor{4};
+        inline constexpr std::uint64_t bandSeed{0x5eed};
+
+        std::uint64_t mix(std::uint64_t hash, std::uint64_t value)
+        {
+            hash = (hash ^ value) * 0x9e3779b97f4a7c15;
+            return hash ^ (hash >> 32);
+        }
+
+        // Amp, cabinet and effect models; only presets with equal models are compared
+        std::uint64_t modelKey(const PackedSignalChain& p)
+        {
+            std::uint64_t key = p.amp.amp_num | (std::uint64_t{p.amp.cabinet} << 8);
+
+            for (std::size_t i = 0; i < p.effects.size(); ++i)
+            {
+                key |= std::uint64_t{p.effects[i].effect_num} << (16 + i * 8);
+            }
+            return key;
+        }
+
+        // Byte offsets of the amp controls and effect knobs
+        std::vector<std::size_t> controlOffsets()
+        {
+            std::vector<std::size_t> offsets;
+
+            for (std::size_t i = offsetof(PackedAmp, gain); i < sizeof(PackedAmp); ++i)
+            {
+                if (i != offsetof(PackedAmp, cabinet))
+                {
+                    offsets.push_back(offsetof(PackedSignalChain, amp) + i);
+                }
+            }
+
+            for (std::size_t effect = 0; effect < 4; ++effect)
+            {
+                for (std::size_t i = offsetof(PackedEffect, knob1); i <= offsetof(PackedEffect, knob6); ++i)
+                {
+                    offsets.push_back(offsetof(PackedSignalChain, effects) + effect * sizeof(PackedEffect) + i);
+                }
+            }
+            return offsets;
+        }
+
+        // Cells of all controls, shifted randomly per band. Two presets with
+        // a distance of d end up in different cells of some control with a
+        // probability of at most d / width, so a few bands find almost all.
+        std::vector<std::uint64_t> bucketKeys(const std::vector<PackedSignalChain>& presets, unsigned maxDistance, std::size_t& keysPerPreset)
+        {
+            std::vector<std::uint64_t> keys;
+
+            if (maxDistance == 0)
+            {
+                keysPerPreset = 1;
+                keys.reserve(presets.size());
+                std::transform(presets.cbegin(), presets.cend(), std::back_inserter(keys), [](const auto& p) { return contentHash(p); });
+                return keys;
+            }
+
+            const unsigned width = cellWidthFactor * maxDistance;
+            const auto offsets = controlOffsets();
+            std::mt19937_64 rng{bandSeed};
+            std::uniform_int_distribution<unsigned> shift{0, width - 1};
+            std::vector<std::vector<unsigned>> shifts(bands, std::vector<unsigned>(offsets.size()));
+
+            for (auto& band : shifts)
+            {
+                std::generate(band.begin(), band.end(), [&rng, &shift] { return shift(rng); });
+            }
+
+            keysPerPreset = bands;
+            keys.reserve(presets.size() * bands);
+
+            for (const auto& p : presets)
+            {
+                const auto* bytes = reinterpret_cast<const std::uint8_t*>(&p);
+                const auto models = modelKey(p);
+
+                for (std::size_t b = 0; b < bands; ++b)
+                {
+                    std::uint64_t key = mix(models, b);
+
+                    for (std::size_t i = 0; i < offsets.size(); ++i)
+                    {
+                        key = mix(key, (bytes[offsets[i]] + shifts[b][i]) / width);
+                    }
+                    keys.push_back(key);
+                }
+            }
+            return keys;
+        }
+    }
+
+
+    std::vector<DuplicateCluster> findDuplicates(const std::vector<PackedSignalChain>& presets, unsigned maxDistance)
+    {
+        std::size_t keysPerPreset{0};
+        const auto keys = bucketKeys(presets, maxDistance, keysPerPreset);
+        std::unordered_map<std::uint64_t, std::vector<std::size_t>> buckets;
+
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            buckets[keys[i]].push_back(i / keysPerPreset);
+        }
+
+        // Each preset not taken yet collects the following ones within the
+        // distance; presets sharing several buckets are compared once
+        std::vector<DuplicateCluster> clusters;
+        std::vector<bool> assigned(presets.size(), false);
+        std::vector<std::size_t> comparedWith(presets.size(), presets.size());
+
+        for (std::size_t first = 0; first < presets.size(); ++first)
+        {
+            if (assigned[first] == true)
+            {
+                continue;
+            }
+
+            DuplicateCluster cluster{{first}, true, 0};
+            const auto models = modelKey(presets[first]);
+
+            for (std::size_t k = 0; k < keysPerPreset; ++k)
+            {
+                for (const auto other : buckets[keys[first * keysPerPreset + k]])
+                {
+                    if ((other <= first) || (assigned[other] == true) || (comparedWith[other] == first))
+                    {
+                        continue;
+                    }
+                    comparedWith[other] = first;
+
+                    if (modelKey(presets[other]) != models)
+                    {
+                        continue;
+                    }
+
+                    const unsigned distance = settingsDistance(presets[first], presets[other]);
+
+                    if (distance <= maxDistance)
+                    {
+                        cluster.members.push_back(other);
+                        cluster.exact = cluster.exact && (distance == 0);
+                        cluster.maxDistance = std::max(cluster.maxDistance, distance);
+                    }
+                }
+            }
+
+            if (cluster.members.size() > 1)
+            {
+                std::sort(cluster.members.begin(), cluster.members.end());
+                std::for_each(cluster.members.cbegin(), cluster.members.cend(), [&assigned](auto i) { assigned[i] = true; });
+                clusters.push_back(std::move(cluster));
+            }
+        }
+        return clusters;
+    }
+
+    std::vector<std::size_t> uniquePresets(std::size_t count, const std::vector<DuplicateCluster>& clusters)
+    {
+        std::vector<bool> duplicate(count, false);
+
+        for (const auto& cluster : clusters)
+        {
+            std::for_each(std::next(cluster.members.cbegin()), cluster.members.cend(), [&duplicate](auto i) { duplicate[i] = true; });
+        }
+
+        std::vector<std::size_t> result;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (duplicate[i] == false)
+            {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+}
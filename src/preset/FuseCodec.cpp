@@ -0,0 +1,827 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/FuseCodec.h"
+#include "EffectDescriptor.h"
+#include "preset/MappedFile.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+
+namespace plug::preset
+{
+    namespace
+    {
+        enum class Tag
+        {
+            Amplifier,
+            Module,
+            Param,
+            FX,
+            Stompbox,
+            Modulation,
+            Delay,
+            Reverb,
+            FUSE,
+            Info,
+            UsbGain,
+            Unknown
+        };
+
+        enum class Section
+        {
+            none,
+            amp,
+            fx,
+            fuse
+        };
+
+        // Values the FUSE software stores along with each amp model
+        struct AmpModel
+        {
+            std::uint8_t id;
+            std::uint8_t param12;
+            std::uint8_t param22;
+            std::uint8_t param8;
+        };
+
+        inline constexpr std::array<AmpModel, 12> ampModels{{{0x67, 0x01, 0x53, 0x80},
+                                                             {0x64, 0x02, 0x67, 0x80},
+                                                             {0x7c, 0x0c, 0x00, 0x80},
+                                                             {0x53, 0x03, 0x6a, 0x00},
+                                                             {0x6a, 0x04, 0x61, 0x80},
+                                                             {0x75, 0x05, 0x72, 0x80},
+                                                             {0x72, 0x06, 0x79, 0x80},
+                                                             {0x61, 0x07, 0x5e, 0x80},
+                                                             {0x79, 0x0b, 0x7c, 0x80},
+                                                             {0x5e, 0x09, 0x5d, 0x80},
+                                                             {0x5d, 0x0a, 0x6d, 0x80},
+                                                             {0x6d, 0x08, 0x75, 0x80}}};
+
+        inline constexpr std::array<std::uint8_t, 38> effectIds{{0x00, 0x3c, 0x49, 0x4a, 0x1a, 0x1c, 0x88, 0x07,
+                                                                 0x12, 0x13, 0x18, 0x19, 0x2d, 0x40, 0x41, 0x22, 0x29, 0x4f, 0x1f,
+                                                                 0x16, 0x43, 0x48, 0x44, 0x45, 0x15, 0x46, 0x2b, 0x2a,
+                                                                 0x24, 0x3a, 0x26, 0x3b, 0x4e, 0x4b, 0x4c, 0x4d, 0x21, 0x0b}};
+
+        inline constexpr std::array<std::string_view, 4> fxSections{{"Stompbox", "Modulation", "Delay", "Reverb"}};
+
+        inline constexpr std::uint8_t noModel{0xff};
+
+        template <std::size_t n, class F>
+        constexpr std::array<std::uint8_t, 256> reverseTable(F idOf)
+        {
+            std::array<std::uint8_t, 256> table{};
+
+            for (auto& entry : table)
+            {
+                entry = noModel;
+            }
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                table[idOf(i)] = static_cast<std::uint8_t>(i);
+            }
+            return table;
+        }
+
+        inline constexpr auto ampById = reverseTable<ampModels.size()>([](std::size_t i) { return ampModels[i].id; });
+        inline constexpr auto effectById = reverseTable<effectIds.size()>([](std::size_t i) { return effectIds[i]; });
+
+
+        constexpr Tag internTag(std::string_view name)
+        {
+            switch (name.size())
+            {
+                case 2:
+                    return name == "FX" ? Tag::FX : Tag::Unknown;
+                case 4:
+                    return name == "FUSE" ? Tag::FUSE : (name == "Info" ? Tag::Info : Tag::Unknown);
+                case 5:
+                    return name == "Param" ? Tag::Param : (name == "Delay" ? Tag::Delay : Tag::Unknown);
+                case 6:
+                    return name == "Module" ? Tag::Module : (name == "Reverb" ? Tag::Reverb : Tag::Unknown);
+                case 7:
+                    return name == "UsbGain" ? Tag::UsbGain : Tag::Unknown;
+                case 8:
+                    return name == "Stompbox" ? Tag::Stompbox : Tag::Unknown;
+                case 9:
+                    return name == "Amplifier" ? Tag::Amplifier : Tag::Unknown;
+                case 10:
+                    return name == "Modulation" ? Tag::Modulation : Tag::Unknown;
+                default:
+                    return Tag::Unknown;
+            }
+        }
+
+        constexpr bool isSpace(char c)
+        {
+            return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+        }
+
+        constexpr std::string_view trim(std::string_view value)
+        {
+            while ((value.empty() == false) && (isSpace(value.front()) == true))
+            {
+                value.remove_prefix(1);
+            }
+            while ((value.empty() == false) && (isSpace(value.back()) == true))
+            {
+                value.remove_suffix(1);
+            }
+            return value;
+        }
+
+        int toInt(std::string_view value)
+        {
+            value = trim(value);
+
+            if ((value.empty() == false) && (value.front() == '+'))
+            {
+                value.remove_prefix(1);
+            }
+
+            int result{0};
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+            return ((ec == std::errc{}) && (end == value.data() + value.size())) ? result : 0;
+        }
+
+        void appendUtf8(std::string& out, std::uint32_t c)
+        {
+            if (c < 0x80)
+            {
+                out.push_back(static_cast<char>(c));
+            }
+            else if (c < 0x800)
+            {
+                out.push_back(static_cast<char>(0xc0 | (c >> 6)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+            }
+            else if (c < 0x10000)
+            {
+                out.push_back(static_cast<char>(0xe0 | (c >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+            }
+            else
+            {
+                out.push_back(static_cast<char>(0xf0 | (c >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+            }
+        }
+
+        std::string decodeEntities(std::string_view value)
+        {
+            std::string result;
+            result.reserve(value.size());
+
+            while (value.empty() == false)
+            {
+                const auto amp = value.find('&');
+                result.append(value.substr(0, amp));
+
+                if (amp == std::string_view::npos)
+                {
+                    break;
+                }
+
+                value.remove_prefix(amp);
+                const auto end = value.find(';');
+
+                if (end == std::string_view::npos)
+                {
+                    result.append(value);
+                    break;
+                }
+
+                const auto entity = value.substr(1, end - 1);
+                value.remove_prefix(end + 1);
+
+                if (entity == "amp")
+                {
+                    result.push_back('&');
+                }
+                else if (entity == "lt")
+                {
+                    result.push_back('<');
+                }
+                else if (entity == "gt")
+                {
+                    result.push_back('>');
+                }
+                else if (entity == "quot")
+                {
+                    result.push_back('"');
+                }
+                else if (entity == "apos")
+                {
+                    result.push_back('\'');
+                }
+                else if ((entity.size() > 1) && (entity.front() == '#'))
+                {
+                    const bool hex = (entity[1] == 'x') || (entity[1] == 'X');
+                    const auto digits = entity.substr(hex ? 2 : 1);
+                    std::uint32_t c{0};
+                    const auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), c, hex ? 16 : 10);
+
+                    if ((ec == std::errc{}) && (ptr == digits.data() + digits.size()) && (c <= 0x10ffff))
+                    {
+                        appendUtf8(result, c);
+                    }
+                }
+            }
+            return result;
+        }
+
+
+        class XmlScanner
+        {
+        public:
+            enum class Token
+            {
+                startTag,
+                endTag,
+                end
+            };
+
+            explicit XmlScanner(std::string_view data)
+                : data_(data), pos_(0), name_(), attributes_()
+            {
+            }
+
+            Token next()
+            {
+                while (true)
+                {
+                    const auto open = data_.find('<', pos_);
+
+                    if (open == std::string_view::npos)
+                    {
+                        pos_ = data_.size();
+                        return Token::end;
+                    }
+
+                    pos_ = open + 1;
+                    const auto rest = data_.substr(pos_);
+
+                    if (startsWith(rest, "!--"))
+                    {
+                        skipPast("-->");
+                    }
+                    else if (startsWith(rest, "![CDATA["))
+                    {
+                        skipPast("]]>");
+                    }
+                    else if ((startsWith(rest, "?") == true) || (startsWith(rest, "!") == true))
+                    {
+                        skipPast(">");
+                    }
+                    else if (startsWith(rest, "/"))
+                    {
+                        const auto close = findTagEnd();
+                        name_ = trim(data_.substr(pos_ + 1, close - pos_ - 1));
+                        attributes_ = {};
+                        pos_ = close + 1;
+                        return Token::endTag;
+                    }
+                    else
+                    {
+                        const auto close = findTagEnd();
+                        auto content = data_.substr(pos_, close - pos_);
+                        selfClosing_ = (content.empty() == false) && (content.back() == '/');
+
+                        if (selfClosing_ == true)
+                        {
+                            content.remove_suffix(1);
+                        }
+
+                        const auto nameEnd = std::find_if(content.cbegin(), content.cend(), isSpace) - content.cbegin();
+                        name_ = content.substr(0, static_cast<std::size_t>(nameEnd));
+                        attributes_ = content.substr(static_cast<std::size_t>(nameEnd));
+                        pos_ = close + 1;
+                        return Token::startTag;
+                    }
+                }
+            }
+
+            std::string_view name() const
+            {
+                return name_;
+            }
+
+            std::string_view attribute(std::string_view key) const
+            {
+                auto rest = attributes_;
+
+                while (true)
+                {
+                    rest = trim(rest);
+                    const auto equals = rest.find('=');
+
+                    if (equals == std::string_view::npos)
+                    {
+                        return {};
+                    }
+
+                    const auto attrName = trim(rest.substr(0, equals));
+                    rest = trim(rest.substr(equals + 1));
+
+                    if ((rest.empty() == true) || ((rest.front() != '"') && (rest.front() != '\'')))
+                    {
+                        throw std::runtime_error{"Invalid FUSE data: malformed attribute"};
+                    }
+
+                    const auto valueEnd = rest.find(rest.front(), 1);
+
+                    if (valueEnd == std::string_view::npos)
+                    {
+                        throw std::runtime_error{"Invalid FUSE data: malformed attribute"};
+                    }
+
+                    if (attrName == key)
+                    {
+                        return rest.substr(1, valueEnd - 1);
+                    }
+                    rest.remove_prefix(valueEnd + 1);
+                }
+            }
+
+            std::string_view text() const
+            {
+                if (selfClosing_ == true)
+                {
+                    return {};
+                }
+                const auto end = data_.find('<', pos_);
+                return data_.substr(pos_, (end == std::string_view::npos ? data_.size() : end) - pos_);
+            }
+
+
+        private:
+            static constexpr bool startsWith(std::string_view value, std::string_view prefix)
+            {
+                return value.substr(0, prefix.size()) == prefix;
+            }
+
+            void skipPast(std::string_view terminator)
+            {
+                const auto end = data_.find(terminator, pos_);
+
+                if (end == std::string_view::npos)
+                {
+                    throw std::runtime_error{"Invalid FUSE data: unterminated markup"};
+                }
+                pos_ = end + terminator.size();
+            }
+
+            std::size_t findTagEnd() const
+            {
+                char quote{'\0'};
+
+                for (auto i = pos_; i < data_.size(); ++i)
+                {
+                    const char c = data_[i];
+
+                    if (quote != '\0')
+                    {
+                        quote = (c == quote ? '\0' : quote);
+                    }
+                    else if ((c == '"') || (c == '\''))
+                    {
+                        quote = c;
+                    }
+                    else if (c == '>')
+                    {
+                        return i;
+                    }
+                }
+                throw std::runtime_error{"Invalid FUSE data: unterminated tag"};
+            }
+
+            std::string_view data_;
+            std::size_t pos_;
+            std::string_view name_;
+            std::string_view attributes_;
+            bool selfClosing_{false};
+        };
+
+
+        void setAmpParam(amp_settings& amp, int index, int value)
+        {
+            const auto high = static_cast<std::uint8_t>(value >> 8);
+            const auto low = static_cast<std::uint8_t>(value);
+
+            switch (index)
+            {
+                case 0:
+                    amp.volume = high;
+                    break;
+                case 1:
+                    amp.gain = high;
+                    break;
+                case 2:
+                    amp.gain2 = high;
+                    break;
+                case 3:
+                    amp.master_vol = high;
+                    break;
+                case 4:
+                    amp.treble = high;
+                    break;
+                case 5:
+                    amp.middle = high;
+                    break;
+                case 6:
+                    amp.bass = high;
+                    break;
+                case 7:
+                    amp.presence = high;
+                    break;
+                case 9:
+                    amp.depth = high;
+                    break;
+                case 10:
+                    amp.bias = high;
+                    break;
+                case 15:
+                    amp.noise_gate = low;
+                    break;
+                case 16:
+                    amp.threshold = low;
+                    break;
+                case 17:
+                    amp.cabinet = static_cast<cabinets>(low);
+                    break;
+                case 19:
+                    amp.sag = low;
+                    break;
+                case 20:
+                    amp.brightness = (value != 0);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void setEffectParam(fx_pedal_settings& effect, int index, int value)
+        {
+            const auto high = static_cast<std::uint8_t>(value >> 8);
+
+            switch (index)
+            {
+                case 0:
+                    effect.knob1 = high;
+                    break;
+                case 1:
+                    effect.knob2 = high;
+                    break;
+                case 2:
+                    effect.knob3 = high;
+                    break;
+                case 3:
+                    effect.knob4 = high;
+                    break;
+                case 4:
+                    effect.knob5 = high;
+                    break;
+                case 5:
+                    effect.knob6 = high;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // FX section of the effect's family, the FUSE sections follow the family order
+        constexpr std::size_t effectSection(effects effect)
+        {
+            return static_cast<std::size_t>(describe(effect).family) - 1;
+        }
+
+
+        class Writer
+        {
+        public:
+            explicit Writer(std::string& out)
+                : out_(out)
+            {
+            }
+
+            Writer& indent(std::size_t depth)
+            {
+                out_.append(depth * 4, ' ');
+                return *this;
+            }
+
+            Writer& raw(std::string_view value)
+            {
+                out_.append(value);
+                return *this;
+            }
+
+            Writer& number(int value)
+            {
+                std::array<char, 16> buffer{};
+                const auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+                out_.append(buffer.data(), static_cast<std::size_t>(result.ptr - buffer.data()));
+                return *this;
+            }
+
+            Writer& escaped(std::string_view value)
+            {
+                for (const char c : value)
+                {
+                    switch (c)
+                    {
+                        case '&':
+                            out_.append("&amp;");
+                            break;
+                        case '<':
+                            out_.append("&lt;");
+                            break;
+                        case '>':
+                            out_.append("&gt;");
+                            break;
+                        case '"':
+                            out_.append("&quot;");
+                            break;
+                        default:
+                            out_.push_back(c);
+                            break;
+                    }
+                }
+                return *this;
+            }
+
+            Writer& param(std::size_t depth, int index, int value)
+            {
+                return indent(depth).raw("<Param ControlIndex=\"").number(index).raw("\">").number(value).raw("</Param>\n");
+            }
+
+        private:
+            std::string& out_;
+        };
+
+        constexpr int doubled(std::uint8_t value)
+        {
+            return (value << 8) | value;
+        }
+
+        void writeAmp(Writer& w, const amp_settings& amp)
+        {
+            const auto& model = ampModels[static_cast<std::size_t>(amp.amp_num) % ampModels.size()];
+
+            w.indent(1).raw("<Amplifier>\n");
+            w.indent(2).raw("<Module ID=\"").number(model.id).raw("\" POS=\"0\" BypassState=\"1\">\n");
+            w.param(3, 0, doubled(amp.volume));
+            w.param(3, 1, doubled(amp.gain));
+            w.param(3, 2, doubled(amp.gain2));
+            w.param(3, 3, doubled(amp.master_vol));
+            w.param(3, 4, doubled(amp.treble));
+            w.param(3, 5, doubled(amp.middle));
+            w.param(3, 6, doubled(amp.bass));
+            w.param(3, 7, doubled(amp.presence));
+            w.param(3, 8, doubled(model.param8));
+            w.param(3, 9, doubled(amp.depth));
+            w.param(3, 10, doubled(amp.bias));
+            w.param(3, 11, doubled(model.param8));
+            w.param(3, 12, model.param12);
+            w.param(3, 13, model.param12);
+            w.param(3, 14, model.param12);
+            w.param(3, 15, amp.noise_gate);
+            w.param(3, 16, amp.threshold);
+            w.param(3, 17, static_cast<int>(amp.cabinet));
+            w.param(3, 18, model.param12);
+            w.param(3, 19, amp.sag);
+            w.param(3, 20, amp.brightness ? 1 : 0);
+            w.param(3, 21, 1);
+            w.param(3, 22, doubled(model.param22));
+            w.indent(2).raw("</Module>\n");
+            w.indent(1).raw("</Amplifier>\n");
+        }
+
+        void writeEffect(Writer& w, const fx_pedal_settings& effect)
+        {
+            const auto id = effectIds[static_cast<std::size_t>(effect.effect_num) % effectIds.size()];
+            const int position = (effect.position == Position::effectsLoop ? (effect.fx_slot + 4) : effect.fx_slot);
+            const std::array<std::uint8_t, 6> knobs{{effect.knob1, effect.knob2, effect.knob3, effect.knob4, effect.knob5, effect.knob6}};
+            const auto count = describe(effect.effect_num).knobCount();
+
+            w.indent(3).raw("<Module ID=\"").number(id).raw("\" POS=\"").number(position).raw("\" BypassState=\"1\">");
+
+            if (count == 0)
+            {
+                w.raw("</Module>\n");
+                return;
+            }
+
+            w.raw("\n");
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                w.param(4, static_cast<int>(i), doubled(knobs[i]));
+            }
+            w.indent(3).raw("</Module>\n");
+        }
+
+        void writeEffects(Writer& w, const std::array<fx_pedal_settings, 4>& chainEffects)
+        {
+            constexpr fx_pedal_settings empty{0, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input};
+
+            w.indent(1).raw("<FX>\n");
+
+            for (std::size_t section = 0; section < fxSections.size(); ++section)
+            {
+                const auto match = std::find_if(chainEffects.cbegin(), chainEffects.cend(), [section](const auto& e) {
+                    return (e.effect_num != effects::EMPTY) && (effectSection(e.effect_num) == section);
+                });
+
+                w.indent(2).raw("<").raw(fxSections[section]).raw(" ID=\"").number(static_cast<int>(section) + 1).raw("\">\n");
+                writeEffect(w, (match != chainEffects.cend() ? *match : empty));
+                w.indent(2).raw("</").raw(fxSections[section]).raw(">\n");
+            }
+            w.indent(1).raw("</FX>\n");
+        }
+    }
+
+
+    SignalChain parseFuse(std::string_view data)
+    {
+        amp_settings amp{};
+        std::array<fx_pedal_settings, 4> fx{};
+        std::array<int, 8> fxSlots{};
+        std::string name;
+        Section section{Section::none};
+        std::size_t fxIndex{0};
+        bool hasAmp{false};
+
+        for (std::size_t i = 0; i < fx.size(); ++i)
+        {
+            fx[i] = fx_pedal_settings{static_cast<std::uint8_t>(i), effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input};
+        }
+
+        XmlScanner scanner{data};
+
+        for (auto token = scanner.next(); token != XmlScanner::Token::end; token = scanner.next())
+        {
+            const Tag tag = internTag(scanner.name());
+
+            if (token == XmlScanner::Token::endTag)
+            {
+                if ((tag == Tag::Amplifier) || (tag == Tag::FX) || (tag == Tag::FUSE))
+                {
+                    section = Section::none;
+                }
+                continue;
+            }
+
+            switch (tag)
+            {
+                case Tag::Amplifier:
+                    section = Section::amp;
+                    hasAmp = true;
+                    break;
+                case Tag::FX:
+                    section = Section::fx;
+                    break;
+                case Tag::FUSE:
+                    section = Section::fuse;
+                    break;
+                case Tag::Stompbox:
+                case Tag::Modulation:
+                case Tag::Delay:
+                case Tag::Reverb:
+                    fxIndex = static_cast<std::size_t>(tag) - static_cast<std::size_t>(Tag::Stompbox);
+                    break;
+                case Tag::Module:
+                {
+                    const int id = toInt(scanner.attribute("ID"));
+
+                    if (section == Section::amp)
+                    {
+                        if (const auto model = ampById[static_cast<std::uint8_t>(id)]; (id >= 0) && (id < 256) && (model != noModel))
+                        {
+                            amp.amp_num = static_cast<amps>(model);
+                        }
+                    }
+                    else if (section == Section::fx)
+                    {
+                        const int position = toInt(scanner.attribute("POS"));
+
+                        if ((position >= 0) && (position < static_cast<int>(fxSlots.size())))
+                        {
+                            fx[fxIndex].position = (position > 3 ? Position::effectsLoop : Position::input);
+                            fxSlots[static_cast<std::size_t>(position)] = static_cast<int>(fxIndex) + 1;
+                        }
+                        if (const auto model = effectById[static_cast<std::uint8_t>(id)]; (id >= 0) && (id < 256) && (model != noModel))
+                        {
+                            fx[fxIndex].effect_num = static_cast<effects>(model);
+                        }
+                    }
+                    break;
+                }
+                case Tag::Param:
+                {
+                    const int index = toInt(scanner.attribute("ControlIndex"));
+
+                    if (section == Section::amp)
+                    {
+                        setAmpParam(amp, index, toInt(scanner.text()));
+                    }
+                    else if (section == Section::fx)
+                    {
+                        setEffectParam(fx[fxIndex], index, toInt(scanner.text()));
+                    }
+                    break;
+                }
+                case Tag::Info:
+                    if (section == Section::fuse)
+                    {
+                        name = decodeEntities(scanner.attribute("name"));
+                    }
+                    break;
+                case Tag::UsbGain:
+                    amp.usb_gain = static_cast<std::uint8_t>(toInt(scanner.text()));
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (hasAmp == false)
+        {
+            throw std::runtime_error{"Invalid FUSE data: no amplifier"};
+        }
+
+        for (std::size_t i = 0, j = 0; i < fxSlots.size(); ++i)
+        {
+            if (fxSlots[i] != 0)
+            {
+                fx[static_cast<std::size_t>(fxSlots[i] - 1)].fx_slot = static_cast<std::uint8_t>(j);
+                ++j;
+            }
+        }
+
+        return SignalChain{name, amp, fx};
+    }
+
+    SignalChain loadFuseFile(const std::string& path)
+    {
+        const MappedFile file{path};
+        return parseFuse(file.view());
+    }
+
+    std::string writeFuse(const SignalChain& chain, std::string_view author)
+    {
+        std::string out;
+        writeFuse(out, chain, author);
+        return out;
+    }
+
+    void writeFuse(std::string& out, const SignalChain& chain, std::string_view author)
+    {
+        const auto amp = chain.amp();
+        Writer w{out};
+
+        w.raw("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+        w.raw("<Preset amplifier=\"Mustang I/II\" ProductId=\"1\">\n");
+        writeAmp(w, amp);
+        writeEffects(w, chain.effects());
+        w.indent(1).raw("<FUSE>\n");
+        w.indent(2).raw("<Info name=\"").escaped(chain.name()).raw("\" author=\"").escaped(author);
+        w.raw("\" rating=\"0\" genre1=\"-1\" genre2=\"-1\" genre3=\"-1\" tags=\"\" fenderid=\"0\"></Info>\n");
+        w.indent(1).raw("</FUSE>\n");
+        w.indent(1).raw("<UsbGain>").number(amp.usb_gain).raw("</UsbGain>\n");
+        w.raw("</Preset>\n");
+    }
+
+    void saveFuseFile(const std::string& path, const SignalChain& chain, std::string_view author)
+    {
+        const auto data = writeFuse(chain, author);
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+
+        if ((out.is_open() == false) || (out.write(data.data(), static_cast<std::streamsize>(data.size())).flush().good() == false))
+        {
+            throw std::runtime_error{"Unable to write " + path};
+        }
+    }
+}
@@ -0,0 +1,629 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/JsonCodec.h"
+#include <array>
+#include <charconv>
+#include <stdexcept>
+
+namespace plug::preset
+{
+    namespace
+    {
+        inline constexpr std::size_t maxAmp{static_cast<std::size_t>(amps::METAL_2000)};
+        inline constexpr std::size_t maxEffect{static_cast<std::size_t>(effects::FENDER_65_SPRING_REVERB)};
+        inline constexpr std::size_t maxCabinet{static_cast<std::size_t>(cabinets::cabSS112)};
+        inline constexpr std::size_t maxByte{0xff};
+        inline constexpr std::size_t maxDepth{64};
+
+
+        class JsonReader
+        {
+        public:
+            explicit JsonReader(std::string_view data)
+                : data_(data), pos_(0)
+            {
+            }
+
+            void expect(char c)
+            {
+                if (peek() != c)
+                {
+                    fail(std::string{"expected '"} + c + "'");
+                }
+                ++pos_;
+            }
+
+            // Iterates the members of an object; returns false after the closing brace
+            bool nextMember(std::string& key, bool first)
+            {
+                if (peek() == '}')
+                {
+                    ++pos_;
+                    return false;
+                }
+                if (first == false)
+                {
+                    expect(',');
+                }
+                key = readString();
+                expect(':');
+                return true;
+            }
+
+            bool nextElement(bool first)
+            {
+                if (peek() == ']')
+                {
+                    ++pos_;
+                    return false;
+                }
+                if (first == false)
+                {
+                    expect(',');
+                }
+                return true;
+            }
+
+            std::string readString()
+            {
+                expect('"');
+                std::string value;
+
+                while (pos_ < data_.size())
+                {
+                    const char c = data_[pos_++];
+
+                    if (c == '"')
+                    {
+                        return value;
+                    }
+                    if (c != '\\')
+                    {
+                        value.push_back(c);
+                        continue;
+                    }
+                    if (pos_ >= data_.size())
+                    {
+                        break;
+                    }
+
+                    switch (const char escaped = data_[pos_++]; escaped)
+                    {
+                        case 'n':
+                            value.push_back('\n');
+                            break;
+                        case 't':
+                            value.push_back('\t');
+                            break;
+                        case 'r':
+                            value.push_back('\r');
+                            break;
+                        case 'b':
+                            value.push_back('\b');
+                            break;
+                        case 'f':
+                            value.push_back('\f');
+                            break;
+                        case 'u':
+                            appendUtf8(value, readCodePoint());
+                            break;
+                        default:
+                            value.push_back(escaped);
+                            break;
+                    }
+                }
+                fail("unterminated string");
+                return value;
+            }
+
+            std::size_t readNumber(std::size_t maxValue)
+            {
+                skipSpace();
+                std::size_t value{0};
+                const auto begin = data_.data() + pos_;
+                const auto [end, ec] = std::from_chars(begin, data_.data() + data_.size(), value);
+
+                if ((ec != std::errc{}) || (value > maxValue))
+                {
+                    fail("invalid number");
+                }
+                pos_ += static_cast<std::size_t>(end - begin);
+                return value;
+            }
+
+            bool readBool()
+            {
+                if (readLiteral("true"))
+                {
+                    return true;
+                }
+                if (readLiteral("false"))
+                {
+                    return false;
+                }
+                fail("expected boolean");
+                return false;
+            }
+
+            // Unknown values are skipped up to a nesting depth of maxDepth
+            void skipValue(std::size_t depth = 0)
+            {
+                if (depth >= maxDepth)
+                {
+                    fail("nested too deeply");
+                }
+
+                switch (peek())
+                {
+                    case '"':
+                        readString();
+                        break;
+                    case '{':
+                    {
+                        ++pos_;
+                        std::string key;
+
+                        for (bool first = true; nextMember(key, first); first = false)
+                        {
+                            skipValue(depth + 1);
+                        }
+                        break;
+                    }
+                    case '[':
+                        ++pos_;
+
+                        for (bool first = true; nextElement(first); first = false)
+                        {
+                            skipValue(depth + 1);
+                        }
+                        break;
+                    case 't':
+                    case 'f':
+                        readBool();
+                        break;
+                    case 'n':
+                        if (readLiteral("null") == false)
+                        {
+                            fail("unexpected value");
+                        }
+                        break;
+                    default:
+                        skipNumber();
+                        break;
+                }
+            }
+
+            void finish()
+            {
+                skipSpace();
+
+                if (pos_ != data_.size())
+                {
+                    fail("trailing data");
+                }
+            }
+
+            char peek()
+            {
+                skipSpace();
+                return (pos_ < data_.size() ? data_[pos_] : '\0');
+            }
+
+            [[noreturn]] void fail(const std::string& message) const
+            {
+                throw std::runtime_error{"Invalid preset JSON at offset " + std::to_string(pos_) + ": " + message};
+            }
+
+
+        private:
+            void skipSpace()
+            {
+                while ((pos_ < data_.size()) && ((data_[pos_] == ' ') || (data_[pos_] == '\t') || (data_[pos_] == '\n') || (data_[pos_] == '\r')))
+                {
+                    ++pos_;
+                }
+            }
+
+            void skipNumber()
+            {
+                const auto start = pos_;
+
+                while ((pos_ < data_.size()) && (std::string_view{"+-.0123456789eE"}.find(data_[pos_]) != std::string_view::npos))
+                {
+                    ++pos_;
+                }
+                if (start == pos_)
+                {
+                    fail("unexpected value");
+                }
+            }
+
+            bool readLiteral(std::string_view literal)
+            {
+                skipSpace();
+
+                if (data_.substr(pos_, literal.size()) == literal)
+                {
+                    pos_ += literal.size();
+                    return true;
+                }
+                return false;
+            }
+
+            unsigned readHex4()
+            {
+                unsigned value{0};
+
+                if ((pos_ + 4) > data_.size())
+                {
+                    fail("invalid escape");
+                }
+                const auto [end, ec] = std::from_chars(data_.data() + pos_, data_.data() + pos_ + 4, value, 16);
+
+                if ((ec != std::errc{}) || (end != data_.data() + pos_ + 4))
+                {
+                    fail("invalid escape");
+                }
+                pos_ += 4;
+                return value;
+            }
+
+            unsigned readCodePoint()
+            {
+                const unsigned high = readHex4();
+
+                if ((high >= 0xd800) && (high < 0xdc00) && (data_.substr(pos_, 2) == "\\u"))
+                {
+                    pos_ += 2;
+                    const unsigned low = readHex4();
+                    return 0x10000 + ((high - 0xd800) << 10) + (low - 0xdc00);
+                }
+                return high;
+            }
+
+            static void appendUtf8(std::string& out, unsigned cp)
+            {
+                if (cp < 0x80)
+                {
+                    out.push_back(static_cast<char>(cp));
+                }
+                else if (cp < 0x800)
+                {
+                    out.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+                }
+                else if (cp < 0x10000)
+                {
+                    out.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                    out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+                }
+                else
+                {
+                    out.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+                    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                    out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+                }
+            }
+
+            std::string_view data_;
+            std::size_t pos_;
+        };
+
+
+        std::uint8_t readByte(JsonReader& reader)
+        {
+            return static_cast<std::uint8_t>(reader.readNumber(maxByte));
+        }
+
+        amp_settings readAmp(JsonReader& reader)
+        {
+            amp_settings amp{};
+            std::string key;
+            reader.expect('{');
+
+            for (bool first = true; reader.nextMember(key, first); first = false)
+            {
+                if (key == "amp_num")
+                {
+                    amp.amp_num = static_cast<amps>(reader.readNumber(maxAmp));
+                }
+                else if (key == "cabinet")
+                {
+                    amp.cabinet = static_cast<cabinets>(reader.readNumber(maxCabinet));
+                }
+                else if (key == "brightness")
+                {
+                    amp.brightness = reader.readBool();
+                }
+                else if (key == "gain")
+                {
+                    amp.gain = readByte(reader);
+                }
+                else if (key == "volume")
+                {
+                    amp.volume = readByte(reader);
+                }
+                else if (key == "treble")
+                {
+                    amp.treble = readByte(reader);
+                }
+                else if (key == "middle")
+                {
+                    amp.middle = readByte(reader);
+                }
+                else if (key == "bass")
+                {
+                    amp.bass = readByte(reader);
+                }
+                else if (key == "noise_gate")
+                {
+                    amp.noise_gate = readByte(reader);
+                }
+                else if (key == "master_vol")
+                {
+                    amp.master_vol = readByte(reader);
+                }
+                else if (key == "gain2")
+                {
+                    amp.gain2 = readByte(reader);
+                }
+                else if (key == "presence")
+                {
+                    amp.presence = readByte(reader);
+                }
+                else if (key == "threshold")
+                {
+                    amp.threshold = readByte(reader);
+                }
+                else if (key == "depth")
+                {
+                    amp.depth = readByte(reader);
+                }
+                else if (key == "bias")
+                {
+                    amp.bias = readByte(reader);
+                }
+                else if (key == "sag")
+                {
+                    amp.sag = readByte(reader);
+                }
+                else if (key == "usb_gain")
+                {
+                    amp.usb_gain = readByte(reader);
+                }
+                else
+                {
+                    reader.skipValue();
+                }
+            }
+            return amp;
+        }
+
+        fx_pedal_settings readEffect(JsonReader& reader)
+        {
+            fx_pedal_settings effect{};
+            std::string key;
+            reader.expect('{');
+
+            for (bool first = true; reader.nextMember(key, first); first = false)
+            {
+                if (key == "fx_slot")
+                {
+                    effect.fx_slot = static_cast<std::uint8_t>(reader.readNumber(3));
+                }
+                else if (key == "effect_num")
+                {
+                    effect.effect_num = static_cast<effects>(reader.readNumber(maxEffect));
+                }
+                else if (key == "position")
+                {
+                    const auto position = reader.readString();
+
+                    if ((position != "input") && (position != "effectsLoop"))
+                    {
+                        reader.fail("invalid position");
+                    }
+                    effect.position = (position == "input" ? Position::input : Position::effectsLoop);
+                }
+                else if (key == "enabled")
+                {
+                    effect.enabled = reader.readBool();
+                }
+                else if ((key.size() == 5) && (key.compare(0, 4, "knob") == 0) && (key[4] >= '1') && (key[4] <= '6'))
+                {
+                    const std::array<std::uint8_t*, 6> knobs{{&effect.knob1, &effect.knob2, &effect.knob3, &effect.knob4, &effect.knob5, &effect.knob6}};
+                    *knobs[static_cast<std::size_t>(key[4] - '1')] = readByte(reader);
+                }
+                else
+                {
+                    reader.skipValue();
+                }
+            }
+            return effect;
+        }
+
+
+        void appendString(std::string& out, std::string_view value)
+        {
+            constexpr std::string_view hex{"0123456789abcdef"};
+            out.push_back('"');
+
+            for (const char c : value)
+            {
+                switch (c)
+                {
+                    case '"':
+                        out.append("\\\"");
+                        break;
+                    case '\\':
+                        out.append("\\\\");
+                        break;
+                    case '\n':
+                        out.append("\\n");
+                        break;
+                    case '\r':
+                        out.append("\\r");
+                        break;
+                    case '\t':
+                        out.append("\\t");
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20)
+                        {
+                            out.append("\\u00");
+                            out.push_back(hex[static_cast<unsigned char>(c) >> 4]);
+                            out.push_back(hex[static_cast<unsigned char>(c) & 0x0f]);
+                        }
+                        else
+                        {
+                            out.push_back(c);
+                        }
+                        break;
+                }
+            }
+            out.push_back('"');
+        }
+
+        void appendMember(std::string& out, std::string_view key, unsigned value, bool last = false)
+        {
+            out.push_back('"');
+            out.append(key);
+            out.append("\":");
+            out.append(std::to_string(value));
+
+            if (last == false)
+            {
+                out.push_back(',');
+            }
+        }
+    }
+
+
+    SignalChain parseJson(std::string_view data)
+    {
+        JsonReader reader{data};
+        std::string name;
+        amp_settings amp{};
+        std::array<fx_pedal_settings, 4> effectSettings{};
+        bool hasAmp{false};
+        std::string key;
+
+        for (std::size_t i = 0; i < effectSettings.size(); ++i)
+        {
+            effectSettings[i].fx_slot = static_cast<std::uint8_t>(i);
+        }
+
+        reader.expect('{');
+
+        for (bool first = true; reader.nextMember(key, first); first = false)
+        {
+            if (key == "name")
+            {
+                name = reader.readString();
+            }
+            else if (key == "amp")
+            {
+                amp = readAmp(reader);
+                hasAmp = true;
+            }
+            else if (key == "effects")
+            {
+                reader.expect('[');
+                std::size_t count{0};
+
+                for (bool firstEffect = true; reader.nextElement(firstEffect); firstEffect = false)
+                {
+                    if (count == effectSettings.size())
+                    {
+                        reader.fail("too many effects");
+                    }
+                    effectSettings[count++] = readEffect(reader);
+                }
+            }
+            else
+            {
+                reader.skipValue();
+            }
+        }
+        reader.finish();
+
+        if (hasAmp == false)
+        {
+            throw std::runtime_error{"Invalid preset JSON: no amp"};
+        }
+        return SignalChain{name, amp, effectSettings};
+    }
+
+    std::string writeJson(const SignalChain& chain)
+    {
+        std::string out;
+        writeJson(out, chain);
+        return out;
+    }
+
+    void writeJson(std::string& out, const SignalChain& chain)
+    {
+        const auto amp = chain.amp();
+
+        out.append("{\"name\":");
+        appendString(out, chain.name());
+        out.append(",\"amp\":{");
+        appendMember(out, "amp_num", value(amp.amp_num));
+        appendMember(out, "gain", amp.gain);
+        appendMember(out, "volume", amp.volume);
+        appendMember(out, "treble", amp.treble);
+        appendMember(out, "middle", amp.middle);
+        appendMember(out, "bass", amp.bass);
+        appendMember(out, "cabinet", value(amp.cabinet));
+        appendMember(out, "noise_gate", amp.noise_gate);
+        appendMember(out, "master_vol", amp.master_vol);
+        appendMember(out, "gain2", amp.gain2);
+        appendMember(out, "presence", amp.presence);
+        appendMember(out, "threshold", amp.threshold);
+        appendMember(out, "depth", amp.depth);
+        appendMember(out, "bias", amp.bias);
+        appendMember(out, "sag", amp.sag);
+        out.append(amp.brightness ? "\"brightness\":true," : "\"brightness\":false,");
+        appendMember(out, "usb_gain", amp.usb_gain, true);
+        out.append("},\"effects\":[");
+
+        const auto effectSettings = chain.effects();
+
+        for (std::size_t i = 0; i < effectSettings.size(); ++i)
+        {
+            const auto& effect = effectSettings[i];
+
+            out.append(i == 0 ? "{" : ",{");
+            appendMember(out, "fx_slot", effect.fx_slot);
+            appendMember(out, "effect_num", value(effect.effect_num));
+            appendMember(out, "knob1", effect.knob1);
+            appendMember(out, "knob2", effect.knob2);
+            appendMember(out, "knob3", effect.knob3);
+            appendMember(out, "knob4", effect.knob4);
+            appendMember(out, "knob5", effect.knob5);
+            appendMember(out, "knob6", effect.knob6);
+            out.append(effect.position == Position::input ? "\"position\":\"input\"}" : "\"position\":\"effectsLoop\"}");
+        }
+        out.append("]}");
+    }
+}
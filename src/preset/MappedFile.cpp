@@ -0,0 +1,99 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/MappedFile.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace plug::preset
+{
+
+    MappedFile::MappedFile(const std::string& path)
+        : data_(nullptr), size_(0)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0)
+        {
+            throw std::runtime_error{"Unable to open " + path + ": " + std::strerror(errno)};
+        }
+
+        struct stat info
+        {
+        };
+
+        if (::fstat(fd, &info) != 0)
+        {
+            const std::string error = std::strerror(errno);
+            ::close(fd);
+            throw std::runtime_error{"Unable to stat " + path + ": " + error};
+        }
+
+        size_ = static_cast<std::size_t>(info.st_size);
+
+        if (size_ > 0)
+        {
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (data_ == MAP_FAILED)
+            {
+                const std::string error = std::strerror(errno);
+                ::close(fd);
+                throw std::runtime_error{"Unable to map " + path + ": " + error};
+            }
+        }
+        ::close(fd);
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_(other.data_), size_(other.size_)
+    {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (data_ != nullptr)
+        {
+            ::munmap(data_, size_);
+        }
+    }
+
+    const std::uint8_t* MappedFile::data() const
+    {
+        return static_cast<const std::uint8_t*>(data_);
+    }
+
+    std::size_t MappedFile::size() const
+    {
+        return size_;
+    }
+
+    std::string_view MappedFile::view() const
+    {
+        return std::string_view{static_cast<const char*>(data_), size_};
+    }
+}
@@ -0,0 +1,265 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetBank.h"
+#include "preset/PresetIndex.h"
+#include "com/PacketSerializer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace plug::preset
+{
+    static_assert(std::is_trivially_copyable_v<BankRecord>);
+    static_assert(alignof(BankRecord) == 1);
+    static_assert(sizeof(BankRecord) == 7 * com::packetRawTypeSize + 32 + 8);
+
+    namespace
+    {
+        inline constexpr std::array<char, 4> bankMagic{{'P', 'L', 'B', 'K'}};
+        inline constexpr std::uint32_t bankVersion{1};
+        inline constexpr std::size_t headerSize{16};
+
+        using BankHeader = std::array<std::uint8_t, headerSize>;
+
+        void store(std::uint8_t* out, std::uint64_t value, std::size_t bytes)
+        {
+            for (std::size_t i = 0; i < bytes; ++i)
+            {
+                out[i] = static_cast<std::uint8_t>((value >> (8 * i)) & 0xff);
+            }
+        }
+
+        std::uint64_t fetch(const std::uint8_t* in, std::size_t bytes)
+        {
+            std::uint64_t value{0};
+
+            for (std::size_t i = 0; i < bytes; ++i)
+            {
+                value |= static_cast<std::uint64_t>(in[i]) << (8 * i);
+            }
+            return value;
+        }
+
+        BankHeader makeHeader()
+        {
+            BankHeader header{};
+            std::copy(bankMagic.cbegin(), bankMagic.cend(), header.begin());
+            store(header.data() + 4, bankVersion, 4);
+            store(header.data() + 8, sizeof(BankRecord), 4);
+            return header;
+        }
+
+        void checkHeader(const std::uint8_t* header, std::size_t size, const std::string& path)
+        {
+            if ((size < headerSize) || (std::equal(bankMagic.cbegin(), bankMagic.cend(), header) == false))
+            {
+                throw std::runtime_error{"Not a preset bank: " + path};
+            }
+            if (fetch(header + 4, 4) != bankVersion)
+            {
+                throw std::runtime_error{"Unsupported preset bank version: " + path};
+            }
+            if (fetch(header + 8, 4) != sizeof(BankRecord))
+            {
+                throw std::runtime_error{"Invalid preset bank record size: " + path};
+            }
+        }
+
+        void writeAll(int fd, const void* data, std::size_t size)
+        {
+            const auto* bytes = static_cast<const std::uint8_t*>(data);
+
+            while (size > 0)
+            {
+                const auto n = ::write(fd, bytes, size);
+
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    throw std::runtime_error{std::string{"Unable to write preset bank: "} + std::strerror(errno)};
+                }
+                bytes += n;
+                size -= static_cast<std::size_t>(n);
+            }
+        }
+
+        BankRecord makeRecord(const com::PresetData& packets, const SignalChain& chain)
+        {
+            const auto name = chain.name().substr(0, std::tuple_size_v<decltype(BankRecord::name)>);
+
+            BankRecord record{packets, {}, {}};
+            std::copy(name.cbegin(), name.cend(), record.name.begin());
+            store(record.hash.data(), contentHash(chain), record.hash.size());
+            return record;
+        }
+    }
+
+
+    std::string_view BankRecord::getName() const
+    {
+        const auto end = std::find(name.cbegin(), name.cend(), '\0');
+        return std::string_view{name.data(), static_cast<std::size_t>(std::distance(name.cbegin(), end))};
+    }
+
+    std::uint64_t BankRecord::getHash() const
+    {
+        return fetch(hash.data(), hash.size());
+    }
+
+
+    BankRecord makeBankRecord(const com::PresetData& packets)
+    {
+        return makeRecord(packets, com::decode_data(packets));
+    }
+
+    BankRecord makeBankRecord(const SignalChain& chain)
+    {
+        return makeRecord(com::encode_data(chain), chain);
+    }
+
+    SignalChain decodeRecord(const BankRecord& record)
+    {
+        return com::decode_data(record.packets);
+    }
+
+
+    PresetBank::PresetBank(const std::string& path)
+        : file_(path), records_(nullptr), size_(0)
+    {
+        checkHeader(file_.data(), file_.size(), path);
+
+        // A torn record at the end of the file (interrupted append) is ignored
+        records_ = reinterpret_cast<const BankRecord*>(file_.data() + headerSize);
+        size_ = (file_.size() - headerSize) / sizeof(BankRecord);
+    }
+
+    std::size_t PresetBank::size() const
+    {
+        return size_;
+    }
+
+    const BankRecord& PresetBank::operator[](std::size_t index) const
+    {
+        return records_[index];
+    }
+
+    const BankRecord& PresetBank::at(std::size_t index) const
+    {
+        if (index >= size_)
+        {
+            throw std::out_of_range{"Invalid preset bank record: " + std::to_string(index)};
+        }
+        return records_[index];
+    }
+
+    const BankRecord* PresetBank::begin() const
+    {
+        return records_;
+    }
+
+    const BankRecord* PresetBank::end() const
+    {
+        return records_ + size_;
+    }
+
+
+    PresetBankWriter::PresetBankWriter(const std::string& path)
+        : fd_(::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644)), size_(0)
+    {
+        if (fd_ < 0)
+        {
+            throw std::runtime_error{"Unable to open " + path + ": " + std::strerror(errno)};
+        }
+
+        try
+        {
+            struct stat info
+            {
+            };
+
+            if (::fstat(fd_, &info) != 0)
+            {
+                throw std::runtime_error{"Unable to stat " + path + ": " + std::strerror(errno)};
+            }
+
+            const auto fileSize = static_cast<std::size_t>(info.st_size);
+
+            if (fileSize == 0)
+            {
+                const auto header = makeHeader();
+                writeAll(fd_, header.data(), header.size());
+                return;
+            }
+
+            BankHeader header{};
+            const auto n = ::pread(fd_, header.data(), header.size(), 0);
+            checkHeader(header.data(), static_cast<std::size_t>(std::max<ssize_t>(n, 0)), path);
+
+            size_ = (fileSize - headerSize) / sizeof(BankRecord);
+            const auto validSize = headerSize + size_ * sizeof(BankRecord);
+
+            if ((validSize != fileSize) && (::ftruncate(fd_, static_cast<off_t>(validSize)) != 0))
+            {
+                throw std::runtime_error{"Unable to truncate " + path + ": " + std::strerror(errno)};
+            }
+        }
+        catch (...)
+        {
+            ::close(fd_);
+            throw;
+        }
+    }
+
+    PresetBankWriter::~PresetBankWriter()
+    {
+        ::close(fd_);
+    }
+
+    void PresetBankWriter::append(const BankRecord& record)
+    {
+        writeAll(fd_, &record, sizeof(record));
+        ++size_;
+    }
+
+    void PresetBankWriter::append(const com::PresetData& packets)
+    {
+        append(makeBankRecord(packets));
+    }
+
+    void PresetBankWriter::append(const std::vector<BankRecord>& records)
+    {
+        writeAll(fd_, records.data(), records.size() * sizeof(BankRecord));
+        size_ += records.size();
+    }
+
+    std::size_t PresetBankWriter::size() const
+    {
+        return size_;
+    }
+}
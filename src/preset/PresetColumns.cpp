@@ -0,0 +1,267 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetColumns.h"
+#include "preset/Duplicates.h"
+#include <algorithm>
+#include <bitset>
+#include <numeric>
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace plug::preset
+{
+    namespace
+    {
+        inline constexpr std::size_t rowsPerWord{64};
+
+#if defined(__SSE2__)
+        std::uint64_t rangeMask(const std::uint8_t* data, std::uint8_t low, std::uint8_t high)
+        {
+            const __m128i lo = _mm_set1_epi8(static_cast<char>(low));
+            const __m128i hi = _mm_set1_epi8(static_cast<char>(high));
+            std::uint64_t mask{0};
+
+            // x is within [low, high] if clamping it doesn't change it
+            for (std::size_t i = 0; i < rowsPerWord / 16; ++i)
+            {
+                const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+                const __m128i inside = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(x, lo), x), _mm_cmpeq_epi8(_mm_min_epu8(x, hi), x));
+                mask |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(inside))) << (i * 16);
+            }
+            return mask;
+        }
+#else
+        std::uint64_t rangeMask(const std::uint8_t* data, std::uint8_t low, std::uint8_t high)
+        {
+            std::uint64_t mask{0};
+
+            for (std::size_t i = 0; i < rowsPerWord; ++i)
+            {
+                mask |= static_cast<std::uint64_t>((data[i] >= low) && (data[i] <= high)) << i;
+            }
+            return mask;
+        }
+#endif
+
+        template <class Function>
+        void forEachRow(const Selection& rows, Function f)
+        {
+            for (std::size_t word = 0; word < rows.size(); ++word)
+            {
+                if (rows[word] == 0)
+                {
+                    continue;
+                }
+
+                for (std::size_t bit = 0; bit < rowsPerWord; ++bit)
+                {
+                    if (((rows[word] >> bit) & 1u) != 0)
+                    {
+                        f(word * rowsPerWord + bit);
+                    }
+                }
+            }
+        }
+    }
+
+
+    void PresetColumns::append(const SignalChain& chain, std::string source)
+    {
+        const auto packed = pack(chain);
+        const auto* settings = reinterpret_cast<const std::uint8_t*>(&packed) + offsetof(PackedSignalChain, amp);
+
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+        {
+            columns_[i].push_back(settings[i]);
+        }
+        names_.push_back(chain.name());
+        sources_.push_back(std::move(source));
+    }
+
+    void PresetColumns::reserve(std::size_t rows)
+    {
+        std::for_each(columns_.begin(), columns_.end(), [rows](auto& c) { c.reserve(rows); });
+        names_.reserve(rows);
+        sources_.reserve(rows);
+    }
+
+    std::size_t PresetColumns::size() const
+    {
+        return names_.size();
+    }
+
+    const std::vector<std::uint8_t>& PresetColumns::column(std::size_t index) const
+    {
+        return columns_.at(index);
+    }
+
+    const std::string& PresetColumns::name(std::size_t row) const
+    {
+        return names_.at(row);
+    }
+
+    const std::string& PresetColumns::source(std::size_t row) const
+    {
+        return sources_.at(row);
+    }
+
+    SignalChain PresetColumns::row(std::size_t row) const
+    {
+        PackedSignalChain packed{};
+        auto* settings = reinterpret_cast<std::uint8_t*>(&packed) + offsetof(PackedSignalChain, amp);
+
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+        {
+            settings[i] = columns_[i].at(row);
+        }
+
+        auto chain = unpack(packed);
+        chain.setName(names_[row]);
+        return chain;
+    }
+
+    Selection PresetColumns::all() const
+    {
+        Selection rows((size() + rowsPerWord - 1) / rowsPerWord, ~std::uint64_t{0});
+
+        if ((size() % rowsPerWord) != 0)
+        {
+            rows.back() = (std::uint64_t{1} << (size() % rowsPerWord)) - 1;
+        }
+        return rows;
+    }
+
+    Selection PresetColumns::between(std::size_t column, std::uint8_t low, std::uint8_t high) const
+    {
+        const auto& data = columns_.at(column);
+        Selection rows((data.size() + rowsPerWord - 1) / rowsPerWord, 0);
+        const std::size_t fullWords = data.size() / rowsPerWord;
+
+        for (std::size_t word = 0; word < fullWords; ++word)
+        {
+            rows[word] = rangeMask(data.data() + word * rowsPerWord, low, high);
+        }
+
+        for (std::size_t row = fullWords * rowsPerWord; row < data.size(); ++row)
+        {
+            rows[fullWords] |= static_cast<std::uint64_t>((data[row] >= low) && (data[row] <= high)) << (row % rowsPerWord);
+        }
+        return rows;
+    }
+
+    Selection PresetColumns::select(std::size_t column, Compare op, std::uint8_t value) const
+    {
+        switch (op)
+        {
+            case Compare::equal:
+                return between(column, value, value);
+            case Compare::notEqual:
+            {
+                auto rows = between(column, value, value);
+                const auto any = all();
+                std::transform(rows.cbegin(), rows.cend(), any.cbegin(), rows.begin(), [](auto a, auto b) { return ~a & b; });
+                return rows;
+            }
+            case Compare::less:
+                return (value == 0 ? Selection(all().size(), 0) : between(column, 0, static_cast<std::uint8_t>(value - 1)));
+            case Compare::lessEqual:
+                return between(column, 0, value);
+            case Compare::greater:
+                return (value == 0xff ? Selection(all().size(), 0) : between(column, static_cast<std::uint8_t>(value + 1), 0xff));
+            case Compare::greaterEqual:
+                return between(column, value, 0xff);
+        }
+        return Selection(all().size(), 0);
+    }
+
+    std::array<std::size_t, 256> PresetColumns::histogram(std::size_t column, const Selection& rows) const
+    {
+        const auto& data = columns_.at(column);
+        std::array<std::size_t, 256> counts{};
+
+        forEachRow(rows, [&data, &counts](std::size_t row) { ++counts[data[row]]; });
+        return counts;
+    }
+
+    std::optional<std::uint8_t> PresetColumns::median(std::size_t column, const Selection& rows) const
+    {
+        const auto counts = histogram(column, rows);
+        const std::size_t total = std::accumulate(counts.cbegin(), counts.cend(), std::size_t{0});
+
+        if (total == 0)
+        {
+            return std::nullopt;
+        }
+
+        // Lower median for an even number of rows
+        std::size_t seen{0};
+
+        for (std::size_t value = 0; value < counts.size(); ++value)
+        {
+            seen += counts[value];
+
+            if (seen > (total - 1) / 2)
+            {
+                return static_cast<std::uint8_t>(value);
+            }
+        }
+        return std::nullopt;
+    }
+
+
+    void intersect(Selection& rows, const Selection& other)
+    {
+        std::transform(rows.cbegin(), rows.cend(), other.cbegin(), rows.begin(), [](auto a, auto b) { return a & b; });
+    }
+
+    void unite(Selection& rows, const Selection& other)
+    {
+        std::transform(rows.cbegin(), rows.cend(), other.cbegin(), rows.begin(), [](auto a, auto b) { return a | b; });
+    }
+
+    std::size_t count(const Selection& rows)
+    {
+        return std::accumulate(rows.cbegin(), rows.cend(), std::size_t{0}, [](std::size_t sum, std::uint64_t word) { return sum + std::bitset<64>{word}.count(); });
+    }
+
+    std::vector<std::size_t> indices(const Selection& rows)
+    {
+        std::vector<std::size_t> result;
+        forEachRow(rows, [&result](std::size_t row) { result.push_back(row); });
+        return result;
+    }
+
+    PresetColumns loadColumns(const std::string& input, ConversionReport& report, std::size_t threads)
+    {
+        auto presets = readPresets(input, report, threads);
+        PresetColumns columns;
+        columns.reserve(presets.size());
+
+        for (auto& preset : presets)
+        {
+            columns.append(preset.chain, std::move(preset.source));
+        }
+        return columns;
+    }
+}
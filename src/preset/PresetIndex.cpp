@@ -0,0 +1,649 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetIndex.h"
+#include "preset/WorkStealingPool.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace plug::preset
+{
+    namespace fs = std::filesystem;
+
+    namespace
+    {
+        inline constexpr std::array<char, 4> indexMagic{{'P', 'L', 'I', 'X'}};
+        inline constexpr std::uint32_t indexVersion{4};
+
+        bool isPresetFile(const fs::path& path)
+        {
+            std::string extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+            return extension == ".fuse";
+        }
+
+        fs::path normalized(const fs::path& path)
+        {
+            fs::path result = path.lexically_normal();
+
+            if (result.has_filename() == false)
+            {
+                result = result.parent_path();
+            }
+            return result;
+        }
+
+        // Path of the file relative to the directory, if it's located below
+        std::optional<fs::path> relativeBelow(const fs::path& path, const fs::path& directory)
+        {
+            const fs::path dir = normalized(directory);
+            const fs::path file = path.lexically_normal();
+            const auto [dirEnd, fileItr] = std::mismatch(dir.begin(), dir.end(), file.begin(), file.end());
+
+            if ((dirEnd != dir.end()) || (fileItr == file.end()))
+            {
+                return std::nullopt;
+            }
+
+            fs::path relative;
+            std::for_each(fileItr, file.end(), [&relative](const auto& part) { relative /= part; });
+            return relative;
+        }
+
+        // First path component of the file below the directory, empty for
+        // files located directly inside it; prefix is the directory with a
+        // trailing separator, which matches the paths found by scanning it
+        std::optional<std::string> subdirectoryOf(const std::string& file, const std::string& prefix, const fs::path& directory)
+        {
+            if (file.compare(0, prefix.size(), prefix) == 0)
+            {
+                const auto end = file.find(fs::path::preferred_separator, prefix.size());
+                return (end == std::string::npos ? std::string{} : file.substr(prefix.size(), end - prefix.size()));
+            }
+
+            const auto below = relativeBelow(fs::path{file}, directory);
+
+            if (below.has_value() == false)
+            {
+                return std::nullopt;
+            }
+            return (below->has_parent_path() == true ? below->begin()->string() : std::string{});
+        }
+
+        std::array<fx_pedal_settings, 4> orderedEffects(const SignalChain& chain)
+        {
+            std::array<fx_pedal_settings, 4> ordered{};
+
+            for (auto& effect : ordered)
+            {
+                effect.effect_num = effects::EMPTY;
+            }
+
+            for (const auto& effect : chain.effects())
+            {
+                ordered[effect.fx_slot % ordered.size()] = effect;
+            }
+            return ordered;
+        }
+
+        IndexEntry makeEntry(const fs::path& path, std::uint64_t size, std::int64_t mtime, const SignalChain& chain)
+        {
+            const auto amp = chain.amp();
+            std::array<effects, 4> models{};
+            const auto ordered = orderedEffects(chain);
+            std::transform(ordered.cbegin(), ordered.cend(), models.begin(), [](const auto& e) { return e.effect_num; });
+
+            return IndexEntry{path.string(), size, mtime, chain.name(), amp.amp_num, amp.cabinet, models,
+                              amp.gain, amp.volume, amp.treble, amp.middle, amp.bass, contentHash(chain)};
+        }
+
+
+        class Writer
+        {
+        public:
+            explicit Writer(std::ostream& out)
+                : out_(out)
+            {
+            }
+
+            void write(std::uint64_t value, std::size_t bytes)
+            {
+                for (std::size_t i = 0; i < bytes; ++i)
+                {
+                    out_.put(static_cast<char>((value >> (8 * i)) & 0xff));
+                }
+            }
+
+            void write(const std::string& value)
+            {
+                write(value.size(), 4);
+                out_.write(value.data(), static_cast<std::streamsize>(value.size()));
+            }
+
+        private:
+            std::ostream& out_;
+        };
+
+        class Reader
+        {
+        public:
+            explicit Reader(std::istream& in)
+                : in_(in)
+            {
+            }
+
+            std::uint64_t read(std::size_t bytes)
+            {
+                std::uint64_t value{0};
+
+                for (std::size_t i = 0; i < bytes; ++i)
+                {
+                    value |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(in_.get())) << (8 * i);
+                }
+                return value;
+            }
+
+            std::string readString()
+            {
+                const auto size = read(4);
+
+                if ((in_.good() == false) || (size > maxStringSize))
+                {
+                    throw std::runtime_error{"Invalid index string"};
+                }
+                std::string value(size, '\0');
+                in_.read(value.data(), static_cast<std::streamsize>(size));
+                return value;
+            }
+
+            bool good() const
+            {
+                return in_.good();
+            }
+
+        private:
+            static constexpr std::uint64_t maxStringSize{4096};
+
+            std::istream& in_;
+        };
+    }
+
+
+    IndexDiff diffEntries(const std::vector<IndexEntry>& before, const std::vector<IndexEntry>& after)
+    {
+        IndexDiff diff;
+        std::vector<const IndexEntry*> removed;
+        auto old = before.cbegin();
+        auto now = after.cbegin();
+
+        while ((old != before.cend()) || (now != after.cend()))
+        {
+            if ((now == after.cend()) || ((old != before.cend()) && (old->path < now->path)))
+            {
+                removed.push_back(&*old++);
+            }
+            else if ((old == before.cend()) || (now->path < old->path))
+            {
+                diff.added.push_back(*now++);
+            }
+            else
+            {
+                if ((old->size != now->size) || (old->mtime != now->mtime) || (old->hash != now->hash) || (old->name != now->name))
+                {
+                    diff.changed.push_back(*now);
+                }
+                ++old;
+                ++now;
+            }
+        }
+
+        std::unordered_multimap<std::uint64_t, std::size_t> candidates;
+        std::vector<bool> moved(removed.size(), false);
+
+        for (std::size_t i = 0; i < removed.size(); ++i)
+        {
+            candidates.emplace(removed[i]->hash, i);
+        }
+
+        std::vector<IndexEntry> added;
+
+        for (auto& entry : diff.added)
+        {
+            const auto [first, last] = candidates.equal_range(entry.hash);
+            const auto match = std::find_if(first, last, [&](const auto& c) { return (removed[c.second]->size == entry.size) && (removed[c.second]->name == entry.name); });
+
+            if (match != last)
+            {
+                moved[match->second] = true;
+                diff.renamed.emplace_back(removed[match->second]->path, std::move(entry));
+                candidates.erase(match);
+            }
+            else
+            {
+                added.push_back(std::move(entry));
+            }
+        }
+        diff.added = std::move(added);
+
+        for (std::size_t i = 0; i < removed.size(); ++i)
+        {
+            if (moved[i] == false)
+            {
+                diff.removed.push_back(removed[i]->path);
+            }
+        }
+        return diff;
+    }
+
+
+    PresetIndex::PresetIndex(Parser parser, std::size_t threads)
+        : parser_(std::move(parser)), threads_(threads), cancelled_(false), mutex_(), entries_()
+    {
+        if (threads_ == 0)
+        {
+            threads_ = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    bool PresetIndex::load(const std::string& indexFile)
+    {
+        std::ifstream in{indexFile, std::ios::binary};
+
+        if (in.is_open() == false)
+        {
+            return false;
+        }
+
+        try
+        {
+            Reader reader{in};
+            std::array<char, 4> magic{};
+            in.read(magic.data(), magic.size());
+
+            if ((magic != indexMagic) || (reader.read(4) != indexVersion))
+            {
+                return false;
+            }
+
+            const auto count = reader.read(4);
+            std::vector<IndexEntry> entries;
+            entries.reserve(std::min<std::uint64_t>(count, 1u << 16));
+
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                IndexEntry entry{};
+                entry.path = reader.readString();
+                entry.size = reader.read(8);
+                entry.mtime = static_cast<std::int64_t>(reader.read(8));
+                entry.name = reader.readString();
+                entry.amp = static_cast<amps>(reader.read(1));
+                entry.cabinet = static_cast<cabinets>(reader.read(1));
+
+                for (auto& effect : entry.effectModels)
+                {
+                    effect = static_cast<effects>(reader.read(1));
+                }
+                entry.gain = static_cast<std::uint8_t>(reader.read(1));
+                entry.volume = static_cast<std::uint8_t>(reader.read(1));
+                entry.treble = static_cast<std::uint8_t>(reader.read(1));
+                entry.middle = static_cast<std::uint8_t>(reader.read(1));
+                entry.bass = static_cast<std::uint8_t>(reader.read(1));
+                entry.hash = reader.read(8);
+
+                if (reader.good() == false)
+                {
+                    return false;
+                }
+                entries.push_back(std::move(entry));
+            }
+
+            const auto failureCount = reader.read(4);
+            std::vector<Candidate> failures;
+            failures.reserve(std::min<std::uint64_t>(failureCount, 1u << 16));
+
+            for (std::uint64_t i = 0; i < failureCount; ++i)
+            {
+                Candidate failure{};
+                failure.path = reader.readString();
+                failure.size = reader.read(8);
+                failure.mtime = static_cast<std::int64_t>(reader.read(8));
+
+                if (reader.good() == false)
+                {
+                    return false;
+                }
+                failures.push_back(std::move(failure));
+            }
+
+            std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.path < b.path; });
+            std::sort(failures.begin(), failures.end(), [](const auto& a, const auto& b) { return a.path < b.path; });
+            std::lock_guard<std::mutex> lock{mutex_};
+            entries_ = std::move(entries);
+            failures_ = std::move(failures);
+        }
+        catch (const std::runtime_error&)
+        {
+            return false;
+        }
+        return true;
+    }
+
+    void PresetIndex::save(const std::string& indexFile) const
+    {
+        const auto [entries, failures] = snapshot();
+        const std::string tempFile = indexFile + ".tmp";
+
+        {
+            std::ofstream out{tempFile, std::ios::binary | std::ios::trunc};
+
+            if (out.is_open() == false)
+            {
+                throw std::runtime_error{"Unable to write index: " + tempFile};
+            }
+
+            Writer writer{out};
+            out.write(indexMagic.data(), indexMagic.size());
+            writer.write(indexVersion, 4);
+            writer.write(entries.size(), 4);
+
+            for (const auto& entry : entries)
+            {
+                writer.write(entry.path);
+                writer.write(entry.size, 8);
+                writer.write(static_cast<std::uint64_t>(entry.mtime), 8);
+                writer.write(entry.name);
+                writer.write(static_cast<std::uint64_t>(entry.amp), 1);
+                writer.write(static_cast<std::uint64_t>(entry.cabinet), 1);
+
+                for (const auto effect : entry.effectModels)
+                {
+                    writer.write(static_cast<std::uint64_t>(effect), 1);
+                }
+                writer.write(entry.gain, 1);
+                writer.write(entry.volume, 1);
+                writer.write(entry.treble, 1);
+                writer.write(entry.middle, 1);
+                writer.write(entry.bass, 1);
+                writer.write(entry.hash, 8);
+            }
+
+            // Files that failed to parse, so they aren't parsed again until they change
+            writer.write(failures.size(), 4);
+
+            for (const auto& failure : failures)
+            {
+                writer.write(failure.path);
+                writer.write(failure.size, 8);
+                writer.write(static_cast<std::uint64_t>(failure.mtime), 8);
+            }
+
+            if (out.flush().good() == false)
+            {
+                throw std::runtime_error{"Unable to write index: " + tempFile};
+            }
+        }
+
+        std::error_code ec;
+        fs::rename(tempFile, indexFile, ec);
+
+        if (ec)
+        {
+            throw std::runtime_error{"Unable to write index: " + ec.message()};
+        }
+    }
+
+    std::optional<PresetIndex::Candidate> PresetIndex::presetFile(const fs::directory_entry& file)
+    {
+        std::error_code statError;
+
+        if ((file.is_regular_file(statError) == false) || (isPresetFile(file.path()) == false))
+        {
+            return std::nullopt;
+        }
+
+        const auto size = file.file_size(statError);
+        const auto mtime = static_cast<std::int64_t>(file.last_write_time(statError).time_since_epoch().count());
+
+        if (statError)
+        {
+            return std::nullopt;
+        }
+        return Candidate{file.path().string(), size, mtime};
+    }
+
+    std::vector<PresetIndex::Candidate> PresetIndex::scanRecursive(const fs::path& directory) const
+    {
+        std::vector<Candidate> found;
+        std::error_code ec;
+        fs::recursive_directory_iterator itr{directory, fs::directory_options::skip_permission_denied, ec};
+
+        if (ec)
+        {
+            throw std::runtime_error{"Unable to scan " + directory.string() + ": " + ec.message()};
+        }
+
+        for (const fs::recursive_directory_iterator end; (ec.value() == 0) && (itr != end) && (cancelled_ == false); itr.increment(ec))
+        {
+            if (auto candidate = presetFile(*itr); candidate)
+            {
+                found.push_back(std::move(*candidate));
+            }
+        }
+        return found;
+    }
+
+    ScanResult PresetIndex::update(const std::string& directory)
+    {
+        return merge(snapshot(), {}, scanRecursive(directory));
+    }
+
+    ScanResult PresetIndex::updateDirectory(const std::string& directory)
+    {
+        const fs::path dir = normalized(directory);
+        const std::string prefix = (dir / "").string();
+        std::vector<Candidate> found;
+        std::set<std::string> subdirectories;
+        std::error_code ec;
+        fs::directory_iterator itr{dir, fs::directory_options::skip_permission_denied, ec};
+
+        if (ec)
+        {
+            throw std::runtime_error{"Unable to scan " + directory + ": " + ec.message()};
+        }
+
+        for (const fs::directory_iterator end; (ec.value() == 0) && (itr != end) && (cancelled_ == false); itr.increment(ec))
+        {
+            std::error_code statError;
+
+            if (itr->is_directory(statError) == true)
+            {
+                subdirectories.insert(itr->path().filename().string());
+            }
+            else if (auto candidate = presetFile(*itr); candidate)
+            {
+                found.push_back(std::move(*candidate));
+            }
+        }
+
+        // Entries of this directory and of vanished subdirectories are
+        // replaced, the ones of existing subdirectories are kept
+        auto [entries, failures] = snapshot();
+        Snapshot inScope;
+        Snapshot kept;
+        std::set<std::string> known;
+
+        auto assign = [&](auto& item, auto& inScopeItems, auto& keptItems) {
+            const auto subdirectory = subdirectoryOf(item.path, prefix, dir);
+
+            if ((subdirectory.has_value() == true) && (subdirectories.count(*subdirectory) > 0))
+            {
+                known.insert(*subdirectory);
+                keptItems.push_back(std::move(item));
+            }
+            else
+            {
+                (subdirectory.has_value() == true ? inScopeItems : keptItems).push_back(std::move(item));
+            }
+        };
+
+        for (auto& entry : entries)
+        {
+            assign(entry, inScope.entries, kept.entries);
+        }
+        for (auto& failure : failures)
+        {
+            assign(failure, inScope.failures, kept.failures);
+        }
+
+        for (const auto& subdirectory : subdirectories)
+        {
+            if ((known.count(subdirectory) == 0) && (cancelled_ == false))
+            {
+                // New subdirectory, its files were never seen before
+                auto files = scanRecursive(dir / subdirectory);
+                std::move(files.begin(), files.end(), std::back_inserter(found));
+            }
+        }
+        return merge(std::move(inScope), std::move(kept), found);
+    }
+
+    void PresetIndex::cancel()
+    {
+        cancelled_ = true;
+    }
+
+    ScanResult PresetIndex::merge(Snapshot previous, Snapshot current, const std::vector<Candidate>& found)
+    {
+        auto byPath = [](const auto& e, const auto& p) { return e.path < p; };
+        auto unchanged = [](const auto& known, const Candidate& candidate) { return (known.size == candidate.size) && (known.mtime == candidate.mtime); };
+        std::vector<const Candidate*> modified;
+        std::size_t known{0};
+        std::size_t knownFailures{0};
+
+        for (const auto& candidate : found)
+        {
+            const auto& path = candidate.path;
+            const auto entry = std::lower_bound(previous.entries.cbegin(), previous.entries.cend(), path, byPath);
+            const auto failure = std::lower_bound(previous.failures.cbegin(), previous.failures.cend(), path, byPath);
+            const bool exists = (entry != previous.entries.cend()) && (entry->path == path);
+            const bool failed = (failure != previous.failures.cend()) && (failure->path == path);
+
+            if ((exists == true) || (failed == true))
+            {
+                ++known;
+            }
+
+            if ((exists == true) && (unchanged(*entry, candidate) == true))
+            {
+                current.entries.push_back(*entry);
+            }
+            else if ((failed == true) && (unchanged(*failure, candidate) == true))
+            {
+                current.failures.push_back(*failure);
+                ++knownFailures;
+            }
+            else
+            {
+                modified.push_back(&candidate);
+            }
+        }
+
+        std::vector<std::optional<IndexEntry>> parsed(modified.size());
+
+        if (modified.empty() == false)
+        {
+            WorkStealingPool pool{std::min(threads_, modified.size())};
+
+            for (std::size_t i = 0; i < modified.size(); ++i)
+            {
+                pool.submit([this, i, &modified, &parsed] {
+                    if (cancelled_ == true)
+                    {
+                        return;
+                    }
+
+                    const auto& candidate = *modified[i];
+
+                    try
+                    {
+                        parsed[i] = makeEntry(candidate.path, candidate.size, candidate.mtime, parser_(candidate.path));
+                    }
+                    catch (const std::exception&)
+                    {
+                        parsed[i] = std::nullopt;
+                    }
+                });
+            }
+            pool.wait();
+        }
+
+        if (cancelled_ == true)
+        {
+            return ScanResult{current.entries.size() + current.failures.size() + modified.size(), 0, 0, 0, true};
+        }
+
+        std::size_t failed{0};
+
+        for (std::size_t i = 0; i < parsed.size(); ++i)
+        {
+            if (parsed[i])
+            {
+                current.entries.push_back(std::move(*parsed[i]));
+            }
+            else
+            {
+                current.failures.push_back(*modified[i]);
+                ++failed;
+            }
+        }
+
+        std::sort(current.entries.begin(), current.entries.end(), [](const auto& a, const auto& b) { return a.path < b.path; });
+        std::sort(current.failures.begin(), current.failures.end(), [](const auto& a, const auto& b) { return a.path < b.path; });
+        const std::size_t files = current.entries.size() + current.failures.size();
+        const std::size_t previousFiles = previous.entries.size() + previous.failures.size();
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            entries_ = std::move(current.entries);
+            failures_ = std::move(current.failures);
+        }
+        return ScanResult{files, modified.size() - failed, failed + knownFailures, previousFiles - known, false};
+    }
+
+    PresetIndex::Snapshot PresetIndex::snapshot() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return Snapshot{entries_, failures_};
+    }
+
+    std::vector<IndexEntry> PresetIndex::entries() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return entries_;
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetPrefetcher.h"
+#include <stdexcept>
+
+namespace plug::preset
+{
+
+    PresetPrefetcher::PresetPrefetcher(Parser parser, std::size_t capacity)
+        : parser_(std::move(parser)), capacity_(capacity), mutex_(), wakeUp_(), pending_(), cache_(), lookup_(), generation_(0), running_(true), worker_()
+    {
+        if (capacity_ == 0)
+        {
+            throw std::invalid_argument{"Prefetch capacity must not be zero"};
+        }
+        worker_ = std::thread{&PresetPrefetcher::run, this};
+    }
+
+    PresetPrefetcher::~PresetPrefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            running_ = false;
+        }
+        wakeUp_.notify_one();
+        worker_.join();
+    }
+
+    void PresetPrefetcher::prefetch(const std::vector<std::string>& paths)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            pending_.assign(paths.cbegin(), paths.cend());
+        }
+        wakeUp_.notify_one();
+    }
+
+    std::optional<SignalChain> PresetPrefetcher::get(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        const auto itr = lookup_.find(path);
+
+        if (itr == lookup_.cend())
+        {
+            return std::nullopt;
+        }
+        cache_.splice(cache_.begin(), cache_, itr->second);
+        return itr->second->second;
+    }
+
+    SignalChain PresetPrefetcher::load(const std::string& path)
+    {
+        if (auto chain = get(path); chain)
+        {
+            return *chain;
+        }
+
+        auto chain = parser_(path);
+        std::lock_guard<std::mutex> lock{mutex_};
+        insert(path, chain);
+        return chain;
+    }
+
+    void PresetPrefetcher::clear()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        pending_.clear();
+        cache_.clear();
+        lookup_.clear();
+        ++generation_;
+    }
+
+    void PresetPrefetcher::invalidate(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (const auto itr = lookup_.find(path); itr != lookup_.end())
+        {
+            cache_.erase(itr->second);
+            lookup_.erase(itr);
+        }
+        ++generation_;
+    }
+
+    void PresetPrefetcher::run()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+
+        while (running_ == true)
+        {
+            wakeUp_.wait(lock, [this] { return (pending_.empty() == false) || (running_ == false); });
+
+            if (running_ == false)
+            {
+                break;
+            }
+
+            const std::string path = pending_.front();
+            pending_.pop_front();
+
+            if (contains(path) == true)
+            {
+                continue;
+            }
+
+            const auto generation = generation_;
+            lock.unlock();
+            std::optional<SignalChain> chain;
+
+            try
+            {
+                chain = parser_(path);
+            }
+            catch (const std::exception&)
+            {
+                chain = std::nullopt;
+            }
+
+            lock.lock();
+
+            if (chain && (generation == generation_))
+            {
+                insert(path, std::move(*chain));
+            }
+        }
+    }
+
+    void PresetPrefetcher::insert(const std::string& path, SignalChain chain)
+    {
+        if (const auto itr = lookup_.find(path); itr != lookup_.end())
+        {
+            itr->second->second = std::move(chain);
+            cache_.splice(cache_.begin(), cache_, itr->second);
+            return;
+        }
+
+        cache_.emplace_front(path, std::move(chain));
+        lookup_[path] = cache_.begin();
+
+        if (cache_.size() > capacity_)
+        {
+            lookup_.erase(cache_.back().first);
+            cache_.pop_back();
+        }
+    }
+
+    bool PresetPrefetcher::contains(const std::string& path) const
+    {
+        return lookup_.find(path) != lookup_.cend();
+    }
+}
@@ -0,0 +1,636 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetSearch.h"
+#include "EffectDescriptor.h"
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+
+namespace plug::preset
+{
+    namespace
+    {
+        inline constexpr std::array<const char*, 12> ampNames{{"FENDER_57_DELUXE", "FENDER_59_BASSMAN", "FENDER_57_CHAMP",
+                                                               "FENDER_65_DELUXE_REVERB", "FENDER_65_PRINCETON", "FENDER_65_TWIN_REVERB",
+                                                               "FENDER_SUPER_SONIC", "BRITISH_60S", "BRITISH_70S", "BRITISH_80S",
+                                                               "AMERICAN_90S", "METAL_2000"}};
+        inline constexpr std::array<const char*, 13> cabinetNames{{"OFF", "57DLX", "BSSMN", "65DLX", "65PRN", "CHAMP", "4x12M",
+                                                                   "2x12C", "4x12G", "65TWN", "4x12V", "SS212", "SS112"}};
+        // Effect families and the DSPs running them, in EffectFamily order after none
+        inline constexpr std::array<const char*, 4> familyNames{{"stompbox", "modulation", "delay", "reverb"}};
+        inline constexpr std::array<const char*, 4> dspNames{{"effect0", "effect1", "effect2", "effect3"}};
+        inline constexpr std::array<const char*, 5> controlNames{{"gain", "volume", "treble", "middle", "bass"}};
+        inline constexpr std::size_t bitsPerWord{64};
+        inline constexpr unsigned fullMatchScore{100};
+
+
+        char lower(char c)
+        {
+            return ((c >= 'A') && (c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c);
+        }
+
+        bool isWordChar(char c)
+        {
+            const auto u = static_cast<unsigned char>(c);
+            return ((u >= 0x80) || ((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')));
+        }
+
+        std::string lowercase(std::string_view text)
+        {
+            std::string result(text.size(), ' ');
+            std::transform(text.cbegin(), text.cend(), result.begin(), lower);
+            return result;
+        }
+
+        // Lower case and without separators, "Fender '63 Spring" -> "fender63spring"
+        std::string normalized(std::string_view text)
+        {
+            std::string result;
+            result.reserve(text.size());
+
+            for (const char c : text)
+            {
+                if (isWordChar(c) == true)
+                {
+                    result.push_back(lower(c));
+                }
+            }
+            return result;
+        }
+
+        std::vector<std::string> words(std::string_view text)
+        {
+            std::vector<std::string> result;
+            std::size_t pos{0};
+
+            while (pos < text.size())
+            {
+                const auto begin = std::find_if(text.cbegin() + static_cast<std::ptrdiff_t>(pos), text.cend(), isWordChar);
+                const auto end = std::find_if_not(begin, text.cend(), isWordChar);
+
+                if (begin != end)
+                {
+                    result.push_back(lowercase(std::string_view{&*begin, static_cast<std::size_t>(end - begin)}));
+                }
+                pos = static_cast<std::size_t>(end - text.cbegin());
+            }
+            return result;
+        }
+
+        // Trigrams of a word padded with blanks; even single characters yield one
+        void addTrigrams(std::vector<std::uint32_t>& out, const std::string& word)
+        {
+            const std::string padded = " " + word + " ";
+
+            for (std::size_t i = 0; (i + 3) <= padded.size(); ++i)
+            {
+                out.push_back((static_cast<std::uint32_t>(static_cast<unsigned char>(padded[i])) << 16)
+                              | (static_cast<std::uint32_t>(static_cast<unsigned char>(padded[i + 1])) << 8)
+                              | static_cast<std::uint32_t>(static_cast<unsigned char>(padded[i + 2])));
+            }
+        }
+
+        void sortUnique(std::vector<std::uint32_t>& values)
+        {
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+        }
+
+        // Exact match or unique prefix of the normalized names
+        template <class Names>
+        std::size_t lookup(const Names& names, std::string_view field, std::string_view value)
+        {
+            const auto wanted = normalized(value);
+            std::size_t found{names.size()};
+            std::size_t prefixes{0};
+
+            for (std::size_t i = 0; i < names.size(); ++i)
+            {
+                const auto name = normalized(names[i]);
+
+                if (name == wanted)
+                {
+                    return i;
+                }
+                if ((wanted.empty() == false) && (name.compare(0, wanted.size(), wanted) == 0))
+                {
+                    found = i;
+                    ++prefixes;
+                }
+            }
+
+            if (prefixes != 1)
+            {
+                throw std::invalid_argument{"Unknown " + std::string{field} + ": " + std::string{value}};
+            }
+            return found;
+        }
+
+        std::array<const char*, 38> effectNames()
+        {
+            std::array<const char*, 38> names{};
+            std::transform(effectDescriptors.cbegin(), effectDescriptors.cend(), names.begin(), [](const auto& d) { return d.name; });
+            return names;
+        }
+
+        void resize(std::vector<std::uint64_t>& bitmap, std::size_t bits)
+        {
+            bitmap.resize((bits + bitsPerWord - 1) / bitsPerWord, 0);
+        }
+
+        void assign(std::vector<std::uint64_t>& bitmap, std::uint32_t bit, bool value)
+        {
+            const auto mask = std::uint64_t{1} << (bit % bitsPerWord);
+            auto& word = bitmap[bit / bitsPerWord];
+            word = (value == true ? (word | mask) : (word & ~mask));
+        }
+
+        bool test(const std::vector<std::uint64_t>& bitmap, std::uint32_t bit)
+        {
+            return ((bitmap[bit / bitsPerWord] >> (bit % bitsPerWord)) & 1u) != 0;
+        }
+
+        enum class Operator
+        {
+            equal,
+            notEqual,
+            less,
+            lessEqual,
+            greater,
+            greaterEqual
+        };
+
+        bool compare(std::uint8_t lhs, Operator op, int rhs)
+        {
+            switch (op)
+            {
+                case Operator::equal:
+                    return lhs == rhs;
+                case Operator::notEqual:
+                    return lhs != rhs;
+                case Operator::less:
+                    return lhs < rhs;
+                case Operator::lessEqual:
+                    return lhs <= rhs;
+                case Operator::greater:
+                    return lhs > rhs;
+                case Operator::greaterEqual:
+                    return lhs >= rhs;
+            }
+            return false;
+        }
+
+        struct Filter
+        {
+            std::string field;
+            Operator op;
+            std::string_view value;
+        };
+
+        Filter parseFilter(std::string_view term)
+        {
+            const auto pos = term.find_first_of("!<>=");
+            auto rest = term.substr(pos);
+            Operator op{Operator::equal};
+
+            if (rest.substr(0, 2) == "!=")
+            {
+                op = Operator::notEqual;
+            }
+            else if (rest.substr(0, 2) == "<=")
+            {
+                op = Operator::lessEqual;
+            }
+            else if (rest.substr(0, 2) == ">=")
+            {
+                op = Operator::greaterEqual;
+            }
+            else if (rest[0] == '<')
+            {
+                op = Operator::less;
+            }
+            else if (rest[0] == '>')
+            {
+                op = Operator::greater;
+            }
+            else if (rest[0] != '=')
+            {
+                throw std::invalid_argument{"Invalid filter: " + std::string{term}};
+            }
+
+            const std::size_t length = (((op == Operator::less) || (op == Operator::greater) || (op == Operator::equal)) ? 1 : 2);
+            const Filter filter{normalized(term.substr(0, pos)), op, rest.substr(length)};
+
+            if (filter.field.empty() || filter.value.empty())
+            {
+                throw std::invalid_argument{"Invalid filter: " + std::string{term}};
+            }
+            return filter;
+        }
+
+        std::vector<std::string_view> terms(std::string_view query)
+        {
+            std::vector<std::string_view> result;
+            std::size_t pos{0};
+
+            while ((pos = query.find_first_not_of(" \t\n", pos)) != std::string_view::npos)
+            {
+                const auto end = std::min(query.find_first_of(" \t\n", pos), query.size());
+                result.push_back(query.substr(pos, end - pos));
+                pos = end;
+            }
+            return result;
+        }
+    }
+
+
+    PresetAttributes attributesOf(const SignalChain& chain)
+    {
+        const auto amp = chain.amp();
+        PresetAttributes attributes{amp.amp_num, amp.cabinet, {}, amp.gain, amp.volume, amp.treble, amp.middle, amp.bass};
+        attributes.effectModels.fill(effects::EMPTY);
+
+        for (const auto& effect : chain.effects())
+        {
+            attributes.effectModels[effect.fx_slot % attributes.effectModels.size()] = effect.effect_num;
+        }
+        return attributes;
+    }
+
+    PresetAttributes attributesOf(const IndexEntry& entry)
+    {
+        return PresetAttributes{entry.amp, entry.cabinet, entry.effectModels, entry.gain, entry.volume, entry.treble, entry.middle, entry.bass};
+    }
+
+
+    void PresetSearch::insert(SearchSource source, const std::string& key, const std::string& name, const std::optional<PresetAttributes>& attributes)
+    {
+        const auto lookupKey = std::to_string(static_cast<int>(source)) + ':' + key;
+        const auto existing = ids_.find(lookupKey);
+        DocumentId id{};
+
+        if (existing != ids_.end())
+        {
+            id = existing->second;
+            unindex(id);
+        }
+        else
+        {
+            id = allocate();
+            ids_.emplace(lookupKey, id);
+        }
+
+        auto& document = documents_[id];
+        document.source = source;
+        document.key = key;
+        document.name = lowercase(name);
+        document.attributes = attributes;
+        document.trigrams.clear();
+
+        for (const auto& word : words(name))
+        {
+            addTrigrams(document.trigrams, word);
+        }
+        sortUnique(document.trigrams);
+        index(id);
+    }
+
+    void PresetSearch::erase(SearchSource source, const std::string& key)
+    {
+        const auto itr = ids_.find(std::to_string(static_cast<int>(source)) + ':' + key);
+
+        if (itr != ids_.end())
+        {
+            unindex(itr->second);
+            free_.push_back(itr->second);
+            ids_.erase(itr);
+        }
+    }
+
+    void PresetSearch::clear(SearchSource source)
+    {
+        std::vector<std::string> keys;
+
+        for (const auto& [lookupKey, id] : ids_)
+        {
+            if (documents_[id].source == source)
+            {
+                keys.push_back(documents_[id].key);
+            }
+        }
+
+        for (const auto& key : keys)
+        {
+            erase(source, key);
+        }
+    }
+
+    std::size_t PresetSearch::size() const
+    {
+        return ids_.size();
+    }
+
+    std::vector<SearchResult> PresetSearch::search(std::string_view query, std::size_t limit) const
+    {
+        Bitmap mask = used_;
+        std::vector<std::string> queryWords;
+
+        for (const auto term : terms(query))
+        {
+            if (term.find_first_of("!<>=") != std::string_view::npos)
+            {
+                const auto matches = evaluate(term);
+                std::transform(mask.cbegin(), mask.cend(), matches.cbegin(), mask.begin(), [](auto a, auto b) { return a & b; });
+            }
+            else if (lowercase(term) != "and")
+            {
+                const auto split = words(term);
+                queryWords.insert(queryWords.end(), split.cbegin(), split.cend());
+            }
+        }
+
+        std::vector<unsigned> scores(documents_.size(), 0);
+        std::vector<std::size_t> matchedWords(documents_.size(), 0);
+        std::vector<unsigned> shared(documents_.size(), 0);
+        std::vector<DocumentId> touched;
+
+        for (std::size_t w = 0; w < queryWords.size(); ++w)
+        {
+            std::vector<std::uint32_t> grams;
+            addTrigrams(grams, queryWords[w]);
+            sortUnique(grams);
+            const std::size_t needed = (grams.size() + 1) / 2;
+            touched.clear();
+
+            for (const auto gram : grams)
+            {
+                const auto postings = postings_.find(gram);
+
+                if (postings != postings_.end())
+                {
+                    for (const auto id : postings->second)
+                    {
+                        if (shared[id]++ == 0)
+                        {
+                            touched.push_back(id);
+                        }
+                    }
+                }
+            }
+
+            for (const auto id : touched)
+            {
+                if ((shared[id] >= needed) && (matchedWords[id] == w))
+                {
+                    const bool substring = (documents_[id].name.find(queryWords[w]) != std::string::npos);
+                    scores[id] += static_cast<unsigned>(fullMatchScore * shared[id] / grams.size()) + (substring ? fullMatchScore : 0);
+                    ++matchedWords[id];
+                }
+                shared[id] = 0;
+            }
+        }
+
+        std::vector<SearchResult> results;
+        std::vector<DocumentId> ids;
+
+        for (DocumentId id = 0; id < documents_.size(); ++id)
+        {
+            if (test(mask, id) && (matchedWords[id] == queryWords.size()))
+            {
+                ids.push_back(id);
+            }
+        }
+
+        std::sort(ids.begin(), ids.end(), [this, &scores](DocumentId a, DocumentId b) {
+            if (scores[a] != scores[b])
+            {
+                return scores[a] > scores[b];
+            }
+            return std::tie(documents_[a].name, documents_[a].source, documents_[a].key) < std::tie(documents_[b].name, documents_[b].source, documents_[b].key);
+        });
+
+        ids.resize(std::min(ids.size(), limit));
+        results.reserve(ids.size());
+        std::transform(ids.cbegin(), ids.cend(), std::back_inserter(results), [this, &scores](DocumentId id) {
+            return SearchResult{documents_[id].source, documents_[id].key, scores[id]};
+        });
+        return results;
+    }
+
+    PresetSearch::DocumentId PresetSearch::allocate()
+    {
+        if (free_.empty() == false)
+        {
+            const auto id = free_.back();
+            free_.pop_back();
+            return id;
+        }
+
+        const auto id = static_cast<DocumentId>(documents_.size());
+        documents_.emplace_back();
+        const auto bits = documents_.size();
+
+        for (auto* bitmap : {&used_, &hasAttributes_})
+        {
+            resize(*bitmap, bits);
+        }
+        for (auto& bitmap : amps_)
+        {
+            resize(bitmap, bits);
+        }
+        for (auto& bitmap : cabinets_)
+        {
+            resize(bitmap, bits);
+        }
+        for (auto& slot : effects_)
+        {
+            for (auto& bitmap : slot)
+            {
+                resize(bitmap, bits);
+            }
+        }
+        for (auto& column : controls_)
+        {
+            column.resize(bits, 0);
+        }
+        return id;
+    }
+
+    void PresetSearch::index(DocumentId id)
+    {
+        const auto& document = documents_[id];
+
+        for (const auto gram : document.trigrams)
+        {
+            postings_[gram].push_back(id);
+        }
+
+        assign(used_, id, true);
+        assign(hasAttributes_, id, document.attributes.has_value());
+
+        if (const auto& attributes = document.attributes)
+        {
+            assign(amps_[value(attributes->amp) % amps_.size()], id, true);
+            assign(cabinets_[value(attributes->cabinet) % cabinets_.size()], id, true);
+
+            for (std::size_t slot = 0; slot < effects_.size(); ++slot)
+            {
+                assign(effects_[slot][value(attributes->effectModels[slot]) % effects_[slot].size()], id, true);
+            }
+
+            const std::array<std::uint8_t, 5> controls{{attributes->gain, attributes->volume, attributes->treble, attributes->middle, attributes->bass}};
+
+            for (std::size_t i = 0; i < controls.size(); ++i)
+            {
+                controls_[i][id] = controls[i];
+            }
+        }
+    }
+
+    void PresetSearch::unindex(DocumentId id)
+    {
+        const auto& document = documents_[id];
+
+        for (const auto gram : document.trigrams)
+        {
+            auto& postings = postings_[gram];
+            postings.erase(std::remove(postings.begin(), postings.end(), id), postings.end());
+
+            if (postings.empty() == true)
+            {
+                postings_.erase(gram);
+            }
+        }
+
+        assign(used_, id, false);
+        assign(hasAttributes_, id, false);
+
+        if (const auto& attributes = document.attributes)
+        {
+            assign(amps_[value(attributes->amp) % amps_.size()], id, false);
+            assign(cabinets_[value(attributes->cabinet) % cabinets_.size()], id, false);
+
+            for (std::size_t slot = 0; slot < effects_.size(); ++slot)
+            {
+                assign(effects_[slot][value(attributes->effectModels[slot]) % effects_[slot].size()], id, false);
+            }
+        }
+    }
+
+    PresetSearch::Bitmap PresetSearch::evaluate(std::string_view term) const
+    {
+        const auto filter = parseFilter(term);
+        const auto numeric = std::find(controlNames.cbegin(), controlNames.cend(), filter.field);
+        Bitmap matches(used_.size(), 0);
+
+        if (numeric != controlNames.cend())
+        {
+            int number{0};
+            const auto [end, error] = std::from_chars(filter.value.data(), filter.value.data() + filter.value.size(), number);
+
+            if ((error != std::errc{}) || (end != filter.value.data() + filter.value.size()))
+            {
+                throw std::invalid_argument{"Invalid number: " + std::string{filter.value}};
+            }
+
+            const auto& column = controls_[static_cast<std::size_t>(numeric - controlNames.cbegin())];
+
+            for (std::size_t word = 0; word < matches.size(); ++word)
+            {
+                std::uint64_t bits{0};
+                const std::size_t first = word * bitsPerWord;
+                const std::size_t count = std::min(bitsPerWord, column.size() - first);
+
+                for (std::size_t bit = 0; bit < count; ++bit)
+                {
+                    bits |= std::uint64_t{compare(column[first + bit], filter.op, number)} << bit;
+                }
+                matches[word] = bits & hasAttributes_[word];
+            }
+            return matches;
+        }
+
+        if ((filter.op != Operator::equal) && (filter.op != Operator::notEqual))
+        {
+            throw std::invalid_argument{"Invalid filter: " + std::string{term}};
+        }
+
+        auto merge = [&matches](const Bitmap& bitmap) {
+            std::transform(matches.cbegin(), matches.cend(), bitmap.cbegin(), matches.begin(), [](auto a, auto b) { return a | b; });
+        };
+
+        if (filter.field == "amp")
+        {
+            merge(amps_[lookup(ampNames, filter.field, filter.value)]);
+        }
+        else if ((filter.field == "cabinet") || (filter.field == "cab"))
+        {
+            auto cabinet = normalized(filter.value);
+
+            if (cabinet.compare(0, 3, "cab") == 0)
+            {
+                cabinet.erase(0, 3);
+            }
+            merge(cabinets_[lookup(cabinetNames, filter.field, cabinet)]);
+        }
+        else if ((filter.field == "effect") || (filter.field == "fx"))
+        {
+            const auto effect = lookup(effectNames(), filter.field, filter.value);
+
+            for (const auto& slot : effects_)
+            {
+                merge(slot[effect]);
+            }
+        }
+        else if ((filter.field == "family") || (filter.field == "dsp"))
+        {
+            const auto index = (filter.field == "family" ? lookup(familyNames, filter.field, filter.value) : lookup(dspNames, filter.field, filter.value));
+            const auto family = static_cast<EffectFamily>(index + 1);
+
+            for (const auto& descriptor : effectDescriptors)
+            {
+                if (descriptor.family == family)
+                {
+                    for (const auto& slot : effects_)
+                    {
+                        merge(slot[value(descriptor.id)]);
+                    }
+                }
+            }
+        }
+        else if ((filter.field.size() == 3) && (filter.field.compare(0, 2, "fx") == 0) && (filter.field[2] >= '1') && (filter.field[2] <= '4'))
+        {
+            merge(effects_[static_cast<std::size_t>(filter.field[2] - '1')][lookup(effectNames(), filter.field, filter.value)]);
+        }
+        else
+        {
+            throw std::invalid_argument{"Unknown filter: " + std::string{term}};
+        }
+
+        if (filter.op == Operator::notEqual)
+        {
+            std::transform(matches.cbegin(), matches.cend(), hasAttributes_.cbegin(), matches.begin(), [](auto a, auto b) { return ~a & b; });
+        }
+        return matches;
+    }
+}
@@ -0,0 +1,178 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/WorkStealingPool.h"
+#include <algorithm>
+
+namespace plug::preset
+{
+    namespace
+    {
+        thread_local const WorkStealingPool* currentPool{nullptr};
+        thread_local std::size_t currentIndex{0};
+    }
+
+
+    WorkStealingPool::WorkStealingPool(std::size_t threads)
+        : queued_(0), pending_(0), next_(0), running_(true)
+    {
+        const std::size_t count = (threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()));
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            workers_.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            running_ = false;
+        }
+        wakeUp_.notify_all();
+        std::for_each(workers_.begin(), workers_.end(), [](auto& t) { t.join(); });
+    }
+
+    void WorkStealingPool::submit(Task task)
+    {
+        std::size_t index{0};
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            ++pending_;
+            ++queued_;
+            index = (currentPool == this ? currentIndex : next_++ % queues_.size());
+        }
+        {
+            auto& queue = *queues_[index];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            queue.tasks.push_back(std::move(task));
+        }
+        wakeUp_.notify_one();
+    }
+
+    void WorkStealingPool::wait()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        done_.wait(lock, [this] { return pending_ == 0; });
+
+        if (error_)
+        {
+            auto error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::size_t WorkStealingPool::size() const
+    {
+        return workers_.size();
+    }
+
+    void WorkStealingPool::run(std::size_t index)
+    {
+        currentPool = this;
+        currentIndex = index;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock{mutex_};
+                wakeUp_.wait(lock, [this] { return (queued_ > 0) || (running_ == false); });
+
+                if ((running_ == false) && (queued_ == 0))
+                {
+                    return;
+                }
+            }
+
+            Task task;
+
+            if ((popOwn(index, task) == false) && (steal(index, task) == false))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::exception_ptr error;
+
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            finish(error);
+        }
+    }
+
+    bool WorkStealingPool::popOwn(std::size_t index, Task& task)
+    {
+        auto& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+
+        if (queue.tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        --queued_;
+        return true;
+    }
+
+    bool WorkStealingPool::steal(std::size_t index, Task& task)
+    {
+        for (std::size_t i = 1; i < queues_.size(); ++i)
+        {
+            auto& queue = *queues_[(index + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+
+            if (queue.tasks.empty() == false)
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                --queued_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkStealingPool::finish(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+
+        if (error && (error_ == nullptr))
+        {
+            error_ = error;
+        }
+        if (--pending_ == 0)
+        {
+            done_.notify_all();
+        }
+    }
+}
@@ -329,6 +329,11 @@ namespace plug
         advanced->set_usb_gain(settings.usb_gain);
     }
 
+    void Amplifier::set_changed(bool value)
+    {
+        changed = value;
+    }
+
     void Amplifier::get_settings(amp_settings* settings)
     {
         settings->amp_num = amp_num;
@@ -0,0 +1,241 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ * Copyright (C) 2010-2016  piorekf <piorek@piorekf.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ui/appsettings.h"
+#include <QSettings>
+#include <QWidget>
+#include <algorithm>
+#include <utility>
+
+namespace plug
+{
+    namespace
+    {
+        inline constexpr int writeDelayMs{500};
+        inline constexpr int maxPort{0xffff};
+
+        inline constexpr std::array<const char*, 5> flagKeys{{"Settings/connectOnStartup",
+                                                              "Settings/oneSetToSetThemAll",
+                                                              "Settings/keepWindowsOpen",
+                                                              "Settings/popupChangedWindows",
+                                                              "Settings/defaultEffectValues"}};
+
+        inline constexpr std::array<bool, 5> flagDefaults{{true, false, false, true, true}};
+
+
+        QString quickPresetKey(std::size_t index)
+        {
+            return QString("DefaultPresets/Preset%1").arg(index);
+        }
+    }
+
+
+    AppSettings::AppSettings(QObject* parent)
+        : QObject(parent),
+          dirtyFlags{},
+          dirtyPresets{},
+          oscPort(0)
+    {
+        static_assert(flagKeys.size() == flagCount);
+        QSettings settings;
+
+        for (std::size_t i = 0; i < flagCount; ++i)
+        {
+            flags[i] = settings.value(flagKeys[i], flagDefaults[i]).toBool();
+            dirtyFlags[i] = (settings.contains(flagKeys[i]) == false);
+        }
+
+        for (std::size_t i = 0; i < quickPresetCount; ++i)
+        {
+            const QString key = quickPresetKey(i);
+
+            if (settings.contains(key))
+            {
+                quickPresets[i] = settings.value(key).toInt();
+            }
+        }
+
+        oscAddress = settings.value("Osc/address", "127.0.0.1").toString();
+        const int port = settings.value("Osc/port", 0).toInt();
+
+        if ((port > 0) && (port <= maxPort))
+        {
+            oscPort = static_cast<std::uint16_t>(port);
+        }
+
+        writeTimer.setSingleShot(true);
+        writeTimer.setInterval(writeDelayMs);
+        connect(&writeTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+        if (std::find(dirtyFlags.cbegin(), dirtyFlags.cend(), true) != dirtyFlags.cend())
+        {
+            schedule_write();
+        }
+    }
+
+    AppSettings::~AppSettings()
+    {
+        flush();
+    }
+
+    bool AppSettings::read_connect_on_startup()
+    {
+        return QSettings{}.value(flagKeys[connectOnStartup], flagDefaults[connectOnStartup]).toBool();
+    }
+
+    void AppSettings::restore_geometry(QWidget& window, const QString& key)
+    {
+        window.restoreGeometry(QSettings{}.value(key).toByteArray());
+    }
+
+    void AppSettings::save_geometry(const QWidget& window, const QString& key)
+    {
+        QSettings{}.setValue(key, window.saveGeometry());
+    }
+
+    bool AppSettings::connect_on_startup() const
+    {
+        return flags[connectOnStartup];
+    }
+
+    bool AppSettings::one_set_to_set_them_all() const
+    {
+        return flags[oneSetToSetThemAll];
+    }
+
+    bool AppSettings::keep_windows_open() const
+    {
+        return flags[keepWindowsOpen];
+    }
+
+    bool AppSettings::popup_changed_windows() const
+    {
+        return flags[popupChangedWindows];
+    }
+
+    bool AppSettings::default_effect_values() const
+    {
+        return flags[defaultEffectValues];
+    }
+
+    std::optional<int> AppSettings::quick_preset(std::size_t index) const
+    {
+        return quickPresets.at(index);
+    }
+
+    QString AppSettings::osc_address() const
+    {
+        return oscAddress;
+    }
+
+    std::uint16_t AppSettings::osc_port() const
+    {
+        return oscPort;
+    }
+
+    void AppSettings::set_connect_on_startup(bool value)
+    {
+        set_flag(connectOnStartup, value);
+    }
+
+    void AppSettings::set_one_set_to_set_them_all(bool value)
+    {
+        set_flag(oneSetToSetThemAll, value);
+    }
+
+    void AppSettings::set_keep_windows_open(bool value)
+    {
+        set_flag(keepWindowsOpen, value);
+    }
+
+    void AppSettings::set_popup_changed_windows(bool value)
+    {
+        set_flag(popupChangedWindows, value);
+    }
+
+    void AppSettings::set_default_effect_values(bool value)
+    {
+        set_flag(defaultEffectValues, value);
+    }
+
+    void AppSettings::set_quick_preset(std::size_t index, std::optional<int> slot)
+    {
+        if (quickPresets.at(index) == slot)
+        {
+            return;
+        }
+        quickPresets[index] = slot;
+        dirtyPresets[index] = true;
+        schedule_write();
+        emit changed();
+    }
+
+    void AppSettings::flush()
+    {
+        writeTimer.stop();
+        QSettings settings;
+
+        for (std::size_t i = 0; i < flagCount; ++i)
+        {
+            if (std::exchange(dirtyFlags[i], false))
+            {
+                settings.setValue(flagKeys[i], flags[i]);
+            }
+        }
+
+        for (std::size_t i = 0; i < quickPresetCount; ++i)
+        {
+            if (std::exchange(dirtyPresets[i], false))
+            {
+                if (quickPresets[i])
+                {
+                    settings.setValue(quickPresetKey(i), *quickPresets[i]);
+                }
+                else
+                {
+                    settings.remove(quickPresetKey(i));
+                }
+            }
+        }
+    }
+
+    void AppSettings::set_flag(Flag flag, bool value)
+    {
+        if (flags[flag] == value)
+        {
+            return;
+        }
+        flags[flag] = value;
+        dirtyFlags[flag] = true;
+        schedule_write();
+        emit changed();
+    }
+
+    void AppSettings::schedule_write()
+    {
+        if (writeTimer.isActive() == false)
+        {
+            writeTimer.start();
+        }
+    }
+}
+
+#include "ui/moc_appsettings.moc"
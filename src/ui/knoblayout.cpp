@@ -0,0 +1,81 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ * Copyright (C) 2010-2016  piorekf <piorek@piorekf.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ui/knoblayout.h"
+#include "EffectDescriptor.h"
+#include <QCoreApplication>
+#include <QDial>
+#include <QLabel>
+#include <QObject>
+#include <QSpinBox>
+
+namespace plug
+{
+
+    void layoutKnobs(const std::array<KnobWidgets, 6>& widgets, const EffectDescriptor& descriptor, const QString& owner, bool resetUnused)
+    {
+        const bool isEmpty = (descriptor.id == effects::EMPTY);
+
+        for (std::size_t i = 0; i < widgets.size(); ++i)
+        {
+            const auto& knob = descriptor.knobs[i];
+            const auto& [label, dial, spinBox] = widgets[i];
+            const int number = static_cast<int>(i) + 1;
+
+            // activate proper knobs and set their max values
+            dial->setMaximum(knob.maximum);
+            spinBox->setMaximum(knob.maximum);
+            dial->setEnabled(knob.isUsed());
+            spinBox->setEnabled(knob.isUsed());
+
+            if ((knob.isUsed() == false) && resetUnused)
+            {
+                dial->setValue(0);
+            }
+
+            // set knobs labels and accessibility informations
+            if (knob.isUsed())
+            {
+                label->setText(QCoreApplication::translate(effectTranslationContext, knob.label));
+                dial->setAccessibleName(QObject::tr("%1 \"%2\" dial").arg(owner).arg(knob.parameter));
+                dial->setAccessibleDescription(QObject::tr("Allows you to set \"%1\" parameter of this effect").arg(knob.parameter));
+                spinBox->setAccessibleName(QObject::tr("%1 \"%2\" box").arg(owner).arg(knob.parameter));
+                spinBox->setAccessibleDescription(QObject::tr("Allows you to precisely set \"%1\" parameter of this effect").arg(knob.parameter));
+            }
+            else if (isEmpty)
+            {
+                label->setText("");
+                dial->setAccessibleName(QObject::tr("%1 dial %2").arg(owner).arg(number));
+                dial->setAccessibleDescription(QObject::tr("When you choose an effect you can set value of a parameter here"));
+                spinBox->setAccessibleName(QObject::tr("%1 box %2").arg(owner).arg(number));
+                spinBox->setAccessibleDescription(QObject::tr("When you choose an effect you can set precise value of a parameter here"));
+            }
+            else
+            {
+                label->setText("");
+                dial->setAccessibleName(QObject::tr("Disabled dial"));
+                dial->setAccessibleDescription(QObject::tr("This dial is disabled in this effect"));
+                spinBox->setAccessibleName(QObject::tr("Disabled box"));
+                spinBox->setAccessibleDescription(QObject::tr("This box is disabled in this effect"));
+            }
+        }
+    }
+}
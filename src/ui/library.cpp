@@ -21,20 +21,93 @@
 
 #include "ui/library.h"
 #include "ui/mainwindow.h"
+#include "ui/presetfilemodel.h"
+#include "ui/presetnamemodel.h"
+#include "preset/Converter.h"
+#include "preset/Duplicates.h"
+#include "preset/FuseCodec.h"
 #include "ui_library.h"
+#include <QCryptographicHash>
+#include <QDebug>
 #include <QDir>
+#include <QDirIterator>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QSet>
 #include <QSettings>
+#include <QSignalBlocker>
+#include <QStandardPaths>
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 namespace plug
 {
+    namespace
+    {
+        inline constexpr int loadDelayMs{150};
+        inline constexpr int refreshDelayMs{200};
+        inline constexpr int searchDelayMs{150};
+        inline constexpr int prefetchDistance{2};
+        inline constexpr std::size_t prefetchCapacity{32};
+
+        QString indexFileFor(const QString& directory)
+        {
+            const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+            QDir().mkpath(cacheDir);
+
+            const QByteArray key = QCryptographicHash::hash(QDir(directory).canonicalPath().toUtf8(), QCryptographicHash::Md5).toHex();
+            return cacheDir + "/library-" + QString::fromLatin1(key) + ".index";
+        }
+
+        // The directory and all directories below it
+        QStringList subdirectories(const QString& path)
+        {
+            QStringList directories{path};
+            QDirIterator itr{path, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories};
+
+            while (itr.hasNext())
+            {
+                directories.append(itr.next());
+            }
+            return directories;
+        }
+    }
 
-    Library::Library(const std::vector<std::string>& names, QWidget* parent)
+    Library::Library(PresetNameModel& presets, QWidget* parent)
         : QDialog(parent),
           ui(std::make_unique<Ui::Library>()),
-          files(std::make_unique<QList<QFileInfo>>())
+          amp_presets(presets),
+          file_model(new PresetFileModel(this)),
+          watcher(new QFileSystemWatcher(this)),
+          directory(),
+          selected_file(),
+          changed_directories(),
+          scanning(false),
+          index(),
+          indexers(),
+          next_indexer(0),
+          duplicate_finder(),
+          generation(0),
+          prefetcher(std::make_unique<preset::PresetPrefetcher>(preset::loadFuseFile, prefetchCapacity)),
+          load_timer(new QTimer(this)),
+          refresh_timer(new QTimer(this)),
+          search_timer(new QTimer(this)),
+          search()
     {
         ui->setupUi(this);
+        ui->listView->setModel(&presets);
+        ui->listView_2->setModel(file_model);
+        load_timer->setSingleShot(true);
+        load_timer->setInterval(loadDelayMs);
+        refresh_timer->setSingleShot(true);
+        refresh_timer->setInterval(refreshDelayMs);
+        search_timer->setSingleShot(true);
+        search_timer->setInterval(searchDelayMs);
         QSettings settings;
         restoreGeometry(settings.value("Windows/libraryWindowGeometry").toByteArray());
 
@@ -44,25 +117,33 @@ namespace plug
             get_files(settings.value("Library/lastDirectory").toString());
         }
 
-        QFont font(settings.value("Library/FontFamily", ui->listWidget->font().family()).toString(), settings.value("Library/FontSize", ui->listWidget->font().pointSize()).toInt());
-        ui->listWidget->setFont(font);
-        ui->listWidget_2->setFont(font);
+        QFont font(settings.value("Library/FontFamily", ui->listView->font().family()).toString(), settings.value("Library/FontSize", ui->listView->font().pointSize()).toInt());
+        ui->listView->setFont(font);
+        ui->listView_2->setFont(font);
 
         ui->spinBox->setValue(font.pointSize());
         ui->fontComboBox->setCurrentFont(font);
+        index_amp_presets(0, presets.rowCount() - 1);
 
-        for (std::size_t i = 0; i < 100; ++i)
-        {
-            if (names[i][0] == 0x00)
-            {
-                break;
-            }
-            ui->listWidget->addItem(QString("[%1] %2").arg(i + 1).arg(QString::fromStdString(names[i])));
-        }
-
-        connect(ui->listWidget, SIGNAL(currentRowChanged(int)), this, SLOT(load_slot(int)));
-        connect(ui->listWidget_2, SIGNAL(currentRowChanged(int)), this, SLOT(load_file(int)));
+        connect(ui->listView->selectionModel(), &QItemSelectionModel::currentRowChanged, this, [this](const QModelIndex& current) { load_slot(current.row()); });
+        connect(ui->listView_2->selectionModel(), &QItemSelectionModel::currentRowChanged, this, [this](const QModelIndex& current) { load_file(current.row()); });
+        connect(&presets, &QAbstractItemModel::modelReset, this, [this] {
+            search.clear(preset::SearchSource::amp);
+            index_amp_presets(0, amp_presets.rowCount() - 1);
+            apply_search();
+        });
+        connect(&presets, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex& first, const QModelIndex& last) {
+            index_amp_presets(first.row(), last.row());
+            search_timer->start();
+        });
+        // Searching runs once typing pauses, not for every keystroke
+        connect(ui->lineEdit, SIGNAL(textChanged(QString)), search_timer, SLOT(start()));
+        connect(search_timer, SIGNAL(timeout()), this, SLOT(apply_search()));
+        connect(load_timer, SIGNAL(timeout()), this, SLOT(load_selected_file()));
+        connect(refresh_timer, SIGNAL(timeout()), this, SLOT(refresh_directories()));
+        connect(watcher, SIGNAL(directoryChanged(QString)), this, SLOT(directory_modified(QString)));
         connect(ui->pushButton, SIGNAL(clicked()), this, SLOT(get_directory()));
+        connect(ui->pushButton_2, SIGNAL(clicked()), this, SLOT(find_duplicates()));
         connect(this, SIGNAL(directory_changed(QString)), ui->label_3, SLOT(setText(QString)));
         connect(this, SIGNAL(directory_changed(QString)), this, SLOT(get_files(QString)));
         connect(ui->spinBox, SIGNAL(valueChanged(int)), this, SLOT(change_font_size(int)));
@@ -71,6 +152,19 @@ namespace plug
 
     Library::~Library()
     {
+        if (index)
+        {
+            index->cancel();
+        }
+        for (auto& [job, thread] : indexers)
+        {
+            thread.join();
+        }
+
+        if (duplicate_finder.joinable())
+        {
+            duplicate_finder.join();
+        }
         QSettings settings;
         settings.setValue("Windows/libraryWindowGeometry", saveGeometry());
     }
@@ -82,7 +176,8 @@ namespace plug
             return;
         }
 
-        ui->listWidget_2->setCurrentRow(-1);
+        load_timer->stop();
+        ui->listView_2->selectionModel()->clear();
         dynamic_cast<MainWindow*>(parent())->load_from_amp(slot);
     }
 
@@ -102,20 +197,346 @@ namespace plug
 
     void Library::get_files(const QString& path)
     {
-        QDir directory(path, "*.fuse", (QDir::Name | QDir::IgnoreCase), (QDir::Files | QDir::NoDotAndDotDot | QDir::Readable));
+        // The scan of the previous directory ends on its own, its results are dropped
+        if (index)
+        {
+            index->cancel();
+        }
+        ++generation;
+        load_timer->stop();
+        refresh_timer->stop();
+        prefetcher->clear();
+        changed_directories.clear();
+        selected_file.clear();
+
+        if (const QStringList watched = watcher->directories(); watched.isEmpty() == false)
+        {
+            watcher->removePaths(watched);
+        }
+
+        directory = path;
+        scanning = true;
+        file_model->reset(directory, {});
+        search.clear(preset::SearchSource::library);
+
+        // Show the persisted index right away, rescan in the background and
+        // watch the directories for changes from then on
+        index = std::make_shared<preset::PresetIndex>(preset::loadFuseFile);
+        run_indexer([this, path, current = generation, idx = index, indexFile = indexFileFor(path).toStdString()] {
+            std::vector<preset::IndexEntry> shown;
+
+            if (idx->load(indexFile))
+            {
+                shown = idx->entries();
+                post(current, [this, entries = shown] { show_changes(preset::IndexDiff{}, &entries); });
+            }
+
+            try
+            {
+                if (idx->update(path.toStdString()).cancelled)
+                {
+                    return;
+                }
+
+                auto entries = idx->entries();
+                auto diff = preset::diffEntries(shown, entries);
+                post(current, [this, entries = std::move(entries), diff = std::move(diff), directories = subdirectories(path)] {
+                    show_changes(diff, (file_model->rowCount() == 0) ? &entries : nullptr);
+                    watch(directories);
+                });
+                idx->save(indexFile);
+            }
+            catch (const std::exception& ex)
+            {
+                qWarning() << "ERROR: " << ex.what();
+            }
+            post(current, [this] { finish_scan(); });
+        });
+    }
+
+    void Library::directory_modified(const QString& path)
+    {
+        changed_directories.insert(path);
+        refresh_timer->start();
+    }
+
+    void Library::refresh_directories()
+    {
+        if (scanning || changed_directories.isEmpty())
+        {
+            return;
+        }
+
+        const QStringList directories = changed_directories.values();
+        changed_directories.clear();
+        scanning = true;
+
+        // The previous scan of the index has finished, including its save
+        run_indexer([this, directories, current = generation, idx = index, indexFile = indexFileFor(directory).toStdString()] {
+            const auto previous = idx->entries();
+            QStringList added;
+
+            try
+            {
+                for (const QString& path : directories)
+                {
+                    if (QFileInfo(path).isDir() == false)
+                    {
+                        continue;
+                    }
+                    if (idx->updateDirectory(path.toStdString()).cancelled)
+                    {
+                        return;
+                    }
+                    added += subdirectories(path);
+                }
+
+                auto diff = preset::diffEntries(previous, idx->entries());
+                post(current, [this, diff = std::move(diff), added] {
+                    show_changes(diff, nullptr);
+                    watch(added);
+                });
+                idx->save(indexFile);
+            }
+            catch (const std::exception& ex)
+            {
+                qWarning() << "ERROR: " << ex.what();
+            }
+            post(current, [this] { finish_scan(); });
+        });
+    }
+
+    // Indexer threads are joined once their work is done, only the destructor waits for them
+    void Library::run_indexer(std::function<void()> work)
+    {
+        const std::size_t job = next_indexer++;
+
+        indexers.emplace(job, std::thread{[this, job, work = std::move(work)] {
+                             work();
+                             QMetaObject::invokeMethod(this, [this, job] { finish_indexer(job); }, Qt::QueuedConnection);
+                         }});
+    }
+
+    void Library::finish_indexer(std::size_t job)
+    {
+        if (const auto itr = indexers.find(job); itr != indexers.end())
+        {
+            itr->second.join();
+            indexers.erase(itr);
+        }
+    }
+
+    void Library::post(std::size_t current, std::function<void()> update)
+    {
+        QMetaObject::invokeMethod(
+            this, [this, current, update = std::move(update)] {
+                if (current == generation)
+                {
+                    update();
+                }
+            },
+            Qt::QueuedConnection);
+    }
+
+    void Library::show_changes(const preset::IndexDiff& diff, const std::vector<preset::IndexEntry>* entries)
+    {
+        for (const auto& entry : diff.changed)
+        {
+            prefetcher->invalidate(entry.path);
+        }
+        for (const auto& path : diff.removed)
+        {
+            prefetcher->invalidate(path);
+        }
+        for (const auto& renamed : diff.renamed)
+        {
+            prefetcher->invalidate(renamed.first);
+        }
+
+        // Changing rows must not send another preset to the amp
+        const QSignalBlocker blocker(ui->listView_2->selectionModel());
+
+        if (entries != nullptr)
+        {
+            file_model->reset(directory, *entries);
+            search.clear(preset::SearchSource::library);
+
+            for (const auto& entry : *entries)
+            {
+                search.insert(preset::SearchSource::library, entry.path, entry.name, preset::attributesOf(entry));
+            }
+        }
+        else
+        {
+            file_model->apply(diff);
+
+            for (const auto& path : diff.removed)
+            {
+                search.erase(preset::SearchSource::library, path);
+            }
+            for (const auto& [oldPath, entry] : diff.renamed)
+            {
+                search.erase(preset::SearchSource::library, oldPath);
+                search.insert(preset::SearchSource::library, entry.path, entry.name, preset::attributesOf(entry));
+            }
+            for (const auto* modified : {&diff.added, &diff.changed})
+            {
+                for (const auto& entry : *modified)
+                {
+                    search.insert(preset::SearchSource::library, entry.path, entry.name, preset::attributesOf(entry));
+                }
+            }
+        }
+        apply_search();
+    }
+
+    void Library::watch(const QStringList& directories)
+    {
+        QSet<QString> known;
+        QStringList missing;
+
+        for (const QString& path : watcher->directories())
+        {
+            known.insert(path);
+        }
+
+        std::copy_if(directories.cbegin(), directories.cend(), std::back_inserter(missing), [&known](const auto& path) { return known.contains(path) == false; });
+
+        if (missing.isEmpty() == false)
+        {
+            watcher->addPaths(missing);
+        }
+    }
+
+    void Library::finish_scan()
+    {
+        scanning = false;
 
-        if (!files->isEmpty())
+        if (changed_directories.isEmpty() == false)
         {
-            files->clear();
+            refresh_timer->start();
         }
-        ui->listWidget_2->clear();
-        *files = directory.entryInfoList(QDir::Files | QDir::NoDotAndDotDot | QDir::Readable);
-        for (int i = 0; i < files->size(); ++i)
+    }
+
+    void Library::index_amp_presets(int first, int last)
+    {
+        for (int slot = first; slot <= last; ++slot)
         {
-            ui->listWidget_2->addItem((*files)[i].completeBaseName());
+            const auto chain = amp_presets.chain(slot);
+            const auto attributes = (chain.has_value() ? std::optional{preset::attributesOf(*chain)} : std::nullopt);
+            search.insert(preset::SearchSource::amp, std::to_string(slot), amp_presets.name(slot).toStdString(), attributes);
         }
     }
 
+    // Hides all presets not matching the query, both lists keep their order
+    void Library::apply_search()
+    {
+        search_timer->stop();
+
+        const std::string query = ui->lineEdit->text().trimmed().toStdString();
+        std::vector<preset::SearchResult> results;
+
+        try
+        {
+            results = search.search(query, search.size());
+            ui->lineEdit->setToolTip({});
+        }
+        catch (const std::invalid_argument& ex)
+        {
+            ui->lineEdit->setToolTip(QString::fromUtf8(ex.what()));
+            return;
+        }
+
+        QSet<int> slots;
+        QSet<QString> paths;
+
+        for (const auto& result : results)
+        {
+            if (result.source == preset::SearchSource::amp)
+            {
+                slots.insert(std::stoi(result.key));
+            }
+            else
+            {
+                paths.insert(QString::fromStdString(result.key));
+            }
+        }
+
+        for (int row = 0; row < amp_presets.rowCount(); ++row)
+        {
+            ui->listView->setRowHidden(row, slots.contains(row) == false);
+        }
+        for (int row = 0; row < file_model->rowCount(); ++row)
+        {
+            ui->listView_2->setRowHidden(row, paths.contains(file_model->path(row)) == false);
+        }
+    }
+
+    void Library::find_duplicates()
+    {
+        if (directory.isEmpty() || duplicate_finder.joinable())
+        {
+            return;
+        }
+
+        bool ok{false};
+        const int distance = QInputDialog::getInt(this, tr("Find duplicates"), tr("Maximum difference of the settings (0: identical only):"), 0, 0, 255 * 64, 1, &ok);
+
+        if (ok == false)
+        {
+            return;
+        }
+
+        ui->pushButton_2->setEnabled(false);
+
+        duplicate_finder = std::thread{[this, path = directory, current = generation, distance] {
+            QString summary;
+            QString details;
+
+            try
+            {
+                preset::ConversionReport report{0, 0, 0, 0, 0, {}, {}};
+                const auto presets = preset::readPresets(path.toStdString(), report);
+                std::vector<PackedSignalChain> packed;
+                packed.reserve(presets.size());
+                std::transform(presets.cbegin(), presets.cend(), std::back_inserter(packed), [](const auto& p) { return pack(p.chain); });
+
+                const auto clusters = preset::findDuplicates(packed, static_cast<unsigned>(distance));
+                const auto unique = preset::uniquePresets(presets.size(), clusters);
+                summary = tr("%1 of %2 presets are duplicates, in %3 groups.").arg(presets.size() - unique.size()).arg(presets.size()).arg(clusters.size());
+
+                for (const auto& cluster : clusters)
+                {
+                    details += (cluster.exact ? tr("Identical:") : tr("Difference up to %1:").arg(cluster.maxDistance)) + "\n";
+
+                    for (const auto member : cluster.members)
+                    {
+                        details += "  " + QString::fromStdString(presets[member].source) + "\n";
+                    }
+                }
+            }
+            catch (const std::exception& ex)
+            {
+                qWarning() << "ERROR: " << ex.what();
+                summary = tr("Could not read presets");
+            }
+
+            QMetaObject::invokeMethod(
+                this, [this, current, summary, details] {
+                    duplicate_finder.join();
+                    ui->pushButton_2->setEnabled(true);
+
+                    if (current == generation)
+                    {
+                        QMessageBox box(QMessageBox::Information, tr("Duplicates"), summary, QMessageBox::Ok, this);
+                        box.setDetailedText(details);
+                        box.exec();
+                    }
+                },
+                Qt::QueuedConnection);
+        }};
+    }
+
     void Library::load_file(int row)
     {
         if (row < 0)
@@ -123,8 +544,44 @@ namespace plug
             return;
         }
 
-        ui->listWidget->setCurrentRow(-1);
-        dynamic_cast<MainWindow*>(parent())->loadfile((*files)[row].canonicalFilePath());
+        ui->listView->selectionModel()->clear();
+        selected_file = file_model->path(row);
+
+        // Parse the selection and its neighbours in the background, but only
+        // send the preset to the amp once the selection stopped changing
+        std::vector<std::string> paths{selected_file.toStdString()};
+
+        for (int distance = 1; distance <= prefetchDistance; ++distance)
+        {
+            for (const int neighbour : {row + distance, row - distance})
+            {
+                if ((neighbour >= 0) && (neighbour < file_model->rowCount()))
+                {
+                    paths.push_back(file_model->path(neighbour).toStdString());
+                }
+            }
+        }
+
+        prefetcher->prefetch(paths);
+        load_timer->start();
+    }
+
+    void Library::load_selected_file()
+    {
+        if (selected_file.isEmpty())
+        {
+            return;
+        }
+
+        try
+        {
+            dynamic_cast<MainWindow*>(parent())->load_preset(prefetcher->load(selected_file.toStdString()));
+        }
+        catch (const std::exception& ex)
+        {
+            qWarning() << "ERROR: " << ex.what();
+            QMessageBox::critical(this, tr("Error!"), tr("Could not open file"));
+        }
     }
 
     void Library::resizeEvent(QResizeEvent* event)
@@ -135,11 +592,11 @@ namespace plug
     void Library::change_font_size(int value)
     {
         QSettings settings;
-        QFont font(ui->listWidget_2->font());
+        QFont font(ui->listView_2->font());
 
         font.setPointSize(value);
-        ui->listWidget->setFont(font);
-        ui->listWidget_2->setFont(font);
+        ui->listView->setFont(font);
+        ui->listView_2->setFont(font);
 
         settings.setValue("Library/FontSize", value);
     }
@@ -149,8 +606,8 @@ namespace plug
         QSettings settings;
 
         font.setPointSize(ui->spinBox->value());
-        ui->listWidget->setFont(font);
-        ui->listWidget_2->setFont(font);
+        ui->listView->setFont(font);
+        ui->listView_2->setFont(font);
 
         settings.setValue("Library/FontFamily", font.family());
     }
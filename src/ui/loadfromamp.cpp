@@ -20,9 +20,10 @@
  */
 
 #include "ui/loadfromamp.h"
+#include "ui/appsettings.h"
 #include "ui/mainwindow.h"
+#include "ui/presetnamemodel.h"
 #include "ui_loadfromamp.h"
-#include <QSettings>
 
 namespace plug
 {
@@ -32,9 +33,9 @@ namespace plug
           ui(std::make_unique<Ui::LoadFromAmp>())
     {
         ui->setupUi(this);
+        ui->comboBox->setModel(&dynamic_cast<MainWindow*>(parent)->preset_model());
 
-        QSettings settings;
-        restoreGeometry(settings.value("Windows/loadAmpPresetWindowGeometry").toByteArray());
+        AppSettings::restore_geometry(*this, "Windows/loadAmpPresetWindowGeometry");
 
         connect(ui->pushButton, SIGNAL(clicked()), this, SLOT(load()));
         connect(ui->pushButton_2, SIGNAL(clicked()), this, SLOT(close()));
@@ -42,48 +43,19 @@ namespace plug
 
     LoadFromAmp::~LoadFromAmp()
     {
-        QSettings settings;
-        settings.setValue("Windows/loadAmpPresetWindowGeometry", saveGeometry());
+        AppSettings::save_geometry(*this, "Windows/loadAmpPresetWindowGeometry");
     }
 
     void LoadFromAmp::load()
     {
-        QSettings settings;
-
         dynamic_cast<MainWindow*>(parent())->load_from_amp(ui->comboBox->currentIndex());
         dynamic_cast<MainWindow*>(parent())->set_index(ui->comboBox->currentIndex());
 
-        if (!settings.value("Settings/keepWindowsOpen").toBool())
+        if (dynamic_cast<MainWindow*>(parent())->app_settings().keep_windows_open() == false)
         {
             this->close();
         }
     }
-
-    void LoadFromAmp::load_names(const std::vector<std::string>& names)
-    {
-        for (std::size_t i = 0; i < 100; ++i)
-        {
-            if (names[i][0] == 0x00)
-            {
-                break;
-            }
-            ui->comboBox->addItem(QString("[%1] %2").arg(i + 1).arg(QString::fromStdString(names[i])));
-        }
-    }
-
-    void LoadFromAmp::delete_items()
-    {
-        for (int i = 0; i < ui->comboBox->count(); ++i)
-        {
-            ui->comboBox->removeItem(0);
-        }
-    }
-
-    void LoadFromAmp::change_name(int slot, QString* name)
-    {
-        ui->comboBox->setItemText(slot, *name);
-        ui->comboBox->setCurrentIndex(slot);
-    }
 }
 
 #include "ui/moc_loadfromamp.moc"
@@ -21,56 +21,111 @@
 
 #include "ui/mainwindow.h"
 #include "ui/amplifier.h"
+#include "ui/appsettings.h"
 #include "ui/defaulteffects.h"
 #include "ui/effect.h"
 #include "ui/library.h"
 #include "ui/loadfromamp.h"
-#include "ui/loadfromfile.h"
+#include "ui/presetnamemodel.h"
 #include "ui/quickpresets.h"
 #include "ui/save_effects.h"
 #include "ui/saveonamp.h"
 #include "ui/savetofile.h"
 #include "ui/settings.h"
 #include "com/Mustang.h"
+#include "com/AmpReader.h"
+#include "com/AutomationScheduler.h"
+#include "com/AutomationTimeline.h"
+#include "com/CommandQueue.h"
 #include "com/ConnectionFactory.h"
 #include "com/CommunicationException.h"
 #include "com/MustangUpdater.h"
+#include "com/OscServer.h"
+#include "com/PacketCache.h"
+#include "com/ToneSnapshots.h"
+#include "metrics/PrometheusExporter.h"
+#include "metrics/StartupProfile.h"
+#include "metrics/Trace.h"
+#include "preset/AmpBackup.h"
+#include "preset/FuseCodec.h"
+#include "preset/PresetBank.h"
+#include "EffectDescriptor.h"
 #include "ui_defaulteffects.h"
 #include "ui_mainwindow.h"
+#include <QCoreApplication>
+#include <QDialog>
+#include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QFontDatabase>
 #include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QProgressDialog>
+#include <QScrollBar>
 #include <QSettings>
 #include <QShortcut>
+#include <QTimer>
+#include <QVBoxLayout>
 #include <QDebug>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
 
 namespace plug
 {
     namespace
     {
-        constexpr int check_fx_family(effects value)
+        // Presets kept serialized for quick presets, setlists and the library
+        inline constexpr std::size_t packetCacheSize{64};
+
+        // Same as the USB transfer timeout
+        inline constexpr std::chrono::milliseconds ampResponseTimeout{500};
+
+        inline constexpr std::chrono::milliseconds statisticsInterval{1000};
+        inline constexpr std::chrono::milliseconds metricsFileInterval{10000};
+
+        // What a freshly created amplifier window reports
+        inline constexpr amp_settings defaultAmp{amps::FENDER_57_DELUXE, 0, 0, 0, 0, 0, cabinets::cab57DLX, 0, 128, 128, 128, 0, 128, 128, 1, false, 0};
+
+        // Waits for a command sent by the amp queue, events are still processed
+        template <class Result>
+        Result await(std::future<Result> result)
+        {
+            while (result.wait_for(std::chrono::milliseconds{10}) != std::future_status::ready)
+            {
+                QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+            }
+            return result.get();
+        }
+
+        void recordStartup(const char* phase, std::chrono::steady_clock::time_point start)
         {
-            if (value == effects::EMPTY)
-                return 0;
-            if ((value >= effects::OVERDRIVE) && (value <= effects::COMPRESSOR))
-                return 1;
-            if ((value >= effects::SINE_CHORUS) && (value <= effects::PITCH_SHIFTER))
-                return 2;
-            if ((value >= effects::MONO_DELAY) && (value <= effects::STEREO_TAPE_DELAY))
-                return 3;
-            if ((value >= effects::SMALL_HALL_REVERB) && (value <= effects::FENDER_65_SPRING_REVERB))
-                return 4;
-            return 0;
+            auto& histogram = metrics::Registry::global().histogram("plug_startup_seconds", "Time from creating the main window until it is shown or connected", {{"phase", phase}});
+            histogram.observe(std::chrono::steady_clock::now() - start);
         }
 
     }
 
 
     MainWindow::MainWindow(QWidget* parent)
+        : MainWindow(com::createUsbConnection, {}, parent)
+    {
+    }
+
+    MainWindow::MainWindow(ConnectionFactory factory, std::future<AmpConnection> pending, QWidget* parent)
         : QMainWindow(parent),
           ui(std::make_unique<Ui::MainWindow>()),
+          appSettings(std::make_unique<AppSettings>()),
+          connectionFactory(std::move(factory)),
           presetNames(100, ""),
-          amp_ops(nullptr)
+          presetModel(std::make_unique<PresetNameModel>()),
+          updating_windows(false),
+          amp_ops(nullptr),
+          snapshots(std::make_unique<com::ToneSnapshots>()),
+          packetCache(std::make_unique<com::PacketCache>(packetCacheSize))
     {
+        PLUG_TRACE_SPAN("ui", "MainWindow::MainWindow");
+        const auto constructionStart = std::chrono::steady_clock::now();
         ui->setupUi(this);
 
         // load window size
@@ -78,54 +133,47 @@ namespace plug
         restoreGeometry(settings.value("Windows/mainWindowGeometry").toByteArray());
         restoreState(settings.value("Windows/mainWindowState").toByteArray());
 
-        // setting default values if there was none
-        if (!settings.contains("Settings/connectOnStartup"))
-            settings.setValue("Settings/connectOnStartup", true);
-        if (!settings.contains("Settings/oneSetToSetThemAll"))
-            settings.setValue("Settings/oneSetToSetThemAll", false);
-        if (!settings.contains("Settings/keepWindowsOpen"))
-            settings.setValue("Settings/keepWindowsOpen", false);
-        if (!settings.contains("Settings/popupChangedWindows"))
-            settings.setValue("Settings/popupChangedWindows", true);
-        if (!settings.contains("Settings/defaultEffectValues"))
-            settings.setValue("Settings/defaultEffectValues", true);
-
-        // create child objects
-        amp = new Amplifier(this);
-        effect1 = new Effect(this, 0);
-        effect2 = new Effect(this, 1);
-        effect3 = new Effect(this, 2);
-        effect4 = new Effect(this, 3);
-
-        save = new SaveOnAmp(this);
-        load = new LoadFromAmp(this);
-        seffects = new SaveEffects(this);
-        settings_win = new Settings(this);
-        saver = new SaveToFile(this);
-        quickpres = new QuickPresets(this);
+        // child windows are created on first use
+        amp = nullptr;
+        effect_windows.fill(nullptr);
+        set_buttons_enabled = false;
+        current_index = -1;
+        save = nullptr;
+        load = nullptr;
+        seffects = nullptr;
+        settings_win = nullptr;
+        saver = nullptr;
+        quickpres = nullptr;
+        statistics = nullptr;
+        statisticsText = nullptr;
 
         connected = false;
 
         // connect buttons to slots
-        connect(ui->Amplifier, SIGNAL(clicked()), amp, SLOT(showAndActivate()));
-        connect(ui->EffectButton1, SIGNAL(clicked()), effect1, SLOT(showAndActivate()));
-        connect(ui->EffectButton2, SIGNAL(clicked()), effect2, SLOT(showAndActivate()));
-        connect(ui->EffectButton3, SIGNAL(clicked()), effect3, SLOT(showAndActivate()));
-        connect(ui->EffectButton4, SIGNAL(clicked()), effect4, SLOT(showAndActivate()));
+        connect(ui->Amplifier, SIGNAL(clicked()), this, SLOT(show_amp()));
+        connect(ui->EffectButton1, SIGNAL(clicked()), this, SLOT(show_fx1()));
+        connect(ui->EffectButton2, SIGNAL(clicked()), this, SLOT(show_fx2()));
+        connect(ui->EffectButton3, SIGNAL(clicked()), this, SLOT(show_fx3()));
+        connect(ui->EffectButton4, SIGNAL(clicked()), this, SLOT(show_fx4()));
         connect(ui->actionConnect, SIGNAL(triggered()), this, SLOT(start_amp()));
         connect(ui->actionDisconnect, SIGNAL(triggered()), this, SLOT(stop_amp()));
         connect(ui->actionExit, SIGNAL(triggered()), this, SLOT(close()));
         connect(ui->actionAbout, SIGNAL(triggered()), this, SLOT(about()));
-        connect(ui->actionSave_to_amplifier, SIGNAL(triggered()), save, SLOT(show()));
-        connect(ui->action_Load_from_amplifier, SIGNAL(triggered()), load, SLOT(show()));
-        connect(ui->actionSave_effects, SIGNAL(triggered()), seffects, SLOT(open()));
-        connect(ui->action_Options, SIGNAL(triggered()), settings_win, SLOT(show()));
+        connect(ui->actionSave_to_amplifier, &QAction::triggered, this, [this] { save_window()->show(); });
+        connect(ui->action_Load_from_amplifier, &QAction::triggered, this, [this] { load_window()->show(); });
+        connect(ui->actionSave_effects, &QAction::triggered, this, [this] { save_effects_window()->open(); });
+        connect(ui->actionBackup_amplifier, SIGNAL(triggered()), this, SLOT(backup_amp()));
+        connect(ui->actionRestore_amplifier, SIGNAL(triggered()), this, SLOT(restore_amp()));
+        connect(ui->action_Options, &QAction::triggered, this, [this] { settings_window()->show(); });
         connect(ui->actionL_oad_from_file, SIGNAL(triggered()), this, SLOT(loadfile()));
-        connect(ui->actionS_ave_to_file, SIGNAL(triggered()), saver, SLOT(show()));
+        connect(ui->actionS_ave_to_file, &QAction::triggered, this, [this] { save_to_file_window()->show(); });
         connect(ui->action_Library_view, SIGNAL(triggered()), this, SLOT(show_library()));
         connect(ui->action_Update_firmware, SIGNAL(triggered()), this, SLOT(update_firmware()));
         connect(ui->action_Default_effects, SIGNAL(triggered()), this, SLOT(show_default_effects()));
-        connect(ui->action_Quick_presets, SIGNAL(triggered()), quickpres, SLOT(show()));
+        connect(ui->action_Quick_presets, &QAction::triggered, this, [this] { quick_presets_window()->show(); });
+        connect(ui->actionStatistics, SIGNAL(triggered()), this, SLOT(show_statistics()));
+        connect(ui->actionPlay_automation, SIGNAL(triggered()), this, SLOT(play_automation()));
+        connect(ui->actionStop_automation, SIGNAL(triggered()), this, SLOT(stop_automation()));
 
         // shortcuts to activate effect windows
         QShortcut* showfx1 = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_1), this, nullptr, nullptr, Qt::ApplicationShortcut);
@@ -139,6 +187,15 @@ namespace plug
         connect(showfx4, SIGNAL(activated()), this, SLOT(show_fx4()));
         connect(showamp, SIGNAL(activated()), this, SLOT(show_amp()));
 
+        // shortcuts to switch effects off and to load their default settings
+        for (std::size_t i = 0; i < effect_windows.size(); ++i)
+        {
+            QShortcut* off = new QShortcut(QKeySequence(QString("F%1").arg(i + 1)), this, nullptr, nullptr, Qt::ApplicationShortcut);
+            QShortcut* defaultFx = new QShortcut(QKeySequence(QString("F%1").arg(i + 5)), this, nullptr, nullptr, Qt::ApplicationShortcut);
+            connect(off, &QShortcut::activated, this, [this, i] { effect_window(i)->toggle_off_switch(); });
+            connect(defaultFx, &QShortcut::activated, this, [this, i] { effect_window(i)->load_default_fx(); });
+        }
+
         // shortcuts for quick loading presets
         QShortcut* loadpres0 = new QShortcut(QKeySequence(Qt::Key_0), this, nullptr, nullptr, Qt::ApplicationShortcut);
         QShortcut* loadpres1 = new QShortcut(QKeySequence(Qt::Key_1), this, nullptr, nullptr, Qt::ApplicationShortcut);
@@ -160,21 +217,50 @@ namespace plug
         connect(loadpres7, SIGNAL(activated()), this, SLOT(load_presets7()));
         connect(loadpres8, SIGNAL(activated()), this, SLOT(load_presets8()));
         connect(loadpres9, SIGNAL(activated()), this, SLOT(load_presets9()));
+        quickPresetShortcuts = {{loadpres0, loadpres1, loadpres2, loadpres3, loadpres4, loadpres5, loadpres6, loadpres7, loadpres8, loadpres9}};
+        apply_settings();
+        connect(appSettings.get(), &AppSettings::changed, this, &MainWindow::apply_settings);
+
+        // shortcuts for storing and recalling A/B/C/D snapshots
+        for (int i = 0; i < static_cast<int>(com::ToneSnapshots::count); ++i)
+        {
+            QShortcut* storeSnapshot = new QShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + (Qt::Key_F1 + i)), this, nullptr, nullptr, Qt::ApplicationShortcut);
+            QShortcut* recallSnapshot = new QShortcut(QKeySequence(Qt::CTRL + (Qt::Key_F1 + i)), this, nullptr, nullptr, Qt::ApplicationShortcut);
+            connect(storeSnapshot, &QShortcut::activated, this, [this, i] { store_snapshot(i); });
+            connect(recallSnapshot, &QShortcut::activated, this, [this, i] { recall_snapshot(i); });
+        }
 
         // shortcut to activate buttons
         QShortcut* shortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_A), this);
         connect(shortcut, SIGNAL(activated()), this, SLOT(enable_buttons()));
 
-        // connect the functions if needed
-        if (settings.value("Settings/connectOnStartup").toBool())
+        start_metrics_export();
+
+        // connect the functions if needed, unless already connecting
+        if ((pending.valid() == false) && appSettings->connect_on_startup())
         {
             connect(this, SIGNAL(started()), this, SLOT(start_amp()));
         }
 
-        this->show();
-        this->repaint();
+        {
+            const metrics::StartupScope phase{"first_paint"};
+            this->show();
+            this->repaint();
+        }
+
+        recordStartup("first_frame", constructionStart);
+
+        if (pending.valid())
+        {
+            finish_start_amp(std::move(pending));
+        }
 
         emit started();
+
+        if (connected)
+        {
+            recordStartup("connected", constructionStart);
+        }
     }
 
     MainWindow::~MainWindow()
@@ -184,6 +270,21 @@ namespace plug
         settings.setValue("Windows/mainWindowState", saveState());
     }
 
+    AppSettings& MainWindow::app_settings()
+    {
+        return *appSettings;
+    }
+
+    PresetNameModel& MainWindow::preset_model()
+    {
+        return *presetModel;
+    }
+
+    bool MainWindow::is_connected() const
+    {
+        return connected;
+    }
+
     void MainWindow::about()
     {
         const QString title{tr("About %1").arg(QCoreApplication::applicationName())};
@@ -204,24 +305,72 @@ namespace plug
     }
 
 
+    MainWindow::AmpConnection MainWindow::connect_amp(const ConnectionFactory& factory)
+    {
+        std::shared_ptr<com::Connection> connection;
+        {
+            const metrics::StartupScope phase{"create_connection"};
+            connection = factory();
+        }
+        auto reader = std::make_shared<com::AmpReader>(connection, ampResponseTimeout);
+        auto mustang = std::make_unique<com::Mustang>(reader);
+        auto [signalChain, presets] = mustang->start_amp();
+
+        return {std::move(reader), std::move(mustang), std::move(signalChain), std::move(presets)};
+    }
+
+    std::future<MainWindow::AmpConnection> MainWindow::connect_amp_async(ConnectionFactory factory)
+    {
+        return std::async(std::launch::async, [factory = std::move(factory)] { return connect_amp(factory); });
+    }
+
     void MainWindow::start_amp()
     {
-        QSettings settings;
-        amp_settings amplifier_set{};
-        std::array<fx_pedal_settings, 4> effects_set{{}};
-        QString name;
+        PLUG_TRACE_SPAN("ui", "MainWindow::start_amp");
 
         ui->statusBar->showMessage(tr("Connecting..."));
         this->repaint(); // this should not be needed!
 
+        finish_start_amp(std::async(std::launch::deferred, [this] { return connect_amp(connectionFactory); }));
+    }
+
+    void MainWindow::finish_start_amp(std::future<AmpConnection> pending)
+    {
+        PLUG_TRACE_SPAN("ui", "MainWindow::finish_start_amp");
+        SignalChain chain;
+
         try
         {
-            amp_ops = std::make_unique<plug::com::Mustang>(plug::com::createUsbConnection());
-            const auto [signalChain, presets] = amp_ops->start_amp();
-            name = QString::fromStdString(signalChain.name());
-            amplifier_set = signalChain.amp();
-            effects_set = signalChain.effects();
-            presetNames = presets;
+            auto connection = pending.get();
+            automation.reset();
+            oscServer.reset();
+            amp_queue.reset();
+            connection.reader->subscribe([this](const com::StateChange& change) {
+                QMetaObject::invokeMethod(this, [this, change] { show_amp_change(change); }, Qt::QueuedConnection);
+            });
+            connection.reader->setErrorHandler([](const std::exception& ex) { qWarning() << "ERROR: " << ex.what(); });
+
+            amp_ops = std::move(connection.mustang);
+            snapshots->invalidate();
+
+            // The initial data is read directly, front panel changes from now on
+            connection.reader->start();
+
+            // All further commands are sent by the queue
+            amp_queue = std::make_unique<com::CommandQueue>(*amp_ops);
+            amp_queue->setErrorHandler([this](const std::exception& ex) {
+                const QString message = QString::fromUtf8(ex.what());
+                QMetaObject::invokeMethod(
+                    this, [this, message] {
+                        qWarning() << "ERROR: " << message;
+                        snapshots->invalidate();
+                        ui->statusBar->showMessage(QString(tr("Error: %1")).arg(message), 5000);
+                    },
+                    Qt::QueuedConnection);
+            });
+            amp_queue->start();
+            chain = std::move(connection.chain);
+            presetNames = std::move(connection.presetNames);
         }
         catch (const std::exception& ex)
         {
@@ -230,78 +379,27 @@ namespace plug
             return;
         }
 
-        load->load_names(presetNames);
-        save->load_names(presetNames);
-        quickpres->load_names(presetNames);
+        start_osc_server(chain);
+        automation = std::make_unique<com::AutomationScheduler>(*amp_queue, chain);
 
-        if (name.isEmpty() == true)
-        {
-            setWindowTitle(QString(tr("PLUG: NONE")));
-            setAccessibleName(QString(tr("Main window: NONE")));
-        }
-        else
-        {
-            setWindowTitle(QString(tr("PLUG: %1")).arg(name));
-            setAccessibleName(QString(tr("Main window: %1")).arg(name));
-        }
-
-        current_name = name;
+        const metrics::StartupScope phase{"populate_ui"};
+        update_preset_names();
 
-        amp->load(amplifier_set);
-        if (settings.value("Settings/popupChangedWindows").toBool())
-        {
-            amp->show();
-        }
-        for (std::size_t i = 0; i < 4; i++)
-        {
-            switch (effects_set[i].fx_slot)
-            {
-                case 0x00:
-                case 0x04:
-                    effect1->load(effects_set[i]);
-                    if (effects_set[i].effect_num != effects::EMPTY)
-                        if (settings.value("Settings/popupChangedWindows").toBool())
-                            effect1->show();
-                    break;
-
-                case 0x01:
-                case 0x05:
-                    effect2->load(effects_set[i]);
-                    if (effects_set[i].effect_num != effects::EMPTY)
-                        if (settings.value("Settings/popupChangedWindows").toBool())
-                            effect2->show();
-                    break;
-
-                case 0x02:
-                case 0x06:
-                    effect3->load(effects_set[i]);
-                    if (effects_set[i].effect_num != effects::EMPTY)
-                        if (settings.value("Settings/popupChangedWindows").toBool())
-                            effect3->show();
-                    break;
-
-                case 0x03:
-                case 0x07:
-                    effect4->load(effects_set[i]);
-                    if (effects_set[i].effect_num != effects::EMPTY)
-                        if (settings.value("Settings/popupChangedWindows").toBool())
-                            effect4->show();
-                    break;
-            }
-        }
+        update_windows(chain);
+        popup_windows(chain);
 
         // activate buttons
-        amp->enable_set_button(true);
-        effect1->enable_set_button(true);
-        effect2->enable_set_button(true);
-        effect3->enable_set_button(true);
-        effect4->enable_set_button(true);
+        enable_set_buttons(true);
         ui->actionConnect->setDisabled(true);
         ui->actionDisconnect->setDisabled(false);
         ui->actionSave_to_amplifier->setDisabled(false);
         ui->action_Load_from_amplifier->setDisabled(false);
         ui->actionSave_effects->setDisabled(false);
+        ui->actionBackup_amplifier->setDisabled(false);
+        ui->actionRestore_amplifier->setDisabled(false);
         ui->action_Library_view->setDisabled(false);
+        ui->actionPlay_automation->setDisabled(false);
+        ui->actionStop_automation->setDisabled(false);
         ui->statusBar->showMessage(tr("Connected"), 3000);
 
         connected = true;
@@ -309,26 +407,29 @@ namespace plug
 
     void MainWindow::stop_amp()
     {
-        save->delete_items();
-        load->delete_items();
-        quickpres->delete_items();
+        PLUG_TRACE_SPAN("ui", "MainWindow::stop_amp");
+
+        presetModel->clear();
 
         try
         {
+            automation.reset();
+            oscServer.reset();
+            amp_queue.reset();
             amp_ops->stop_amp();
 
             // deactivate buttons
-            amp->enable_set_button(false);
-            effect1->enable_set_button(false);
-            effect2->enable_set_button(false);
-            effect3->enable_set_button(false);
-            effect4->enable_set_button(false);
+            enable_set_buttons(false);
             ui->actionConnect->setDisabled(false);
             ui->actionDisconnect->setDisabled(true);
             ui->actionSave_to_amplifier->setDisabled(true);
             ui->action_Load_from_amplifier->setDisabled(true);
             ui->actionSave_effects->setDisabled(true);
+            ui->actionBackup_amplifier->setDisabled(true);
+            ui->actionRestore_amplifier->setDisabled(true);
             ui->action_Library_view->setDisabled(true);
+            ui->actionPlay_automation->setDisabled(true);
+            ui->actionStop_automation->setDisabled(true);
             setWindowTitle(QString(tr("PLUG")));
             setAccessibleName(QString(tr("Main window: None")));
             ui->statusBar->showMessage(tr("Disconnected"), 5000);
@@ -346,79 +447,61 @@ namespace plug
     // pass the message to the amp
     void MainWindow::set_effect(fx_pedal_settings pedal)
     {
-        if (!connected)
+        PLUG_TRACE_SPAN("ui", "MainWindow::set_effect");
+
+        if (!connected || updating_windows)
         {
             return;
         }
+        snapshots->invalidate();
 
-        QSettings settings;
+        if (appSettings->one_set_to_set_them_all() == false)
+        {
+            amp_queue->post(com::CommandPriority::setting, com::effectKey(pedal.fx_slot), [pedal](com::Mustang& m) { m.set_effect(pedal); });
+        }
 
-        if (!settings.value("Settings/oneSetToSetThemAll").toBool())
+        if (amp != nullptr)
         {
-            try
-            {
-                amp_ops->set_effect(pedal);
-            }
-            catch (const std::exception& ex)
-            {
-                qWarning() << "ERROR: " << ex.what();
-                ui->statusBar->showMessage(QString(tr("Error: %1")).arg(ex.what()), 5000);
-                return;
-            }
+            amp->send_amp();
+        }
+        else if (appSettings->one_set_to_set_them_all())
+        {
+            set_amplifier(current_amp());
         }
-        amp->send_amp();
+        sync_controls();
     }
 
     void MainWindow::set_amplifier(amp_settings amp_settings)
     {
+        PLUG_TRACE_SPAN("ui", "MainWindow::set_amplifier");
 
-        if (!connected)
+        if (!connected || updating_windows)
         {
             return;
         }
+        snapshots->invalidate();
 
-        QSettings settings;
-
-        try
+        if (appSettings->one_set_to_set_them_all())
         {
-            if (settings.value("Settings/oneSetToSetThemAll").toBool())
+            for (Effect* window : effect_windows)
             {
-                fx_pedal_settings pedal{};
-
-                if (effect1->get_changed())
-                {
-                    effect1->get_settings(pedal);
-                    amp_ops->set_effect(pedal);
-                }
-                if (effect2->get_changed())
+                if ((window != nullptr) && window->get_changed())
                 {
-                    effect2->get_settings(pedal);
-                    amp_ops->set_effect(pedal);
-                }
-                if (effect3->get_changed())
-                {
-                    effect3->get_settings(pedal);
-                    amp_ops->set_effect(pedal);
-                }
-                if (effect4->get_changed())
-                {
-                    effect4->get_settings(pedal);
-                    amp_ops->set_effect(pedal);
+                    fx_pedal_settings pedal{};
+                    window->get_settings(pedal);
+                    amp_queue->post(com::CommandPriority::setting, com::effectKey(pedal.fx_slot), [pedal](com::Mustang& m) { m.set_effect(pedal); });
                 }
             }
-
-            amp_ops->set_amplifier(amp_settings);
-        }
-        catch (const std::exception& ex)
-        {
-            qWarning() << "ERROR: " << ex.what();
-            ui->statusBar->showMessage(QString(tr("Error: %1")).arg(ex.what()), 5000);
-            return;
         }
+
+        amp_queue->post(com::CommandPriority::setting, com::ampKey, [amp_settings](com::Mustang& m) { m.set_amplifier(amp_settings); });
+        sync_controls();
     }
 
     void MainWindow::save_on_amp(char* name, int slot)
     {
+        PLUG_TRACE_SPAN("ui", "MainWindow::save_on_amp");
+
         if (connected == false)
         {
             return;
@@ -426,7 +509,10 @@ namespace plug
 
         try
         {
-            amp_ops->save_on_amp(name, static_cast<std::uint8_t>(slot));
+            // Saves the current settings, so it's sent after pending changes
+            await(amp_queue->submit(com::CommandPriority::setting, [preset = std::string{name}, slot](com::Mustang& m) {
+                m.save_on_amp(preset, static_cast<std::uint8_t>(slot));
+            }));
         }
         catch (const std::exception& ex)
         {
@@ -448,83 +534,33 @@ namespace plug
 
         current_name = name;
         presetNames[static_cast<std::size_t>(slot)] = current_name.toStdString();
+        presetModel->set_name(slot, current_name);
+
+        amp_settings amplifier_set{};
+        std::array<fx_pedal_settings, 4> effects_set{{}};
+        get_settings(&amplifier_set, effects_set.data());
+        presetModel->set_chain(slot, SignalChain{current_name.toStdString(), amplifier_set, effects_set});
     }
 
     void MainWindow::load_from_amp(int slot)
     {
+        PLUG_TRACE_SPAN("ui", "MainWindow::load_from_amp");
+
         if (!connected)
         {
             return;
         }
+        snapshots->invalidate();
 
-        QSettings settings;
         try
         {
-            const auto signalChain = amp_ops->load_memory_bank(static_cast<std::uint8_t>(slot));
-            const QString bankName = QString::fromStdString(signalChain.name());
-
-
-            if (bankName.isEmpty())
-            {
-                setWindowTitle(QString(tr("PLUG: NONE")));
-                setAccessibleName(QString(tr("Main window: NONE")));
-            }
-            else
-            {
-                setWindowTitle(QString(tr("PLUG: %1")).arg(bankName));
-                setAccessibleName(QString(tr("Main window: %1")).arg(bankName));
-            }
-
-            current_name = bankName;
-
-            amp->load(signalChain.amp());
-            if (settings.value("Settings/popupChangedWindows").toBool())
-            {
-                amp->show();
-            }
-
-            const auto effects_set = signalChain.effects();
-            for (std::size_t i = 0; i < 4; i++)
-            {
-                switch (effects_set[i].fx_slot)
-                {
-                    case 0x00:
-                    case 0x04:
-                        effect1->load(effects_set[i]);
-                        if (effects_set[i].effect_num != effects::EMPTY)
-                            if (settings.value("Settings/popupChangedWindows").toBool())
-                                effect1->show();
-                        break;
-
-                    case 0x01:
-                    case 0x05:
-                        effect2->load(effects_set[i]);
-                        if (effects_set[i].effect_num != effects::EMPTY)
-                            if (settings.value("Settings/popupChangedWindows").toBool())
-                                effect2->show();
-                        break;
-
-                    case 0x02:
-                    case 0x06:
-                        effect3->load(effects_set[i]);
-                        if (effects_set[i].effect_num != effects::EMPTY)
-                            if (settings.value("Settings/popupChangedWindows").toBool())
-                                effect3->show();
-                        break;
-
-                    case 0x03:
-                    case 0x07:
-                        effect4->load(effects_set[i]);
-                        if (effects_set[i].effect_num != effects::EMPTY)
-                        {
-                            if (settings.value("Settings/popupChangedWindows").toBool())
-                            {
-                                effect4->show();
-                            }
-                        }
-                        break;
-                }
-            }
+            const auto signalChain = await(amp_queue->submit(com::CommandPriority::preset, [slot](com::Mustang& m) {
+                return m.load_memory_bank(static_cast<std::uint8_t>(slot));
+            }));
+            update_windows(signalChain);
+            popup_windows(signalChain);
+            presetModel->set_chain(slot, signalChain);
+            sync_controls();
         }
         catch (const std::exception& ex)
         {
@@ -537,49 +573,48 @@ namespace plug
     // activate buttons
     void MainWindow::enable_buttons()
     {
-        amp->enable_set_button(true);
-        effect1->enable_set_button(true);
-        effect2->enable_set_button(true);
-        effect3->enable_set_button(true);
-        effect4->enable_set_button(true);
+        enable_set_buttons(true);
         ui->actionConnect->setDisabled(false);
         ui->actionDisconnect->setDisabled(false);
         ui->actionSave_to_amplifier->setDisabled(false);
         ui->action_Load_from_amplifier->setDisabled(false);
         ui->actionSave_effects->setDisabled(false);
+        ui->actionBackup_amplifier->setDisabled(false);
+        ui->actionRestore_amplifier->setDisabled(false);
         ui->action_Library_view->setDisabled(false);
     }
 
-    void MainWindow::change_name(int slot, QString* name)
-    {
-        load->change_name(slot, name);
-        quickpres->change_name(slot, name);
-    }
-
     void MainWindow::set_index(int value)
     {
-        save->change_index(value, current_name);
+        current_index = value;
+
+        if (save != nullptr)
+        {
+            save->change_index(value, current_name);
+        }
     }
 
     void MainWindow::save_effects(int slot, char* name, int fx_num, bool mod, bool dly, bool rev)
     {
+        PLUG_TRACE_SPAN("ui", "MainWindow::save_effects");
+
         std::vector<fx_pedal_settings> effects(static_cast<std::size_t>(fx_num));
 
         if (fx_num == 1)
         {
             if (mod)
             {
-                effect2->get_settings(effects[0]);
+                effects[0] = current_effect(1);
                 set_effect(effects[0]);
             }
             else if (dly)
             {
-                effect3->get_settings(effects[0]);
+                effects[0] = current_effect(2);
                 set_effect(effects[0]);
             }
             else if (rev)
             {
-                effect4->get_settings(effects[0]);
+                effects[0] = current_effect(3);
                 set_effect(effects[0]);
             }
             else
@@ -589,15 +624,17 @@ namespace plug
         }
         else
         {
-            effect3->get_settings(effects[0]);
+            effects[0] = current_effect(2);
             set_effect(effects[0]);
-            effect4->get_settings(effects[1]);
+            effects[1] = current_effect(3);
             set_effect(effects[1]);
         }
 
         try
         {
-            amp_ops->save_effects(static_cast<std::uint8_t>(slot), name, effects);
+            await(amp_queue->submit(com::CommandPriority::setting, [slot, preset = std::string{name}, effects](com::Mustang& m) {
+                m.save_effects(static_cast<std::uint8_t>(slot), preset, effects);
+            }));
         }
         catch (const std::exception& ex)
         {
@@ -609,6 +646,8 @@ namespace plug
 
     void MainWindow::loadfile(QString filename)
     {
+        PLUG_TRACE_SPAN("ui", "MainWindow::loadfile");
+
         QSettings settings;
 
         if (filename.isEmpty())
@@ -622,80 +661,68 @@ namespace plug
         }
 
         settings.setValue("LoadFile/lastDirectory", QFileInfo(filename).absolutePath());
-        auto file = std::make_unique<QFile>(filename, this);
 
-        if (file->exists())
-        {
-            if (!file->open(QFile::ReadOnly | QFile::Text))
-            {
-                QMessageBox::critical(this, tr("Error!"), tr("Could not open file"));
-                return;
-            }
-        }
-        else
+        if (QFileInfo::exists(filename) == false)
         {
             QMessageBox::critical(this, tr("Error!"), tr("No such file"));
             return;
         }
 
-        amp_settings amplifier_set{};
-        fx_pedal_settings effects_set[4];
-        QString name;
-        auto loader = std::make_unique<LoadFromFile>(file.get(), &name, &amplifier_set, effects_set);
-        loader->loadfile();
-        file->close();
+        try
+        {
+            load_preset(preset::loadFuseFile(filename.toStdString()));
+        }
+        catch (const std::exception& ex)
+        {
+            QMessageBox::critical(this, tr("Error!"), QString(tr("Could not open file: %1")).arg(ex.what()));
+        }
+    }
 
-        change_title(name);
+    void MainWindow::load_preset(const SignalChain& chain)
+    {
+        PLUG_TRACE_SPAN("ui", "MainWindow::load_preset");
 
-        amp->load(amplifier_set);
         if (connected)
         {
-            amp->send_amp();
+            snapshots->invalidate();
+            amp_queue->post(com::CommandPriority::preset, com::presetKey, [packets = packetCache->get(chain)](com::Mustang& m) { m.apply_settings(packets); });
         }
-        if (settings.value("Settings/popupChangedWindows").toBool())
+
+        update_windows(chain);
+        popup_windows(chain);
+        sync_controls();
+    }
+
+    // Shows the settings of the chain, which the amp has already
+    void MainWindow::update_windows(const SignalChain& chain)
+    {
+        updating_windows = true;
+        change_title(QString::fromStdString(chain.name()));
+        load_amp(chain.amp());
+
+        for (const auto& effect : chain.effects())
         {
-            amp->show();
+            load_effect(effect);
         }
+        reset_changed();
+        updating_windows = false;
+    }
 
-        for (int i = 0; i < 4; i++)
+    void MainWindow::popup_windows(const SignalChain& chain)
+    {
+        // presets browsed in the library never pop up the edit windows
+        if ((appSettings->popup_changed_windows() == false) || ((library != nullptr) && library->isVisible()))
         {
-            switch (effects_set[i].fx_slot)
+            return;
+        }
+
+        amp_window()->show();
+
+        for (const auto& effect : chain.effects())
+        {
+            if (effect.effect_num != effects::EMPTY)
             {
-                case 0x00:
-                    effect1->load(effects_set[i]);
-                    if (connected)
-                        effect1->send_fx();
-                    if (effects_set[i].effect_num != effects::EMPTY)
-                        if (settings.value("Settings/popupChangedWindows").toBool())
-                            effect1->show();
-                    break;
-
-                case 0x01:
-                    effect2->load(effects_set[i]);
-                    if (connected)
-                        effect2->send_fx();
-                    if (effects_set[i].effect_num != effects::EMPTY)
-                        if (settings.value("Settings/popupChangedWindows").toBool())
-                            effect2->show();
-                    break;
-
-                case 0x02:
-                    effect3->load(effects_set[i]);
-                    if (connected)
-                        effect3->send_fx();
-                    if (effects_set[i].effect_num != effects::EMPTY)
-                        if (settings.value("Settings/popupChangedWindows").toBool())
-                            effect3->show();
-                    break;
-
-                case 0x03:
-                    effect4->load(effects_set[i]);
-                    if (connected)
-                        effect4->send_fx();
-                    if (effects_set[i].effect_num != effects::EMPTY)
-                        if (settings.value("Settings/popupChangedWindows").toBool())
-                            effect4->show();
-                    break;
+                effect_window(effect.fx_slot & 0x03)->show();
             }
         }
     }
@@ -704,15 +731,199 @@ namespace plug
     {
         if (amplifier_settings != nullptr)
         {
-            amp->get_settings(amplifier_settings);
+            *amplifier_settings = current_amp();
         }
         if (fx_settings != nullptr)
         {
-            effect1->get_settings(fx_settings[0]);
-            effect2->get_settings(fx_settings[1]);
-            effect3->get_settings(fx_settings[2]);
-            effect4->get_settings(fx_settings[3]);
+            for (std::size_t i = 0; i < effect_windows.size(); ++i)
+            {
+                fx_settings[i] = current_effect(i);
+            }
+        }
+    }
+
+    Amplifier* MainWindow::amp_window()
+    {
+        if (amp == nullptr)
+        {
+            const bool updating = std::exchange(updating_windows, true);
+            amp = new Amplifier(this);
+
+            if (amp_state.has_value())
+            {
+                amp->load(*amp_state);
+                amp_state.reset();
+            }
+            amp->set_changed(false);
+            amp->enable_set_button(set_buttons_enabled);
+            updating_windows = updating;
+        }
+        return amp;
+    }
+
+    Effect* MainWindow::effect_window(std::size_t slot)
+    {
+        Effect*& window = effect_windows[slot];
+
+        if (window == nullptr)
+        {
+            const bool updating = std::exchange(updating_windows, true);
+            window = new Effect(this, static_cast<std::uint8_t>(slot));
+
+            if (effect_states[slot].has_value())
+            {
+                window->load(*effect_states[slot]);
+                effect_states[slot].reset();
+            }
+            window->set_changed(false);
+            window->enable_set_button(set_buttons_enabled);
+            updating_windows = updating;
+        }
+        return window;
+    }
+
+    SaveOnAmp* MainWindow::save_window()
+    {
+        if (save == nullptr)
+        {
+            save = new SaveOnAmp(this);
+
+            if (connected)
+            {
+                save->change_index(current_index, current_name);
+            }
+        }
+        return save;
+    }
+
+    LoadFromAmp* MainWindow::load_window()
+    {
+        if (load == nullptr)
+        {
+            load = new LoadFromAmp(this);
+        }
+        return load;
+    }
+
+    SaveEffects* MainWindow::save_effects_window()
+    {
+        if (seffects == nullptr)
+        {
+            seffects = new SaveEffects(this);
+        }
+        return seffects;
+    }
+
+    Settings* MainWindow::settings_window()
+    {
+        if (settings_win == nullptr)
+        {
+            settings_win = new Settings(this);
         }
+        return settings_win;
+    }
+
+    SaveToFile* MainWindow::save_to_file_window()
+    {
+        if (saver == nullptr)
+        {
+            saver = new SaveToFile(this);
+        }
+        return saver;
+    }
+
+    QuickPresets* MainWindow::quick_presets_window()
+    {
+        if (quickpres == nullptr)
+        {
+            quickpres = new QuickPresets(this);
+        }
+        return quickpres;
+    }
+
+    amp_settings MainWindow::current_amp()
+    {
+        if (amp == nullptr)
+        {
+            return amp_state.value_or(defaultAmp);
+        }
+
+        amp_settings settings{};
+        amp->get_settings(&settings);
+        return settings;
+    }
+
+    fx_pedal_settings MainWindow::current_effect(std::size_t slot)
+    {
+        if (effect_windows[slot] == nullptr)
+        {
+            return effect_states[slot].value_or(fx_pedal_settings{static_cast<std::uint8_t>(slot), effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input});
+        }
+
+        fx_pedal_settings settings{};
+        effect_windows[slot]->get_settings(settings);
+        return settings;
+    }
+
+    void MainWindow::load_amp(const amp_settings& settings)
+    {
+        if (amp == nullptr)
+        {
+            amp_state = settings;
+        }
+        else
+        {
+            amp->load(settings);
+        }
+    }
+
+    void MainWindow::load_effect(const fx_pedal_settings& settings)
+    {
+        const std::size_t slot = settings.fx_slot & 0x03;
+
+        if (effect_windows[slot] == nullptr)
+        {
+            effect_states[slot] = settings;
+        }
+        else
+        {
+            effect_windows[slot]->load(settings);
+        }
+    }
+
+    void MainWindow::reset_changed()
+    {
+        if (amp != nullptr)
+        {
+            amp->set_changed(false);
+        }
+        std::for_each(effect_windows.cbegin(), effect_windows.cend(), [](Effect* window) {
+            if (window != nullptr)
+            {
+                window->set_changed(false);
+            }
+        });
+    }
+
+    void MainWindow::enable_set_buttons(bool value)
+    {
+        set_buttons_enabled = value;
+
+        if (amp != nullptr)
+        {
+            amp->enable_set_button(value);
+        }
+        std::for_each(effect_windows.cbegin(), effect_windows.cend(), [value](Effect* window) {
+            if (window != nullptr)
+            {
+                window->enable_set_button(value);
+            }
+        });
+    }
+
+    void MainWindow::update_preset_names()
+    {
+        presetModel->set_names(presetNames);
     }
 
     void MainWindow::change_title(const QString& name)
@@ -733,64 +944,43 @@ namespace plug
 
     void MainWindow::show_fx1()
     {
-        if (!effect1->isVisible())
-        {
-            effect1->show();
-        }
-        effect1->activateWindow();
+        effect_window(0)->showAndActivate();
     }
 
     void MainWindow::show_fx2()
     {
-        if (!effect2->isVisible())
-        {
-            effect2->show();
-        }
-        effect2->activateWindow();
+        effect_window(1)->showAndActivate();
     }
     void MainWindow::show_fx3()
     {
-        if (!effect3->isVisible())
-        {
-            effect3->show();
-        }
-        effect3->activateWindow();
+        effect_window(2)->showAndActivate();
     }
     void MainWindow::show_fx4()
     {
-        if (!effect4->isVisible())
-        {
-            effect4->show();
-        }
-        effect4->activateWindow();
+        effect_window(3)->showAndActivate();
     }
 
     void MainWindow::show_amp()
     {
-        if (!amp->isVisible())
-        {
-            amp->show();
-        }
-        amp->activateWindow();
+        amp_window()->showAndActivate();
     }
 
     void MainWindow::show_library()
     {
-        QSettings settings;
-        bool previous = settings.value("Settings/popupChangedWindows").toBool();
-
-        settings.setValue("Settings/popupChangedWindows", false);
-
-        library = std::make_unique<Library>(presetNames, this);
-        effect1->close();
-        effect2->close();
-        effect3->close();
-        effect4->close();
-        amp->close();
+        library = std::make_unique<Library>(*presetModel, this);
+        std::for_each(effect_windows.cbegin(), effect_windows.cend(), [](Effect* window) {
+            if (window != nullptr)
+            {
+                window->close();
+            }
+        });
+        if (amp != nullptr)
+        {
+            amp->close();
+        }
         this->close();
         library->exec();
 
-        settings.setValue("Settings/popupChangedWindows", previous);
         this->show();
     }
 
@@ -840,130 +1030,439 @@ namespace plug
         deffx.reset();
     }
 
-    void MainWindow::empty_other(int value, Effect* caller)
+    void MainWindow::show_statistics()
     {
-        const int fx_family = check_fx_family(static_cast<effects>(value));
-        fx_pedal_settings settings{};
+        if (statistics == nullptr)
+        {
+            statistics = new QDialog(this);
+            statistics->setWindowTitle(tr("Statistics"));
+            statistics->resize(640, 480);
+            statisticsText = new QPlainTextEdit(statistics);
+            statisticsText->setReadOnly(true);
+            statisticsText->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+            auto* layout = new QVBoxLayout(statistics);
+            layout->addWidget(statisticsText);
+
+            QTimer* timer = new QTimer(statistics);
+            connect(timer, SIGNAL(timeout()), this, SLOT(update_statistics()));
+            timer->start(statisticsInterval.count());
+        }
 
-        if (caller != effect1)
+        update_statistics();
+        statistics->show();
+        statistics->activateWindow();
+    }
+
+    void MainWindow::update_statistics()
+    {
+        if (statistics->isVisible() == false)
         {
-            effect1->get_settings(settings);
-            if (check_fx_family(settings.effect_num) == fx_family)
-            {
-                effect1->choose_fx(0);
-                effect1->send_fx();
-            }
+            return;
+        }
+
+        const int position = statisticsText->verticalScrollBar()->value();
+        statisticsText->setPlainText(QString::fromStdString(metrics::formatPrometheus(metrics::Registry::global().collect())));
+        statisticsText->verticalScrollBar()->setValue(position);
+    }
+
+    void MainWindow::start_osc_server(const SignalChain& chain)
+    {
+        if (appSettings->osc_port() == 0)
+        {
+            return;
+        }
+
+        try
+        {
+            oscServer = std::make_unique<com::OscServer>(*amp_queue, chain, appSettings->osc_address().toStdString(), appSettings->osc_port());
+            oscServer->setErrorHandler([this](const std::exception& ex) {
+                const QString message = QString::fromUtf8(ex.what());
+                QMetaObject::invokeMethod(
+                    this, [this, message] { ui->statusBar->showMessage(QString(tr("OSC error: %1")).arg(message), 5000); }, Qt::QueuedConnection);
+            });
+            oscServer->start();
+        }
+        catch (const std::exception& ex)
+        {
+            qWarning() << "ERROR: " << ex.what();
+        }
+    }
+
+    // OSC and automation write whole blocks, they have to know what was changed elsewhere
+    void MainWindow::sync_controls()
+    {
+        if ((oscServer == nullptr) && (automation == nullptr))
+        {
+            return;
+        }
+
+        amp_settings amplifier_set{};
+        std::array<fx_pedal_settings, 4> effects_set{{}};
+        get_settings(&amplifier_set, effects_set.data());
+        const SignalChain chain{current_name.toStdString(), amplifier_set, effects_set};
+
+        if (oscServer != nullptr)
+        {
+            oscServer->update(chain);
+        }
+        if (automation != nullptr)
+        {
+            automation->update(chain);
+        }
+    }
+
+    void MainWindow::play_automation()
+    {
+        if ((connected == false) || (automation == nullptr))
+        {
+            return;
+        }
+
+        QSettings settings;
+        const QString filename = QFileDialog::getOpenFileName(this, tr("Play automation..."), settings.value("Automation/lastDirectory", QDir::homePath()).toString(), tr("Automation files (*.txt *.automation)"));
+
+        if (filename.isEmpty())
+        {
+            return;
+        }
+        settings.setValue("Automation/lastDirectory", QFileInfo(filename).absolutePath());
+
+        QFile file{filename};
+
+        if (file.open(QFile::ReadOnly | QFile::Text) == false)
+        {
+            QMessageBox::critical(this, tr("Error!"), tr("Could not open file"));
+            return;
+        }
+
+        try
+        {
+            const QByteArray data = file.readAll();
+            automation->start(com::parseTimeline(std::string_view{data.constData(), static_cast<std::size_t>(data.size())}));
+            ui->statusBar->showMessage(QString(tr("Playing %1")).arg(QFileInfo(filename).fileName()), 3000);
+        }
+        catch (const std::exception& ex)
+        {
+            QMessageBox::critical(this, tr("Error!"), QString(tr("Could not play automation: %1")).arg(ex.what()));
         }
+    }
 
-        if (caller != effect2)
+    void MainWindow::stop_automation()
+    {
+        if (automation != nullptr)
         {
-            effect2->get_settings(settings);
-            if (check_fx_family(settings.effect_num) == fx_family)
+            automation->stop();
+            ui->statusBar->showMessage(tr("Automation stopped"), 3000);
+        }
+    }
+
+    void MainWindow::start_metrics_export()
+    {
+        QSettings settings;
+        const int port = settings.value("Metrics/port", 0).toInt();
+
+        if ((port > 0) && (port <= 0xffff))
+        {
+            try
+            {
+                metricsServer = std::make_unique<metrics::PrometheusServer>(metrics::Registry::global(), static_cast<std::uint16_t>(port));
+                metricsServer->start();
+            }
+            catch (const std::runtime_error& ex)
             {
-                effect2->choose_fx(0);
-                effect2->send_fx();
+                qWarning() << "ERROR: " << ex.what();
             }
         }
 
-        if (caller != effect3)
+        const std::string file = settings.value("Metrics/file").toString().toStdString();
+
+        if (file.empty() == false)
+        {
+            QTimer* timer = new QTimer(this);
+            connect(timer, &QTimer::timeout, this, [file] {
+                try
+                {
+                    metrics::writePrometheusFile(metrics::Registry::global(), file);
+                }
+                catch (const std::runtime_error& ex)
+                {
+                    qWarning() << "ERROR: " << ex.what();
+                }
+            });
+            timer->start(metricsFileInterval.count());
+        }
+    }
+
+    void MainWindow::backup_amp()
+    {
+        PLUG_TRACE_SPAN("ui", "MainWindow::backup_amp");
+
+        if (connected == false)
+        {
+            return;
+        }
+
+        QSettings settings;
+        const QString filename = QFileDialog::getSaveFileName(this, tr("Backup amplifier..."), settings.value("Backup/lastDirectory", QDir::homePath()).toString(), tr("Preset banks (*.bank)"));
+
+        if (filename.isEmpty())
+        {
+            return;
+        }
+
+        settings.setValue("Backup/lastDirectory", QFileInfo(filename).absolutePath());
+        QProgressDialog progress(tr("Reading presets..."), QString(), 0, static_cast<int>(presetNames.size()), this);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(0);
+
+        try
+        {
+            await(amp_queue->submit(com::CommandPriority::setting, [&progress, count = presetNames.size(), path = filename.toStdString()](com::Mustang& m) {
+                preset::backupToBank(m, count, path, [&progress](std::size_t done, std::size_t) {
+                    QMetaObject::invokeMethod(
+                        &progress, [&progress, done] { progress.setValue(static_cast<int>(done)); }, Qt::QueuedConnection);
+                });
+            }));
+        }
+        catch (const std::exception& ex)
+        {
+            qWarning() << "ERROR: " << ex.what();
+            ui->statusBar->showMessage(QString(tr("Error: %1")).arg(ex.what()), 5000);
+            return;
+        }
+
+        ui->statusBar->showMessage(tr("Backup finished"), 5000);
+    }
+
+    void MainWindow::restore_amp()
+    {
+        PLUG_TRACE_SPAN("ui", "MainWindow::restore_amp");
+
+        if (connected == false)
+        {
+            return;
+        }
+
+        QSettings settings;
+        const QString filename = QFileDialog::getOpenFileName(this, tr("Restore amplifier..."), settings.value("Backup/lastDirectory", QDir::homePath()).toString(), tr("Preset banks (*.bank)"));
+
+        if (filename.isEmpty())
+        {
+            return;
+        }
+
+        if (QMessageBox::question(this, tr("Restore amplifier"), tr("All presets on the amplifier will be overwritten. Continue?")) != QMessageBox::Yes)
         {
-            effect3->get_settings(settings);
-            if (check_fx_family(settings.effect_num) == fx_family)
+            return;
+        }
+
+        settings.setValue("Backup/lastDirectory", QFileInfo(filename).absolutePath());
+        snapshots->invalidate();
+        QProgressDialog progress(tr("Writing presets..."), QString(), 0, static_cast<int>(presetNames.size()), this);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(0);
+
+        try
+        {
+            const preset::PresetBank bank{filename.toStdString()};
+
+            if (bank.size() > presetNames.size())
             {
-                effect3->choose_fx(0);
-                effect3->send_fx();
+                throw std::runtime_error{"Bank has more presets than the amplifier"};
             }
+
+            await(amp_queue->submit(com::CommandPriority::setting, [&progress, path = filename.toStdString()](com::Mustang& m) {
+                preset::restoreFromBank(m, path, [&progress](std::size_t done, std::size_t total) {
+                    QMetaObject::invokeMethod(
+                        &progress, [&progress, done, total] {
+                            progress.setMaximum(static_cast<int>(total));
+                            progress.setValue(static_cast<int>(done));
+                        },
+                        Qt::QueuedConnection);
+                });
+            }));
+            std::transform(bank.begin(), bank.end(), presetNames.begin(), [](const auto& record) { return std::string{record.getName()}; });
+        }
+        catch (const std::exception& ex)
+        {
+            qWarning() << "ERROR: " << ex.what();
+            ui->statusBar->showMessage(QString(tr("Error: %1")).arg(ex.what()), 5000);
+            return;
+        }
+
+        update_preset_names();
+        ui->statusBar->showMessage(tr("Restore finished"), 5000);
+    }
+
+    void MainWindow::store_snapshot(int index)
+    {
+        amp_settings amplifier_set{};
+        std::array<fx_pedal_settings, 4> effects_set{{}};
+        get_settings(&amplifier_set, effects_set.data());
+
+        snapshots->store(static_cast<std::size_t>(index), SignalChain{current_name.toStdString(), amplifier_set, effects_set});
+        ui->statusBar->showMessage(QString(tr("Stored snapshot %1")).arg(QChar('A' + index)), 5000);
+    }
+
+    void MainWindow::recall_snapshot(int index)
+    {
+        PLUG_TRACE_SPAN("ui", "MainWindow::recall_snapshot");
+
+        const auto slot = static_cast<std::size_t>(index);
+
+        if (snapshots->contains(slot) == false)
+        {
+            ui->statusBar->showMessage(QString(tr("Snapshot %1 is empty")).arg(QChar('A' + index)), 5000);
+            return;
+        }
+
+        if (connected)
+        {
+            amp_queue->post(com::CommandPriority::preset, com::presetKey, [packets = snapshots->select(slot)](com::Mustang& m) { m.apply_settings(packets); });
+        }
+
+        update_windows(snapshots->chain(slot));
+        sync_controls();
+        ui->statusBar->showMessage(QString(tr("Snapshot %1")).arg(QChar('A' + index)), 2000);
+    }
+
+    // Shows settings changed on the amp itself
+    void MainWindow::show_amp_change(const com::StateChange& change)
+    {
+        PLUG_TRACE_SPAN("ui", "MainWindow::show_amp_change");
+
+        if (connected == false)
+        {
+            return;
+        }
+
+        amp_settings current = current_amp();
+
+        snapshots->invalidate();
+        updating_windows = true;
+
+        if (const auto* settings = std::get_if<amp_settings>(&change); settings != nullptr)
+        {
+            amp_settings updated = *settings;
+            updated.usb_gain = current.usb_gain;
+            load_amp(updated);
+        }
+        else if (const auto* usbGain = std::get_if<com::UsbGainChange>(&change); usbGain != nullptr)
+        {
+            current.usb_gain = usbGain->value;
+            load_amp(current);
+        }
+        else if (const auto* effect = std::get_if<fx_pedal_settings>(&change); effect != nullptr)
+        {
+            load_effect(*effect);
+        }
+        else if (const auto* name = std::get_if<com::NameChange>(&change); name != nullptr)
+        {
+            change_title(QString::fromStdString(name->name));
         }
 
-        if (caller != effect4)
+        reset_changed();
+        updating_windows = false;
+        sync_controls();
+    }
+
+    void MainWindow::empty_other(int value, Effect* caller)
+    {
+        const auto fx_family = describe(static_cast<effects>(value)).family;
+
+        for (std::size_t slot = 0; slot < effect_windows.size(); ++slot)
         {
-            effect4->get_settings(settings);
-            if (check_fx_family(settings.effect_num) == fx_family)
+            Effect* window = effect_windows[slot];
+
+            if (window == caller)
+            {
+                continue;
+            }
+
+            if (window != nullptr)
             {
-                effect4->choose_fx(0);
-                effect4->send_fx();
+                fx_pedal_settings settings{};
+                window->get_settings(settings);
+
+                if (describe(settings.effect_num).family == fx_family)
+                {
+                    window->choose_fx(0);
+                    window->send_fx();
+                }
+            }
+            else if (effect_states[slot].has_value() && (describe(effect_states[slot]->effect_num).family == fx_family))
+            {
+                effect_states[slot]->effect_num = effects::EMPTY;
+                set_effect(*effect_states[slot]);
             }
         }
     }
 
-    void MainWindow::load_presets0()
+    void MainWindow::apply_settings()
     {
-        QSettings settings;
+        // Keys without a quick preset are left to the focused widget
+        for (std::size_t i = 0; i < quickPresetShortcuts.size(); ++i)
+        {
+            quickPresetShortcuts[i]->setEnabled(appSettings->quick_preset(i).has_value());
+        }
+    }
+
+    void MainWindow::load_quick_preset(std::size_t index)
+    {
+        if (const auto slot = appSettings->quick_preset(index); slot)
+        {
+            load_from_amp(*slot);
+        }
+    }
 
-        if (settings.contains("DefaultPresets/Preset0"))
-            load_from_amp(settings.value("DefaultPresets/Preset0").toInt());
+    void MainWindow::load_presets0()
+    {
+        load_quick_preset(0);
     }
 
     void MainWindow::load_presets1()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset1"))
-            load_from_amp(settings.value("DefaultPresets/Preset1").toInt());
+        load_quick_preset(1);
     }
 
     void MainWindow::load_presets2()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset2"))
-            load_from_amp(settings.value("DefaultPresets/Preset2").toInt());
+        load_quick_preset(2);
     }
 
     void MainWindow::load_presets3()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset3"))
-            load_from_amp(settings.value("DefaultPresets/Preset3").toInt());
+        load_quick_preset(3);
     }
 
     void MainWindow::load_presets4()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset4"))
-            load_from_amp(settings.value("DefaultPresets/Preset4").toInt());
+        load_quick_preset(4);
     }
 
     void MainWindow::load_presets5()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset5"))
-            load_from_amp(settings.value("DefaultPresets/Preset5").toInt());
+        load_quick_preset(5);
     }
 
     void MainWindow::load_presets6()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset6"))
-            load_from_amp(settings.value("DefaultPresets/Preset6").toInt());
+        load_quick_preset(6);
     }
 
     void MainWindow::load_presets7()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset7"))
-            load_from_amp(settings.value("DefaultPresets/Preset7").toInt());
+        load_quick_preset(7);
     }
 
     void MainWindow::load_presets8()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset8"))
-            load_from_amp(settings.value("DefaultPresets/Preset8").toInt());
+        load_quick_preset(8);
     }
 
     void MainWindow::load_presets9()
     {
-        QSettings settings;
-
-        if (settings.contains("DefaultPresets/Preset9"))
-            load_from_amp(settings.value("DefaultPresets/Preset9").toInt());
+        load_quick_preset(9);
     }
 }
 
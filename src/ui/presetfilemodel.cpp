@@ -0,0 +1,185 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ui/presetfilemodel.h"
+#include <QFileInfo>
+#include <algorithm>
+#include <iterator>
+
+namespace plug
+{
+    namespace
+    {
+        bool before(const QString& labelA, const QString& pathA, const QString& labelB, const QString& pathB)
+        {
+            const int order = labelA.compare(labelB, Qt::CaseInsensitive);
+            return (order < 0) || ((order == 0) && (pathA < pathB));
+        }
+    }
+
+
+    PresetFileModel::PresetFileModel(QObject* parent)
+        : QAbstractListModel(parent)
+    {
+    }
+
+    void PresetFileModel::reset(const QString& directory, const std::vector<preset::IndexEntry>& entries)
+    {
+        beginResetModel();
+        root = QDir(directory);
+        files.clear();
+        files.reserve(entries.size());
+        std::transform(entries.cbegin(), entries.cend(), std::back_inserter(files), [this](const auto& entry) { return makeFile(entry); });
+        std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return before(a.label, a.path, b.label, b.path); });
+        endResetModel();
+    }
+
+    void PresetFileModel::apply(const preset::IndexDiff& diff)
+    {
+        for (const auto& path : diff.removed)
+        {
+            if (const int row = find(QString::fromStdString(path)); row >= 0)
+            {
+                remove(row);
+            }
+        }
+
+        for (const auto& entry : diff.added)
+        {
+            insert(makeFile(entry));
+        }
+
+        for (const auto& entry : diff.changed)
+        {
+            if (const int row = find(QString::fromStdString(entry.path)); row >= 0)
+            {
+                files[static_cast<std::size_t>(row)].name = QString::fromStdString(entry.name);
+                emit dataChanged(index(row), index(row), {Qt::ToolTipRole});
+            }
+        }
+
+        for (const auto& [oldPath, entry] : diff.renamed)
+        {
+            const int row = find(QString::fromStdString(oldPath));
+
+            if (row < 0)
+            {
+                insert(makeFile(entry));
+                continue;
+            }
+
+            File file = makeFile(entry);
+            const int target = position(file);
+            // position() still counts the old row, skip it when moving down
+            const int newRow = (target > row ? target - 1 : target);
+
+            if (newRow != row)
+            {
+                beginMoveRows(QModelIndex(), row, row, QModelIndex(), target);
+                files.erase(files.begin() + row);
+                files.insert(files.begin() + newRow, std::move(file));
+                endMoveRows();
+            }
+            else
+            {
+                files[static_cast<std::size_t>(row)] = std::move(file);
+            }
+            emit dataChanged(index(newRow), index(newRow));
+        }
+    }
+
+    void PresetFileModel::clear()
+    {
+        beginResetModel();
+        files.clear();
+        endResetModel();
+    }
+
+    QString PresetFileModel::path(int row) const
+    {
+        if ((row < 0) || (row >= rowCount()))
+        {
+            return {};
+        }
+        return files[static_cast<std::size_t>(row)].path;
+    }
+
+    int PresetFileModel::rowCount(const QModelIndex& parent) const
+    {
+        return parent.isValid() ? 0 : static_cast<int>(files.size());
+    }
+
+    QVariant PresetFileModel::data(const QModelIndex& index, int role) const
+    {
+        if ((index.isValid() == false) || (index.row() >= rowCount()))
+        {
+            return {};
+        }
+
+        const auto& file = files[static_cast<std::size_t>(index.row())];
+
+        switch (role)
+        {
+            case Qt::DisplayRole:
+                return file.label;
+            case Qt::ToolTipRole:
+                return file.name;
+            default:
+                return {};
+        }
+    }
+
+    PresetFileModel::File PresetFileModel::makeFile(const preset::IndexEntry& entry) const
+    {
+        const QString path = QString::fromStdString(entry.path);
+        QString label = root.relativeFilePath(path);
+        label.chop(QFileInfo(label).suffix().size() + 1);
+        return File{label, path, QString::fromStdString(entry.name)};
+    }
+
+    int PresetFileModel::find(const QString& path) const
+    {
+        const auto itr = std::find_if(files.cbegin(), files.cend(), [&path](const auto& file) { return file.path == path; });
+        return (itr != files.cend() ? static_cast<int>(std::distance(files.cbegin(), itr)) : -1);
+    }
+
+    int PresetFileModel::position(const File& file) const
+    {
+        const auto itr = std::lower_bound(files.cbegin(), files.cend(), file, [](const auto& a, const auto& b) { return before(a.label, a.path, b.label, b.path); });
+        return static_cast<int>(std::distance(files.cbegin(), itr));
+    }
+
+    void PresetFileModel::insert(File file)
+    {
+        const int row = position(file);
+        beginInsertRows(QModelIndex(), row, row);
+        files.insert(files.begin() + row, std::move(file));
+        endInsertRows();
+    }
+
+    void PresetFileModel::remove(int row)
+    {
+        beginRemoveRows(QModelIndex(), row, row);
+        files.erase(files.begin() + row);
+        endRemoveRows();
+    }
+}
+
+#include "ui/moc_presetfilemodel.moc"
@@ -0,0 +1,144 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ui/presetnamemodel.h"
+
+namespace plug
+{
+
+    PresetNameModel::PresetNameModel(QObject* parent)
+        : QAbstractListModel(parent)
+    {
+    }
+
+    void PresetNameModel::set_names(const std::vector<std::string>& presetNames)
+    {
+        beginResetModel();
+        names.clear();
+
+        for (const auto& name : presetNames)
+        {
+            if (name.empty() || (name[0] == 0x00))
+            {
+                break;
+            }
+            names.push_back(QString::fromStdString(name));
+        }
+        chains.assign(names.size(), std::nullopt);
+        endResetModel();
+    }
+
+    void PresetNameModel::set_name(int slot, const QString& name)
+    {
+        if ((slot < 0) || (static_cast<std::size_t>(slot) >= names.size()))
+        {
+            return;
+        }
+
+        names[static_cast<std::size_t>(slot)] = name;
+        const QModelIndex changed = index(slot);
+        emit dataChanged(changed, changed, {Qt::DisplayRole});
+    }
+
+    void PresetNameModel::clear()
+    {
+        beginResetModel();
+        names.clear();
+        chains.clear();
+        endResetModel();
+    }
+
+    void PresetNameModel::set_chain(int slot, const SignalChain& chain)
+    {
+        if ((slot < 0) || (static_cast<std::size_t>(slot) >= chains.size()))
+        {
+            return;
+        }
+
+        chains[static_cast<std::size_t>(slot)] = chain;
+        const QModelIndex changed = index(slot);
+        emit dataChanged(changed, changed);
+    }
+
+    std::optional<SignalChain> PresetNameModel::chain(int slot) const
+    {
+        if ((slot < 0) || (static_cast<std::size_t>(slot) >= chains.size()))
+        {
+            return std::nullopt;
+        }
+        return chains[static_cast<std::size_t>(slot)];
+    }
+
+    QString PresetNameModel::name(int slot) const
+    {
+        if ((slot < 0) || (static_cast<std::size_t>(slot) >= names.size()))
+        {
+            return {};
+        }
+        return names[static_cast<std::size_t>(slot)];
+    }
+
+    int PresetNameModel::rowCount(const QModelIndex& parent) const
+    {
+        return parent.isValid() ? 0 : static_cast<int>(names.size());
+    }
+
+    QVariant PresetNameModel::data(const QModelIndex& index, int role) const
+    {
+        if ((index.isValid() == false) || (index.row() >= rowCount()) || (role != Qt::DisplayRole))
+        {
+            return {};
+        }
+        return QString("[%1] %2").arg(index.row() + 1).arg(names[static_cast<std::size_t>(index.row())]);
+    }
+
+
+    OptionalPresetModel::OptionalPresetModel(PresetNameModel& presets, QObject* parent)
+        : QAbstractListModel(parent),
+          source(presets)
+    {
+        connect(&presets, &QAbstractItemModel::modelAboutToBeReset, this, &OptionalPresetModel::beginResetModel);
+        connect(&presets, &QAbstractItemModel::modelReset, this, &OptionalPresetModel::endResetModel);
+        connect(&presets, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex& first, const QModelIndex& last, const QVector<int>& roles) {
+            emit dataChanged(index(first.row()), index(last.row()), roles);
+        });
+    }
+
+    int OptionalPresetModel::rowCount(const QModelIndex& parent) const
+    {
+        const int presets = (source != nullptr ? source->rowCount() : 0);
+        return parent.isValid() ? 0 : presets + 1;
+    }
+
+    QVariant OptionalPresetModel::data(const QModelIndex& index, int role) const
+    {
+        if ((index.isValid() == false) || (role != Qt::DisplayRole))
+        {
+            return {};
+        }
+        if ((source == nullptr) || (index.row() >= source->rowCount()))
+        {
+            return tr("[Empty]");
+        }
+        return source->data(source->index(index.row()), role);
+    }
+}
+
+#include "ui/moc_presetnamemodel.moc"
@@ -20,17 +20,41 @@
  */
 
 #include "ui/quickpresets.h"
+#include "ui/appsettings.h"
+#include "ui/mainwindow.h"
+#include "ui/presetnamemodel.h"
 #include "ui_quickpresets.h"
+#include <array>
 
 namespace plug
 {
+    namespace
+    {
+        std::array<QComboBox*, AppSettings::quickPresetCount> comboBoxes(const Ui::QuickPresets* ui)
+        {
+            return {{ui->comboBox, ui->comboBox_2, ui->comboBox_3, ui->comboBox_4, ui->comboBox_5,
+                     ui->comboBox_6, ui->comboBox_7, ui->comboBox_8, ui->comboBox_9, ui->comboBox_10}};
+        }
+    }
+
 
     QuickPresets::QuickPresets(QWidget* parent)
         : QDialog(parent),
-          ui(std::make_unique<Ui::QuickPresets>())
+          ui(std::make_unique<Ui::QuickPresets>()),
+          settings(dynamic_cast<MainWindow*>(parent)->app_settings()),
+          choices(new OptionalPresetModel(dynamic_cast<MainWindow*>(parent)->preset_model(), this))
     {
         ui->setupUi(this);
 
+        // All boxes show the same list, the names are formatted by the model
+        for (QComboBox* box : comboBoxes(ui.get()))
+        {
+            box->setModel(choices);
+        }
+        select_quick_presets();
+        connect(choices, &QAbstractItemModel::modelReset, this, &QuickPresets::select_quick_presets);
+        connect(&settings, &AppSettings::changed, this, &QuickPresets::select_quick_presets);
+
         connect(ui->pushButton, SIGNAL(clicked()), this, SLOT(close()));
 
         connect(ui->comboBox, SIGNAL(activated(int)), this, SLOT(setDefaultPreset0(int)));
@@ -45,241 +69,73 @@ namespace plug
         connect(ui->comboBox_10, SIGNAL(activated(int)), this, SLOT(setDefaultPreset9(int)));
     }
 
-    void QuickPresets::load_names(const std::vector<std::string>& names)
+    void QuickPresets::select_quick_presets()
     {
-        QSettings settings;
-        std::size_t i = 0;
-
-        for (i = 0; i < 100; i++)
-        {
-            if (names[i][0] == 0x00)
-            {
-                break;
-            }
-            const QString name = QString::fromStdString(names[i]);
-            ui->comboBox->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_2->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_3->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_4->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_5->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_6->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_7->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_8->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_9->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-            ui->comboBox_10->addItem(QString("[%1] %2").arg(i + 1).arg(name));
-        }
-
-        ui->comboBox->addItem(tr("[Empty]"));
-        ui->comboBox_2->addItem(tr("[Empty]"));
-        ui->comboBox_3->addItem(tr("[Empty]"));
-        ui->comboBox_4->addItem(tr("[Empty]"));
-        ui->comboBox_5->addItem(tr("[Empty]"));
-        ui->comboBox_6->addItem(tr("[Empty]"));
-        ui->comboBox_7->addItem(tr("[Empty]"));
-        ui->comboBox_8->addItem(tr("[Empty]"));
-        ui->comboBox_9->addItem(tr("[Empty]"));
-        ui->comboBox_10->addItem(tr("[Empty]"));
-
-        if (settings.contains("DefaultPresets/Preset0"))
-            ui->comboBox->setCurrentIndex(settings.value("DefaultPresets/Preset0").toInt());
-        else
-            ui->comboBox->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset1"))
-            ui->comboBox_2->setCurrentIndex(settings.value("DefaultPresets/Preset1").toInt());
-        else
-            ui->comboBox_2->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset2"))
-            ui->comboBox_3->setCurrentIndex(settings.value("DefaultPresets/Preset2").toInt());
-        else
-            ui->comboBox_3->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset3"))
-            ui->comboBox_4->setCurrentIndex(settings.value("DefaultPresets/Preset3").toInt());
-        else
-            ui->comboBox_4->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset4"))
-            ui->comboBox_5->setCurrentIndex(settings.value("DefaultPresets/Preset4").toInt());
-        else
-            ui->comboBox_5->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset5"))
-            ui->comboBox_6->setCurrentIndex(settings.value("DefaultPresets/Preset5").toInt());
-        else
-            ui->comboBox_6->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset6"))
-            ui->comboBox_7->setCurrentIndex(settings.value("DefaultPresets/Preset6").toInt());
-        else
-            ui->comboBox_7->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset7"))
-            ui->comboBox_8->setCurrentIndex(settings.value("DefaultPresets/Preset7").toInt());
-        else
-            ui->comboBox_8->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset8"))
-            ui->comboBox_9->setCurrentIndex(settings.value("DefaultPresets/Preset8").toInt());
-        else
-            ui->comboBox_9->setCurrentIndex(i);
-
-        if (settings.contains("DefaultPresets/Preset9"))
-            ui->comboBox_10->setCurrentIndex(settings.value("DefaultPresets/Preset9").toInt());
-        else
-            ui->comboBox_10->setCurrentIndex(i);
-    }
+        const int empty = choices->rowCount() - 1;
+        const auto boxes = comboBoxes(ui.get());
 
-    void QuickPresets::delete_items()
-    {
-        int j = ui->comboBox->count();
-        for (int i = 0; i < j; i++)
+        for (std::size_t i = 0; i < boxes.size(); ++i)
         {
-            ui->comboBox->removeItem(0);
-            ui->comboBox_2->removeItem(0);
-            ui->comboBox_3->removeItem(0);
-            ui->comboBox_4->removeItem(0);
-            ui->comboBox_5->removeItem(0);
-            ui->comboBox_6->removeItem(0);
-            ui->comboBox_7->removeItem(0);
-            ui->comboBox_8->removeItem(0);
-            ui->comboBox_9->removeItem(0);
-            ui->comboBox_10->removeItem(0);
+            boxes[i]->setCurrentIndex(settings.quick_preset(i).value_or(empty));
         }
     }
 
-    void QuickPresets::change_name(int slot, QString* name)
+    void QuickPresets::set_quick_preset(std::size_t index, int slot)
     {
-        ui->comboBox->setItemText(slot, *name);
-        ui->comboBox->setCurrentIndex(slot);
-
-        ui->comboBox_2->setItemText(slot, *name);
-        ui->comboBox_2->setCurrentIndex(slot);
-
-        ui->comboBox_3->setItemText(slot, *name);
-        ui->comboBox_3->setCurrentIndex(slot);
-
-        ui->comboBox_4->setItemText(slot, *name);
-        ui->comboBox_4->setCurrentIndex(slot);
-
-        ui->comboBox_5->setItemText(slot, *name);
-        ui->comboBox_5->setCurrentIndex(slot);
-
-        ui->comboBox_6->setItemText(slot, *name);
-        ui->comboBox_6->setCurrentIndex(slot);
-
-        ui->comboBox_7->setItemText(slot, *name);
-        ui->comboBox_7->setCurrentIndex(slot);
-
-        ui->comboBox_8->setItemText(slot, *name);
-        ui->comboBox_8->setCurrentIndex(slot);
-
-        ui->comboBox_9->setItemText(slot, *name);
-        ui->comboBox_9->setCurrentIndex(slot);
-
-        ui->comboBox_10->setItemText(slot, *name);
-        ui->comboBox_10->setCurrentIndex(slot);
+        if (slot == choices->rowCount() - 1)
+            settings.set_quick_preset(index, std::nullopt);
+        else
+            settings.set_quick_preset(index, slot);
     }
 
     void QuickPresets::setDefaultPreset0(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset0");
-        else
-            settings.setValue("DefaultPresets/Preset0", slot);
+        set_quick_preset(0, slot);
     }
 
     void QuickPresets::setDefaultPreset1(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset1");
-        else
-            settings.setValue("DefaultPresets/Preset1", slot);
+        set_quick_preset(1, slot);
     }
 
     void QuickPresets::setDefaultPreset2(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset2");
-        else
-            settings.setValue("DefaultPresets/Preset2", slot);
+        set_quick_preset(2, slot);
     }
 
     void QuickPresets::setDefaultPreset3(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset3");
-        else
-            settings.setValue("DefaultPresets/Preset3", slot);
+        set_quick_preset(3, slot);
     }
 
     void QuickPresets::setDefaultPreset4(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset4");
-        else
-            settings.setValue("DefaultPresets/Preset4", slot);
+        set_quick_preset(4, slot);
     }
 
     void QuickPresets::setDefaultPreset5(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset5");
-        else
-            settings.setValue("DefaultPresets/Preset5", slot);
+        set_quick_preset(5, slot);
     }
 
     void QuickPresets::setDefaultPreset6(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset6");
-        else
-            settings.setValue("DefaultPresets/Preset6", slot);
+        set_quick_preset(6, slot);
     }
 
     void QuickPresets::setDefaultPreset7(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset7");
-        else
-            settings.setValue("DefaultPresets/Preset7", slot);
+        set_quick_preset(7, slot);
     }
 
     void QuickPresets::setDefaultPreset8(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset8");
-        else
-            settings.setValue("DefaultPresets/Preset8", slot);
+        set_quick_preset(8, slot);
     }
 
     void QuickPresets::setDefaultPreset9(int slot)
     {
-        QSettings settings;
-
-        if (slot == 24 || slot == 100)
-            settings.remove("DefaultPresets/Preset9");
-        else
-            settings.setValue("DefaultPresets/Preset9", slot);
+        set_quick_preset(9, slot);
     }
 
     void QuickPresets::changeEvent(QEvent* e)
@@ -20,9 +20,10 @@
  */
 
 #include "ui/saveonamp.h"
+#include "ui/appsettings.h"
 #include "ui/mainwindow.h"
+#include "ui/presetnamemodel.h"
 #include "ui_saveonamp.h"
-#include <QSettings>
 
 namespace plug
 {
@@ -32,9 +33,9 @@ namespace plug
           ui(std::make_unique<Ui::SaveOnAmp>())
     {
         ui->setupUi(this);
+        ui->comboBox->setModel(&dynamic_cast<MainWindow*>(parent)->preset_model());
 
-        QSettings settings;
-        restoreGeometry(settings.value("Windows/saveAmpPresetWindowGeometry").toByteArray());
+        AppSettings::restore_geometry(*this, "Windows/saveAmpPresetWindowGeometry");
 
         connect(ui->pushButton, SIGNAL(clicked()), this, SLOT(save()));
         connect(ui->pushButton_2, SIGNAL(clicked()), this, SLOT(close()));
@@ -42,44 +43,18 @@ namespace plug
 
     SaveOnAmp::~SaveOnAmp()
     {
-        QSettings settings;
-        settings.setValue("Windows/saveAmpPresetWindowGeometry", saveGeometry());
+        AppSettings::save_geometry(*this, "Windows/saveAmpPresetWindowGeometry");
     }
 
     void SaveOnAmp::save()
     {
-        QSettings settings;
-        QString name(QString("[%1] %2").arg(ui->comboBox->currentIndex()).arg(ui->lineEdit->text()));
-
-        ui->comboBox->setItemText(ui->comboBox->currentIndex(), name);
-        dynamic_cast<MainWindow*>(parent())->change_name(ui->comboBox->currentIndex(), &name);
         dynamic_cast<MainWindow*>(parent())->save_on_amp(ui->lineEdit->text().toLatin1().data(), ui->comboBox->currentIndex());
-        if (!settings.value("Settings/keepWindowsOpen").toBool())
+        if (dynamic_cast<MainWindow*>(parent())->app_settings().keep_windows_open() == false)
         {
             this->close();
         }
     }
 
-    void SaveOnAmp::load_names(const std::vector<std::string>& names)
-    {
-        for (std::size_t i = 0; i < 100; ++i)
-        {
-            if (names[i][0] == 0x00)
-            {
-                break;
-            }
-            ui->comboBox->addItem(QString("[%1] %2").arg(i + 1).arg(QString::fromStdString(names[i])));
-        }
-    }
-
-    void SaveOnAmp::delete_items()
-    {
-        for (int i = 0; i < ui->comboBox->count(); ++i)
-        {
-            ui->comboBox->removeItem(0);
-        }
-    }
-
     void SaveOnAmp::change_index(int value, const QString& name)
     {
         if (value > 0)
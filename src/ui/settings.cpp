@@ -20,6 +20,8 @@
  */
 
 #include "ui/settings.h"
+#include "ui/appsettings.h"
+#include "ui/mainwindow.h"
 #include "ui_settings.h"
 
 namespace plug
@@ -27,18 +29,13 @@ namespace plug
 
     Settings::Settings(QWidget* parent)
         : QDialog(parent),
-          ui(std::make_unique<Ui::Settings>())
+          ui(std::make_unique<Ui::Settings>()),
+          settings(dynamic_cast<MainWindow*>(parent)->app_settings())
     {
-        QSettings settings;
-
         ui->setupUi(this);
+        show_settings();
 
-        ui->checkBox_2->setChecked(settings.value("Settings/connectOnStartup").toBool());
-        ui->checkBox_3->setChecked(settings.value("Settings/oneSetToSetThemAll").toBool());
-        ui->checkBox_4->setChecked(settings.value("Settings/keepWindowsOpen").toBool());
-        ui->checkBox_5->setChecked(settings.value("Settings/popupChangedWindows").toBool());
-        ui->checkBox_6->setChecked(settings.value("Settings/defaultEffectValues").toBool());
-
+        connect(&settings, &AppSettings::changed, this, &Settings::show_settings);
         connect(ui->checkBox_2, SIGNAL(toggled(bool)), this, SLOT(change_connect(bool)));
         connect(ui->checkBox_3, SIGNAL(toggled(bool)), this, SLOT(change_oneset(bool)));
         connect(ui->checkBox_4, SIGNAL(toggled(bool)), this, SLOT(change_keepopen(bool)));
@@ -46,39 +43,38 @@ namespace plug
         connect(ui->checkBox_6, SIGNAL(toggled(bool)), this, SLOT(change_effectvalues(bool)));
     }
 
-    void Settings::change_connect(bool value)
+    void Settings::show_settings()
     {
-        QSettings settings;
+        ui->checkBox_2->setChecked(settings.connect_on_startup());
+        ui->checkBox_3->setChecked(settings.one_set_to_set_them_all());
+        ui->checkBox_4->setChecked(settings.keep_windows_open());
+        ui->checkBox_5->setChecked(settings.popup_changed_windows());
+        ui->checkBox_6->setChecked(settings.default_effect_values());
+    }
 
-        settings.setValue("Settings/connectOnStartup", value);
+    void Settings::change_connect(bool value)
+    {
+        settings.set_connect_on_startup(value);
     }
 
     void Settings::change_oneset(bool value)
     {
-        QSettings settings;
-
-        settings.setValue("Settings/oneSetToSetThemAll", value);
+        settings.set_one_set_to_set_them_all(value);
     }
 
     void Settings::change_keepopen(bool value)
     {
-        QSettings settings;
-
-        settings.setValue("Settings/keepWindowsOpen", value);
+        settings.set_keep_windows_open(value);
     }
 
     void Settings::change_popupwindows(bool value)
     {
-        QSettings settings;
-
-        settings.setValue("Settings/popupChangedWindows", value);
+        settings.set_popup_changed_windows(value);
     }
 
     void Settings::change_effectvalues(bool value)
     {
-        QSettings settings;
-
-        settings.setValue("Settings/defaultEffectValues", value);
+        settings.set_default_effect_values(value);
     }
 }
 
@@ -0,0 +1,140 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/AmpBackup.h"
+#include "preset/PresetBank.h"
+#include "com/PacketSerializer.h"
+#include "mocks/MockConnection.h"
+#include <filesystem>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace testing;
+
+namespace fs = std::filesystem;
+
+
+class AmpBackupTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        path = (fs::temp_directory_path() / ("plug-backup-test-" + std::string{testing::UnitTest::GetInstance()->current_test_info()->name()} + ".bank")).string();
+        fs::remove(path);
+        conn = std::make_shared<NiceMock<mock::MockConnection>>();
+        amp = std::make_unique<com::Mustang>(conn);
+
+        ON_CALL(*conn, sendImpl(_, _)).WillByDefault([this](std::uint8_t* data, std::size_t size) {
+            sent.emplace_back(data, data + size);
+            return size;
+        });
+    }
+
+    void TearDown() override
+    {
+        fs::remove(path);
+    }
+
+    // Answers load requests with presets named "preset <n>"
+    void simulatePresets()
+    {
+        ON_CALL(*conn, receive(_)).WillByDefault([this](std::size_t) {
+            const auto slot = received / 7;
+            const auto index = received % 7;
+
+            if (slot >= loadRequests())
+            {
+                return std::vector<std::uint8_t>{};
+            }
+            ++received;
+            const amp_settings ampSettings{amps::FENDER_57_DELUXE, static_cast<std::uint8_t>(slot), 0, 0, 0, 0, cabinets::cab57DLX, 0, 0, 0, 0, 0, 0, 0, 0, false, 0};
+            const fx_pedal_settings fx{static_cast<std::uint8_t>(index - 2), effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input};
+
+            switch (index)
+            {
+                case 0:
+                    return asBuffer(com::serializeName(static_cast<std::uint8_t>(slot), "preset " + std::to_string(slot)).getBytes());
+                case 1:
+                    return asBuffer(com::serializeAmpSettings(ampSettings).getBytes());
+                case 6:
+                    return asBuffer(com::serializeAmpSettingsUsbGain(ampSettings).getBytes());
+                default:
+                    return asBuffer(com::serializeEffectSettings(fx).getBytes());
+            }
+        });
+    }
+
+    std::size_t loadRequests() const
+    {
+        return static_cast<std::size_t>(std::count_if(sent.cbegin(), sent.cend(), [](const auto& p) { return (p.size() > 4) && (p == asBuffer(com::serializeLoadSlotCommand(p[4]).getBytes())); }));
+    }
+
+    template <class Container>
+    static std::vector<std::uint8_t> asBuffer(const Container& c)
+    {
+        return std::vector<std::uint8_t>{std::cbegin(c), std::cend(c)};
+    }
+
+    std::string path;
+    std::shared_ptr<NiceMock<mock::MockConnection>> conn;
+    std::unique_ptr<com::Mustang> amp;
+    std::vector<std::vector<std::uint8_t>> sent;
+    std::size_t received{0};
+};
+
+TEST_F(AmpBackupTest, backupWritesBank)
+{
+    simulatePresets();
+    std::size_t lastProgress{0};
+
+    backupToBank(*amp, 24, path, [&lastProgress](std::size_t done, std::size_t) { lastProgress = done; });
+
+    const PresetBank bank{path};
+    ASSERT_THAT(bank.size(), Eq(24));
+    EXPECT_THAT(bank[17].getName(), Eq("preset 17"));
+    EXPECT_THAT(decodeRecord(bank[17]).amp().gain, Eq(17));
+    EXPECT_THAT(lastProgress, Eq(24));
+    EXPECT_THAT(fs::exists(path + ".tmp"), IsFalse());
+}
+
+TEST_F(AmpBackupTest, failedBackupKeepsExistingBank)
+{
+    simulatePresets();
+    backupToBank(*amp, 2, path);
+
+    ON_CALL(*conn, receive(_)).WillByDefault(Return(std::vector<std::uint8_t>{}));
+
+    EXPECT_THROW(backupToBank(*amp, 24, path), std::exception);
+    EXPECT_THAT(PresetBank{path}.size(), Eq(2));
+}
+
+TEST_F(AmpBackupTest, restoreSavesAllSlots)
+{
+    simulatePresets();
+    backupToBank(*amp, 3, path);
+    sent.clear();
+
+    EXPECT_THAT(restoreFromBank(*amp, path), Eq(3));
+
+    const auto saveName = asBuffer(com::serializeName(2, "preset 2").getBytes());
+    EXPECT_THAT(sent.size(), Eq(3 * 8));
+    EXPECT_THAT(sent.back(), Eq(saveName));
+}
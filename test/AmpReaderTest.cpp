@@ -0,0 +1,323 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/AmpReader.h"
+#include "com/PacketSerializer.h"
+#include "com/CommunicationException.h"
+#include "metrics/Metrics.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+    std::vector<std::uint8_t> asVector(const PacketRawType& packet)
+    {
+        return std::vector<std::uint8_t>{packet.cbegin(), packet.cend()};
+    }
+
+    // Connection with scripted incoming packets
+    class FakeConnection : public Connection
+    {
+    public:
+        void close() override
+        {
+        }
+
+        bool isOpen() const override
+        {
+            return true;
+        }
+
+        std::vector<std::uint8_t> receive(std::size_t) override
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            incomingReady.wait_for(lock, 5ms, [this] { return (incoming.empty() == false) || failing; });
+
+            if (failing == true)
+            {
+                throw CommunicationException{"failed"};
+            }
+            if (incoming.empty() == true)
+            {
+                return {};
+            }
+            auto packet = incoming.front();
+            incoming.pop_front();
+            return packet;
+        }
+
+        void inject(const PacketRawType& packet)
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            incoming.emplace_back(packet.cbegin(), packet.cend());
+            incomingReady.notify_one();
+        }
+
+        void fail()
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            failing = true;
+            incomingReady.notify_one();
+        }
+
+        std::size_t sentCount() const
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            return sent;
+        }
+
+        std::optional<PacketRawType> ack;
+
+    private:
+        std::size_t sendImpl(std::uint8_t*, std::size_t size) override
+        {
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                ++sent;
+            }
+            if (ack.has_value())
+            {
+                inject(*ack);
+            }
+            return size;
+        }
+
+        mutable std::mutex mutex;
+        std::condition_variable incomingReady;
+        std::deque<std::vector<std::uint8_t>> incoming;
+        std::size_t sent{0};
+        bool failing{false};
+    };
+}
+
+
+class AmpReaderTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        conn = std::make_shared<FakeConnection>();
+        reader = std::make_unique<AmpReader>(conn, 50ms);
+    }
+
+    template <class Predicate>
+    static bool waitFor(Predicate predicate)
+    {
+        const auto end = std::chrono::steady_clock::now() + 2s;
+
+        while ((predicate() == false) && (std::chrono::steady_clock::now() < end))
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        return predicate();
+    }
+
+    static PacketRawType frontPanel(PacketRawType packet)
+    {
+        packet[0] = 0x05;
+        return packet;
+    }
+
+    static std::uint64_t responseTimeouts()
+    {
+        return metrics::Registry::global().counter("plug_amp_response_timeouts_total", "Amp responses not received within the timeout").value();
+    }
+
+    std::vector<StateChange> changes() const
+    {
+        std::lock_guard<std::mutex> lock{changesMutex};
+        return received;
+    }
+
+    void subscribe()
+    {
+        reader->subscribe([this](const StateChange& change) {
+            std::lock_guard<std::mutex> lock{changesMutex};
+            received.push_back(change);
+        });
+    }
+
+    std::shared_ptr<FakeConnection> conn;
+    std::unique_ptr<AmpReader> reader;
+    mutable std::mutex changesMutex;
+    std::vector<StateChange> received;
+
+    const amp_settings amp{amps::BRITISH_80S, 10, 20, 30, 40, 50, cabinets::cab4x12M, 1, 2, 3, 4, 5, 6, 7, 1, false, 9};
+    const fx_pedal_settings effect{2, effects::TAPE_DELAY, 1, 2, 3, 4, 5, 6, Position::effectsLoop};
+    const PacketRawType ackPacket = [] { PacketRawType p{}; p[0] = 0x1c; p[1] = 0x01; return p; }();
+    const std::array<std::uint8_t, 8> command{{0x1c, 0x03}};
+};
+
+TEST_F(AmpReaderTest, passesThroughUntilStarted)
+{
+    conn->inject(ackPacket);
+
+    EXPECT_FALSE(reader->isRunning());
+    EXPECT_THAT(reader->receive(packetRawTypeSize), ElementsAreArray(ackPacket));
+}
+
+TEST_F(AmpReaderTest, responseIsReceivedAfterSend)
+{
+    conn->ack = ackPacket;
+    reader->start();
+    reader->send(command);
+
+    EXPECT_THAT(reader->receive(packetRawTypeSize), ElementsAreArray(ackPacket));
+    EXPECT_THAT(conn->sentCount(), Eq(1));
+}
+
+TEST_F(AmpReaderTest, receiveTimesOutWithoutResponse)
+{
+    reader->start();
+    EXPECT_THAT(reader->receive(packetRawTypeSize), IsEmpty());
+}
+
+TEST_F(AmpReaderTest, missingResponseIsCountedAsTimeout)
+{
+    const auto before = responseTimeouts();
+    reader->start();
+    reader->receive(packetRawTypeSize);
+
+    EXPECT_THAT(responseTimeouts(), Eq(before + 1));
+}
+
+TEST_F(AmpReaderTest, idleReadsAreNotCountedAsTimeout)
+{
+    conn->ack = ackPacket;
+    const auto before = responseTimeouts();
+    reader->start();
+    std::this_thread::sleep_for(20ms);
+    reader->send(command);
+    reader->receive(packetRawTypeSize);
+
+    EXPECT_THAT(responseTimeouts(), Eq(before));
+}
+
+TEST_F(AmpReaderTest, frontPanelChangeIsPublished)
+{
+    subscribe();
+    reader->start();
+    reader->send(command);
+    conn->inject(frontPanel(serializeAmpSettings(amp).getBytes()));
+
+    ASSERT_TRUE(waitFor([this] { return changes().size() == 1; }));
+    const auto change = std::get<amp_settings>(changes()[0]);
+    EXPECT_THAT(change.amp_num, Eq(amps::BRITISH_80S));
+    EXPECT_THAT(change.gain, Eq(10));
+    EXPECT_THAT(reader->receive(packetRawTypeSize), IsEmpty());
+}
+
+TEST_F(AmpReaderTest, unsolicitedPacketIsNotTakenAsResponse)
+{
+    subscribe();
+    reader->start();
+    conn->inject(serializeEffectSettings(effect).getBytes());
+
+    ASSERT_TRUE(waitFor([this] { return changes().size() == 1; }));
+    EXPECT_THAT(std::get<fx_pedal_settings>(changes()[0]).effect_num, Eq(effects::TAPE_DELAY));
+
+    conn->ack = ackPacket;
+    reader->send(command);
+    EXPECT_THAT(reader->receive(packetRawTypeSize), ElementsAreArray(ackPacket));
+}
+
+TEST_F(AmpReaderTest, staleResponseIsDroppedOnSend)
+{
+    reader->start();
+    reader->send(command);
+    conn->inject(serializeAmpSettingsUsbGain(amp).getBytes());
+
+    std::this_thread::sleep_for(120ms);
+
+    conn->ack = ackPacket;
+    reader->send(command);
+
+    EXPECT_THAT(reader->receive(packetRawTypeSize), ElementsAreArray(ackPacket));
+    EXPECT_THAT(reader->discarded(), Eq(1));
+}
+
+TEST_F(AmpReaderTest, unsubscribedIsNotCalled)
+{
+    std::size_t calls{0};
+    const auto id = reader->subscribe([&calls](const StateChange&) { ++calls; });
+    subscribe();
+    reader->unsubscribe(id);
+    reader->start();
+    conn->inject(frontPanel(serializeEffectSettings(effect).getBytes()));
+
+    ASSERT_TRUE(waitFor([this] { return changes().size() == 1; }));
+    EXPECT_THAT(calls, Eq(0));
+}
+
+TEST_F(AmpReaderTest, readErrorStopsReader)
+{
+    std::atomic<bool> failed{false};
+    reader->setErrorHandler([&failed](const std::exception&) { failed = true; });
+    reader->start();
+    conn->fail();
+
+    ASSERT_TRUE(waitFor([&failed] { return failed == true; }));
+    EXPECT_TRUE(waitFor([this] { return reader->isRunning() == false; }));
+}
+
+TEST_F(AmpReaderTest, decodeStateChangeOfEffect)
+{
+    const auto change = decodeStateChange(asVector(serializeEffectSettings(effect).getBytes()));
+
+    ASSERT_TRUE(change.has_value());
+    const auto decoded = std::get<fx_pedal_settings>(*change);
+    EXPECT_THAT(decoded.fx_slot, Eq(2));
+    EXPECT_THAT(decoded.effect_num, Eq(effects::TAPE_DELAY));
+    EXPECT_THAT(decoded.knob6, Eq(6));
+    EXPECT_THAT(decoded.position, Eq(Position::effectsLoop));
+}
+
+TEST_F(AmpReaderTest, decodeStateChangeOfUsbGain)
+{
+    const auto change = decodeStateChange(asVector(serializeAmpSettingsUsbGain(amp).getBytes()));
+
+    ASSERT_TRUE(change.has_value());
+    EXPECT_THAT(std::get<UsbGainChange>(*change).value, Eq(9));
+}
+
+TEST_F(AmpReaderTest, decodeStateChangeOfName)
+{
+    auto packet = serializeName(3, "abc").getBytes();
+    packet[2] = 0x04;
+    const auto change = decodeStateChange(asVector(packet));
+
+    ASSERT_TRUE(change.has_value());
+    EXPECT_THAT(std::get<NameChange>(*change).name, StrEq("abc"));
+}
+
+TEST_F(AmpReaderTest, decodeStateChangeIgnoresOtherPackets)
+{
+    EXPECT_FALSE(decodeStateChange(asVector(serializeApplyCommand().getBytes())).has_value());
+    EXPECT_FALSE(decodeStateChange(std::vector<std::uint8_t>(10)).has_value());
+    EXPECT_FALSE(decodeStateChange(std::vector<std::uint8_t>(packetRawTypeSize, 0xee)).has_value());
+}
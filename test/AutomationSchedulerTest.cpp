@@ -0,0 +1,290 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/AutomationScheduler.h"
+#include "com/CommandQueue.h"
+#include "com/Mustang.h"
+#include "com/PacketSerializer.h"
+#include "mocks/MockConnection.h"
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace testing;
+using namespace std::chrono_literals;
+
+
+class AutomationSchedulerTest : public testing::Test
+{
+protected:
+    using Clock = AutomationScheduler::Clock;
+
+    struct Sent
+    {
+        PacketRawType packet;
+        Clock::time_point time;
+    };
+
+    void SetUp() override
+    {
+        conn = std::make_shared<NiceMock<mock::MockConnection>>();
+        mustang = std::make_unique<Mustang>(conn);
+        queue = std::make_unique<CommandQueue>(*mustang);
+
+        ON_CALL(*conn, sendImpl(_, _)).WillByDefault(Invoke(this, &AutomationSchedulerTest::record));
+        queue->start();
+    }
+
+    void TearDown() override
+    {
+        queue->stop();
+    }
+
+    std::size_t record(std::uint8_t* data, std::size_t size)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        PacketRawType packet{};
+        std::copy_n(data, std::min(size, packet.size()), packet.begin());
+        sent.push_back({packet, Clock::now()});
+        return size;
+    }
+
+    // Waits until everything posted so far was sent
+    void sync()
+    {
+        queue->submit(CommandPriority::setting, [](Mustang&) {}).get();
+    }
+
+    std::optional<Clock::time_point> sentAt(const PacketRawType& expected)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        const auto itr = std::find_if(sent.cbegin(), sent.cend(), [&expected](const auto& s) { return s.packet == expected; });
+        return (itr != sent.cend() ? std::optional{itr->time} : std::nullopt);
+    }
+
+    // Gain of all amp writes, in order
+    std::vector<int> sentGains()
+    {
+        return sentGains(amp);
+    }
+
+    // Gain of all amp writes matching base otherwise, in order
+    std::vector<int> sentGains(const amp_settings& base)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        std::vector<int> gains;
+
+        for (const auto& s : sent)
+        {
+            for (int gain = 0; gain < 256; ++gain)
+            {
+                auto settings = base;
+                settings.gain = static_cast<std::uint8_t>(gain);
+
+                if (s.packet == serializeAmpSettings(settings).getBytes())
+                {
+                    gains.push_back(gain);
+                    break;
+                }
+            }
+        }
+        return gains;
+    }
+
+    static ControlEvent ampGain(std::uint8_t value)
+    {
+        return {ControlTarget::amp, 0, static_cast<std::uint8_t>(AmpParameter::gain), value};
+    }
+
+    const amp_settings amp{amps::BRITISH_80S, 120, 100, 80, 70, 60, cabinets::cab4x12M, 1, 2, 3, 4, 5, 6, 7, 8, false, 9};
+    const SignalChain chain{"automated", amp, {{{0, effects::OVERDRIVE, 10, 20, 30, 40, 50, 0, Position::input, true},
+                                               {1, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                               {2, effects::MONO_DELAY, 1, 2, 3, 4, 5, 0, Position::effectsLoop, true},
+                                               {3, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input}}}};
+    std::shared_ptr<NiceMock<mock::MockConnection>> conn;
+    std::unique_ptr<Mustang> mustang;
+    std::unique_ptr<CommandQueue> queue;
+    std::mutex mutex;
+    std::vector<Sent> sent;
+};
+
+TEST_F(AutomationSchedulerTest, tempoConvertsMusicalTime)
+{
+    const Tempo tempo{120.0, 4};
+
+    EXPECT_THAT(tempo.at(1), Eq(0s));
+    EXPECT_THAT(tempo.at(1, 3.0), Eq(1s));
+    EXPECT_THAT(tempo.at(33), Eq(64s));
+    EXPECT_THROW(tempo.at(0), std::invalid_argument);
+    EXPECT_THROW((Tempo{0.0, 4}.at(1)), std::invalid_argument);
+}
+
+TEST_F(AutomationSchedulerTest, setWritesAmpAtScheduledTime)
+{
+    AutomationScheduler scheduler{*queue, chain};
+    const auto origin = Clock::now();
+    auto expected = amp;
+    expected.gain = 200;
+
+    scheduler.start({setAt(20ms, ampGain(200))}, origin);
+    scheduler.wait();
+    sync();
+
+    const auto time = sentAt(serializeAmpSettings(expected).getBytes());
+    ASSERT_THAT(time.has_value(), IsTrue());
+    EXPECT_THAT(*time, Ge(origin + 20ms));
+    EXPECT_THAT(scheduler.isRunning(), IsFalse());
+}
+
+TEST_F(AutomationSchedulerTest, setWritesEffect)
+{
+    AutomationScheduler scheduler{*queue, chain};
+    auto expected = chain.effects()[2];
+    expected.knob1 = 200;
+
+    scheduler.start({setAt(1ms, {ControlTarget::effect, 2, static_cast<std::uint8_t>(EffectParameter::knob1), 200})});
+    scheduler.wait();
+    sync();
+
+    EXPECT_THAT(sentAt(serializeEffectSettings(expected).getBytes()).has_value(), IsTrue());
+}
+
+TEST_F(AutomationSchedulerTest, replacedEffectOfOtherFamilyIsCleared)
+{
+    AutomationScheduler scheduler{*queue, chain};
+    auto replaced = chain.effects()[0];
+    replaced.enabled = false;
+
+    scheduler.start({setAt(1ms, {ControlTarget::effect, 0, static_cast<std::uint8_t>(EffectParameter::model), static_cast<std::uint8_t>(effects::SINE_CHORUS)})});
+    scheduler.wait();
+    sync();
+
+    EXPECT_THAT(sentAt(serializeClearEffectSettings(replaced).getBytes()).has_value(), IsTrue());
+}
+
+TEST_F(AutomationSchedulerTest, rampEndsOnTargetValue)
+{
+    AutomationScheduler scheduler{*queue, chain, 5ms};
+
+    scheduler.start({rampAt(5ms, ampGain(180), 120, 100ms)});
+    scheduler.wait();
+    sync();
+
+    const auto gains = sentGains();
+    ASSERT_THAT(gains.size(), Gt(1));
+    EXPECT_THAT(gains.front(), Ge(120));
+    EXPECT_THAT(gains.back(), Eq(180));
+    EXPECT_THAT(std::is_sorted(gains.cbegin(), gains.cend()), IsTrue());
+}
+
+TEST_F(AutomationSchedulerTest, setTakesOverFromRamp)
+{
+    AutomationScheduler scheduler{*queue, chain, 5ms};
+
+    scheduler.start({rampAt(1ms, ampGain(255), 0, 10s), setAt(20ms, ampGain(17))});
+    scheduler.wait();
+    sync();
+
+    EXPECT_THAT(sentGains().back(), Eq(17));
+}
+
+TEST_F(AutomationSchedulerTest, recordsJitterOfEveryEvent)
+{
+    AutomationScheduler scheduler{*queue, chain};
+
+    scheduler.start({setAt(30ms, ampGain(1)),
+                     setAt(10ms, {ControlTarget::effect, 0, static_cast<std::uint8_t>(EffectParameter::knob2), 5}),
+                     setAt(10ms, ampGain(2))});
+    scheduler.wait();
+    sync();
+
+    const auto records = scheduler.dispatched();
+    ASSERT_THAT(records.size(), Eq(3));
+    EXPECT_THAT(records, UnorderedElementsAre(Field(&DispatchRecord::event, 0), Field(&DispatchRecord::event, 1), Field(&DispatchRecord::event, 2)));
+    EXPECT_THAT(records, Each(Field(&DispatchRecord::jitter, AllOf(Ge(0ns), Lt(1s)))));
+}
+
+TEST_F(AutomationSchedulerTest, slowWritesAreCoalesced)
+{
+    ON_CALL(*conn, sendImpl(_, _)).WillByDefault(Invoke([this](std::uint8_t* data, std::size_t size) {
+        std::this_thread::sleep_for(20ms);
+        return record(data, size);
+    }));
+    AutomationScheduler scheduler{*queue, chain, 10ms};
+    constexpr auto duration = 200ms;
+
+    scheduler.start({rampAt(0ms, ampGain(200), 0, duration),
+                     setAt(50ms, {ControlTarget::effect, 0, static_cast<std::uint8_t>(EffectParameter::knob1), 99}),
+                     setAt(100ms, {ControlTarget::effect, 2, static_cast<std::uint8_t>(EffectParameter::knob2), 98})});
+    scheduler.wait();
+    sync();
+
+    const auto gains = sentGains();
+    ASSERT_THAT(gains.empty(), IsFalse());
+    EXPECT_THAT(gains.size(), Lt(static_cast<std::size_t>(duration / 10ms)));
+    EXPECT_THAT(gains.back(), Eq(200));
+    EXPECT_THAT(scheduler.dispatched(), UnorderedElementsAre(Field(&DispatchRecord::event, 0), Field(&DispatchRecord::event, 1), Field(&DispatchRecord::event, 2)));
+}
+
+TEST_F(AutomationSchedulerTest, updateKeepsExternalChanges)
+{
+    AutomationScheduler scheduler{*queue, chain, 5ms};
+    auto updated = amp;
+    updated.volume = 33;
+
+    scheduler.start({rampAt(0ms, ampGain(200), 0, 300ms)});
+    std::this_thread::sleep_for(100ms);
+    scheduler.update(SignalChain{"external", updated, chain.effects()});
+    scheduler.wait();
+    sync();
+
+    auto reverted = amp;
+    reverted.gain = 200;
+    const auto gains = sentGains(updated);
+    ASSERT_THAT(gains.empty(), IsFalse());
+    EXPECT_THAT(gains.back(), Eq(200));
+    EXPECT_THAT(sentAt(serializeAmpSettings(reverted).getBytes()).has_value(), IsFalse());
+}
+
+TEST_F(AutomationSchedulerTest, stopEndsPlayback)
+{
+    AutomationScheduler scheduler{*queue, chain};
+
+    scheduler.start({setAt(10s, ampGain(1))});
+    EXPECT_THAT(scheduler.isRunning(), IsTrue());
+    scheduler.stop();
+    sync();
+
+    EXPECT_THAT(scheduler.isRunning(), IsFalse());
+    EXPECT_THAT(sentGains(), IsEmpty());
+    EXPECT_THAT(scheduler.dispatched(), IsEmpty());
+}
+
+TEST_F(AutomationSchedulerTest, presetEventsAreRejected)
+{
+    AutomationScheduler scheduler{*queue, chain};
+
+    EXPECT_THROW(scheduler.start({setAt(0ms, {ControlTarget::preset, 1, 0, 0})}), std::invalid_argument);
+    EXPECT_THAT(scheduler.isRunning(), IsFalse());
+}
@@ -0,0 +1,108 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/AutomationTimeline.h"
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+    MATCHER_P4(IsChange, target, slot, parameter, value, "")
+    {
+        return (arg.target == target) && (arg.slot == slot) && (arg.parameter == static_cast<std::uint8_t>(parameter)) && (arg.value == value);
+    }
+}
+
+
+TEST(AutomationTimelineTest, emptyTimeline)
+{
+    EXPECT_THAT(parseTimeline(""), IsEmpty());
+    EXPECT_THAT(parseTimeline("# nothing\n\n   \n"), IsEmpty());
+}
+
+TEST(AutomationTimelineTest, setAtBar)
+{
+    const auto timeline = parseTimeline("33 /fx/2/knob1 200\n");
+
+    ASSERT_THAT(timeline.size(), Eq(1));
+    EXPECT_THAT(timeline[0].at, Eq(64s));
+    EXPECT_THAT(timeline[0].ramp, Eq(0ns));
+    EXPECT_THAT(timeline[0].change, IsChange(ControlTarget::effect, 1, EffectParameter::knob1, 200));
+}
+
+TEST(AutomationTimelineTest, setAtBeat)
+{
+    const auto timeline = parseTimeline("2:3 /amp/gain 10");
+
+    ASSERT_THAT(timeline.size(), Eq(1));
+    EXPECT_THAT(timeline[0].at, Eq(3s));
+    EXPECT_THAT(timeline[0].change, IsChange(ControlTarget::amp, 0, AmpParameter::gain, 10));
+}
+
+TEST(AutomationTimelineTest, ramp)
+{
+    const auto timeline = parseTimeline("1 /amp/gain 120..180 2s");
+
+    ASSERT_THAT(timeline.size(), Eq(1));
+    EXPECT_THAT(timeline[0].at, Eq(0s));
+    EXPECT_THAT(timeline[0].from, Eq(120));
+    EXPECT_THAT(timeline[0].ramp, Eq(2s));
+    EXPECT_THAT(timeline[0].change, IsChange(ControlTarget::amp, 0, AmpParameter::gain, 180));
+}
+
+TEST(AutomationTimelineTest, tempoAppliesToChanges)
+{
+    const auto timeline = parseTimeline("tempo 60 3\n"
+                                        "2 /amp/volume 1   # second bar\n"
+                                        "3:2.5 /amp/volume 2\n");
+
+    ASSERT_THAT(timeline.size(), Eq(2));
+    EXPECT_THAT(timeline[0].at, Eq(3s));
+    EXPECT_THAT(timeline[1].at, Eq(7500ms));
+}
+
+TEST(AutomationTimelineTest, errorsNameTheLine)
+{
+    EXPECT_THAT([] { parseTimeline("1 /amp/gain 1\n2 /amp/unknown 1"); }, ThrowsMessage<std::runtime_error>(StartsWith("Line 2:")));
+}
+
+TEST(AutomationTimelineTest, invalidLinesAreRejected)
+{
+    EXPECT_THROW(parseTimeline("1 /amp/gain"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("1 /amp/gain 256"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("0 /amp/gain 1"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("x /amp/gain 1"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("1:0.5 /amp/gain 1"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("1 /amp/gain 1..2"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("1 /amp/gain 1..2 2"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("1 /amp/gain 1..2 0s"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("tempo 0 4"), std::runtime_error);
+    EXPECT_THROW(parseTimeline("1 /amp/gain 1\ntempo 90 4"), std::runtime_error);
+}
+
+TEST(AutomationTimelineTest, presetLoadsAreRejected)
+{
+    EXPECT_THROW(parseTimeline("1 /preset/load 3"), std::runtime_error);
+}
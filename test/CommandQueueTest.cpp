@@ -0,0 +1,194 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/CommandQueue.h"
+#include "com/Mustang.h"
+#include "mocks/MockConnection.h"
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace testing;
+
+
+class CommandQueueTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        conn = std::make_shared<NiceMock<mock::MockConnection>>();
+        mustang = std::make_unique<Mustang>(conn);
+        queue = std::make_unique<CommandQueue>(*mustang);
+    }
+
+    CommandQueue::Command record(const std::string& name)
+    {
+        return [this, name](Mustang&) { executed.push_back(name); };
+    }
+
+    // Waits until everything posted so far was sent
+    void sync()
+    {
+        queue->submit(CommandPriority::setting, [](Mustang&) {}).get();
+    }
+
+    std::shared_ptr<NiceMock<mock::MockConnection>> conn;
+    std::unique_ptr<Mustang> mustang;
+    std::unique_ptr<CommandQueue> queue;
+    std::vector<std::string> executed;
+};
+
+TEST_F(CommandQueueTest, executesInPostOrder)
+{
+    queue->start();
+    queue->post(CommandPriority::setting, unkeyed, record("a"));
+    queue->post(CommandPriority::setting, unkeyed, record("b"));
+    queue->post(CommandPriority::setting, unkeyed, record("c"));
+    sync();
+
+    EXPECT_THAT(executed, ElementsAre("a", "b", "c"));
+}
+
+TEST_F(CommandQueueTest, presetGoesAheadOfSettings)
+{
+    queue->post(CommandPriority::setting, unkeyed, record("a"));
+    queue->post(CommandPriority::setting, unkeyed, record("b"));
+    queue->post(CommandPriority::preset, unkeyed, record("preset"));
+    queue->start();
+    sync();
+
+    EXPECT_THAT(executed, ElementsAre("preset", "a", "b"));
+}
+
+TEST_F(CommandQueueTest, newerWriteSupersedesPendingOne)
+{
+    queue->post(CommandPriority::setting, ampKey, record("amp 1"));
+    queue->post(CommandPriority::setting, effectKey(1), record("effect"));
+    queue->post(CommandPriority::setting, ampKey, record("amp 2"));
+    queue->start();
+    sync();
+
+    EXPECT_THAT(executed, ElementsAre("amp 2", "effect"));
+    EXPECT_THAT(queue->superseded(), Eq(1));
+}
+
+TEST_F(CommandQueueTest, presetDropsKeyedSettingsQueuedBeforeIt)
+{
+    queue->post(CommandPriority::setting, ampKey, record("amp 1"));
+    queue->post(CommandPriority::setting, unkeyed, record("unkeyed"));
+    queue->post(CommandPriority::preset, unkeyed, record("preset"));
+    queue->post(CommandPriority::setting, ampKey, record("amp 2"));
+    queue->start();
+    sync();
+
+    EXPECT_THAT(executed, ElementsAre("preset", "unkeyed", "amp 2"));
+    EXPECT_THAT(queue->superseded(), Eq(1));
+}
+
+TEST_F(CommandQueueTest, newerPresetSupersedesPendingOne)
+{
+    queue->post(CommandPriority::preset, presetKey, record("preset 1"));
+    queue->post(CommandPriority::preset, unkeyed, record("unkeyed"));
+    queue->post(CommandPriority::preset, presetKey, record("preset 2"));
+    queue->start();
+    sync();
+
+    EXPECT_THAT(executed, ElementsAre("preset 2", "unkeyed"));
+    EXPECT_THAT(queue->superseded(), Eq(1));
+}
+
+TEST_F(CommandQueueTest, commandsRunWithTheMustang)
+{
+    Mustang* used{nullptr};
+    queue->start();
+    queue->post(CommandPriority::setting, unkeyed, [&used](Mustang& m) { used = &m; });
+    sync();
+
+    EXPECT_THAT(used, Eq(mustang.get()));
+}
+
+TEST_F(CommandQueueTest, submitReturnsResult)
+{
+    queue->start();
+    auto result = queue->submit(CommandPriority::preset, [](Mustang&) { return 17; });
+
+    EXPECT_THAT(result.get(), Eq(17));
+}
+
+TEST_F(CommandQueueTest, submitPassesException)
+{
+    queue->start();
+    auto result = queue->submit(CommandPriority::preset, [](Mustang&) -> int { throw std::runtime_error{"failed"}; });
+
+    EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST_F(CommandQueueTest, errorOfPostedCommandIsReported)
+{
+    std::string error;
+    queue->setErrorHandler([&error](const std::exception& ex) { error = ex.what(); });
+    queue->start();
+    queue->post(CommandPriority::setting, unkeyed, [](Mustang&) { throw std::runtime_error{"failed"}; });
+    queue->post(CommandPriority::setting, unkeyed, record("next"));
+    sync();
+
+    EXPECT_THAT(error, StrEq("failed"));
+    EXPECT_THAT(executed, ElementsAre("next"));
+}
+
+TEST_F(CommandQueueTest, multipleProducers)
+{
+    constexpr std::size_t producers{4};
+    constexpr std::size_t count{1000};
+    std::array<std::size_t, producers> received{{}};
+    std::array<bool, producers> ordered{{true, true, true, true}};
+    std::vector<std::thread> threads;
+
+    queue->start();
+
+    for (std::size_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([this, p, &received, &ordered] {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                queue->post(CommandPriority::setting, unkeyed, [p, i, &received, &ordered](Mustang&) {
+                    ordered[p] = ordered[p] && (received[p] == i);
+                    ++received[p];
+                });
+            }
+        });
+    }
+    std::for_each(threads.begin(), threads.end(), [](auto& t) { t.join(); });
+    sync();
+
+    EXPECT_THAT(received, Each(Eq(count)));
+    EXPECT_THAT(ordered, Each(IsTrue()));
+}
+
+TEST_F(CommandQueueTest, pendingCommandsAreDiscardedOnDestruction)
+{
+    auto result = queue->submit(CommandPriority::preset, [](Mustang&) { return 1; });
+    queue.reset();
+
+    EXPECT_THROW(result.get(), std::future_error);
+}
@@ -0,0 +1,136 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/ControlState.h"
+#include "matcher/TypeMatcher.h"
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace test::matcher;
+using namespace testing;
+
+
+class ControlStateTest : public testing::Test
+{
+protected:
+    static ControlEvent ampEvent(AmpParameter parameter, std::uint8_t value)
+    {
+        return ControlEvent{ControlTarget::amp, 0, static_cast<std::uint8_t>(parameter), value};
+    }
+
+    static ControlEvent effectEvent(std::uint8_t slot, EffectParameter parameter, std::uint8_t value)
+    {
+        return ControlEvent{ControlTarget::effect, slot, static_cast<std::uint8_t>(parameter), value};
+    }
+
+    const amp_settings amp{amps::BRITISH_80S, 10, 20, 30, 40, 50, cabinets::cab4x12M, 1, 2, 3, 4, 5, 6, 7, 1, false, 9};
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::OVERDRIVE, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {1, effects::SINE_CHORUS, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {2, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {3, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 6, Position::effectsLoop}}};
+    const SignalChain chain{"abc", amp, effects};
+};
+
+TEST_F(ControlStateTest, initialStateHasNoChanges)
+{
+    ControlState state{chain};
+    EXPECT_FALSE(state.hasChanges());
+    EXPECT_THAT(state.amp(), AmpIs(amp));
+    EXPECT_THAT(state.effect(3), EffectIs(effects[3]));
+}
+
+TEST_F(ControlStateTest, effectsAreOrderedBySlot)
+{
+    const std::array<fx_pedal_settings, 4> unordered{{effects[3], effects[1], effects[0], effects[2]}};
+    ControlState state{SignalChain{"", amp, unordered}};
+
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        EXPECT_THAT(state.effect(i), EffectIs(effects[i]));
+    }
+}
+
+TEST_F(ControlStateTest, ampEventChangesAmp)
+{
+    ControlState state{chain};
+    state.apply(ampEvent(AmpParameter::gain, 200));
+
+    EXPECT_TRUE(state.ampChanged());
+    EXPECT_THAT(state.amp().gain, Eq(200));
+}
+
+TEST_F(ControlStateTest, continuousEventsAreCoalesced)
+{
+    ControlState state{chain};
+    state.apply(ampEvent(AmpParameter::gain, 120));
+    state.apply(ampEvent(AmpParameter::gain, 150));
+    state.apply(ampEvent(AmpParameter::gain, 180));
+    state.apply(ampEvent(AmpParameter::bass, 99));
+
+    EXPECT_TRUE(state.ampChanged());
+    EXPECT_THAT(state.amp().gain, Eq(180));
+    EXPECT_THAT(state.amp().bass, Eq(99));
+    EXPECT_FALSE(state.effectChanged(0));
+}
+
+TEST_F(ControlStateTest, effectEventChangesOnlyItsSlot)
+{
+    ControlState state{chain};
+    state.apply(effectEvent(1, EffectParameter::knob3, 77));
+
+    EXPECT_FALSE(state.ampChanged());
+    EXPECT_FALSE(state.effectChanged(0));
+    EXPECT_TRUE(state.effectChanged(1));
+    EXPECT_THAT(state.effect(1).knob3, Eq(77));
+}
+
+TEST_F(ControlStateTest, modelChangeKeepsReplacedEffect)
+{
+    ControlState state{chain};
+    state.apply(effectEvent(1, EffectParameter::model, static_cast<std::uint8_t>(effects::MONO_DELAY)));
+    state.apply(effectEvent(1, EffectParameter::model, static_cast<std::uint8_t>(effects::TAPE_DELAY)));
+
+    ASSERT_TRUE(state.replacedEffect(1).has_value());
+    EXPECT_THAT(state.replacedEffect(1)->effect_num, Eq(effects::SINE_CHORUS));
+    EXPECT_THAT(state.effect(1).effect_num, Eq(effects::TAPE_DELAY));
+}
+
+TEST_F(ControlStateTest, clearChangesResetsFlags)
+{
+    ControlState state{chain};
+    state.apply(ampEvent(AmpParameter::gain, 1));
+    state.apply(effectEvent(2, EffectParameter::enabled, 0));
+    state.clearChanges();
+
+    EXPECT_FALSE(state.hasChanges());
+    EXPECT_THAT(state.amp().gain, Eq(1));
+    EXPECT_FALSE(state.effect(2).enabled);
+}
+
+TEST_F(ControlStateTest, resetReplacesState)
+{
+    ControlState state{SignalChain{}};
+    state.apply(ampEvent(AmpParameter::gain, 1));
+    state.reset(chain);
+
+    EXPECT_FALSE(state.hasChanges());
+    EXPECT_THAT(state.amp(), AmpIs(amp));
+}
@@ -0,0 +1,218 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/ControlWriter.h"
+#include "com/Mustang.h"
+#include "com/PacketSerializer.h"
+#include "mocks/MockConnection.h"
+#include <algorithm>
+#include <mutex>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace testing;
+
+
+class ControlWriterTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        conn = std::make_shared<NiceMock<mock::MockConnection>>();
+        mustang = std::make_unique<Mustang>(conn);
+        queue = std::make_unique<CommandQueue>(*mustang);
+
+        ON_CALL(*conn, sendImpl(_, _)).WillByDefault(Invoke(this, &ControlWriterTest::record));
+    }
+
+    void TearDown() override
+    {
+        queue->stop();
+    }
+
+    std::size_t record(std::uint8_t* data, std::size_t size)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        PacketRawType packet{};
+        std::copy_n(data, std::min(size, packet.size()), packet.begin());
+        sent.push_back(packet);
+        return size;
+    }
+
+    // Runs everything posted so far
+    void sync()
+    {
+        if (queue->isRunning() == false)
+        {
+            queue->start();
+        }
+        queue->submit(CommandPriority::setting, [](Mustang&) {}).get();
+    }
+
+    std::optional<std::size_t> sentIndex(const PacketRawType& expected)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        const auto itr = std::find(sent.cbegin(), sent.cend(), expected);
+        return (itr != sent.cend() ? std::optional{static_cast<std::size_t>(std::distance(sent.cbegin(), itr))} : std::nullopt);
+    }
+
+    bool wasSent(const PacketRawType& expected)
+    {
+        return sentIndex(expected).has_value();
+    }
+
+    static ControlEvent ampChange(AmpParameter parameter, std::uint8_t value)
+    {
+        return {ControlTarget::amp, 0, static_cast<std::uint8_t>(parameter), value};
+    }
+
+    static ControlEvent effectModel(std::uint8_t slot, effects effect)
+    {
+        return {ControlTarget::effect, slot, static_cast<std::uint8_t>(EffectParameter::model), static_cast<std::uint8_t>(effect)};
+    }
+
+    const amp_settings amp{amps::BRITISH_80S, 120, 100, 80, 70, 60, cabinets::cab4x12M, 1, 2, 3, 4, 5, 6, 7, 8, false, 9};
+    const SignalChain chain{"current", amp, {{{0, effects::OVERDRIVE, 10, 20, 30, 40, 50, 0, Position::input, true},
+                                             {1, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                             {2, effects::MONO_DELAY, 1, 2, 3, 4, 5, 0, Position::effectsLoop, true},
+                                             {3, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input}}}};
+    std::shared_ptr<NiceMock<mock::MockConnection>> conn;
+    std::unique_ptr<Mustang> mustang;
+    std::unique_ptr<CommandQueue> queue;
+    std::mutex mutex;
+    std::vector<PacketRawType> sent;
+};
+
+TEST_F(ControlWriterTest, changedBlocksAreWritten)
+{
+    ControlWriter writer{*queue, chain};
+    auto expected = amp;
+    expected.gain = 200;
+
+    writer.write([](ControlState& state, bool) { state.apply(ampChange(AmpParameter::gain, 200)); });
+    sync();
+
+    EXPECT_THAT(wasSent(serializeAmpSettings(expected).getBytes()), IsTrue());
+    EXPECT_THAT(wasSent(serializeEffectSettings(chain.effects()[0]).getBytes()), IsFalse());
+    EXPECT_THAT(wasSent(serializeEffectSettings(chain.effects()[2]).getBytes()), IsFalse());
+}
+
+TEST_F(ControlWriterTest, pendingWriteCarriesLatestValues)
+{
+    ControlWriter writer{*queue, chain};
+    auto first = amp;
+    first.gain = 150;
+    auto latest = amp;
+    latest.gain = 200;
+
+    writer.write([](ControlState& state, bool) { state.apply(ampChange(AmpParameter::gain, 150)); });
+    writer.write([](ControlState& state, bool) { state.apply(ampChange(AmpParameter::gain, 200)); });
+    sync();
+
+    EXPECT_THAT(wasSent(serializeAmpSettings(first).getBytes()), IsFalse());
+    EXPECT_THAT(wasSent(serializeAmpSettings(latest).getBytes()), IsTrue());
+    EXPECT_THAT(queue->superseded(), Eq(1));
+}
+
+TEST_F(ControlWriterTest, replacedEffectOfOtherFamilyIsClearedFirst)
+{
+    ControlWriter writer{*queue, chain};
+    auto cleared = chain.effects()[0];
+    cleared.enabled = false;
+    auto chorus = chain.effects()[0];
+    chorus.effect_num = effects::SINE_CHORUS;
+
+    writer.write([](ControlState& state, bool) { state.apply(effectModel(0, effects::SINE_CHORUS)); });
+    sync();
+
+    const auto clearIndex = sentIndex(serializeClearEffectSettings(cleared).getBytes());
+    const auto writeIndex = sentIndex(serializeEffectSettings(chorus).getBytes());
+    ASSERT_THAT(clearIndex.has_value(), IsTrue());
+    ASSERT_THAT(writeIndex.has_value(), IsTrue());
+    EXPECT_THAT(*clearIndex, Lt(*writeIndex));
+}
+
+TEST_F(ControlWriterTest, replacedEffectIsClearedOnceWhenReplacedAgain)
+{
+    ControlWriter writer{*queue, chain};
+    auto cleared = chain.effects()[0];
+    cleared.enabled = false;
+
+    writer.write([](ControlState& state, bool) { state.apply(effectModel(0, effects::SINE_CHORUS)); });
+    writer.write([](ControlState& state, bool) { state.apply(effectModel(0, effects::SMALL_HALL_REVERB)); });
+    sync();
+
+    std::lock_guard<std::mutex> lock{mutex};
+    EXPECT_THAT(std::count(sent.cbegin(), sent.cend(), serializeClearEffectSettings(cleared).getBytes()), Eq(1));
+}
+
+TEST_F(ControlWriterTest, updateKeepsExternalChanges)
+{
+    ControlWriter writer{*queue, chain};
+    auto external = amp;
+    external.treble = 33;
+    auto expected = external;
+    expected.gain = 200;
+    std::vector<bool> updated;
+
+    writer.update(SignalChain{"external", external, chain.effects()});
+    writer.write([&updated](ControlState& state, bool u) { updated.push_back(u); state.apply(ampChange(AmpParameter::gain, 200)); });
+    writer.write([&updated](ControlState&, bool u) { updated.push_back(u); });
+    sync();
+
+    EXPECT_THAT(wasSent(serializeAmpSettings(expected).getBytes()), IsTrue());
+    EXPECT_THAT(updated, ElementsAre(true, false));
+}
+
+TEST_F(ControlWriterTest, updateDropsPendingClears)
+{
+    ControlWriter writer{*queue, chain};
+    auto cleared = chain.effects()[0];
+    cleared.enabled = false;
+    auto chorus = chain.effects()[0];
+    chorus.effect_num = effects::SINE_CHORUS;
+
+    writer.write([](ControlState& state, bool) { state.apply(effectModel(0, effects::SINE_CHORUS)); });
+    writer.update(SignalChain{"external", amp, {{chorus, chain.effects()[1], chain.effects()[2], chain.effects()[3]}}});
+    sync();
+
+    EXPECT_THAT(wasSent(serializeClearEffectSettings(cleared).getBytes()), IsFalse());
+    EXPECT_THAT(wasSent(serializeEffectSettings(chorus).getBytes()), IsTrue());
+}
+
+TEST_F(ControlWriterTest, deliveryIsReportedPerKey)
+{
+    std::mutex keysMutex;
+    std::vector<CommandKey> keys;
+    ControlWriter writer{*queue, chain, [&](CommandKey key) {
+                             std::lock_guard<std::mutex> lock{keysMutex};
+                             keys.push_back(key);
+                         }};
+
+    writer.write([](ControlState& state, bool) {
+        state.apply(ampChange(AmpParameter::gain, 200));
+        state.apply(effectModel(2, effects::TAPE_DELAY));
+    });
+    sync();
+
+    std::lock_guard<std::mutex> lock{keysMutex};
+    EXPECT_THAT(keys, ElementsAre(ampKey, effectKey(2)));
+}
@@ -0,0 +1,221 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/Converter.h"
+#include "preset/FuseCodec.h"
+#include "preset/JsonCodec.h"
+#include "preset/PresetBank.h"
+#include "matcher/TypeMatcher.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace test::matcher;
+using namespace testing;
+
+namespace fs = std::filesystem;
+
+
+class ConverterTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        dir = fs::temp_directory_path() / ("plug-converter-test-" + std::string{testing::UnitTest::GetInstance()->current_test_info()->name()});
+        fs::remove_all(dir);
+        fs::create_directories(dir / "in" / "sub");
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(dir);
+    }
+
+    SignalChain chain(const std::string& name, std::uint8_t gain) const
+    {
+        const amp_settings amp{amps::BRITISH_80S, gain, 2, 3, 4, 5, cabinets::cab4x12M, 0, 9, 10, 11, 0, 0x80, 13, 1, false, 0xab};
+        return SignalChain{name, amp, effects};
+    }
+
+    void writeText(const fs::path& path, const std::string& content) const
+    {
+        std::ofstream{path, std::ios::binary} << content;
+    }
+
+    std::vector<std::string> readLines(const fs::path& path) const
+    {
+        std::ifstream in{path};
+        std::vector<std::string> lines;
+
+        for (std::string line; std::getline(in, line);)
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    fs::path dir;
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::OVERDRIVE, 1, 2, 3, 4, 5, 0, Position::input},
+                                                    {1, effects::SINE_CHORUS, 1, 2, 3, 4, 5, 0, Position::input},
+                                                    {2, effects::TAPE_DELAY, 1, 2, 3, 4, 5, 6, Position::effectsLoop},
+                                                    {3, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 0, Position::effectsLoop}}};
+};
+
+TEST_F(ConverterTest, formatNames)
+{
+    EXPECT_THAT(formatFromName("fuse"), Optional(Format::fuse));
+    EXPECT_THAT(formatFromName("bank"), Optional(Format::bank));
+    EXPECT_THAT(formatFromName("jsonl"), Optional(Format::jsonl));
+    EXPECT_THAT(formatFromName("xml"), Eq(std::nullopt));
+    EXPECT_THAT(formatOfPath("a/b.FUSE"), Optional(Format::fuse));
+    EXPECT_THAT(formatOfPath("a/b.txt"), Eq(std::nullopt));
+    EXPECT_THAT(formatOfPath("a/bank"), Eq(std::nullopt));
+}
+
+TEST_F(ConverterTest, fuseTreeToBankKeepsInputOrder)
+{
+    for (std::uint8_t i = 0; i < 20; ++i)
+    {
+        const auto sub = (i % 2 == 0 ? dir / "in" : dir / "in" / "sub");
+        saveFuseFile((sub / ("p" + std::to_string(100 + i) + ".fuse")).string(), chain("preset " + std::to_string(i), i));
+    }
+    writeText(dir / "in" / "readme.txt", "ignored");
+
+    const auto report = convertPresets((dir / "in").string(), (dir / "out.bank").string(), Format::bank, 4);
+
+    EXPECT_THAT(report.files, Eq(20));
+    EXPECT_THAT(report.presets, Eq(20));
+    EXPECT_THAT(report.failed, Eq(0));
+    EXPECT_THAT(report.bytesRead, Gt(0));
+    EXPECT_THAT(report.bytesWritten, Eq(20 * sizeof(BankRecord)));
+
+    const PresetBank bank{(dir / "out.bank").string()};
+    ASSERT_THAT(bank.size(), Eq(20));
+    EXPECT_THAT(bank[0].getName(), Eq("preset 0"));
+    EXPECT_THAT(bank[10].getName(), Eq("preset 1"));
+    EXPECT_THAT(decodeRecord(bank[10]).amp(), AmpIs(chain("", 1).amp()));
+}
+
+TEST_F(ConverterTest, bankToJsonAndBackToFuse)
+{
+    {
+        PresetBankWriter writer{(dir / "in" / "amp.bank").string()};
+
+        for (std::uint8_t i = 0; i < 3; ++i)
+        {
+            writer.append(makeBankRecord(chain("preset/" + std::to_string(i), i)));
+        }
+    }
+
+    const auto toJson = convertPresets((dir / "in" / "amp.bank").string(), (dir / "out.jsonl").string(), Format::jsonl);
+    const auto lines = readLines(dir / "out.jsonl");
+
+    EXPECT_THAT(toJson.presets, Eq(3));
+    ASSERT_THAT(lines.size(), Eq(3));
+    EXPECT_THAT(parseJson(lines[2]).name(), StrEq("preset/2"));
+
+    const auto toFuse = convertPresets((dir / "out.jsonl").string(), (dir / "fuse").string(), Format::fuse);
+    const auto path = dir / "fuse" / "out" / "0002 preset_2.fuse";
+
+    EXPECT_THAT(toFuse.presets, Eq(3));
+    ASSERT_THAT(fs::exists(path), IsTrue());
+
+    const auto loaded = loadFuseFile(path.string());
+    EXPECT_THAT(loaded.name(), StrEq("preset/2"));
+    EXPECT_THAT(loaded.amp(), AmpIs(chain("", 2).amp()));
+}
+
+TEST_F(ConverterTest, fuseTreeToFuseMirrorsTree)
+{
+    saveFuseFile((dir / "in" / "sub" / "a.fuse").string(), chain("a", 1));
+
+    const auto report = convertPresets((dir / "in").string(), (dir / "out").string(), Format::fuse);
+
+    EXPECT_THAT(report.presets, Eq(1));
+    EXPECT_THAT(loadFuseFile((dir / "out" / "sub" / "a.fuse").string()).name(), StrEq("a"));
+}
+
+TEST_F(ConverterTest, failuresAreReportedAndSkipped)
+{
+    saveFuseFile((dir / "in" / "good.fuse").string(), chain("good", 1));
+    writeText(dir / "in" / "broken.fuse", "<Preset>");
+    writeText(dir / "in" / "lines.jsonl", writeJson(chain("json", 2)) + "\n\nnot json\n");
+    writeText(dir / "in" / "broken.bank", "XXXX");
+
+    const auto report = convertPresets((dir / "in").string(), (dir / "out.jsonl").string(), Format::jsonl);
+
+    EXPECT_THAT(report.files, Eq(4));
+    EXPECT_THAT(report.presets, Eq(2));
+    EXPECT_THAT(report.failed, Eq(3));
+    EXPECT_THAT(report.errors, Contains(HasSubstr("lines.jsonl: line 3")));
+    EXPECT_THAT(readLines(dir / "out.jsonl").size(), Eq(2));
+}
+
+TEST_F(ConverterTest, throwsOnMissingInput)
+{
+    EXPECT_THROW(convertPresets((dir / "missing").string(), (dir / "out.bank").string(), Format::bank), std::runtime_error);
+}
+
+TEST_F(ConverterTest, throwsIfOutputIsInput)
+{
+    saveFuseFile((dir / "in" / "a.fuse").string(), chain("a", 1));
+    convertPresets((dir / "in").string(), (dir / "same.jsonl").string(), Format::jsonl);
+    const auto before = readLines(dir / "same.jsonl");
+
+    EXPECT_THROW(convertPresets((dir / "same.jsonl").string(), (dir / "same.jsonl").string(), Format::jsonl), std::runtime_error);
+    EXPECT_THROW(convertPresets((dir / "same.jsonl").string(), (dir / "." / "same.jsonl").string(), Format::jsonl), std::runtime_error);
+    EXPECT_THAT(readLines(dir / "same.jsonl"), Eq(before));
+}
+
+TEST_F(ConverterTest, throwsIfOutputIsInsideInput)
+{
+    saveFuseFile((dir / "in" / "a.fuse").string(), chain("a", 1));
+
+    EXPECT_THROW(convertPresets((dir / "in").string(), (dir / "in" / "out.bank").string(), Format::bank), std::runtime_error);
+    EXPECT_THROW(convertPresets((dir / "in").string(), (dir / "in").string(), Format::fuse), std::runtime_error);
+    EXPECT_THAT(fs::exists(dir / "in" / "out.bank"), IsFalse());
+    EXPECT_NO_THROW(convertPresets((dir / "in").string(), (dir / "in-out").string(), Format::fuse));
+}
+
+TEST_F(ConverterTest, readPresetsKeepsInputOrder)
+{
+    saveFuseFile((dir / "in" / "b.fuse").string(), chain("b", 2));
+    saveFuseFile((dir / "in" / "sub" / "a.fuse").string(), chain("a", 1));
+    writeText(dir / "in" / "broken.fuse", "<Preset>");
+    {
+        PresetBankWriter writer{(dir / "in" / "amp.bank").string()};
+        writer.append(makeBankRecord(chain("bank", 3)));
+    }
+
+    ConversionReport report{0, 0, 0, 0, 0, {}, {}};
+    const auto presets = readPresets((dir / "in").string(), report, 2);
+
+    EXPECT_THAT(report.files, Eq(4));
+    EXPECT_THAT(report.presets, Eq(3));
+    EXPECT_THAT(report.failed, Eq(1));
+    ASSERT_THAT(presets.size(), Eq(3));
+    EXPECT_THAT(presets[0].source, StrEq("amp/0000 bank.fuse"));
+    EXPECT_THAT(presets[1].source, StrEq("b.fuse"));
+    EXPECT_THAT(presets[2].source, StrEq("sub/a.fuse"));
+    EXPECT_THAT(presets[2].chain.amp(), AmpIs(chain("", 1).amp()));
+}
@@ -0,0 +1,139 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/Duplicates.h"
+#include <random>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace testing;
+
+
+class DuplicatesTest : public testing::Test
+{
+protected:
+    static SignalChain chain(const std::string& name, std::uint8_t gain, std::uint8_t knob = 5, amps model = amps::BRITISH_80S)
+    {
+        const amp_settings amp{model, gain, 2, 3, 4, 5, cabinets::cab4x12M, 0, 9, 10, 11, 0, 0x80, 13, 1, false, 0};
+        const std::array<fx_pedal_settings, 4> effects{{{0, effects::OVERDRIVE, 1, 2, 3, 4, knob, 0, Position::input},
+                                                        {1, effects::SINE_CHORUS, 1, 2, 3, 4, 5, 0, Position::input},
+                                                        {2, effects::TAPE_DELAY, 1, 2, 3, 4, 5, 6, Position::effectsLoop},
+                                                        {3, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input}}};
+        return SignalChain{name, amp, effects};
+    }
+
+    static std::vector<std::vector<std::size_t>> members(const std::vector<DuplicateCluster>& clusters)
+    {
+        std::vector<std::vector<std::size_t>> result;
+        std::transform(clusters.cbegin(), clusters.cend(), std::back_inserter(result), [](const auto& c) { return c.members; });
+        return result;
+    }
+};
+
+TEST_F(DuplicatesTest, exactDuplicatesIgnoreNames)
+{
+    const std::vector<PackedSignalChain> presets{pack(chain("a", 10)), pack(chain("b", 20)),
+                                                 pack(chain("c", 10)), pack(chain("d", 11)),
+                                                 pack(chain("e", 10))};
+    const auto clusters = findDuplicates(presets);
+
+    ASSERT_THAT(clusters.size(), Eq(1));
+    EXPECT_THAT(clusters[0].members, ElementsAre(0, 2, 4));
+    EXPECT_THAT(clusters[0].exact, IsTrue());
+    EXPECT_THAT(clusters[0].maxDistance, Eq(0));
+}
+
+TEST_F(DuplicatesTest, nearDuplicatesWithinDistance)
+{
+    const std::vector<PackedSignalChain> presets{pack(chain("a", 100)), pack(chain("b", 103, 7)),
+                                                 pack(chain("c", 120)), pack(chain("d", 100)),
+                                                 pack(chain("e", 104, 4))};
+    const auto clusters = findDuplicates(presets, 5);
+
+    ASSERT_THAT(clusters.size(), Eq(1));
+    EXPECT_THAT(clusters[0].members, ElementsAre(0, 1, 3, 4));
+    EXPECT_THAT(clusters[0].exact, IsFalse());
+    EXPECT_THAT(clusters[0].maxDistance, Eq(5));
+}
+
+TEST_F(DuplicatesTest, membersAreCloseToTheFirstPreset)
+{
+    const std::vector<PackedSignalChain> presets{pack(chain("a", 100)), pack(chain("b", 104)), pack(chain("c", 108))};
+
+    EXPECT_THAT(members(findDuplicates(presets, 4)), ElementsAre(ElementsAre(0, 1)));
+}
+
+TEST_F(DuplicatesTest, differentModelsAreNoDuplicates)
+{
+    const std::vector<PackedSignalChain> presets{pack(chain("a", 100, 5, amps::BRITISH_80S)),
+                                                 pack(chain("b", 100, 5, amps::BRITISH_70S))};
+
+    EXPECT_THAT(findDuplicates(presets, 10), IsEmpty());
+}
+
+TEST_F(DuplicatesTest, findsPlantedDuplicatesInLargeLibrary)
+{
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<int> byte{0, 255};
+    std::uniform_int_distribution<int> offset{-3, 3};
+    std::vector<PackedSignalChain> presets;
+
+    auto next = [&rng, &byte] { return static_cast<std::uint8_t>(byte(rng)); };
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        auto preset = pack(chain("p", next(), next(), static_cast<amps>(next() % 12)));
+        preset.amp.volume = next();
+        preset.amp.treble = next();
+        preset.effects[1].knob1 = next();
+        preset.effects[2].knob2 = next();
+        presets.push_back(preset);
+    }
+
+    // Every 100th preset gets a copy with both controls moved a bit
+    std::size_t planted{0};
+
+    for (std::size_t i = 0; i < 20000; i += 100, ++planted)
+    {
+        auto copy = presets[i];
+        copy.amp.gain = static_cast<std::uint8_t>(std::clamp(copy.amp.gain + offset(rng), 0, 255));
+        copy.effects[0].knob5 = static_cast<std::uint8_t>(std::clamp(copy.effects[0].knob5 + offset(rng), 0, 255));
+        presets.push_back(copy);
+    }
+
+    const auto clusters = findDuplicates(presets, 6);
+    std::size_t found{0};
+
+    for (const auto& cluster : clusters)
+    {
+        EXPECT_THAT(cluster.maxDistance, Le(6));
+        found += static_cast<std::size_t>(std::count_if(cluster.members.cbegin(), cluster.members.cend(), [](auto i) { return i >= 20000; }));
+    }
+    EXPECT_THAT(found, Eq(planted));
+}
+
+TEST_F(DuplicatesTest, uniquePresetsKeepFirstMembers)
+{
+    const std::vector<DuplicateCluster> clusters{{{1, 3, 4}, true, 0}, {{2, 5}, false, 3}};
+
+    EXPECT_THAT(uniquePresets(7, clusters), ElementsAre(0, 1, 2, 6));
+    EXPECT_THAT(uniquePresets(2, {}), ElementsAre(0, 1));
+}
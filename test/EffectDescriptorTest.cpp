@@ -0,0 +1,180 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EffectDescriptor.h"
+#include <algorithm>
+#include <array>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace testing;
+
+namespace
+{
+    struct DialogDefaults
+    {
+        effects effect;
+        std::size_t knobs;
+        std::array<std::uint8_t, 6> values;
+    };
+
+    // Enabled knobs and default values of the effect dialogs before they
+    // were driven by the descriptors; the dials clamped values above their
+    // maximum
+    constexpr std::array<DialogDefaults, 37> dialogDefaults{{
+            {effects::OVERDRIVE, 5, {{0x80, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::WAH, 5, {{0xff, 0x80, 0x00, 0xff, 0x00, 0x00}}},
+            {effects::TOUCH_WAH, 5, {{0xff, 0x80, 0x00, 0xff, 0x00, 0x00}}},
+            {effects::FUZZ, 5, {{0x80, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::FUZZ_TOUCH_WAH, 5, {{0x80, 0x80, 0x80, 0x80, 0x80, 0x80}}},
+            {effects::SIMPLE_COMP, 1, {{0x01, 0x00, 0x00, 0x00, 0x00, 0x00}}},
+            {effects::COMPRESSOR, 5, {{0x8d, 0x0f, 0x4f, 0x7f, 0x7f, 0x00}}},
+            {effects::SINE_CHORUS, 5, {{0xff, 0x0e, 0x19, 0x19, 0x80, 0x00}}},
+            {effects::TRIANGLE_CHORUS, 5, {{0x5d, 0x0e, 0x19, 0x19, 0x80, 0x00}}},
+            {effects::SINE_FLANGER, 5, {{0xff, 0x0e, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::TRIANGLE_FLANGER, 5, {{0xff, 0x00, 0xff, 0x33, 0x41, 0x00}}},
+            {effects::VIBRATONE, 5, {{0xf4, 0xff, 0x27, 0xad, 0x82, 0x00}}},
+            {effects::VINTAGE_TREMOLO, 5, {{0xdb, 0xad, 0x63, 0xf4, 0xf1, 0x00}}},
+            {effects::SINE_TREMOLO, 5, {{0xdb, 0x99, 0x7d, 0x00, 0x00, 0x00}}},
+            {effects::RING_MODULATOR, 5, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::STEP_FILTER, 5, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::PHASER, 5, {{0xfd, 0x00, 0xfd, 0xb8, 0x00, 0x00}}},
+            {effects::PITCH_SHIFTER, 5, {{0xc7, 0x3e, 0x80, 0x00, 0x00, 0x00}}},
+            {effects::MONO_ECHO_FILTER, 6, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x80}}},
+            {effects::STEREO_ECHO_FILTER, 6, {{0x80, 0xb3, 0x80, 0x80, 0x80, 0x80}}},
+            {effects::MONO_DELAY, 5, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::MULTITAP_DELAY, 5, {{0xff, 0x80, 0x66, 0x80, 0x80, 0x00}}},
+            {effects::REVERSE_DELAY, 5, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::PING_PONG_DELAY, 5, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::TAPE_DELAY, 6, {{0x7d, 0x1c, 0x00, 0x63, 0x80, 0x00}}},
+            {effects::STEREO_TAPE_DELAY, 6, {{0x7d, 0x88, 0x1c, 0x63, 0xff, 0x80}}},
+            {effects::DUCKING_DELAY, 5, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::SMALL_HALL_REVERB, 5, {{0x6e, 0x5d, 0x6e, 0x80, 0x91, 0x00}}},
+            {effects::LARGE_HALL_REVERB, 5, {{0x4f, 0x3e, 0x80, 0x05, 0xb0, 0x00}}},
+            {effects::SMALL_ROOM_REVERB, 5, {{0x80, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::LARGE_ROOM_REVERB, 5, {{0x80, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::SMALL_PLATE_REVERB, 5, {{0x80, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::LARGE_PLATE_REVERB, 5, {{0x38, 0x80, 0x91, 0x80, 0xb6, 0x00}}},
+            {effects::AMBIENT_REVERB, 5, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::ARENA_REVERB, 5, {{0xff, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::FENDER_63_SPRING_REVERB, 5, {{0x80, 0x80, 0x80, 0x80, 0x80, 0x00}}},
+            {effects::FENDER_65_SPRING_REVERB, 5, {{0x80, 0x8b, 0x49, 0xff, 0x80, 0x00}}},
+    }};
+}
+
+
+TEST(EffectDescriptorTest, describeReturnsEntryOfEffect)
+{
+    EXPECT_THAT(describe(effects::EMPTY).id, Eq(effects::EMPTY));
+    EXPECT_THAT(describe(effects::TAPE_DELAY).id, Eq(effects::TAPE_DELAY));
+    EXPECT_THAT(describe(effects::FENDER_65_SPRING_REVERB).name, StrEq("Fender '65 Spring Reverb"));
+}
+
+TEST(EffectDescriptorTest, knobCount)
+{
+    EXPECT_THAT(describe(effects::EMPTY).knobCount(), Eq(0));
+    EXPECT_THAT(describe(effects::SIMPLE_COMP).knobCount(), Eq(1));
+    EXPECT_THAT(describe(effects::OVERDRIVE).knobCount(), Eq(5));
+    EXPECT_THAT(describe(effects::MONO_ECHO_FILTER).knobCount(), Eq(6));
+    EXPECT_THAT(describe(effects::STEREO_ECHO_FILTER).knobCount(), Eq(6));
+    EXPECT_THAT(describe(effects::TAPE_DELAY).knobCount(), Eq(6));
+    EXPECT_THAT(describe(effects::STEREO_TAPE_DELAY).knobCount(), Eq(6));
+}
+
+TEST(EffectDescriptorTest, usedKnobsHaveTexts)
+{
+    for (const auto& descriptor : effectDescriptors)
+    {
+        for (std::size_t i = 0; i < descriptor.knobCount(); ++i)
+        {
+            EXPECT_THAT(descriptor.knobs[i].label, NotNull()) << descriptor.name;
+            EXPECT_THAT(descriptor.knobs[i].parameter, NotNull()) << descriptor.name;
+        }
+        for (std::size_t i = descriptor.knobCount(); i < descriptor.knobs.size(); ++i)
+        {
+            EXPECT_THAT(descriptor.knobs[i].isUsed(), IsFalse()) << descriptor.name;
+        }
+    }
+}
+
+TEST(EffectDescriptorTest, familyFollowsEffectRanges)
+{
+    EXPECT_THAT(describe(effects::EMPTY).family, Eq(EffectFamily::none));
+    EXPECT_THAT(describe(effects::OVERDRIVE).family, Eq(EffectFamily::stompbox));
+    EXPECT_THAT(describe(effects::COMPRESSOR).family, Eq(EffectFamily::stompbox));
+    EXPECT_THAT(describe(effects::SINE_CHORUS).family, Eq(EffectFamily::modulation));
+    EXPECT_THAT(describe(effects::PITCH_SHIFTER).family, Eq(EffectFamily::modulation));
+    EXPECT_THAT(describe(effects::MONO_DELAY).family, Eq(EffectFamily::delay));
+    EXPECT_THAT(describe(effects::STEREO_TAPE_DELAY).family, Eq(EffectFamily::delay));
+    EXPECT_THAT(describe(effects::SMALL_HALL_REVERB).family, Eq(EffectFamily::reverb));
+    EXPECT_THAT(describe(effects::FENDER_65_SPRING_REVERB).family, Eq(EffectFamily::reverb));
+}
+
+TEST(EffectDescriptorTest, limitedKnobRanges)
+{
+    EXPECT_THAT(describe(effects::SIMPLE_COMP).knobs[0].maximum, Eq(3));
+    EXPECT_THAT(describe(effects::RING_MODULATOR).knobs[3].maximum, Eq(1));
+    EXPECT_THAT(describe(effects::PHASER).knobs[4].maximum, Eq(1));
+    EXPECT_THAT(describe(effects::MULTITAP_DELAY).knobs[4].maximum, Eq(3));
+    EXPECT_THAT(describe(effects::OVERDRIVE).knobs[0].maximum, Eq(0xff));
+}
+
+TEST(EffectDescriptorTest, defaultsWithinRange)
+{
+    for (const auto& descriptor : effectDescriptors)
+    {
+        for (const auto& knob : descriptor.knobs)
+        {
+            EXPECT_THAT(knob.defaultValue, Le(knob.maximum)) << descriptor.name;
+        }
+    }
+}
+
+TEST(EffectDescriptorTest, knobCountsMatchDialogs)
+{
+    EXPECT_THAT(describe(effects::EMPTY).knobCount(), Eq(0));
+
+    for (const auto& expected : dialogDefaults)
+    {
+        EXPECT_THAT(describe(expected.effect).knobCount(), Eq(expected.knobs)) << describe(expected.effect).name;
+    }
+}
+
+TEST(EffectDescriptorTest, defaultsMatchDialogs)
+{
+    for (const auto& expected : dialogDefaults)
+    {
+        const auto& knobs = describe(expected.effect).knobs;
+
+        for (std::size_t i = 0; i < knobs.size(); ++i)
+        {
+            EXPECT_THAT(knobs[i].defaultValue, Eq(std::min(expected.values[i], knobs[i].maximum))) << describe(expected.effect).name << ", knob " << (i + 1);
+        }
+    }
+}
+
+TEST(EffectDescriptorTest, everyEffectHasDialogDefaults)
+{
+    for (const auto& descriptor : effectDescriptors)
+    {
+        const bool listed = std::any_of(dialogDefaults.cbegin(), dialogDefaults.cend(), [&descriptor](const auto& d) { return d.effect == descriptor.id; });
+        EXPECT_THAT(listed || (descriptor.id == effects::EMPTY), IsTrue()) << descriptor.name;
+    }
+}
@@ -0,0 +1,227 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/FuseCodec.h"
+#include "matcher/TypeMatcher.h"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace test::matcher;
+using namespace testing;
+
+
+class FuseCodecTest : public testing::Test
+{
+protected:
+    static std::array<fx_pedal_settings, 4> bySlot(std::array<fx_pedal_settings, 4> effects)
+    {
+        std::sort(effects.begin(), effects.end(), [](const auto& a, const auto& b) { return a.fx_slot < b.fx_slot; });
+        return effects;
+    }
+
+    const std::string document{R"(<?xml version="1.0" encoding="UTF-8"?>
+<!-- saved by FUSE -->
+<Preset amplifier="Mustang I/II" ProductId="1">
+    <Amplifier>
+        <Module ID="94" POS="0" BypassState="1">
+            <Param ControlIndex="0">51400</Param>
+            <Param ControlIndex="1">  2570 </Param>
+            <Param ControlIndex="4">32896</Param>
+            <Param ControlIndex="15">3</Param>
+            <Param ControlIndex="17">6</Param>
+            <Param ControlIndex="19">2</Param>
+            <Param ControlIndex="20">1</Param>
+        </Module>
+    </Amplifier>
+    <FX>
+        <Stompbox ID="1">
+            <Module ID="60" POS="1" BypassState="1">
+                <Param ControlIndex="0">257</Param>
+                <Param ControlIndex="4">1285</Param>
+            </Module>
+        </Stompbox>
+        <Modulation ID="2">
+            <Module ID="18" POS="5" BypassState="1">
+                <Param ControlIndex="2">771</Param>
+            </Module>
+        </Modulation>
+        <Delay ID="3">
+            <Module ID="0" POS="2" BypassState="1"/>
+        </Delay>
+        <Reverb ID="4">
+            <Module ID="77" POS="0" BypassState="1">
+                <Param ControlIndex="5">1542</Param>
+            </Module>
+        </Reverb>
+    </FX>
+    <FUSE>
+        <Info name="Rock &amp; Roll &#x263A;" author="x" rating="0"/>
+    </FUSE>
+    <UsbGain>17</UsbGain>
+</Preset>
+)"};
+};
+
+TEST_F(FuseCodecTest, parseAmp)
+{
+    const auto amp = parseFuse(document).amp();
+
+    EXPECT_THAT(amp.amp_num, Eq(amps::BRITISH_80S));
+    EXPECT_THAT(amp.volume, Eq(200));
+    EXPECT_THAT(amp.gain, Eq(10));
+    EXPECT_THAT(amp.treble, Eq(128));
+    EXPECT_THAT(amp.noise_gate, Eq(3));
+    EXPECT_THAT(amp.cabinet, Eq(cabinets::cab4x12M));
+    EXPECT_THAT(amp.sag, Eq(2));
+    EXPECT_THAT(amp.brightness, IsTrue());
+    EXPECT_THAT(amp.usb_gain, Eq(17));
+}
+
+TEST_F(FuseCodecTest, parseEffects)
+{
+    const auto effects = parseFuse(document).effects();
+
+    EXPECT_THAT(effects[0], EffectIs(fx_pedal_settings{1, effects::OVERDRIVE, 1, 0, 0, 0, 5, 0, Position::input}));
+    EXPECT_THAT(effects[1], EffectIs(fx_pedal_settings{3, effects::SINE_CHORUS, 0, 0, 3, 0, 0, 0, Position::effectsLoop}));
+    EXPECT_THAT(effects[2], EffectIs(fx_pedal_settings{2, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input}));
+    EXPECT_THAT(effects[3], EffectIs(fx_pedal_settings{0, effects::ARENA_REVERB, 0, 0, 0, 0, 0, 6, Position::input}));
+}
+
+TEST_F(FuseCodecTest, parseNameDecodesEntities)
+{
+    EXPECT_THAT(parseFuse(document).name(), StrEq("Rock & Roll \xe2\x98\xba"));
+}
+
+TEST_F(FuseCodecTest, parseIgnoresUnknownIds)
+{
+    const auto chain = parseFuse(R"(<Preset><Amplifier><Module ID="999"/></Amplifier>
+        <FX><Stompbox><Module ID="250" POS="17"/></Stompbox></FX></Preset>)");
+
+    EXPECT_THAT(chain.amp().amp_num, Eq(amps::FENDER_57_DELUXE));
+    EXPECT_THAT(chain.effects()[0].effect_num, Eq(effects::EMPTY));
+}
+
+TEST_F(FuseCodecTest, parseThrowsWithoutAmplifier)
+{
+    EXPECT_THROW(parseFuse("<Preset><FX></FX></Preset>"), std::runtime_error);
+    EXPECT_THROW(parseFuse(""), std::runtime_error);
+}
+
+TEST_F(FuseCodecTest, parseThrowsOnMalformedData)
+{
+    EXPECT_THROW(parseFuse("<Preset><Amplifier"), std::runtime_error);
+    EXPECT_THROW(parseFuse("<Preset><!-- <Amplifier>"), std::runtime_error);
+    EXPECT_THROW(parseFuse(R"(<Preset><Amplifier><Module ID=94/></Amplifier></Preset>)"), std::runtime_error);
+}
+
+TEST_F(FuseCodecTest, writeMatchesFuseLayout)
+{
+    const amp_settings amp{amps::METAL_2000, 1, 2, 3, 4, 5, cabinets::cab4x12G, 6, 7, 8, 9, 10, 11, 12, 13, true, 14};
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::SIMPLE_COMP, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {1, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {2, effects::TAPE_DELAY, 1, 2, 3, 4, 5, 6, Position::effectsLoop},
+                                                    {3, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input}}};
+    const auto data = writeFuse(SignalChain{"a<b", amp, effects}, "me");
+
+    EXPECT_THAT(data, StartsWith("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Preset amplifier=\"Mustang I/II\" ProductId=\"1\">\n"));
+    EXPECT_THAT(data, HasSubstr("        <Module ID=\"109\" POS=\"0\" BypassState=\"1\">\n"));
+    EXPECT_THAT(data, HasSubstr("            <Param ControlIndex=\"22\">30069</Param>\n"));
+    EXPECT_THAT(data, HasSubstr("<Stompbox ID=\"1\">\n            <Module ID=\"136\" POS=\"0\" BypassState=\"1\">\n"
+                                "                <Param ControlIndex=\"0\">257</Param>\n            </Module>\n"));
+    EXPECT_THAT(data, HasSubstr("<Modulation ID=\"2\">\n            <Module ID=\"0\" POS=\"0\" BypassState=\"1\"></Module>\n"));
+    EXPECT_THAT(data, HasSubstr("<Module ID=\"43\" POS=\"6\" BypassState=\"1\">"));
+    EXPECT_THAT(data, HasSubstr("<Param ControlIndex=\"5\">1542</Param>"));
+    EXPECT_THAT(data, HasSubstr("<Info name=\"a&lt;b\" author=\"me\" rating=\"0\""));
+    EXPECT_THAT(data, HasSubstr("<UsbGain>14</UsbGain>\n</Preset>\n"));
+}
+
+TEST_F(FuseCodecTest, roundTrip)
+{
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> byte{0, 255};
+    const std::array<std::pair<effects, effects>, 4> families{{{effects::EMPTY, effects::COMPRESSOR},
+                                                               {effects::SINE_CHORUS, effects::PITCH_SHIFTER},
+                                                               {effects::MONO_DELAY, effects::STEREO_TAPE_DELAY},
+                                                               {effects::SMALL_HALL_REVERB, effects::FENDER_65_SPRING_REVERB}}};
+
+    for (int n = 0; n < 200; ++n)
+    {
+        auto next = [&rng, &byte] { return static_cast<std::uint8_t>(byte(rng)); };
+        const amp_settings amp{static_cast<amps>(next() % 12), next(), next(), next(), next(), next(), static_cast<cabinets>(next() % 13),
+                               next(), next(), next(), next(), next(), next(), next(), next(), (next() % 2) == 0, next()};
+        std::array<fx_pedal_settings, 4> effects{};
+        const std::size_t loopStart = next() % 5;
+
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            const auto [first, last] = families[i];
+            auto& e = effects[i];
+            e.fx_slot = static_cast<std::uint8_t>(i);
+            e.effect_num = static_cast<plug::effects>(value(first) + next() % (value(last) - value(first) + 1));
+            e.position = ((i >= loopStart) && (e.effect_num != effects::EMPTY) ? Position::effectsLoop : Position::input);
+
+            if (e.effect_num != effects::EMPTY)
+            {
+                e.knob1 = next();
+            }
+            if ((e.effect_num != effects::EMPTY) && (e.effect_num != effects::SIMPLE_COMP))
+            {
+                e.knob2 = next();
+                e.knob3 = next();
+                e.knob4 = next();
+                e.knob5 = next();
+            }
+            if ((e.effect_num == effects::TAPE_DELAY) || (e.effect_num == effects::STEREO_TAPE_DELAY) || (e.effect_num == effects::MONO_ECHO_FILTER) || (e.effect_num == effects::STEREO_ECHO_FILTER))
+            {
+                e.knob6 = next();
+            }
+        }
+
+        const SignalChain chain{"Preset " + std::to_string(n), amp, effects};
+        const auto parsed = parseFuse(writeFuse(chain));
+
+        EXPECT_THAT(parsed.name(), StrEq(chain.name()));
+        EXPECT_THAT(parsed.amp(), AmpIs(amp));
+        EXPECT_THAT(bySlot(parsed.effects()), ElementsAre(EffectIs(effects[0]), EffectIs(effects[1]), EffectIs(effects[2]), EffectIs(effects[3])));
+    }
+}
+
+TEST_F(FuseCodecTest, saveAndLoadFile)
+{
+    const auto path = (std::filesystem::temp_directory_path() / "plug-fuse-codec-test.fuse").string();
+    const auto chain = parseFuse(document);
+
+    saveFuseFile(path, chain);
+    const auto loaded = loadFuseFile(path);
+    std::filesystem::remove(path);
+
+    EXPECT_THAT(loaded.name(), StrEq(chain.name()));
+    EXPECT_THAT(loaded.amp(), AmpIs(chain.amp()));
+}
+
+TEST_F(FuseCodecTest, loadThrowsOnMissingFile)
+{
+    EXPECT_THROW(loadFuseFile("/nonexistent/file.fuse"), std::runtime_error);
+}
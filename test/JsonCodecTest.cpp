@@ -0,0 +1,98 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/JsonCodec.h"
+#include "matcher/TypeMatcher.h"
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace test::matcher;
+using namespace testing;
+
+
+class JsonCodecTest : public testing::Test
+{
+protected:
+    const amp_settings amp{amps::METAL_2000, 1, 2, 3, 4, 5, cabinets::cab4x12G, 6, 7, 8, 9, 10, 11, 12, 13, true, 14};
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::SIMPLE_COMP, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {1, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {2, effects::TAPE_DELAY, 1, 2, 3, 4, 5, 6, Position::effectsLoop},
+                                                    {3, effects::ARENA_REVERB, 7, 8, 9, 10, 11, 0, Position::effectsLoop}}};
+};
+
+TEST_F(JsonCodecTest, writeIsSingleLine)
+{
+    const auto data = writeJson(SignalChain{"a\nb", amp, effects});
+
+    EXPECT_THAT(data, StartsWith(R"({"name":"a\nb","amp":{"amp_num":11,"gain":1,"volume":2,)"));
+    EXPECT_THAT(data, HasSubstr(R"("brightness":true,"usb_gain":14})"));
+    EXPECT_THAT(data, HasSubstr(R"({"fx_slot":2,"effect_num":26,"knob1":1,"knob2":2,"knob3":3,"knob4":4,"knob5":5,"knob6":6,"position":"effectsLoop"})"));
+    EXPECT_THAT(data.find('\n'), Eq(std::string::npos));
+}
+
+TEST_F(JsonCodecTest, roundTrip)
+{
+    const SignalChain chain{"Quote \" Slash \\ Tab \t \x01 \xe2\x98\xba", amp, effects};
+    const auto parsed = parseJson(writeJson(chain));
+
+    EXPECT_THAT(parsed.name(), StrEq(chain.name()));
+    EXPECT_THAT(parsed.amp(), AmpIs(amp));
+    EXPECT_THAT(parsed.effects(), ElementsAre(EffectIs(effects[0]), EffectIs(effects[1]), EffectIs(effects[2]), EffectIs(effects[3])));
+}
+
+TEST_F(JsonCodecTest, parseIgnoresUnknownMembersAndWhitespace)
+{
+    const auto chain = parseJson(R"( { "version" : [1, {"x": null}, -2.5e3],
+        "name" : "☺🎸",
+        "amp" : { "amp_num" : 3, "gain" : 200, "extra" : "x" }, "effects" : [ ] } )");
+
+    EXPECT_THAT(chain.name(), StrEq("\xe2\x98\xba\xf0\x9f\x8e\xb8"));
+    EXPECT_THAT(chain.amp().amp_num, Eq(amps::FENDER_65_DELUXE_REVERB));
+    EXPECT_THAT(chain.amp().gain, Eq(200));
+    EXPECT_THAT(chain.effects()[3].fx_slot, Eq(3));
+    EXPECT_THAT(chain.effects()[3].effect_num, Eq(effects::EMPTY));
+}
+
+TEST_F(JsonCodecTest, parseThrowsOnInvalidData)
+{
+    EXPECT_THROW(parseJson(""), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"name":"x"})"), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"amp":{"gain":256}})"), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"amp":{"amp_num":12}})"), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"amp":{},"effects":[{"effect_num":38}]})"), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"amp":{},"effects":[{"position":"x"}]})"), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"amp":{},"effects":[{},{},{},{},{}]})"), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"amp":{}} x)"), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"name":"x)"), std::runtime_error);
+}
+
+TEST_F(JsonCodecTest, parseLimitsNestingDepth)
+{
+    auto nested = [](std::size_t depth) {
+        return R"({"extra":)" + std::string(depth, '[') + std::string(depth, ']') + R"(,"amp":{}})";
+    };
+
+    EXPECT_NO_THROW(parseJson(nested(32)));
+    EXPECT_THROW(parseJson(nested(65)), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"extra":)" + std::string(1000000, '[')), std::runtime_error);
+    EXPECT_THROW(parseJson(R"({"extra":)" + std::string(1000000, '{')), std::runtime_error);
+}
@@ -0,0 +1,157 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics/Metrics.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gmock/gmock.h>
+
+using namespace plug::metrics;
+using namespace testing;
+
+
+class MetricsTest : public testing::Test
+{
+protected:
+    Registry registry;
+};
+
+TEST_F(MetricsTest, counterAddsValues)
+{
+    Counter counter;
+    counter.add();
+    counter.add(4);
+
+    EXPECT_THAT(counter.value(), Eq(5));
+}
+
+TEST_F(MetricsTest, counterSumsAllThreads)
+{
+    Counter counter;
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&counter] {
+            for (int n = 0; n < 10000; ++n)
+            {
+                counter.add();
+            }
+        });
+    }
+    std::for_each(threads.begin(), threads.end(), [](auto& t) { t.join(); });
+
+    EXPECT_THAT(counter.value(), Eq(40000));
+}
+
+TEST_F(MetricsTest, gaugeSetAndAdd)
+{
+    Gauge gauge;
+    gauge.set(3);
+    gauge.add(-5);
+
+    EXPECT_THAT(gauge.value(), Eq(-2));
+}
+
+TEST_F(MetricsTest, histogramBucketsAreInclusive)
+{
+    Histogram histogram{{1.0, 2.0}};
+    histogram.observe(0.5);
+    histogram.observe(1.0);
+    histogram.observe(1.5);
+    histogram.observe(7.0);
+
+    const auto data = histogram.data();
+    EXPECT_THAT(data.counts, ElementsAre(2, 1, 1));
+    EXPECT_THAT(data.count, Eq(4));
+    EXPECT_THAT(data.sum, DoubleEq(10.0));
+}
+
+TEST_F(MetricsTest, histogramThrowsOnInvalidBuckets)
+{
+    EXPECT_THROW(Histogram({2.0, 1.0}), std::invalid_argument);
+    EXPECT_THROW(Histogram(std::vector<double>(Histogram::maxBuckets + 1, 1.0)), std::invalid_argument);
+}
+
+TEST_F(MetricsTest, scopedTimerObservesDuration)
+{
+    Histogram histogram{latencyBuckets()};
+    Counter failures;
+    {
+        ScopedTimer timer{histogram, &failures};
+    }
+
+    EXPECT_THAT(histogram.data().count, Eq(1));
+    EXPECT_THAT(failures.value(), Eq(0));
+}
+
+TEST_F(MetricsTest, scopedTimerCountsFailures)
+{
+    Histogram histogram{latencyBuckets()};
+    Counter failures;
+
+    try
+    {
+        ScopedTimer timer{histogram, &failures};
+        throw std::runtime_error{"failure"};
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+
+    EXPECT_THAT(histogram.data().count, Eq(1));
+    EXPECT_THAT(failures.value(), Eq(1));
+}
+
+TEST_F(MetricsTest, registryReturnsSameMetricForSameLabels)
+{
+    auto& a = registry.counter("requests_total", "Requests", {{"result", "hit"}});
+    auto& b = registry.counter("requests_total", "Requests", {{"result", "hit"}});
+    auto& c = registry.counter("requests_total", "Requests", {{"result", "miss"}});
+
+    EXPECT_THAT(&a, Eq(&b));
+    EXPECT_THAT(&a, Ne(&c));
+}
+
+TEST_F(MetricsTest, registryThrowsOnTypeMismatch)
+{
+    registry.counter("value", "Value");
+
+    EXPECT_THROW(registry.gauge("value", "Value"), std::invalid_argument);
+}
+
+TEST_F(MetricsTest, collectReturnsAllSeries)
+{
+    registry.counter("b_total", "B", {{"x", "1"}}).add(2);
+    registry.counter("b_total", "B", {{"x", "2"}}).add(3);
+    registry.gauge("a", "A").set(7);
+    registry.histogram("c_seconds", "C", {}, {0.1}).observe(0.05);
+
+    const auto families = registry.collect();
+    ASSERT_THAT(families, SizeIs(3));
+    EXPECT_THAT(families[0].name, StrEq("a"));
+    EXPECT_THAT(families[0].type, Eq(Type::gauge));
+    EXPECT_THAT(families[0].series[0].value, DoubleEq(7.0));
+    EXPECT_THAT(families[1].series, SizeIs(2));
+    EXPECT_THAT(families[1].series[1].value, DoubleEq(3.0));
+    EXPECT_THAT(families[2].series[0].histogram.counts, ElementsAre(1, 0));
+}
@@ -26,6 +26,7 @@
 #include "matcher/Matcher.h"
 #include "matcher/TypeMatcher.h"
 #include <array>
+#include <deque>
 #include <gmock/gmock.h>
 
 using namespace plug;
@@ -59,6 +60,32 @@ protected:
         return std::vector<std::uint8_t>{std::cbegin(c), std::cend(c)};
     }
 
+    // Data the amp sends for a slot, optionally followed by an empty packet
+    static void appendSlotData(std::deque<std::vector<std::uint8_t>>& responses, std::uint8_t slot, bool terminate)
+    {
+        amp_settings amp{};
+        amp.gain = slot;
+        auto data = encode_data(SignalChain{"preset " + std::to_string(slot), amp, {}});
+        data[0] = serializeName(slot, "preset " + std::to_string(slot)).getBytes();
+        std::transform(data.cbegin(), data.cend(), std::back_inserter(responses), [](const auto& p) { return std::vector<std::uint8_t>{p.cbegin(), p.cend()}; });
+
+        if (terminate == true)
+        {
+            responses.emplace_back();
+        }
+    }
+
+    static std::vector<std::uint8_t> pop(std::deque<std::vector<std::uint8_t>>& responses)
+    {
+        if (responses.empty())
+        {
+            return {};
+        }
+        auto packet = std::move(responses.front());
+        responses.pop_front();
+        return packet;
+    }
+
 
     std::shared_ptr<mock::MockConnection> conn;
     std::unique_ptr<com::Mustang> m;
@@ -630,3 +657,227 @@ TEST_F(MustangTest, saveOnAmp)
 
     m->save_on_amp(name, slot);
 }
+
+TEST_F(MustangTest, loadMemoryBankDataReturnsRawPackets)
+{
+    const auto recvData = asBuffer(serializeName(0, "abc").getBytes());
+
+    InSequence s;
+    EXPECT_CALL(*conn, sendImpl(_, _)).WillOnce(Return(packetRawTypeSize));
+    EXPECT_CALL(*conn, receive(packetRawTypeSize))
+        .WillOnce(Return(recvData))
+        .WillOnce(Return(ignoreAmpData))
+        .WillOnce(Return(ignoreData))
+        .WillOnce(Return(ignoreData))
+        .WillOnce(Return(ignoreData))
+        .WillOnce(Return(ignoreData))
+        .WillOnce(Return(ignoreData))
+        .WillOnce(Return(noData));
+
+    const auto data = m->load_memory_bank_data(slot);
+    EXPECT_THAT(asBuffer(data[0]), Eq(recvData));
+    EXPECT_THAT(asBuffer(data[1]), Eq(ignoreAmpData));
+}
+
+TEST_F(MustangTest, applyPresetDataSendsPacketsAsSettings)
+{
+    constexpr amp_settings amp{amps::BRITISH_80S, 2, 1, 3, 4, 5,
+                               cabinets::cab4x12M, 0, 9, 10, 11,
+                               0, 0x80, 13, 1, false, 0xab};
+    constexpr fx_pedal_settings e0{0x00, effects::OVERDRIVE, 10, 20, 30, 40, 50, 0, Position::input};
+    constexpr fx_pedal_settings e1{0x01, effects::TRIANGLE_CHORUS, 0, 0, 0, 1, 1, 0, Position::input};
+    constexpr fx_pedal_settings e2{0x02, effects::TAPE_DELAY, 1, 2, 3, 4, 5, 6, Position::effectsLoop};
+    constexpr fx_pedal_settings e3{0x03, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 0, Position::effectsLoop};
+    const std::array<PacketRawType, 6> expected{{serializeAmpSettings(amp).getBytes(),
+                                                 serializeEffectSettings(e0).getBytes(),
+                                                 serializeEffectSettings(e1).getBytes(),
+                                                 serializeEffectSettings(e2).getBytes(),
+                                                 serializeEffectSettings(e3).getBytes(),
+                                                 serializeAmpSettingsUsbGain(amp).getBytes()}};
+
+    // Bank data as received from the amp: operation type and slot set
+    PresetData data{{serializeName(slot, "abc").getBytes()}};
+    std::transform(expected.cbegin(), expected.cend(), std::next(data.begin()), [](auto p) {
+        p[1] = 0x01;
+        p[4] = slot;
+        return p;
+    });
+
+    InSequence s;
+
+    for (const auto& packet : expected)
+    {
+        EXPECT_CALL(*conn, sendImpl(BufferIs(packet), packet.size())).WillOnce(Return(packet.size()));
+        EXPECT_CALL(*conn, receive(packetRawTypeSize)).WillOnce(Return(ignoreData));
+        EXPECT_CALL(*conn, sendImpl(BufferIs(applyCmd), applyCmd.size())).WillOnce(Return(applyCmd.size()));
+        EXPECT_CALL(*conn, receive(packetRawTypeSize)).WillOnce(Return(ignoreData));
+    }
+
+    m->apply_preset_data(data);
+}
+
+TEST_F(MustangTest, applySettingsSendsAllPacketsBeforeReadingAcks)
+{
+    constexpr amp_settings amp{amps::BRITISH_80S, 2, 1, 3, 4, 5,
+                               cabinets::cab4x12M, 0, 9, 10, 11,
+                               0, 0x80, 13, 1, false, 0xab};
+    const auto ampPacket = serializeAmpSettings(amp).getBytes();
+    const auto usbGainPacket = serializeAmpSettingsUsbGain(amp).getBytes();
+
+    InSequence s;
+    EXPECT_CALL(*conn, sendImpl(BufferIs(ampPacket), ampPacket.size())).WillOnce(Return(ampPacket.size()));
+    EXPECT_CALL(*conn, sendImpl(BufferIs(usbGainPacket), usbGainPacket.size())).WillOnce(Return(usbGainPacket.size()));
+    EXPECT_CALL(*conn, sendImpl(BufferIs(applyCmd), applyCmd.size())).WillOnce(Return(applyCmd.size()));
+    EXPECT_CALL(*conn, receive(packetRawTypeSize)).Times(3).WillRepeatedly(Return(ignoreData));
+
+    m->apply_settings(std::vector<PacketRawType>{ampPacket, usbGainPacket});
+}
+
+TEST_F(MustangTest, applySettingsWithoutPacketsSendsNothing)
+{
+    EXPECT_CALL(*conn, sendImpl(_, _)).Times(0);
+    m->apply_settings(std::vector<PacketRawType>{});
+}
+
+TEST_F(MustangTest, backupPresetsPipelinesLoadCommands)
+{
+    constexpr std::size_t count{10};
+    std::vector<PacketRawType> sent;
+    std::deque<std::vector<std::uint8_t>> responses;
+
+    ON_CALL(*conn, sendImpl(_, _)).WillByDefault([&sent, &responses](std::uint8_t* data, std::size_t size) {
+        PacketRawType packet{};
+        std::copy_n(data, size, packet.begin());
+        sent.push_back(packet);
+        appendSlotData(responses, packet[4], true);
+        return size;
+    });
+    EXPECT_CALL(*conn, sendImpl(_, packetRawTypeSize)).Times(count);
+    EXPECT_CALL(*conn, receive(packetRawTypeSize)).Times(count * 8).WillRepeatedly([&responses](std::size_t) { return pop(responses); });
+
+    std::vector<std::pair<std::size_t, std::size_t>> progress;
+    const auto presets = m->backup_presets(count, [&progress](std::size_t done, std::size_t total) { progress.emplace_back(done, total); });
+
+    ASSERT_THAT(presets.size(), Eq(count));
+    EXPECT_THAT(decode_data(presets[3]).name(), StrEq("preset 3"));
+    EXPECT_THAT(decode_data(presets[3]).amp().gain, Eq(3));
+    EXPECT_THAT(sent[9], Eq(serializeLoadSlotCommand(9).getBytes()));
+    EXPECT_THAT(progress.size(), Eq(count));
+    EXPECT_THAT(progress.back(), Pair(count, count));
+}
+
+TEST_F(MustangTest, backupPresetsWithoutTerminatingPackets)
+{
+    std::deque<std::vector<std::uint8_t>> responses;
+
+    EXPECT_CALL(*conn, sendImpl(_, _)).WillRepeatedly([&responses](std::uint8_t* data, std::size_t size) {
+        appendSlotData(responses, data[4], false);
+        return size;
+    });
+    EXPECT_CALL(*conn, receive(packetRawTypeSize)).WillRepeatedly([&responses](std::size_t) { return pop(responses); });
+
+    const auto presets = m->backup_presets(3);
+
+    ASSERT_THAT(presets.size(), Eq(3));
+    EXPECT_THAT(decode_data(presets[2]).name(), StrEq("preset 2"));
+}
+
+TEST_F(MustangTest, backupPresetsThrowsOnIncompleteData)
+{
+    EXPECT_CALL(*conn, sendImpl(_, _)).WillRepeatedly(Return(packetRawTypeSize));
+    EXPECT_CALL(*conn, receive(packetRawTypeSize)).WillOnce(Return(asBuffer(serializeName(0, "preset 0").getBytes()))).WillOnce(Return(noData));
+
+    EXPECT_THROW(m->backup_presets(2), CommunicationException);
+}
+
+TEST_F(MustangTest, backupPresetsThrowsOnMissingPacket)
+{
+    std::deque<std::vector<std::uint8_t>> responses;
+
+    EXPECT_CALL(*conn, sendImpl(_, _)).WillRepeatedly([&responses](std::uint8_t* data, std::size_t size) {
+        appendSlotData(responses, data[4], false);
+
+        if (data[4] == 0)
+        {
+            responses.erase(std::next(responses.begin(), 3));
+        }
+        return size;
+    });
+    EXPECT_CALL(*conn, receive(packetRawTypeSize)).WillRepeatedly([&responses](std::size_t) { return pop(responses); });
+
+    EXPECT_THROW(m->backup_presets(3), CommunicationException);
+}
+
+TEST_F(MustangTest, backupPresetsThrowsOnExtraPacket)
+{
+    std::deque<std::vector<std::uint8_t>> responses;
+
+    EXPECT_CALL(*conn, sendImpl(_, _)).WillRepeatedly([&responses](std::uint8_t* data, std::size_t size) {
+        appendSlotData(responses, data[4], false);
+
+        if (data[4] == 1)
+        {
+            responses.push_back(responses.back());
+        }
+        return size;
+    });
+    EXPECT_CALL(*conn, receive(packetRawTypeSize)).WillRepeatedly([&responses](std::size_t) { return pop(responses); });
+
+    EXPECT_THROW(m->backup_presets(3), CommunicationException);
+}
+
+TEST_F(MustangTest, backupPresetsThrowsOnInvalidCount)
+{
+    EXPECT_THROW(m->backup_presets(257), std::invalid_argument);
+}
+
+TEST_F(MustangTest, restorePresetsSendsSettingsAndSavesSlot)
+{
+    constexpr amp_settings amp{amps::BRITISH_80S, 2, 1, 3, 4, 5,
+                               cabinets::cab4x12M, 0, 9, 10, 11,
+                               0, 0x80, 13, 1, false, 0xab};
+    constexpr fx_pedal_settings fx{0x00, effects::OVERDRIVE, 10, 20, 30, 40, 50, 0, Position::input};
+    const PresetData data{{serializeName(0, "abc").getBytes(),
+                           serializeAmpSettings(amp).getBytes(),
+                           serializeEffectSettings(fx).getBytes(),
+                           serializeEffectSettings(fx).getBytes(),
+                           serializeEffectSettings(fx).getBytes(),
+                           serializeEffectSettings(fx).getBytes(),
+                           serializeAmpSettingsUsbGain(amp).getBytes()}};
+    const auto ampPacket = serializeAmpSettings(amp).getBytes();
+    const auto savePacket0 = serializeName(0, "abc").getBytes();
+    const auto savePacket1 = serializeName(1, "abc").getBytes();
+
+    EXPECT_CALL(*conn, sendImpl(_, _)).WillRepeatedly(Return(packetRawTypeSize));
+    EXPECT_CALL(*conn, sendImpl(BufferIs(ampPacket), ampPacket.size())).Times(2).WillRepeatedly(Return(packetRawTypeSize));
+    EXPECT_CALL(*conn, sendImpl(BufferIs(savePacket0), savePacket0.size())).WillOnce(Return(packetRawTypeSize));
+    EXPECT_CALL(*conn, sendImpl(BufferIs(savePacket1), savePacket1.size())).WillOnce(Return(packetRawTypeSize));
+    EXPECT_CALL(*conn, receive(packetRawTypeSize)).Times(2 * 8).WillRepeatedly(Return(ignoreData));
+
+    std::vector<std::pair<std::size_t, std::size_t>> progress;
+    m->restore_presets({data, data}, [&progress](std::size_t done, std::size_t total) { progress.emplace_back(done, total); });
+
+    EXPECT_THAT(progress, ElementsAre(Pair(1, 2), Pair(2, 2)));
+}
+
+TEST_F(MustangTest, encodeDataOrdersEffectsByDsp)
+{
+    constexpr amp_settings amp{amps::BRITISH_80S, 2, 1, 3, 4, 5,
+                               cabinets::cab4x12M, 0, 9, 10, 11,
+                               0, 0x80, 13, 1, false, 0xab};
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 0, Position::input},
+                                                    {1, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {2, effects::OVERDRIVE, 1, 2, 3, 4, 5, 0, Position::effectsLoop},
+                                                    {3, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input}}};
+    const SignalChain chain{"abc", amp, effects};
+
+    const auto data = encode_data(chain);
+
+    EXPECT_THAT(data[2], Eq(serializeEffectSettings(effects[2]).getBytes()));
+    EXPECT_THAT(data[5], Eq(serializeEffectSettings(effects[0]).getBytes()));
+
+    const auto decoded = decode_data(data);
+    EXPECT_THAT(decoded.name(), StrEq("abc"));
+    EXPECT_THAT(decoded.amp(), AmpIs(amp));
+    EXPECT_THAT(decoded.effects(), ElementsAre(EffectIs(effects[0]), EffectIs(effects[1]), EffectIs(effects[2]), EffectIs(effects[3])));
+}
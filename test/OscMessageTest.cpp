@@ -0,0 +1,189 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/OscMessage.h"
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace plug::com::osc;
+using namespace testing;
+
+
+class OscMessageTest : public testing::Test
+{
+protected:
+    using Message = osc::Message;
+
+    std::vector<Message> roundTrip(const Message& message) const
+    {
+        const auto data = serializeMessage(message);
+        return parsePacket(data.data(), data.size());
+    }
+
+    std::vector<std::uint8_t> bundleOf(const std::vector<Message>& messages) const
+    {
+        std::vector<std::uint8_t> data{'#', 'b', 'u', 'n', 'd', 'l', 'e', '\0', 0, 0, 0, 0, 0, 0, 0, 1};
+
+        for (const auto& message : messages)
+        {
+            const auto element = serializeMessage(message);
+            const auto size = static_cast<std::uint32_t>(element.size());
+            data.insert(data.end(), {static_cast<std::uint8_t>(size >> 24), static_cast<std::uint8_t>(size >> 16),
+                                     static_cast<std::uint8_t>(size >> 8), static_cast<std::uint8_t>(size)});
+            data.insert(data.end(), element.cbegin(), element.cend());
+        }
+        return data;
+    }
+};
+
+TEST_F(OscMessageTest, serializePadsToFourBytes)
+{
+    const auto data = serializeMessage(Message{"/amp/gain", {std::int32_t{3}}});
+    EXPECT_THAT(data.size(), Eq(12 + 4 + 4));
+    EXPECT_THAT(data.size() % 4, Eq(0));
+}
+
+TEST_F(OscMessageTest, parseIntArgument)
+{
+    const auto messages = roundTrip(Message{"/amp/gain", {std::int32_t{200}}});
+    ASSERT_THAT(messages.size(), Eq(1));
+    EXPECT_THAT(messages[0].address, StrEq("/amp/gain"));
+    EXPECT_THAT(std::get<std::int32_t>(messages[0].arguments[0]), Eq(200));
+}
+
+TEST_F(OscMessageTest, parseMixedArguments)
+{
+    const auto messages = roundTrip(Message{"/x", {0.5f, std::string{"abcd"}, true, false, std::int32_t{-4}}});
+    ASSERT_THAT(messages.size(), Eq(1));
+    const auto& args = messages[0].arguments;
+    ASSERT_THAT(args.size(), Eq(5));
+    EXPECT_THAT(std::get<float>(args[0]), FloatEq(0.5f));
+    EXPECT_THAT(std::get<std::string>(args[1]), StrEq("abcd"));
+    EXPECT_THAT(std::get<bool>(args[2]), IsTrue());
+    EXPECT_THAT(std::get<bool>(args[3]), IsFalse());
+    EXPECT_THAT(std::get<std::int32_t>(args[4]), Eq(-4));
+}
+
+TEST_F(OscMessageTest, parseBundle)
+{
+    const auto data = bundleOf({Message{"/amp/gain", {std::int32_t{1}}}, Message{"/amp/bass", {std::int32_t{2}}}});
+    const auto messages = parsePacket(data.data(), data.size());
+    ASSERT_THAT(messages.size(), Eq(2));
+    EXPECT_THAT(messages[0].address, StrEq("/amp/gain"));
+    EXPECT_THAT(messages[1].address, StrEq("/amp/bass"));
+}
+
+TEST_F(OscMessageTest, parseRejectsTruncatedData)
+{
+    auto data = serializeMessage(Message{"/amp/gain", {std::int32_t{1}}});
+    data.resize(data.size() - 4);
+    EXPECT_THAT(parsePacket(data.data(), data.size()), IsEmpty());
+}
+
+TEST_F(OscMessageTest, parseRejectsUnknownTypeTag)
+{
+    auto data = serializeMessage(Message{"/amp/gain", {std::int32_t{1}}});
+    data[12 + 1] = 'q';
+    EXPECT_THAT(parsePacket(data.data(), data.size()), IsEmpty());
+}
+
+TEST_F(OscMessageTest, parseRejectsInvalidAddress)
+{
+    const auto data = serializeMessage(Message{"amp", {std::int32_t{1}}});
+    EXPECT_THAT(parsePacket(data.data(), data.size()), IsEmpty());
+}
+
+TEST_F(OscMessageTest, ampParameterEvent)
+{
+    const auto event = toControlEvent(Message{"/amp/gain", {std::int32_t{180}}});
+    ASSERT_TRUE(event.has_value());
+    EXPECT_THAT(event->target, Eq(ControlTarget::amp));
+    EXPECT_THAT(event->parameter, Eq(static_cast<std::uint8_t>(AmpParameter::gain)));
+    EXPECT_THAT(event->value, Eq(180));
+}
+
+TEST_F(OscMessageTest, normalizedFloatIsScaled)
+{
+    EXPECT_THAT(toControlEvent(Message{"/amp/volume", {1.0f}})->value, Eq(255));
+    EXPECT_THAT(toControlEvent(Message{"/amp/volume", {0.0f}})->value, Eq(0));
+    EXPECT_THAT(toControlEvent(Message{"/amp/volume", {0.5f}})->value, Eq(128));
+    EXPECT_THAT(toControlEvent(Message{"/amp/volume", {7.0f}})->value, Eq(255));
+}
+
+TEST_F(OscMessageTest, intValueOutOfRangeIsIgnored)
+{
+    EXPECT_THAT(toControlEvent(Message{"/amp/volume", {std::int32_t{255}}})->value, Eq(255));
+    EXPECT_THAT(toControlEvent(Message{"/amp/volume", {std::int32_t{0}}})->value, Eq(0));
+    EXPECT_FALSE(toControlEvent(Message{"/amp/volume", {std::int32_t{256}}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/amp/volume", {std::int32_t{-3}}}).has_value());
+}
+
+TEST_F(OscMessageTest, effectParameterEvent)
+{
+    const auto event = toControlEvent(Message{"/fx/2/knob3", {std::int32_t{77}}});
+    ASSERT_TRUE(event.has_value());
+    EXPECT_THAT(event->target, Eq(ControlTarget::effect));
+    EXPECT_THAT(event->slot, Eq(1));
+    EXPECT_THAT(event->parameter, Eq(static_cast<std::uint8_t>(EffectParameter::knob3)));
+    EXPECT_THAT(event->value, Eq(77));
+}
+
+TEST_F(OscMessageTest, effectSlotOutOfRangeIsIgnored)
+{
+    EXPECT_FALSE(toControlEvent(Message{"/fx/0/knob1", {std::int32_t{1}}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/fx/5/knob1", {std::int32_t{1}}}).has_value());
+}
+
+TEST_F(OscMessageTest, presetLoadEvent)
+{
+    const auto event = toControlEvent(Message{"/preset/load", {std::int32_t{17}}});
+    ASSERT_TRUE(event.has_value());
+    EXPECT_THAT(event->target, Eq(ControlTarget::preset));
+    EXPECT_THAT(event->slot, Eq(17));
+}
+
+TEST_F(OscMessageTest, presetLoadRequiresIntegerSlot)
+{
+    EXPECT_FALSE(toControlEvent(Message{"/preset/load", {0.5f}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/preset/load", {std::int32_t{100}}}).has_value());
+}
+
+TEST_F(OscMessageTest, presetLoadRejectsSlotOutOfRange)
+{
+    EXPECT_THAT(toControlEvent(Message{"/preset/load", {std::int32_t{0}}})->slot, Eq(0));
+    EXPECT_FALSE(toControlEvent(Message{"/preset/load", {std::int32_t{-5}}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/preset/load", {std::int32_t{999}}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/preset/load", {std::int32_t{256}}}).has_value());
+}
+
+TEST_F(OscMessageTest, invalidModelsAreIgnored)
+{
+    EXPECT_FALSE(toControlEvent(Message{"/amp/model", {std::int32_t{12}}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/amp/cabinet", {std::int32_t{13}}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/fx/1/model", {std::int32_t{38}}}).has_value());
+}
+
+TEST_F(OscMessageTest, unknownAddressIsIgnored)
+{
+    EXPECT_FALSE(toControlEvent(Message{"/amp/unknown", {std::int32_t{1}}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/mixer/1", {std::int32_t{1}}}).has_value());
+    EXPECT_FALSE(toControlEvent(Message{"/amp/gain", {}}).has_value());
+}
@@ -0,0 +1,241 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/OscServer.h"
+#include "com/OscMessage.h"
+#include "com/CommandQueue.h"
+#include "com/Mustang.h"
+#include "com/PacketSerializer.h"
+#include "com/CommunicationException.h"
+#include "mocks/MockConnection.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace testing;
+
+
+class OscServerTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        conn = std::make_shared<NiceMock<mock::MockConnection>>();
+        mustang = std::make_unique<Mustang>(conn);
+
+        ON_CALL(*conn, sendImpl(_, _)).WillByDefault(Invoke([this](std::uint8_t* data, std::size_t size) {
+            std::lock_guard<std::mutex> lock{mutex};
+            PacketRawType packet{};
+            std::copy_n(data, std::min(size, packet.size()), packet.begin());
+            sent.push_back(packet);
+
+            if (packet == serializeLoadSlotCommand(packet[4]).getBytes())
+            {
+                pending.insert(pending.end(), bankData.cbegin(), bankData.cend());
+            }
+            return size;
+        }));
+        ON_CALL(*conn, receive(_)).WillByDefault(Invoke([this](std::size_t) {
+            std::lock_guard<std::mutex> lock{mutex};
+
+            if (pending.empty())
+            {
+                return std::vector<std::uint8_t>{};
+            }
+            const auto packet = pending.front();
+            pending.pop_front();
+            return std::vector<std::uint8_t>(packet.cbegin(), packet.cend());
+        }));
+
+        queue = std::make_unique<CommandQueue>(*mustang);
+        queue->start();
+        sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+    }
+
+    void TearDown() override
+    {
+        server.reset();
+        queue->stop();
+        ::close(sender);
+    }
+
+    void send(const osc::Message& message) const
+    {
+        const auto data = osc::serializeMessage(message);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server->port());
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        ::sendto(sender, data.data(), data.size(), 0, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    }
+
+    bool waitForSent(const PacketRawType& expected)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+
+                if (std::find(sent.cbegin(), sent.cend(), expected) != sent.cend())
+                {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        return false;
+    }
+
+    void startServer(const SignalChain& chain)
+    {
+        server = std::make_unique<OscServer>(*queue, chain, "127.0.0.1", 0);
+        server->start();
+    }
+
+    const amp_settings amp{amps::BRITISH_80S, 10, 20, 30, 40, 50, cabinets::cab4x12M, 1, 2, 3, 4, 5, 6, 7, 1, false, 9};
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::OVERDRIVE, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {1, effects::SINE_CHORUS, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {2, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {3, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 6, Position::effectsLoop}}};
+    const amp_settings bankAmp{amps::METAL_2000, 1, 1, 1, 1, 1, cabinets::cab4x12G, 1, 1, 1, 1, 1, 1, 1, 1, true, 1};
+    const std::array<PacketRawType, 7> bankData{{serializeName(0, "bank").getBytes(),
+                                                 serializeAmpSettings(bankAmp).getBytes(),
+                                                 serializeEffectSettings(effects[0]).getBytes(),
+                                                 serializeEffectSettings(effects[1]).getBytes(),
+                                                 serializeEffectSettings(effects[2]).getBytes(),
+                                                 serializeEffectSettings(effects[3]).getBytes(),
+                                                 serializeAmpSettingsUsbGain(bankAmp).getBytes()}};
+
+    std::shared_ptr<NiceMock<mock::MockConnection>> conn;
+    std::unique_ptr<Mustang> mustang;
+    std::unique_ptr<CommandQueue> queue;
+    std::unique_ptr<OscServer> server;
+    int sender{-1};
+    std::mutex mutex;
+    std::vector<PacketRawType> sent;
+    std::deque<PacketRawType> pending;
+};
+
+TEST_F(OscServerTest, bindsToEphemeralPort)
+{
+    OscServer s{*queue, SignalChain{}, "127.0.0.1", 0};
+    EXPECT_THAT(s.port(), Ne(0));
+    EXPECT_FALSE(s.isRunning());
+}
+
+TEST_F(OscServerTest, throwsOnInvalidAddress)
+{
+    EXPECT_THROW((OscServer{*queue, SignalChain{}, "not-an-address", 0}), CommunicationException);
+}
+
+TEST_F(OscServerTest, startAndStop)
+{
+    startServer(SignalChain{"", amp, effects});
+    EXPECT_TRUE(server->isRunning());
+    server->stop();
+    EXPECT_FALSE(server->isRunning());
+}
+
+TEST_F(OscServerTest, ampMessageSetsAmplifier)
+{
+    startServer(SignalChain{"", amp, effects});
+    send(osc::Message{"/amp/gain", {std::int32_t{200}}});
+
+    auto expected = amp;
+    expected.gain = 200;
+    EXPECT_TRUE(waitForSent(serializeAmpSettings(expected).getBytes()));
+}
+
+TEST_F(OscServerTest, effectMessageSetsEffect)
+{
+    startServer(SignalChain{"", amp, effects});
+    send(osc::Message{"/fx/2/knob3", {std::int32_t{77}}});
+
+    auto expected = effects[1];
+    expected.knob3 = 77;
+    EXPECT_TRUE(waitForSent(serializeEffectSettings(expected).getBytes()));
+}
+
+TEST_F(OscServerTest, presetMessageLoadsMemoryBank)
+{
+    startServer(SignalChain{"", amp, effects});
+    send(osc::Message{"/preset/load", {std::int32_t{17}}});
+
+    EXPECT_TRUE(waitForSent(serializeLoadSlotCommand(17).getBytes()));
+}
+
+TEST_F(OscServerTest, changesApplyOnTopOfLoadedPreset)
+{
+    startServer(SignalChain{"", amp, effects});
+    send(osc::Message{"/preset/load", {std::int32_t{3}}});
+    ASSERT_TRUE(waitForSent(serializeLoadSlotCommand(3).getBytes()));
+    send(osc::Message{"/amp/volume", {std::int32_t{44}}});
+
+    auto expected = bankAmp;
+    expected.volume = 44;
+    EXPECT_TRUE(waitForSent(serializeAmpSettings(expected).getBytes()));
+}
+
+TEST_F(OscServerTest, changesApplyOnTopOfExternalUpdate)
+{
+    startServer(SignalChain{"", amp, effects});
+    auto external = amp;
+    external.bass = 99;
+    server->update(SignalChain{"", external, effects});
+    send(osc::Message{"/amp/gain", {std::int32_t{200}}});
+
+    auto expected = external;
+    expected.gain = 200;
+    EXPECT_TRUE(waitForSent(serializeAmpSettings(expected).getBytes()));
+}
+
+TEST_F(OscServerTest, invalidMessagesAreIgnored)
+{
+    startServer(SignalChain{"", amp, effects});
+    send(osc::Message{"/amp/unknown", {std::int32_t{1}}});
+    send(osc::Message{"/amp/treble", {std::int32_t{1}}});
+
+    auto expected = amp;
+    expected.treble = 1;
+    EXPECT_TRUE(waitForSent(serializeAmpSettings(expected).getBytes()));
+
+    std::lock_guard<std::mutex> lock{mutex};
+    EXPECT_THAT(sent.size(), Eq(4));
+}
+
+TEST_F(OscServerTest, replacedEffectOfOtherFamilyIsCleared)
+{
+    startServer(SignalChain{"", amp, effects});
+    send(osc::Message{"/fx/1/model", {std::int32_t{value(effects::MONO_DELAY)}}});
+
+    auto cleared = effects[0];
+    cleared.enabled = false;
+    EXPECT_TRUE(waitForSent(serializeClearEffectSettings(cleared).getBytes()));
+}
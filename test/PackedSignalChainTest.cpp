@@ -0,0 +1,150 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PackedSignalChain.h"
+#include "matcher/TypeMatcher.h"
+#include <algorithm>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace test::matcher;
+using namespace testing;
+
+
+class PackedSignalChainTest : public testing::Test
+{
+protected:
+    const amp_settings amp{amps::METAL_2000, 1, 2, 3, 4, 5, cabinets::cab4x12G, 6, 7, 8, 9, 10, 11, 12, 13, true, 14};
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::SIMPLE_COMP, 1, 2, 3, 4, 5, 6, Position::input, true},
+                                                    {1, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input, false},
+                                                    {2, effects::TAPE_DELAY, 1, 2, 3, 4, 5, 6, Position::effectsLoop, true},
+                                                    {3, effects::ARENA_REVERB, 7, 8, 9, 10, 11, 0, Position::effectsLoop, true}}};
+    const SignalChain chain{"Preset", amp, effects};
+};
+
+TEST_F(PackedSignalChainTest, layout)
+{
+    EXPECT_THAT(alignof(PackedSignalChain), Eq(64));
+    EXPECT_THAT(offsetof(PackedSignalChain, amp), Eq(32));
+    EXPECT_THAT(offsetof(PackedSignalChain, effects), Eq(49));
+}
+
+TEST_F(PackedSignalChainTest, packAndUnpack)
+{
+    const auto unpacked = unpack(pack(chain));
+
+    EXPECT_THAT(unpacked.name(), StrEq("Preset"));
+    EXPECT_THAT(unpacked.amp(), AmpIs(amp));
+    EXPECT_THAT(unpacked.effects(), ElementsAre(EffectIs(effects[0]), EffectIs(effects[1]), EffectIs(effects[2]), EffectIs(effects[3])));
+    EXPECT_THAT(unpacked.effects()[1].enabled, IsFalse());
+}
+
+TEST_F(PackedSignalChainTest, packOrdersEffectsBySlot)
+{
+    auto reordered = effects;
+    std::reverse(reordered.begin(), reordered.end());
+    const SignalChain other{"Preset", amp, reordered};
+
+    EXPECT_THAT(pack(other) == pack(chain), IsTrue());
+    EXPECT_THAT(pack(other).effects[0].fx_slot, Eq(0));
+    EXPECT_THAT(contentHash(other), Eq(contentHash(chain)));
+}
+
+TEST_F(PackedSignalChainTest, nameIsLimitedTo32Bytes)
+{
+    const std::string name(40, 'x');
+
+    EXPECT_THAT(unpack(pack(SignalChain{name, amp, effects})).name(), StrEq(std::string(32, 'x')));
+    EXPECT_THAT(unpack(pack(SignalChain{std::string(32, 'y'), amp, effects})).name(), StrEq(std::string(32, 'y')));
+}
+
+TEST_F(PackedSignalChainTest, equality)
+{
+    auto other = chain;
+    EXPECT_THAT(pack(chain) == pack(other), IsTrue());
+
+    other.setName("Other");
+    EXPECT_THAT(pack(chain) != pack(other), IsTrue());
+    EXPECT_THAT(settingsEqual(pack(chain), pack(other)), IsTrue());
+
+    auto e = effects;
+    e[3].knob5 = 99;
+    other.setEffects(e);
+    EXPECT_THAT(settingsEqual(pack(chain), pack(other)), IsFalse());
+}
+
+TEST_F(PackedSignalChainTest, diffMaskOfEqualChains)
+{
+    EXPECT_THAT(diffMask(pack(chain), pack(chain)), Eq(0));
+}
+
+TEST_F(PackedSignalChainTest, diffMaskReportsFields)
+{
+    auto a = amp;
+    a.gain = 100;
+    a.usb_gain = 0;
+    auto e = effects;
+    e[2].knob3 = 0;
+    e[3].position = Position::input;
+    const SignalChain other{"Other", a, e};
+
+    const auto mask = diffMask(pack(chain), pack(other));
+
+    EXPECT_THAT(mask, Eq(diff::name | diff::ampField(offsetof(PackedAmp, gain)) | diff::ampField(offsetof(PackedAmp, usb_gain))
+                         | diff::effectField(2, offsetof(PackedEffect, knob3)) | diff::effectField(3, offsetof(PackedEffect, position))));
+    EXPECT_THAT(mask & diff::amp, Ne(0));
+    EXPECT_THAT(mask & diff::effect(0), Eq(0));
+    EXPECT_THAT(mask & diff::effect(1), Eq(0));
+    EXPECT_THAT(mask & diff::effect(2), Ne(0));
+    EXPECT_THAT(mask & diff::effect(3), Ne(0));
+}
+
+TEST_F(PackedSignalChainTest, settingsDistanceSumsDifferences)
+{
+    auto other = chain;
+    other.setName("Other");
+
+    EXPECT_THAT(settingsDistance(pack(chain), pack(other)), Eq(0));
+
+    auto a = amp;
+    a.gain = 11;
+    a.usb_gain = 4;
+    auto e = effects;
+    e[3].knob5 = 255;
+    other.setAmp(a);
+    other.setEffects(e);
+
+    EXPECT_THAT(settingsDistance(pack(chain), pack(other)), Eq(10 + 10 + 244));
+    EXPECT_THAT(settingsDistance(pack(other), pack(chain)), Eq(264));
+}
+
+TEST_F(PackedSignalChainTest, contentHashIgnoresName)
+{
+    auto other = chain;
+    other.setName("Other");
+
+    EXPECT_THAT(contentHash(pack(chain)), Eq(contentHash(pack(other))));
+    EXPECT_THAT(contentHash(chain), Eq(contentHash(pack(chain))));
+
+    auto a = amp;
+    a.sag = 0;
+    other.setAmp(a);
+    EXPECT_THAT(contentHash(pack(chain)), Ne(contentHash(pack(other))));
+}
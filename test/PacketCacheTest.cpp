@@ -0,0 +1,107 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/PacketCache.h"
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace testing;
+
+
+class PacketCacheTest : public testing::Test
+{
+protected:
+    SignalChain withGain(std::uint8_t gain) const
+    {
+        auto settings = amp;
+        settings.gain = gain;
+        return SignalChain{"abc", settings, effects};
+    }
+
+    const amp_settings amp{amps::BRITISH_80S, 10, 20, 30, 40, 50, cabinets::cab4x12M, 1, 2, 3, 4, 5, 6, 7, 1, false, 9};
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::OVERDRIVE, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {1, effects::SINE_CHORUS, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {2, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {3, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 6, Position::effectsLoop}}};
+};
+
+TEST_F(PacketCacheTest, getReturnsSerializedSettings)
+{
+    PacketCache cache{4};
+    const SignalChain chain{"abc", amp, effects};
+
+    EXPECT_THAT(cache.get(chain), ContainerEq(encode_settings(chain)));
+    EXPECT_THAT(cache.get(chain), ContainerEq(encode_settings(chain)));
+    EXPECT_THAT(cache.hits(), Eq(1));
+    EXPECT_THAT(cache.misses(), Eq(1));
+}
+
+TEST_F(PacketCacheTest, nameIsNotPartOfTheKey)
+{
+    PacketCache cache{4};
+    cache.get(SignalChain{"abc", amp, effects});
+    cache.get(SignalChain{"other", amp, effects});
+
+    EXPECT_THAT(cache.hits(), Eq(1));
+    EXPECT_THAT(cache.size(), Eq(1));
+}
+
+TEST_F(PacketCacheTest, differentSettingsAreSeparateEntries)
+{
+    PacketCache cache{4};
+
+    EXPECT_THAT(cache.get(withGain(1)), ContainerEq(encode_settings(withGain(1))));
+    EXPECT_THAT(cache.get(withGain(2)), ContainerEq(encode_settings(withGain(2))));
+    EXPECT_THAT(cache.misses(), Eq(2));
+    EXPECT_THAT(cache.size(), Eq(2));
+}
+
+TEST_F(PacketCacheTest, leastRecentlyUsedEntryIsEvicted)
+{
+    PacketCache cache{2};
+    cache.get(withGain(1));
+    cache.get(withGain(2));
+    cache.get(withGain(1));
+    cache.get(withGain(3));
+
+    EXPECT_THAT(cache.size(), Eq(2));
+    cache.get(withGain(1));
+    EXPECT_THAT(cache.hits(), Eq(2));
+    cache.get(withGain(2));
+    EXPECT_THAT(cache.misses(), Eq(4));
+}
+
+TEST_F(PacketCacheTest, clearRemovesEntries)
+{
+    PacketCache cache{2};
+    cache.get(withGain(1));
+    cache.clear();
+
+    EXPECT_THAT(cache.size(), Eq(0));
+    cache.get(withGain(1));
+    EXPECT_THAT(cache.misses(), Eq(2));
+}
+
+TEST_F(PacketCacheTest, zeroCapacityThrows)
+{
+    EXPECT_THROW(PacketCache{0}, std::invalid_argument);
+}
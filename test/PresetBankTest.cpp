@@ -0,0 +1,178 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetBank.h"
+#include "preset/PresetIndex.h"
+#include "com/PacketSerializer.h"
+#include "matcher/TypeMatcher.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace test::matcher;
+using namespace testing;
+
+namespace fs = std::filesystem;
+
+
+class PresetBankTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        path = (fs::temp_directory_path() / ("plug-bank-test-" + std::string{testing::UnitTest::GetInstance()->current_test_info()->name()} + ".bank")).string();
+        fs::remove(path);
+    }
+
+    void TearDown() override
+    {
+        fs::remove(path);
+    }
+
+    static com::PresetData serialize(const SignalChain& chain)
+    {
+        const auto fx = chain.effects();
+        return {{com::serializeName(0, chain.name()).getBytes(),
+                 com::serializeAmpSettings(chain.amp()).getBytes(),
+                 com::serializeEffectSettings(fx[0]).getBytes(),
+                 com::serializeEffectSettings(fx[1]).getBytes(),
+                 com::serializeEffectSettings(fx[2]).getBytes(),
+                 com::serializeEffectSettings(fx[3]).getBytes(),
+                 com::serializeAmpSettingsUsbGain(chain.amp()).getBytes()}};
+    }
+
+    SignalChain chain(const std::string& name, std::uint8_t gain) const
+    {
+        amp_settings amp{amps::BRITISH_80S, gain, 2, 3, 4, 5, cabinets::cab4x12M, 0, 9, 10, 11, 0, 0x80, 13, 1, false, 0xab};
+        return SignalChain{name, amp, effects};
+    }
+
+    std::string path;
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::OVERDRIVE, 1, 2, 3, 4, 5, 0, Position::input},
+                                                    {1, effects::SINE_CHORUS, 1, 2, 3, 4, 5, 0, Position::input},
+                                                    {2, effects::TAPE_DELAY, 1, 2, 3, 4, 5, 6, Position::effectsLoop},
+                                                    {3, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 0, Position::effectsLoop}}};
+};
+
+TEST_F(PresetBankTest, recordContainsNameAndHash)
+{
+    const auto c = chain("abc", 7);
+    const auto record = makeBankRecord(serialize(c));
+
+    EXPECT_THAT(record.getName(), Eq("abc"));
+    EXPECT_THAT(record.getHash(), Eq(contentHash(c)));
+    EXPECT_THAT(record.packets, Eq(serialize(c)));
+}
+
+TEST_F(PresetBankTest, decodeRecord)
+{
+    const auto c = chain("abc", 7);
+    const auto decoded = decodeRecord(makeBankRecord(serialize(c)));
+
+    EXPECT_THAT(decoded.name(), StrEq("abc"));
+    EXPECT_THAT(decoded.amp(), AmpIs(c.amp()));
+    EXPECT_THAT(decoded.effects(), ElementsAre(EffectIs(effects[0]), EffectIs(effects[1]), EffectIs(effects[2]), EffectIs(effects[3])));
+}
+
+TEST_F(PresetBankTest, writeAndReadRecords)
+{
+    {
+        PresetBankWriter writer{path};
+
+        for (std::uint8_t i = 0; i < 100; ++i)
+        {
+            writer.append(serialize(chain("preset " + std::to_string(i), i)));
+        }
+        EXPECT_THAT(writer.size(), Eq(100));
+    }
+
+    const PresetBank bank{path};
+    ASSERT_THAT(bank.size(), Eq(100));
+    EXPECT_THAT(bank[42].getName(), Eq("preset 42"));
+    EXPECT_THAT(bank[42].packets, Eq(serialize(chain("preset 42", 42))));
+    EXPECT_THAT(decodeRecord(bank.at(99)).amp().gain, Eq(99));
+    EXPECT_THAT(std::distance(bank.begin(), bank.end()), Eq(100));
+}
+
+TEST_F(PresetBankTest, emptyBank)
+{
+    PresetBankWriter{path};
+
+    EXPECT_THAT(fs::file_size(path), Eq(16));
+    EXPECT_THAT(PresetBank{path}.size(), Eq(0));
+}
+
+TEST_F(PresetBankTest, appendToExistingBank)
+{
+    PresetBankWriter{path}.append(serialize(chain("first", 1)));
+
+    PresetBankWriter writer{path};
+    EXPECT_THAT(writer.size(), Eq(1));
+    writer.append(serialize(chain("second", 2)));
+
+    const PresetBank bank{path};
+    ASSERT_THAT(bank.size(), Eq(2));
+    EXPECT_THAT(bank[0].getName(), Eq("first"));
+    EXPECT_THAT(bank[1].getName(), Eq("second"));
+}
+
+TEST_F(PresetBankTest, tornRecordIsDropped)
+{
+    PresetBankWriter{path}.append(serialize(chain("first", 1)));
+    std::ofstream{path, std::ios::binary | std::ios::app} << "partial";
+
+    EXPECT_THAT(PresetBank{path}.size(), Eq(1));
+
+    PresetBankWriter{path}.append(serialize(chain("second", 2)));
+
+    const PresetBank bank{path};
+    ASSERT_THAT(bank.size(), Eq(2));
+    EXPECT_THAT(bank[1].getName(), Eq("second"));
+}
+
+TEST_F(PresetBankTest, accessOutOfRangeThrows)
+{
+    PresetBankWriter{path};
+
+    EXPECT_THROW(PresetBank{path}.at(0), std::out_of_range);
+}
+
+TEST_F(PresetBankTest, invalidBankThrows)
+{
+    std::ofstream{path, std::ios::binary} << "PLIX\x01\x00\x00\x00";
+
+    EXPECT_THROW(PresetBank{path}, std::runtime_error);
+    EXPECT_THROW(PresetBankWriter{path}, std::runtime_error);
+}
+
+TEST_F(PresetBankTest, unsupportedVersionThrows)
+{
+    std::ofstream{path, std::ios::binary} << std::string{"PLBK\x02\x00\x00\x00\xe8\x01\x00\x00\x00\x00\x00\x00", 16};
+
+    EXPECT_THROW(PresetBank{path}, std::runtime_error);
+}
+
+TEST_F(PresetBankTest, missingBankThrows)
+{
+    EXPECT_THROW(PresetBank{"/nonexistent/file.bank"}, std::runtime_error);
+}
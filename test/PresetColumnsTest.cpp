@@ -0,0 +1,180 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetColumns.h"
+#include "preset/PresetBank.h"
+#include "matcher/TypeMatcher.h"
+#include <filesystem>
+#include <random>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace test::matcher;
+using namespace testing;
+
+
+class PresetColumnsTest : public testing::Test
+{
+protected:
+    static SignalChain chain(const std::string& name, amps model, std::uint8_t gain, std::uint8_t sag, std::uint8_t reverbLevel)
+    {
+        const amp_settings amp{model, gain, 2, 3, 4, 5, cabinets::cab4x12M, 0, 9, 10, 11, 0, 0x80, 13, sag, false, 0};
+        const std::array<fx_pedal_settings, 4> effects{{{3, effects::ARENA_REVERB, reverbLevel, 2, 3, 4, 5, 0, Position::effectsLoop},
+                                                        {0, effects::OVERDRIVE, 1, 2, 3, 4, 5, 0, Position::input},
+                                                        {1, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                        {2, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input}}};
+        return SignalChain{name, amp, effects};
+    }
+
+    static constexpr std::size_t gain{column::amp(offsetof(PackedAmp, gain))};
+    static constexpr std::size_t sag{column::amp(offsetof(PackedAmp, sag))};
+    static constexpr std::size_t model{column::amp(offsetof(PackedAmp, amp_num))};
+    static constexpr std::size_t reverbLevel{column::effect(3, offsetof(PackedEffect, knob1))};
+};
+
+TEST_F(PresetColumnsTest, appendStoresColumns)
+{
+    PresetColumns columns;
+    columns.append(chain("a", amps::METAL_2000, 210, 2, 40), "a.fuse");
+    columns.append(chain("b", amps::BRITISH_80S, 100, 1, 90));
+
+    ASSERT_THAT(columns.size(), Eq(2));
+    EXPECT_THAT(columns.column(gain), ElementsAre(210, 100));
+    EXPECT_THAT(columns.column(reverbLevel), ElementsAre(40, 90));
+    EXPECT_THAT(columns.column(column::effect(0, offsetof(PackedEffect, effect_num))), Each(Eq(value(effects::OVERDRIVE))));
+    EXPECT_THAT(columns.name(1), StrEq("b"));
+    EXPECT_THAT(columns.source(0), StrEq("a.fuse"));
+}
+
+TEST_F(PresetColumnsTest, rowRestoresChain)
+{
+    const auto original = chain("preset", amps::METAL_2000, 210, 2, 40);
+    PresetColumns columns;
+    columns.append(original);
+
+    const auto restored = columns.row(0);
+    EXPECT_THAT(restored.name(), StrEq("preset"));
+    EXPECT_THAT(restored.amp(), AmpIs(original.amp()));
+    EXPECT_THAT(restored.effects()[3], EffectIs(original.effects()[0]));
+}
+
+TEST_F(PresetColumnsTest, selectMatchesRowWiseScan)
+{
+    std::mt19937 rng{3};
+    std::uniform_int_distribution<int> byte{0, 255};
+    PresetColumns columns;
+
+    // Not a multiple of 64 rows, so the tail is tested as well
+    for (int i = 0; i < 1000; ++i)
+    {
+        columns.append(chain("", amps::METAL_2000, static_cast<std::uint8_t>(byte(rng)), 0, 0));
+    }
+
+    const std::array<Compare, 6> ops{{Compare::equal, Compare::notEqual, Compare::less, Compare::lessEqual, Compare::greater, Compare::greaterEqual}};
+    auto matches = [](std::uint8_t x, Compare op, std::uint8_t v) {
+        switch (op)
+        {
+            case Compare::equal:
+                return x == v;
+            case Compare::notEqual:
+                return x != v;
+            case Compare::less:
+                return x < v;
+            case Compare::lessEqual:
+                return x <= v;
+            case Compare::greater:
+                return x > v;
+            case Compare::greaterEqual:
+                return x >= v;
+        }
+        return false;
+    };
+
+    for (const auto op : ops)
+    {
+        for (const int v : {0, 1, 127, 128, 200, 255})
+        {
+            std::vector<std::size_t> expected;
+
+            for (std::size_t row = 0; row < columns.size(); ++row)
+            {
+                if (matches(columns.column(gain)[row], op, static_cast<std::uint8_t>(v)))
+                {
+                    expected.push_back(row);
+                }
+            }
+            EXPECT_THAT(indices(columns.select(gain, op, static_cast<std::uint8_t>(v))), ContainerEq(expected)) << static_cast<int>(op) << " " << v;
+        }
+    }
+}
+
+TEST_F(PresetColumnsTest, combinedPredicates)
+{
+    PresetColumns columns;
+    columns.append(chain("a", amps::METAL_2000, 210, 2, 0));
+    columns.append(chain("b", amps::METAL_2000, 210, 1, 0));
+    columns.append(chain("c", amps::METAL_2000, 150, 2, 0));
+    columns.append(chain("d", amps::BRITISH_80S, 255, 2, 0));
+
+    auto rows = columns.select(gain, Compare::greater, 200);
+    intersect(rows, columns.select(sag, Compare::equal, 2));
+    EXPECT_THAT(indices(rows), ElementsAre(0, 3));
+    EXPECT_THAT(count(rows), Eq(2));
+
+    unite(rows, columns.select(gain, Compare::less, 200));
+    EXPECT_THAT(indices(rows), ElementsAre(0, 2, 3));
+    EXPECT_THAT(count(columns.all()), Eq(4));
+}
+
+TEST_F(PresetColumnsTest, medianPerAmpModel)
+{
+    PresetColumns columns;
+    columns.append(chain("", amps::METAL_2000, 0, 0, 10));
+    columns.append(chain("", amps::METAL_2000, 0, 0, 30));
+    columns.append(chain("", amps::METAL_2000, 0, 0, 20));
+    columns.append(chain("", amps::BRITISH_80S, 0, 0, 90));
+    columns.append(chain("", amps::BRITISH_80S, 0, 0, 70));
+
+    EXPECT_THAT(columns.median(reverbLevel, columns.select(model, Compare::equal, value(amps::METAL_2000))), Optional(Eq(20)));
+    EXPECT_THAT(columns.median(reverbLevel, columns.select(model, Compare::equal, value(amps::BRITISH_80S))), Optional(Eq(70)));
+    EXPECT_THAT(columns.median(reverbLevel, columns.select(model, Compare::equal, value(amps::BRITISH_60S))), Eq(std::nullopt));
+    EXPECT_THAT(columns.histogram(reverbLevel, columns.all())[90], Eq(1));
+}
+
+TEST_F(PresetColumnsTest, loadColumnsFromBank)
+{
+    const auto path = (std::filesystem::temp_directory_path() / "plug-columns-test.bank").string();
+    std::filesystem::remove(path);
+    {
+        PresetBankWriter writer{path};
+        writer.append(makeBankRecord(chain("first", amps::METAL_2000, 210, 2, 40)));
+        writer.append(makeBankRecord(chain("second", amps::BRITISH_80S, 100, 1, 90)));
+    }
+
+    ConversionReport report{0, 0, 0, 0, 0, {}, {}};
+    const auto columns = loadColumns(path, report);
+    std::filesystem::remove(path);
+
+    EXPECT_THAT(report.failed, Eq(0));
+    ASSERT_THAT(columns.size(), Eq(2));
+    EXPECT_THAT(columns.name(1), StrEq("second"));
+    EXPECT_THAT(columns.column(gain), ElementsAre(210, 100));
+}
@@ -0,0 +1,393 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetIndex.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace testing;
+
+namespace fs = std::filesystem;
+
+
+class PresetIndexTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        dir = fs::temp_directory_path() / ("plug-index-test-" + std::string{testing::UnitTest::GetInstance()->current_test_info()->name()});
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(dir);
+    }
+
+    void writeFile(const fs::path& path, const std::string& content) const
+    {
+        fs::create_directories((dir / path).parent_path());
+        std::ofstream out{dir / path};
+        out << content;
+    }
+
+    // Test files only contain the preset name; amp model and gain are derived from its length
+    PresetIndex::Parser parser()
+    {
+        return [this](const std::string& path) {
+            ++parseCalls;
+            std::ifstream in{path};
+            const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+            if (content == "broken")
+            {
+                throw std::runtime_error{"parse error"};
+            }
+
+            amp_settings amp{};
+            amp.amp_num = static_cast<amps>(content.size() % 12);
+            amp.gain = static_cast<std::uint8_t>(content.size() * 10);
+            amp.cabinet = cabinets::cab4x12G;
+            return SignalChain{content, amp, effects};
+        };
+    }
+
+    const std::array<fx_pedal_settings, 4> effects{{{2, effects::OVERDRIVE, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {0, effects::SINE_CHORUS, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {1, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {3, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 6, Position::effectsLoop}}};
+    fs::path dir;
+    std::atomic<std::size_t> parseCalls{0};
+};
+
+TEST_F(PresetIndexTest, scansRecursively)
+{
+    writeFile("a.fuse", "a");
+    writeFile("sub/b.fuse", "b");
+    writeFile("sub/deeper/c.FUSE", "c");
+    writeFile("sub/notes.txt", "x");
+
+    PresetIndex index{parser(), 2};
+    const auto result = index.update(dir.string());
+
+    EXPECT_THAT(result.files, Eq(3));
+    EXPECT_THAT(result.parsed, Eq(3));
+    EXPECT_THAT(index.entries().size(), Eq(3));
+}
+
+TEST_F(PresetIndexTest, entriesContainMetadata)
+{
+    writeFile("preset.fuse", "abc");
+
+    PresetIndex index{parser(), 1};
+    index.update(dir.string());
+
+    const auto entries = index.entries();
+    ASSERT_THAT(entries.size(), Eq(1));
+    EXPECT_THAT(entries[0].path, StrEq((dir / "preset.fuse").string()));
+    EXPECT_THAT(entries[0].size, Eq(3));
+    EXPECT_THAT(entries[0].name, StrEq("abc"));
+    EXPECT_THAT(entries[0].amp, Eq(static_cast<amps>(3)));
+    EXPECT_THAT(entries[0].cabinet, Eq(cabinets::cab4x12G));
+    EXPECT_THAT(entries[0].effectModels, ElementsAre(effects::SINE_CHORUS, effects::EMPTY, effects::OVERDRIVE, effects::ARENA_REVERB));
+    EXPECT_THAT(entries[0].gain, Eq(30));
+    EXPECT_THAT(entries[0].hash, Eq(contentHash(SignalChain{"", amp_settings{static_cast<amps>(3), 30, 0, 0, 0, 0, cabinets::cab4x12G, 0, 0, 0, 0, 0, 0, 0, 0, false, 0}, effects})));
+}
+
+TEST_F(PresetIndexTest, unchangedFilesAreNotParsedAgain)
+{
+    writeFile("a.fuse", "a");
+    writeFile("b.fuse", "b");
+
+    PresetIndex index{parser(), 2};
+    index.update(dir.string());
+    parseCalls = 0;
+    const auto result = index.update(dir.string());
+
+    EXPECT_THAT(parseCalls, Eq(0));
+    EXPECT_THAT(result.parsed, Eq(0));
+    EXPECT_THAT(index.entries().size(), Eq(2));
+}
+
+TEST_F(PresetIndexTest, modifiedFilesAreParsedAgain)
+{
+    writeFile("a.fuse", "a");
+    writeFile("b.fuse", "b");
+
+    PresetIndex index{parser(), 2};
+    index.update(dir.string());
+    parseCalls = 0;
+    writeFile("b.fuse", "modified");
+    const auto result = index.update(dir.string());
+
+    EXPECT_THAT(parseCalls, Eq(1));
+    EXPECT_THAT(result.parsed, Eq(1));
+    EXPECT_THAT(index.entries()[1].name, StrEq("modified"));
+}
+
+TEST_F(PresetIndexTest, removedFilesAreDropped)
+{
+    writeFile("a.fuse", "a");
+    writeFile("b.fuse", "b");
+
+    PresetIndex index{parser(), 2};
+    index.update(dir.string());
+    fs::remove(dir / "a.fuse");
+    const auto result = index.update(dir.string());
+
+    EXPECT_THAT(result.removed, Eq(1));
+    ASSERT_THAT(index.entries().size(), Eq(1));
+    EXPECT_THAT(index.entries()[0].name, StrEq("b"));
+}
+
+TEST_F(PresetIndexTest, parseFailuresAreSkipped)
+{
+    writeFile("a.fuse", "a");
+    writeFile("b.fuse", "broken");
+
+    PresetIndex index{parser(), 2};
+    const auto result = index.update(dir.string());
+
+    EXPECT_THAT(result.failed, Eq(1));
+    EXPECT_THAT(index.entries().size(), Eq(1));
+}
+
+TEST_F(PresetIndexTest, parseFailuresAreNotParsedAgain)
+{
+    writeFile("a.fuse", "a");
+    writeFile("b.fuse", "broken");
+
+    PresetIndex index{parser(), 2};
+    index.update(dir.string());
+    parseCalls = 0;
+    const auto result = index.update(dir.string());
+
+    EXPECT_THAT(parseCalls, Eq(0));
+    EXPECT_THAT(result.files, Eq(2));
+    EXPECT_THAT(result.failed, Eq(1));
+    EXPECT_THAT(result.removed, Eq(0));
+}
+
+TEST_F(PresetIndexTest, fixedFilesAreParsedAgain)
+{
+    writeFile("a.fuse", "broken");
+
+    PresetIndex index{parser(), 2};
+    index.update(dir.string());
+    parseCalls = 0;
+    writeFile("a.fuse", "fixed");
+    const auto result = index.update(dir.string());
+
+    EXPECT_THAT(parseCalls, Eq(1));
+    EXPECT_THAT(result.failed, Eq(0));
+    ASSERT_THAT(index.entries().size(), Eq(1));
+    EXPECT_THAT(index.entries()[0].name, StrEq("fixed"));
+}
+
+TEST_F(PresetIndexTest, parseFailuresArePersisted)
+{
+    writeFile("a.fuse", "a");
+    writeFile("sub/b.fuse", "broken");
+    const auto indexFile = (dir / "library.index").string();
+
+    PresetIndex first{parser(), 2};
+    first.update(dir.string());
+    first.save(indexFile);
+    parseCalls = 0;
+
+    PresetIndex second{parser(), 2};
+    EXPECT_TRUE(second.load(indexFile));
+    const auto result = second.update(dir.string());
+
+    EXPECT_THAT(parseCalls, Eq(0));
+    EXPECT_THAT(result.failed, Eq(1));
+    EXPECT_THAT(second.entries().size(), Eq(1));
+}
+
+TEST_F(PresetIndexTest, indexIsPersisted)
+{
+    writeFile("a.fuse", "a");
+    writeFile("sub/b.fuse", "bb");
+    const auto indexFile = (dir / "library.index").string();
+
+    PresetIndex first{parser(), 2};
+    first.update(dir.string());
+    first.save(indexFile);
+    parseCalls = 0;
+
+    PresetIndex second{parser(), 2};
+    EXPECT_TRUE(second.load(indexFile));
+    const auto result = second.update(dir.string());
+
+    EXPECT_THAT(parseCalls, Eq(0));
+    EXPECT_THAT(result.files, Eq(2));
+    ASSERT_THAT(second.entries().size(), Eq(2));
+    EXPECT_THAT(second.entries()[1].name, StrEq("bb"));
+    EXPECT_THAT(second.entries()[1].gain, Eq(20));
+    EXPECT_THAT(second.entries()[1].hash, Eq(first.entries()[1].hash));
+}
+
+TEST_F(PresetIndexTest, loadRejectsInvalidIndex)
+{
+    writeFile("invalid.index", "not an index");
+
+    PresetIndex index{parser()};
+    EXPECT_FALSE(index.load((dir / "invalid.index").string()));
+    EXPECT_FALSE(index.load((dir / "missing.index").string()));
+    EXPECT_THAT(index.entries(), IsEmpty());
+}
+
+TEST_F(PresetIndexTest, updateThrowsOnMissingDirectory)
+{
+    PresetIndex index{parser()};
+    EXPECT_THROW(index.update((dir / "missing").string()), std::runtime_error);
+}
+
+TEST_F(PresetIndexTest, cancelledScanKeepsEntries)
+{
+    writeFile("a.fuse", "a");
+
+    PresetIndex index{parser()};
+    index.update(dir.string());
+    writeFile("b.fuse", "b");
+    index.cancel();
+    const auto result = index.update(dir.string());
+
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_THAT(index.entries().size(), Eq(1));
+}
+
+TEST_F(PresetIndexTest, updateDirectoryOnlyScansThatDirectory)
+{
+    writeFile("a.fuse", "a");
+    writeFile("sub/b.fuse", "b");
+
+    PresetIndex index{parser(), 2};
+    index.update(dir.string());
+    parseCalls = 0;
+    writeFile("c.fuse", "c");
+    writeFile("sub/d.fuse", "d");
+    const auto result = index.updateDirectory(dir.string());
+
+    EXPECT_THAT(parseCalls, Eq(1));
+    EXPECT_THAT(result.parsed, Eq(1));
+    EXPECT_THAT(result.removed, Eq(0));
+    EXPECT_THAT(index.entries().size(), Eq(3)); // sub/d.fuse needs an update of sub/
+
+}
+
+TEST_F(PresetIndexTest, updateDirectoryDropsRemovedFiles)
+{
+    writeFile("a.fuse", "a");
+    writeFile("b.fuse", "b");
+    writeFile("sub/c.fuse", "c");
+
+    PresetIndex index{parser(), 2};
+    index.update(dir.string());
+    fs::remove(dir / "a.fuse");
+    const auto result = index.updateDirectory(dir.string());
+
+    EXPECT_THAT(result.removed, Eq(1));
+    const auto entries = index.entries();
+    ASSERT_THAT(entries.size(), Eq(2));
+    EXPECT_THAT(entries[0].name, StrEq("b"));
+    EXPECT_THAT(entries[1].name, StrEq("c"));
+}
+
+TEST_F(PresetIndexTest, updateDirectoryHandlesNewAndRemovedSubdirectories)
+{
+    writeFile("a.fuse", "a");
+    writeFile("old/b.fuse", "b");
+
+    PresetIndex index{parser(), 2};
+    index.update(dir.string());
+    fs::remove_all(dir / "old");
+    writeFile("new/deeper/c.fuse", "c");
+    const auto result = index.updateDirectory((dir / "").string());
+
+    EXPECT_THAT(result.parsed, Eq(1));
+    EXPECT_THAT(result.removed, Eq(1));
+    const auto entries = index.entries();
+    ASSERT_THAT(entries.size(), Eq(2));
+    EXPECT_THAT(entries[0].name, StrEq("a"));
+    EXPECT_THAT(entries[1].path, StrEq((dir / "new" / "deeper" / "c.fuse").string()));
+}
+
+TEST_F(PresetIndexTest, updateDirectoryReparsesModifiedFiles)
+{
+    writeFile("sub/a.fuse", "a");
+
+    PresetIndex index{parser(), 1};
+    index.update(dir.string());
+    writeFile("sub/a.fuse", "modified");
+    index.updateDirectory((dir / "sub").string());
+
+    ASSERT_THAT(index.entries().size(), Eq(1));
+    EXPECT_THAT(index.entries()[0].name, StrEq("modified"));
+}
+
+TEST_F(PresetIndexTest, diffEntriesReportsChanges)
+{
+    auto entry = [](std::string path, std::string name, std::uint64_t hash) {
+        return IndexEntry{std::move(path), 10, 1, std::move(name), amps::METAL_2000, cabinets::cab4x12G, {}, 0, 0, 0, 0, 0, hash};
+    };
+    const std::vector<IndexEntry> before{entry("a", "a", 1), entry("b", "b", 2), entry("c", "c", 3), entry("d", "d", 4)};
+    auto modified = entry("b", "b", 5);
+    modified.mtime = 2;
+    const std::vector<IndexEntry> after{entry("a", "a", 1), modified, entry("d", "d", 4), entry("e", "e", 6), entry("f", "c", 3)};
+
+    const auto diff = diffEntries(before, after);
+
+    ASSERT_THAT(diff.added.size(), Eq(1));
+    EXPECT_THAT(diff.added[0].path, StrEq("e"));
+    ASSERT_THAT(diff.changed.size(), Eq(1));
+    EXPECT_THAT(diff.changed[0].hash, Eq(5));
+    EXPECT_THAT(diff.removed, IsEmpty());
+    ASSERT_THAT(diff.renamed.size(), Eq(1));
+    EXPECT_THAT(diff.renamed[0].first, StrEq("c"));
+    EXPECT_THAT(diff.renamed[0].second.path, StrEq("f"));
+}
+
+TEST_F(PresetIndexTest, diffEntriesReportsRemovedFiles)
+{
+    const std::vector<IndexEntry> before{IndexEntry{"a", 1, 1, "a", amps::METAL_2000, cabinets::cab4x12G, {}, 0, 0, 0, 0, 0, 1}};
+    const auto diff = diffEntries(before, {});
+
+    EXPECT_THAT(diff.removed, ElementsAre("a"));
+    EXPECT_THAT(diff.added, IsEmpty());
+    EXPECT_THAT(diff.renamed, IsEmpty());
+}
+
+TEST_F(PresetIndexTest, contentHashIgnoresName)
+{
+    amp_settings amp{};
+    amp.gain = 10;
+    auto other = amp;
+    other.gain = 11;
+
+    EXPECT_THAT(contentHash(SignalChain{"a", amp, effects}), Eq(contentHash(SignalChain{"b", amp, effects})));
+    EXPECT_THAT(contentHash(SignalChain{"a", amp, effects}), Ne(contentHash(SignalChain{"a", other, effects})));
+}
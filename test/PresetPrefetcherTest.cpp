@@ -0,0 +1,188 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetPrefetcher.h"
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace testing;
+
+
+class PresetPrefetcherTest : public testing::Test
+{
+protected:
+    PresetPrefetcher::Parser parser()
+    {
+        return [this](const std::string& path) {
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                parsed.push_back(path);
+            }
+
+            if (path == blockingPath)
+            {
+                release.wait();
+            }
+            if (path == "broken")
+            {
+                throw std::runtime_error{"parse error"};
+            }
+            return SignalChain{path, amp_settings{}, {}};
+        };
+    }
+
+    bool waitFor(PresetPrefetcher& prefetcher, const std::string& path) const
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            if (prefetcher.get(path).has_value() == true)
+            {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        return false;
+    }
+
+    std::vector<std::string> parsedPaths()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return parsed;
+    }
+
+    std::mutex mutex;
+    std::vector<std::string> parsed;
+    std::string blockingPath{"blocking"};
+    std::promise<void> releasePromise;
+    std::shared_future<void> release{releasePromise.get_future().share()};
+};
+
+TEST_F(PresetPrefetcherTest, prefetchedPresetsAreCached)
+{
+    PresetPrefetcher prefetcher{parser(), 4};
+    prefetcher.prefetch({"a", "b"});
+
+    ASSERT_TRUE(waitFor(prefetcher, "b"));
+    EXPECT_THAT(prefetcher.get("a")->name(), StrEq("a"));
+    EXPECT_THAT(parsedPaths(), ElementsAre("a", "b"));
+}
+
+TEST_F(PresetPrefetcherTest, getReturnsNothingIfNotCached)
+{
+    PresetPrefetcher prefetcher{parser(), 4};
+    EXPECT_FALSE(prefetcher.get("a").has_value());
+}
+
+TEST_F(PresetPrefetcherTest, loadUsesCache)
+{
+    PresetPrefetcher prefetcher{parser(), 4};
+    prefetcher.prefetch({"a"});
+    ASSERT_TRUE(waitFor(prefetcher, "a"));
+
+    EXPECT_THAT(prefetcher.load("a").name(), StrEq("a"));
+    EXPECT_THAT(parsedPaths().size(), Eq(1));
+}
+
+TEST_F(PresetPrefetcherTest, loadParsesOnCacheMiss)
+{
+    PresetPrefetcher prefetcher{parser(), 4};
+
+    EXPECT_THAT(prefetcher.load("a").name(), StrEq("a"));
+    EXPECT_TRUE(prefetcher.get("a").has_value());
+}
+
+TEST_F(PresetPrefetcherTest, loadThrowsOnParseError)
+{
+    PresetPrefetcher prefetcher{parser(), 4};
+    EXPECT_THROW(prefetcher.load("broken"), std::runtime_error);
+}
+
+TEST_F(PresetPrefetcherTest, newRequestDropsStaleOnes)
+{
+    PresetPrefetcher prefetcher{parser(), 8};
+    prefetcher.prefetch({blockingPath, "stale1", "stale2"});
+
+    while (parsedPaths().empty() == true)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    prefetcher.prefetch({"current"});
+    releasePromise.set_value();
+
+    ASSERT_TRUE(waitFor(prefetcher, "current"));
+    EXPECT_THAT(parsedPaths(), ElementsAre(blockingPath, "current"));
+}
+
+TEST_F(PresetPrefetcherTest, cachedPresetsAreNotParsedAgain)
+{
+    PresetPrefetcher prefetcher{parser(), 4};
+    prefetcher.prefetch({"a"});
+    ASSERT_TRUE(waitFor(prefetcher, "a"));
+    prefetcher.prefetch({"a", "b"});
+    ASSERT_TRUE(waitFor(prefetcher, "b"));
+
+    EXPECT_THAT(parsedPaths(), ElementsAre("a", "b"));
+}
+
+TEST_F(PresetPrefetcherTest, leastRecentlyUsedIsEvicted)
+{
+    PresetPrefetcher prefetcher{parser(), 2};
+    prefetcher.load("a");
+    prefetcher.load("b");
+    prefetcher.get("a");
+    prefetcher.load("c");
+
+    EXPECT_TRUE(prefetcher.get("a").has_value());
+    EXPECT_FALSE(prefetcher.get("b").has_value());
+    EXPECT_TRUE(prefetcher.get("c").has_value());
+}
+
+TEST_F(PresetPrefetcherTest, clearDropsCache)
+{
+    PresetPrefetcher prefetcher{parser(), 4};
+    prefetcher.load("a");
+    prefetcher.clear();
+
+    EXPECT_FALSE(prefetcher.get("a").has_value());
+}
+
+TEST_F(PresetPrefetcherTest, invalidateDropsOnlyThatPreset)
+{
+    PresetPrefetcher prefetcher{parser(), 4};
+    prefetcher.load("a");
+    prefetcher.load("b");
+    prefetcher.invalidate("a");
+
+    EXPECT_FALSE(prefetcher.get("a").has_value());
+    EXPECT_TRUE(prefetcher.get("b").has_value());
+}
+
+TEST_F(PresetPrefetcherTest, throwsOnZeroCapacity)
+{
+    EXPECT_THROW((PresetPrefetcher{parser(), 0}), std::invalid_argument);
+}
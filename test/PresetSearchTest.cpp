@@ -0,0 +1,197 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetSearch.h"
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::preset;
+using namespace testing;
+
+
+class PresetSearchTest : public testing::Test
+{
+protected:
+    static PresetAttributes attributes(amps amp, std::array<effects, 4> models, std::uint8_t gain)
+    {
+        return PresetAttributes{amp, cabinets::cab4x12G, models, gain, 100, 128, 128, 128};
+    }
+
+    std::vector<std::string> keys(std::string_view query) const
+    {
+        std::vector<std::string> result;
+
+        for (const auto& match : search.search(query))
+        {
+            result.push_back(match.key);
+        }
+        return result;
+    }
+
+    void SetUp() override
+    {
+        search.insert(SearchSource::library, "/p/metal.fuse", "Metal Lead",
+                      attributes(amps::METAL_2000, {effects::OVERDRIVE, effects::EMPTY, effects::TAPE_DELAY, effects::EMPTY}, 200));
+        search.insert(SearchSource::library, "/p/clean.fuse", "Clean Chorus",
+                      attributes(amps::FENDER_65_TWIN_REVERB, {effects::EMPTY, effects::SINE_CHORUS, effects::EMPTY, effects::ARENA_REVERB}, 40));
+        search.insert(SearchSource::library, "/p/crunch.fuse", "Crunch",
+                      attributes(amps::METAL_2000, {effects::EMPTY, effects::EMPTY, effects::EMPTY, effects::EMPTY}, 150));
+        search.insert(SearchSource::amp, "3", "Metal Rhythm", std::nullopt);
+    }
+
+    PresetSearch search;
+};
+
+TEST_F(PresetSearchTest, emptyQueryReturnsAllSortedByName)
+{
+    EXPECT_THAT(keys(""), ElementsAre("/p/clean.fuse", "/p/crunch.fuse", "/p/metal.fuse", "3"));
+}
+
+TEST_F(PresetSearchTest, wordsMatchNames)
+{
+    EXPECT_THAT(keys("metal"), UnorderedElementsAre("/p/metal.fuse", "3"));
+    EXPECT_THAT(keys("metal lead"), ElementsAre("/p/metal.fuse"));
+    EXPECT_THAT(keys("CHOR"), ElementsAre("/p/clean.fuse"));
+    EXPECT_THAT(keys("jazz"), IsEmpty());
+}
+
+TEST_F(PresetSearchTest, wordsMatchFuzzy)
+{
+    EXPECT_THAT(keys("metl"), UnorderedElementsAre("/p/metal.fuse", "3"));
+    EXPECT_THAT(keys("crnch"), ElementsAre("/p/crunch.fuse"));
+}
+
+TEST_F(PresetSearchTest, exactMatchesRankFirst)
+{
+    search.insert(SearchSource::library, "/p/metallic.fuse", "Metallica", std::nullopt);
+    search.insert(SearchSource::library, "/p/meta.fuse", "Meta", std::nullopt);
+
+    const auto results = search.search("meta");
+    ASSERT_THAT(results.size(), Ge(2));
+    EXPECT_THAT(results[0].key, StrEq("/p/meta.fuse"));
+    EXPECT_THAT(results[0].score, Gt(results.back().score));
+}
+
+TEST_F(PresetSearchTest, filtersMatchSettings)
+{
+    EXPECT_THAT(keys("amp=METAL_2000"), UnorderedElementsAre("/p/metal.fuse", "/p/crunch.fuse"));
+    EXPECT_THAT(keys("amp=metal2000 and fx3!=EMPTY and gain>180"), ElementsAre("/p/metal.fuse"));
+    EXPECT_THAT(keys("effect=arena_reverb"), ElementsAre("/p/clean.fuse"));
+    EXPECT_THAT(keys("fx4=arena_reverb"), ElementsAre("/p/clean.fuse"));
+    EXPECT_THAT(keys("fx1=arena_reverb"), IsEmpty());
+    EXPECT_THAT(keys("cabinet=cab4x12G gain<=150"), UnorderedElementsAre("/p/clean.fuse", "/p/crunch.fuse"));
+    EXPECT_THAT(keys("crunch amp!=METAL_2000"), IsEmpty());
+}
+
+TEST_F(PresetSearchTest, familyFiltersMatchAnySlot)
+{
+    search.insert(SearchSource::library, "/p/echo.fuse", "Echo",
+                  attributes(amps::BRITISH_60S, {effects::MONO_DELAY, effects::EMPTY, effects::EMPTY, effects::EMPTY}, 90));
+
+    EXPECT_THAT(keys("family=delay"), UnorderedElementsAre("/p/metal.fuse", "/p/echo.fuse"));
+    EXPECT_THAT(keys("dsp=effect2"), UnorderedElementsAre("/p/metal.fuse", "/p/echo.fuse"));
+    EXPECT_THAT(keys("fx3!=EMPTY"), ElementsAre("/p/metal.fuse"));
+    EXPECT_THAT(keys("family=mod"), ElementsAre("/p/clean.fuse"));
+    EXPECT_THAT(keys("dsp!=effect2"), UnorderedElementsAre("/p/clean.fuse", "/p/crunch.fuse"));
+    EXPECT_THROW(search.search("family=flanger"), std::invalid_argument);
+    EXPECT_THROW(search.search("dsp=effect"), std::invalid_argument);
+}
+
+TEST_F(PresetSearchTest, filterValuesMatchUniquePrefixes)
+{
+    EXPECT_THAT(keys("effect=simple_comp"), IsEmpty());
+    EXPECT_THAT(keys("amp=fender_65_twin"), ElementsAre("/p/clean.fuse"));
+    EXPECT_THAT(keys("effect=tape"), ElementsAre("/p/metal.fuse"));
+    EXPECT_THAT(keys("effect=stereo_tape"), IsEmpty());
+    EXPECT_THROW(search.search("amp=fender"), std::invalid_argument);
+    EXPECT_THROW(search.search("amp=twin"), std::invalid_argument);
+}
+
+TEST_F(PresetSearchTest, presetsWithoutSettingsDoNotMatchFilters)
+{
+    EXPECT_THAT(keys("metal amp!=BRITISH_80S"), ElementsAre("/p/metal.fuse"));
+    EXPECT_THAT(keys("metal gain>=0"), ElementsAre("/p/metal.fuse"));
+}
+
+TEST_F(PresetSearchTest, malformedFiltersThrow)
+{
+    EXPECT_THROW(search.search("amp="), std::invalid_argument);
+    EXPECT_THROW(search.search("=x"), std::invalid_argument);
+    EXPECT_THROW(search.search("color=red"), std::invalid_argument);
+    EXPECT_THROW(search.search("gain>loud"), std::invalid_argument);
+    EXPECT_THROW(search.search("amp>METAL_2000"), std::invalid_argument);
+    EXPECT_THROW(search.search("fx5=EMPTY"), std::invalid_argument);
+}
+
+TEST_F(PresetSearchTest, insertReplacesExistingDocument)
+{
+    search.insert(SearchSource::amp, "3", "Blues", attributes(amps::BRITISH_60S, {}, 90));
+
+    EXPECT_THAT(search.size(), Eq(4));
+    EXPECT_THAT(keys("rhythm"), IsEmpty());
+    EXPECT_THAT(keys("blues amp=british_60s"), ElementsAre("3"));
+}
+
+TEST_F(PresetSearchTest, eraseRemovesDocument)
+{
+    search.erase(SearchSource::library, "/p/metal.fuse");
+    search.erase(SearchSource::library, "/p/unknown.fuse");
+
+    EXPECT_THAT(search.size(), Eq(3));
+    EXPECT_THAT(keys("metal"), ElementsAre("3"));
+    EXPECT_THAT(keys("amp=METAL_2000"), ElementsAre("/p/crunch.fuse"));
+}
+
+TEST_F(PresetSearchTest, clearRemovesOnlyOneSource)
+{
+    search.clear(SearchSource::library);
+
+    EXPECT_THAT(keys(""), ElementsAre("3"));
+
+    search.insert(SearchSource::library, "/p/new.fuse", "New", std::nullopt);
+    EXPECT_THAT(search.size(), Eq(2));
+}
+
+TEST_F(PresetSearchTest, sourcesHaveSeparateKeys)
+{
+    search.insert(SearchSource::library, "3", "Library Three", std::nullopt);
+
+    const auto results = search.search("three");
+    ASSERT_THAT(results.size(), Eq(1));
+    EXPECT_THAT(results[0].source, Eq(SearchSource::library));
+    EXPECT_THAT(search.size(), Eq(5));
+}
+
+TEST_F(PresetSearchTest, attributesOfSignalChainOrdersEffectsBySlot)
+{
+    const amp_settings amp{amps::BRITISH_70S, 10, 20, 30, 40, 50, cabinets::cab65TWN, 0, 0, 0, 0, 0, 0, 0, 0, false, 0};
+    const std::array<fx_pedal_settings, 4> effects{{{3, effects::ARENA_REVERB, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {0, effects::OVERDRIVE, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {2, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {1, effects::PHASER, 0, 0, 0, 0, 0, 0, Position::input}}};
+    const auto result = attributesOf(SignalChain{"x", amp, effects});
+
+    EXPECT_THAT(result.amp, Eq(amps::BRITISH_70S));
+    EXPECT_THAT(result.cabinet, Eq(cabinets::cab65TWN));
+    EXPECT_THAT(result.effectModels, ElementsAre(effects::OVERDRIVE, effects::PHASER, effects::EMPTY, effects::ARENA_REVERB));
+    EXPECT_THAT(result.gain, Eq(10));
+    EXPECT_THAT(result.bass, Eq(50));
+}
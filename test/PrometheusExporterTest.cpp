@@ -0,0 +1,148 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics/PrometheusExporter.h"
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <gmock/gmock.h>
+
+using namespace plug::metrics;
+using namespace testing;
+
+
+class PrometheusExporterTest : public testing::Test
+{
+protected:
+    std::string request(std::uint16_t port, const std::string& path)
+    {
+        const int client = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if (::connect(client, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            ::close(client);
+            return "";
+        }
+
+        const std::string data = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        ::send(client, data.data(), data.size(), 0);
+
+        std::string response;
+        std::array<char, 512> buffer{{}};
+
+        for (auto n = ::recv(client, buffer.data(), buffer.size(), 0); n > 0; n = ::recv(client, buffer.data(), buffer.size(), 0))
+        {
+            response.append(buffer.data(), static_cast<std::size_t>(n));
+        }
+        ::close(client);
+        return response;
+    }
+
+    Registry registry;
+};
+
+TEST_F(PrometheusExporterTest, formatCounterAndGauge)
+{
+    registry.counter("plug_packets_total", "Packets", {{"direction", "out"}, {"dsp", "amp"}}).add(3);
+    registry.gauge("plug_amp_connected", "Connected").set(1);
+
+    EXPECT_THAT(formatPrometheus(registry.collect()), StrEq("# HELP plug_amp_connected Connected\n"
+                                                           "# TYPE plug_amp_connected gauge\n"
+                                                           "plug_amp_connected 1\n"
+                                                           "# HELP plug_packets_total Packets\n"
+                                                           "# TYPE plug_packets_total counter\n"
+                                                           "plug_packets_total{direction=\"out\",dsp=\"amp\"} 3\n"));
+}
+
+TEST_F(PrometheusExporterTest, formatHistogramCumulative)
+{
+    auto& histogram = registry.histogram("latency_seconds", "Latency", {{"op", "load"}}, {0.5, 1.0});
+    histogram.observe(0.25);
+    histogram.observe(0.75);
+    histogram.observe(2.0);
+
+    EXPECT_THAT(formatPrometheus(registry.collect()), StrEq("# HELP latency_seconds Latency\n"
+                                                           "# TYPE latency_seconds histogram\n"
+                                                           "latency_seconds_bucket{op=\"load\",le=\"0.5\"} 1\n"
+                                                           "latency_seconds_bucket{op=\"load\",le=\"1\"} 2\n"
+                                                           "latency_seconds_bucket{op=\"load\",le=\"+Inf\"} 3\n"
+                                                           "latency_seconds_sum{op=\"load\"} 3\n"
+                                                           "latency_seconds_count{op=\"load\"} 3\n"));
+}
+
+TEST_F(PrometheusExporterTest, formatEscapesLabelValues)
+{
+    registry.counter("errors_total", "Errors", {{"code", "a\"b\\c\nd"}}).add();
+
+    EXPECT_THAT(formatPrometheus(registry.collect()), HasSubstr("errors_total{code=\"a\\\"b\\\\c\\nd\"} 1\n"));
+}
+
+TEST_F(PrometheusExporterTest, writeFile)
+{
+    const auto path = (std::filesystem::temp_directory_path() / "plug-metrics-test.prom").string();
+    registry.counter("written_total", "Written").add(2);
+
+    writePrometheusFile(registry, path);
+    std::ifstream in{path};
+    const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    std::filesystem::remove(path);
+
+    EXPECT_THAT(content, StrEq(formatPrometheus(registry.collect())));
+}
+
+TEST_F(PrometheusExporterTest, serverServesMetrics)
+{
+    registry.counter("served_total", "Served").add(5);
+    PrometheusServer server{registry, 0};
+    server.start();
+
+    const auto response = request(server.port(), "/metrics");
+
+    EXPECT_THAT(response, StartsWith("HTTP/1.1 200 OK\r\n"));
+    EXPECT_THAT(response, HasSubstr("Content-Type: text/plain; version=0.0.4\r\n"));
+    EXPECT_THAT(response, EndsWith("served_total 5\n"));
+}
+
+TEST_F(PrometheusExporterTest, serverRejectsUnknownPath)
+{
+    PrometheusServer server{registry, 0};
+    server.start();
+
+    EXPECT_THAT(request(server.port(), "/other"), StartsWith("HTTP/1.1 404 Not Found\r\n"));
+}
+
+TEST_F(PrometheusExporterTest, serverStop)
+{
+    PrometheusServer server{registry, 0};
+    server.start();
+    EXPECT_THAT(server.isRunning(), IsTrue());
+
+    server.stop();
+    EXPECT_THAT(server.isRunning(), IsFalse());
+}
@@ -0,0 +1,125 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/SimulatedAmp.h"
+#include "com/AmpReader.h"
+#include "com/CommunicationException.h"
+#include "com/Mustang.h"
+#include "com/PacketSerializer.h"
+#include "matcher/TypeMatcher.h"
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace test::matcher;
+using namespace testing;
+using namespace std::chrono_literals;
+
+
+class SimulatedAmpTest : public testing::Test
+{
+protected:
+    const std::vector<SignalChain> presets{simulatedPresets(24)};
+    std::shared_ptr<SimulatedAmp> amp{std::make_shared<SimulatedAmp>(presets, 5ms)};
+};
+
+TEST_F(SimulatedAmpTest, startAmpReturnsNamesAndCurrentPreset)
+{
+    Mustang m{amp};
+    const auto [chain, names] = m.start_amp();
+
+    EXPECT_THAT(names.size(), Eq(24));
+    EXPECT_THAT(names[0], StrEq("Simulated 1"));
+    EXPECT_THAT(names[23], StrEq("Simulated 24"));
+    EXPECT_THAT(chain.name(), StrEq("Simulated 1"));
+    EXPECT_THAT(chain.amp(), AmpIs(presets[0].amp()));
+}
+
+TEST_F(SimulatedAmpTest, startAmpWithBigAmpPresets)
+{
+    Mustang m{std::make_shared<SimulatedAmp>(simulatedPresets(100), 5ms)};
+    const auto names = std::get<1>(m.start_amp());
+
+    EXPECT_THAT(names.size(), Eq(100));
+    EXPECT_THAT(names[99], StrEq("Simulated 100"));
+}
+
+TEST_F(SimulatedAmpTest, loadMemoryBankSelectsPreset)
+{
+    Mustang m{amp};
+    m.start_amp();
+
+    const auto chain = m.load_memory_bank(5);
+    EXPECT_THAT(chain.name(), StrEq("Simulated 6"));
+    EXPECT_THAT(chain.amp(), AmpIs(presets[5].amp()));
+
+    EXPECT_THAT(std::get<0>(m.start_amp()).name(), StrEq("Simulated 6"));
+}
+
+TEST_F(SimulatedAmpTest, backupPresetsReadsAllSlots)
+{
+    Mustang m{amp};
+    m.start_amp();
+
+    const auto backup = m.backup_presets(presets.size());
+    ASSERT_THAT(backup.size(), Eq(presets.size()));
+    EXPECT_THAT(decode_data(backup[0]).name(), StrEq("Simulated 1"));
+    EXPECT_THAT(decode_data(backup[23]).name(), StrEq("Simulated 24"));
+    EXPECT_THAT(decode_data(backup[17]).amp(), AmpIs(presets[17].amp()));
+}
+
+TEST_F(SimulatedAmpTest, commandsAreAcknowledged)
+{
+    Mustang m{amp};
+    m.start_amp();
+    m.set_amplifier(presets[3].amp());
+    m.set_effect(presets[3].effects()[0]);
+
+    EXPECT_THAT(amp->receive(packetRawTypeSize), IsEmpty());
+}
+
+TEST_F(SimulatedAmpTest, worksBehindAmpReader)
+{
+    auto reader = std::make_shared<AmpReader>(amp, 50ms);
+    Mustang m{reader};
+    m.start_amp();
+    reader->start();
+
+    EXPECT_THAT(m.load_memory_bank(2).name(), StrEq("Simulated 3"));
+    reader->stop();
+}
+
+TEST_F(SimulatedAmpTest, receiveTimesOutWhenIdle)
+{
+    EXPECT_THAT(amp->receive(packetRawTypeSize), IsEmpty());
+}
+
+TEST_F(SimulatedAmpTest, closedAmpThrows)
+{
+    amp->close();
+
+    EXPECT_THAT(amp->isOpen(), IsFalse());
+    EXPECT_THROW(amp->send(serializeApplyCommand().getBytes()), CommunicationException);
+}
+
+TEST_F(SimulatedAmpTest, rejectsUnsupportedPresetCount)
+{
+    EXPECT_THROW(SimulatedAmp(simulatedPresets(3), 5ms), std::invalid_argument);
+}
@@ -0,0 +1,106 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics/StartupProfile.h"
+#include <sstream>
+#include <gmock/gmock.h>
+
+using namespace plug::metrics;
+using namespace testing;
+using namespace std::chrono_literals;
+
+
+class StartupProfileTest : public testing::Test
+{
+protected:
+    std::string report() const
+    {
+        std::ostringstream out;
+        writeStartupReport(out, profile.phases());
+        return out.str();
+    }
+
+    StartupProfile profile;
+    const StartupProfile::Clock::time_point epoch{StartupProfile::Clock::now()};
+};
+
+TEST_F(StartupProfileTest, nothingRecordedUntilEnabled)
+{
+    profile.record("phase", epoch, epoch + 1ms);
+    {
+        const StartupScope scope{"scope", profile};
+    }
+
+    EXPECT_THAT(profile.isEnabled(), IsFalse());
+    EXPECT_THAT(profile.phases(), IsEmpty());
+}
+
+TEST_F(StartupProfileTest, phasesAreRelativeToEpoch)
+{
+    profile.enable(epoch);
+    profile.record("first", epoch + 2ms, epoch + 5ms);
+    profile.record("second", epoch + 1ms, epoch + 8ms);
+
+    const auto phases = profile.phases();
+    ASSERT_THAT(phases.size(), Eq(2));
+    EXPECT_THAT(phases[0].name, StrEq("first"));
+    EXPECT_THAT(phases[0].start, Eq(2ms));
+    EXPECT_THAT(phases[0].duration, Eq(3ms));
+    EXPECT_THAT(phases[1].name, StrEq("second"));
+    EXPECT_THAT(phases[1].duration, Eq(7ms));
+}
+
+TEST_F(StartupProfileTest, scopeRecordsPhase)
+{
+    profile.enable(epoch);
+    {
+        const StartupScope scope{"scope", profile};
+    }
+
+    ASSERT_THAT(profile.phases().size(), Eq(1));
+    EXPECT_THAT(profile.phases()[0].name, StrEq("scope"));
+    EXPECT_THAT(profile.phases()[0].start, Ge(0ns));
+}
+
+TEST_F(StartupProfileTest, enableResetsPhases)
+{
+    profile.enable(epoch);
+    profile.record("phase", epoch, epoch);
+    profile.enable(epoch);
+
+    EXPECT_THAT(profile.phases(), IsEmpty());
+}
+
+TEST_F(StartupProfileTest, reportListsPhasesInMilliseconds)
+{
+    profile.enable(epoch);
+    profile.record("qapplication", epoch, epoch + 12345us);
+    profile.record("load_data", epoch + 20ms, epoch + 20ms + 7us);
+
+    EXPECT_THAT(report(), StrEq("{\"phases\":[\n"
+                                "{\"name\":\"qapplication\",\"start_ms\":0.000,\"duration_ms\":12.345},\n"
+                                "{\"name\":\"load_data\",\"start_ms\":20.000,\"duration_ms\":0.007}\n"
+                                "],\"total_ms\":20.007}\n"));
+}
+
+TEST_F(StartupProfileTest, emptyReport)
+{
+    EXPECT_THAT(report(), StrEq("{\"phases\":[\n],\"total_ms\":0.000}\n"));
+}
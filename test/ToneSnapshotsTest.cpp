@@ -0,0 +1,192 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "com/ToneSnapshots.h"
+#include "com/PacketSerializer.h"
+#include "mocks/MockConnection.h"
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug;
+using namespace plug::com;
+using namespace testing;
+
+
+class ToneSnapshotsTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        conn = std::make_shared<mock::MockConnection>();
+        m = std::make_unique<com::Mustang>(conn);
+
+        ON_CALL(*conn, sendImpl(_, _)).WillByDefault([this](std::uint8_t* data, std::size_t size) {
+            PacketRawType packet{};
+            std::copy(data, data + size, packet.begin());
+            sent.push_back(packet);
+            return size;
+        });
+        ON_CALL(*conn, receive(_)).WillByDefault([this](std::size_t size) {
+            received.push_back(sent.size());
+            return std::vector<std::uint8_t>(size);
+        });
+        EXPECT_CALL(*conn, sendImpl(_, _)).Times(AnyNumber());
+        EXPECT_CALL(*conn, receive(_)).Times(AnyNumber());
+    }
+
+    static SignalChain withGain(const SignalChain& chain, std::uint8_t gain)
+    {
+        auto amp = chain.amp();
+        amp.gain = gain;
+        return SignalChain{chain.name(), amp, chain.effects()};
+    }
+
+    std::shared_ptr<mock::MockConnection> conn;
+    std::unique_ptr<com::Mustang> m;
+    std::vector<PacketRawType> sent;
+    std::vector<std::size_t> received;
+    const PacketRawType applyCmd = serializeApplyCommand().getBytes();
+
+    const amp_settings amp{amps::BRITISH_80S, 10, 20, 30, 40, 50, cabinets::cab4x12M, 1, 2, 3, 4, 5, 6, 7, 1, false, 9};
+    const std::array<fx_pedal_settings, 4> effects{{{0, effects::OVERDRIVE, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {1, effects::SINE_CHORUS, 1, 2, 3, 4, 5, 6, Position::input},
+                                                    {2, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input},
+                                                    {3, effects::ARENA_REVERB, 1, 2, 3, 4, 5, 6, Position::effectsLoop}}};
+    const SignalChain chain{"abc", amp, effects};
+};
+
+TEST_F(ToneSnapshotsTest, firstRecallSendsAllBlocks)
+{
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+
+    EXPECT_THAT(snapshots.recall(*m, 0), Eq(6));
+    EXPECT_THAT(sent, SizeIs(7));
+    EXPECT_THAT(sent.front(), ContainerEq(encode_settings(chain)[0]));
+    EXPECT_THAT(sent.back(), ContainerEq(applyCmd));
+    EXPECT_THAT(snapshots.active(), Optional(0));
+}
+
+TEST_F(ToneSnapshotsTest, recallSendsOnlyDifferingBlocks)
+{
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+    snapshots.store(1, withGain(chain, 99));
+    snapshots.recall(*m, 0);
+    sent.clear();
+
+    EXPECT_THAT(snapshots.recall(*m, 1), Eq(1));
+    EXPECT_THAT(sent, ElementsAre(ContainerEq(serializeAmpSettings(withGain(chain, 99).amp()).getBytes()), ContainerEq(applyCmd)));
+    EXPECT_THAT(snapshots.active(), Optional(1));
+}
+
+TEST_F(ToneSnapshotsTest, recallSendsEverythingBeforeReadingAcks)
+{
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+    snapshots.recall(*m, 0);
+
+    EXPECT_THAT(received, Each(Eq(7)));
+    EXPECT_THAT(received, SizeIs(7));
+}
+
+TEST_F(ToneSnapshotsTest, recallOfIdenticalSettingsSendsNothing)
+{
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+    snapshots.store(1, SignalChain{"other name", amp, effects});
+    snapshots.recall(*m, 0);
+    sent.clear();
+
+    EXPECT_THAT(snapshots.recall(*m, 1), Eq(0));
+    EXPECT_THAT(sent, IsEmpty());
+}
+
+TEST_F(ToneSnapshotsTest, clearedEffectIsSentToItsFamily)
+{
+    auto cleared = effects;
+    cleared[0] = fx_pedal_settings{0, effects::EMPTY, 0, 0, 0, 0, 0, 0, Position::input};
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+    snapshots.store(1, SignalChain{"abc", amp, cleared});
+    snapshots.recall(*m, 0);
+    sent.clear();
+
+    EXPECT_THAT(snapshots.recall(*m, 1), Eq(1));
+    EXPECT_THAT(sent[0][2], Eq(0x06));
+}
+
+TEST_F(ToneSnapshotsTest, invalidateForcesFullRecall)
+{
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+    snapshots.recall(*m, 0);
+    snapshots.invalidate();
+
+    EXPECT_THAT(snapshots.active(), Eq(std::nullopt));
+    EXPECT_THAT(snapshots.recall(*m, 0), Eq(6));
+}
+
+TEST_F(ToneSnapshotsTest, storeOverActiveSnapshotDeactivatesIt)
+{
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+    snapshots.recall(*m, 0);
+    snapshots.store(0, withGain(chain, 1));
+
+    EXPECT_THAT(snapshots.active(), Eq(std::nullopt));
+    EXPECT_THAT(snapshots.delta(0), SizeIs(1));
+}
+
+TEST_F(ToneSnapshotsTest, failedRecallInvalidatesState)
+{
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+    snapshots.store(1, withGain(chain, 1));
+    snapshots.recall(*m, 0);
+    EXPECT_CALL(*conn, receive(_)).WillOnce(Throw(std::runtime_error{"failed"}));
+
+    EXPECT_THROW(snapshots.recall(*m, 1), std::runtime_error);
+    EXPECT_THAT(snapshots.active(), Eq(std::nullopt));
+    EXPECT_THAT(snapshots.delta(1), SizeIs(6));
+}
+
+TEST_F(ToneSnapshotsTest, accessToMissingSnapshotThrows)
+{
+    ToneSnapshots snapshots;
+
+    EXPECT_FALSE(snapshots.contains(0));
+    EXPECT_FALSE(snapshots.contains(ToneSnapshots::count));
+    EXPECT_THROW(snapshots.chain(0), std::out_of_range);
+    EXPECT_THROW(snapshots.recall(*m, 1), std::out_of_range);
+    EXPECT_THROW(snapshots.store(ToneSnapshots::count, chain), std::out_of_range);
+}
+
+TEST_F(ToneSnapshotsTest, selectReturnsDeltaWithoutSending)
+{
+    ToneSnapshots snapshots;
+    snapshots.store(0, chain);
+    snapshots.store(1, withGain(chain, 99));
+
+    EXPECT_THAT(snapshots.select(0), SizeIs(6));
+    EXPECT_THAT(snapshots.select(1), SizeIs(1));
+    EXPECT_THAT(snapshots.active(), Optional(1));
+    EXPECT_THAT(sent, IsEmpty());
+}
@@ -0,0 +1,113 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics/Trace.h"
+#include <sstream>
+#include <thread>
+#include <gmock/gmock.h>
+
+using namespace plug::metrics;
+using namespace testing;
+
+
+class TraceTest : public testing::Test
+{
+protected:
+    std::string trace() const
+    {
+        std::ostringstream out;
+        writeChromeTrace(out);
+        return out.str();
+    }
+
+    std::string eventOf(const std::string& name) const
+    {
+        const auto data = trace();
+        const auto pos = data.find("\"name\":\"" + name + "\"");
+
+        if (pos == std::string::npos)
+        {
+            return "";
+        }
+        const auto begin = data.rfind('{', pos);
+        return data.substr(begin, data.find('}', pos) - begin + 1);
+    }
+};
+
+TEST_F(TraceTest, spanIsRecorded)
+{
+    {
+        PLUG_TRACE_SPAN("test", "TraceTest::spanIsRecorded");
+    }
+
+    EXPECT_THAT(eventOf("TraceTest::spanIsRecorded"),
+                MatchesRegex(R"(\{"ph":"X","pid":1,"tid":[0-9]+,"cat":"test","name":"TraceTest::spanIsRecorded","ts":[0-9]+\.[0-9]{3},"dur":[0-9]+\.[0-9]{3}\})"));
+}
+
+TEST_F(TraceTest, nestedSpansAreContained)
+{
+    {
+        PLUG_TRACE_SPAN("test", "TraceTest::outer");
+        PLUG_TRACE_SPAN("test", "TraceTest::inner");
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    auto value = [](const std::string& event, const std::string& key) {
+        const auto pos = event.find("\"" + key + "\":") + key.size() + 3;
+        return std::stod(event.substr(pos));
+    };
+    const auto outer = eventOf("TraceTest::outer");
+    const auto inner = eventOf("TraceTest::inner");
+
+    EXPECT_THAT(value(inner, "dur"), Ge(1000.0));
+    EXPECT_THAT(value(outer, "ts"), Le(value(inner, "ts")));
+    EXPECT_THAT(value(outer, "ts") + value(outer, "dur"), Ge(value(inner, "ts") + value(inner, "dur")));
+}
+
+TEST_F(TraceTest, threadsHaveOwnIds)
+{
+    {
+        PLUG_TRACE_SPAN("test", "TraceTest::mainThread");
+    }
+    std::thread other{[] { PLUG_TRACE_SPAN("test", "TraceTest::otherThread"); }};
+    other.join();
+
+    auto tid = [](const std::string& event) { return event.substr(event.find("\"tid\":"), event.find(",\"cat\"") - event.find("\"tid\":")); };
+
+    EXPECT_THAT(tid(eventOf("TraceTest::mainThread")), Ne(tid(eventOf("TraceTest::otherThread"))));
+}
+
+TEST_F(TraceTest, namesAreEscaped)
+{
+    {
+        PLUG_TRACE_SPAN("test", "TraceTest::\"quoted\"");
+    }
+
+    EXPECT_THAT(trace(), HasSubstr("\"name\":\"TraceTest::\\\"quoted\\\"\""));
+}
+
+TEST_F(TraceTest, traceIsValidDocument)
+{
+    const auto data = trace();
+
+    EXPECT_THAT(data, StartsWith("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    EXPECT_THAT(data, EndsWith("]}\n"));
+    EXPECT_THAT(droppedTraceEvents(), Eq(0));
+}
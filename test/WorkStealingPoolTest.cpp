@@ -0,0 +1,112 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/WorkStealingPool.h"
+#include <atomic>
+#include <stdexcept>
+#include <gmock/gmock.h>
+
+using namespace plug::preset;
+using namespace testing;
+
+
+class WorkStealingPoolTest : public testing::Test
+{
+};
+
+TEST_F(WorkStealingPoolTest, runsAllTasks)
+{
+    WorkStealingPool pool{4};
+    std::atomic<int> sum{0};
+
+    for (int i = 1; i <= 1000; ++i)
+    {
+        pool.submit([&sum, i] { sum += i; });
+    }
+    pool.wait();
+
+    EXPECT_THAT(pool.size(), Eq(4));
+    EXPECT_THAT(sum.load(), Eq(500500));
+}
+
+TEST_F(WorkStealingPoolTest, tasksCanSubmitTasks)
+{
+    WorkStealingPool pool{3};
+    std::atomic<int> count{0};
+
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.submit([&pool, &count] {
+            for (int j = 0; j < 10; ++j)
+            {
+                pool.submit([&count] { ++count; });
+            }
+        });
+    }
+    pool.wait();
+
+    EXPECT_THAT(count.load(), Eq(100));
+}
+
+TEST_F(WorkStealingPoolTest, idleWorkersStealTasks)
+{
+    WorkStealingPool pool{2};
+    std::atomic<bool> release{false};
+    std::atomic<int> done{0};
+
+    // The first task blocks its worker until the other one ran the remaining tasks
+    pool.submit([&pool, &release, &done] {
+        for (int i = 0; i < 10; ++i)
+        {
+            pool.submit([&done] { ++done; });
+        }
+        while (done < 10)
+        {
+            std::this_thread::yield();
+        }
+        release = true;
+    });
+    pool.wait();
+
+    EXPECT_THAT(release.load(), IsTrue());
+}
+
+TEST_F(WorkStealingPoolTest, waitRethrowsTaskException)
+{
+    WorkStealingPool pool{2};
+    std::atomic<int> count{0};
+
+    pool.submit([] { throw std::runtime_error{"failed"}; });
+    pool.submit([&count] { ++count; });
+
+    EXPECT_THROW(pool.wait(), std::runtime_error);
+    EXPECT_THAT(count.load(), Eq(1));
+
+    pool.submit([&count] { ++count; });
+    EXPECT_NO_THROW(pool.wait());
+}
+
+TEST_F(WorkStealingPoolTest, waitWithoutTasks)
+{
+    WorkStealingPool pool;
+
+    EXPECT_NO_THROW(pool.wait());
+    EXPECT_THAT(pool.size(), Ge(1));
+}
@@ -0,0 +1,117 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/FuseCodec.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<plug::SignalChain> generateCorpus(std::size_t count)
+    {
+        using namespace plug;
+
+        std::mt19937 rng{1};
+        std::uniform_int_distribution<int> byte{0, 255};
+        auto next = [&rng, &byte] { return static_cast<std::uint8_t>(byte(rng)); };
+        std::vector<SignalChain> corpus;
+        corpus.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const amp_settings amp{static_cast<amps>(next() % 12), next(), next(), next(), next(), next(), static_cast<cabinets>(next() % 13),
+                                   next(), next(), next(), next(), next(), next(), next(), next(), (next() % 2) == 0, next()};
+            std::array<fx_pedal_settings, 4> effects{};
+
+            for (std::size_t slot = 0; slot < effects.size(); ++slot)
+            {
+                effects[slot] = fx_pedal_settings{static_cast<std::uint8_t>(slot), static_cast<plug::effects>(next() % 38),
+                                                  next(), next(), next(), next(), next(), next(), Position::input};
+            }
+            corpus.emplace_back("Generated preset " + std::to_string(i), amp, effects);
+        }
+        return corpus;
+    }
+
+    void report(const std::string& name, std::size_t count, std::size_t bytes, Clock::duration elapsed)
+    {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << name << ": " << count << " presets in " << seconds * 1000.0 << " ms, "
+                  << static_cast<double>(count) / seconds << " presets/s, "
+                  << static_cast<double>(bytes) / seconds / (1024.0 * 1024.0) << " MiB/s\n";
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    namespace fs = std::filesystem;
+
+    const std::size_t count = (argc > 1 ? std::stoul(argv[1]) : 20000);
+    const auto corpus = generateCorpus(count);
+
+    std::vector<std::string> documents;
+    documents.reserve(corpus.size());
+    std::size_t bytes{0};
+
+    auto start = Clock::now();
+
+    for (const auto& chain : corpus)
+    {
+        documents.push_back(plug::preset::writeFuse(chain));
+        bytes += documents.back().size();
+    }
+    report("write", count, bytes, Clock::now() - start);
+
+    std::size_t checksum{0};
+    start = Clock::now();
+
+    for (const auto& document : documents)
+    {
+        checksum += plug::preset::parseFuse(document).amp().gain;
+    }
+    report("parse", count, bytes, Clock::now() - start);
+
+    const auto dir = fs::temp_directory_path() / "plug-fuse-benchmark";
+    fs::create_directories(dir);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        plug::preset::saveFuseFile((dir / (std::to_string(i) + ".fuse")).string(), corpus[i]);
+    }
+
+    start = Clock::now();
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        checksum += plug::preset::loadFuseFile((dir / (std::to_string(i) + ".fuse")).string()).amp().volume;
+    }
+    report("load (mmap)", count, bytes, Clock::now() - start);
+
+    fs::remove_all(dir);
+    std::cout << "checksum: " << checksum << "\n";
+    return 0;
+}
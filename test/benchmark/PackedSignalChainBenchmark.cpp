@@ -0,0 +1,157 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PackedSignalChain.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Variations of one preset that only differ in the last knobs, the
+    // worst case for a field by field comparison
+    std::vector<plug::SignalChain> generateCorpus(std::size_t count)
+    {
+        using namespace plug;
+
+        std::mt19937 rng{1};
+        std::uniform_int_distribution<int> byte{0, 255};
+        auto next = [&rng, &byte] { return static_cast<std::uint8_t>(byte(rng)); };
+        const amp_settings amp{amps::BRITISH_80S, next(), next(), next(), next(), next(), cabinets::cab4x12M,
+                               next(), next(), next(), next(), next(), next(), next(), next(), true, next()};
+        std::vector<SignalChain> corpus;
+        corpus.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::array<fx_pedal_settings, 4> effects{};
+
+            for (std::size_t slot = 0; slot < effects.size(); ++slot)
+            {
+                effects[slot] = fx_pedal_settings{static_cast<std::uint8_t>(slot), effects::EMPTY, 1, 2, 3, 4, 5, 6, Position::input};
+            }
+            effects[3].knob5 = static_cast<std::uint8_t>(i % 16);
+            corpus.emplace_back("Generated preset " + std::to_string(i), amp, effects);
+        }
+        return corpus;
+    }
+
+    bool fieldsEqual(const plug::SignalChain& a, const plug::SignalChain& b)
+    {
+        const auto& ampA = a.amp();
+        const auto& ampB = b.amp();
+
+        if ((ampA.amp_num != ampB.amp_num) || (ampA.gain != ampB.gain) || (ampA.volume != ampB.volume)
+            || (ampA.treble != ampB.treble) || (ampA.middle != ampB.middle) || (ampA.bass != ampB.bass) || (ampA.cabinet != ampB.cabinet)
+            || (ampA.noise_gate != ampB.noise_gate) || (ampA.master_vol != ampB.master_vol) || (ampA.gain2 != ampB.gain2)
+            || (ampA.presence != ampB.presence) || (ampA.threshold != ampB.threshold) || (ampA.depth != ampB.depth)
+            || (ampA.bias != ampB.bias) || (ampA.sag != ampB.sag) || (ampA.brightness != ampB.brightness) || (ampA.usb_gain != ampB.usb_gain))
+        {
+            return false;
+        }
+
+        const auto& fxA = a.effects();
+        const auto& fxB = b.effects();
+
+        for (std::size_t i = 0; i < fxA.size(); ++i)
+        {
+            if ((fxA[i].fx_slot != fxB[i].fx_slot) || (fxA[i].effect_num != fxB[i].effect_num) || (fxA[i].knob1 != fxB[i].knob1)
+                || (fxA[i].knob2 != fxB[i].knob2) || (fxA[i].knob3 != fxB[i].knob3) || (fxA[i].knob4 != fxB[i].knob4)
+                || (fxA[i].knob5 != fxB[i].knob5) || (fxA[i].knob6 != fxB[i].knob6) || (fxA[i].position != fxB[i].position)
+                || (fxA[i].enabled != fxB[i].enabled))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <class Function>
+    void measure(const std::string& name, std::size_t comparisons, Function f)
+    {
+        const auto start = Clock::now();
+        const auto result = f();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << name << ": " << static_cast<double>(comparisons) / seconds / 1e6 << " M/s (" << result << ")\n";
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const std::size_t count = (argc > 1 ? std::stoul(argv[1]) : 2000);
+    const auto corpus = generateCorpus(count);
+    std::vector<plug::PackedSignalChain> packed;
+    packed.reserve(corpus.size());
+    std::transform(corpus.cbegin(), corpus.cend(), std::back_inserter(packed), [](const auto& c) { return plug::pack(c); });
+
+    const std::size_t comparisons = count * count;
+
+    measure("SignalChain settings compare", comparisons, [&corpus] {
+        std::size_t equal{0};
+        for (const auto& a : corpus)
+        {
+            for (const auto& b : corpus)
+            {
+                equal += fieldsEqual(a, b) ? 1 : 0;
+            }
+        }
+        return equal;
+    });
+
+    measure("PackedSignalChain settings compare", comparisons, [&packed] {
+        std::size_t equal{0};
+        for (const auto& a : packed)
+        {
+            for (const auto& b : packed)
+            {
+                equal += settingsEqual(a, b) ? 1 : 0;
+            }
+        }
+        return equal;
+    });
+
+    measure("PackedSignalChain diff", comparisons, [&packed] {
+        std::uint64_t bits{0};
+        for (const auto& a : packed)
+        {
+            for (const auto& b : packed)
+            {
+                bits ^= diffMask(a, b);
+            }
+        }
+        return bits;
+    });
+
+    measure("PackedSignalChain hash", count, [&packed] {
+        std::uint64_t hash{0};
+        for (const auto& p : packed)
+        {
+            hash ^= contentHash(p);
+        }
+        return hash;
+    });
+    return 0;
+}
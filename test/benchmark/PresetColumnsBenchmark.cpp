@@ -0,0 +1,123 @@
+/*
+ * PLUG - software to operate Fender Mustang amplifier
+ *        Linux replacement for Fender FUSE software
+ *
+ * Copyright (C) 2017-2022  offa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "preset/PresetColumns.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<plug::SignalChain> generateCorpus(std::size_t count)
+    {
+        using namespace plug;
+
+        std::mt19937 rng{1};
+        std::uniform_int_distribution<int> byte{0, 255};
+        auto next = [&rng, &byte] { return static_cast<std::uint8_t>(byte(rng)); };
+        std::vector<SignalChain> corpus;
+        corpus.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const amp_settings amp{static_cast<amps>(next() % 12), next(), next(), next(), next(), next(), static_cast<cabinets>(next() % 13),
+                                   next(), next(), next(), next(), next(), next(), next(), static_cast<std::uint8_t>(next() % 3), (next() % 2) == 0, next()};
+            std::array<fx_pedal_settings, 4> effects{};
+
+            for (std::size_t slot = 0; slot < effects.size(); ++slot)
+            {
+                effects[slot] = fx_pedal_settings{static_cast<std::uint8_t>(slot), static_cast<plug::effects>(next() % 38),
+                                                  next(), next(), next(), next(), next(), next(), Position::input};
+            }
+            corpus.emplace_back("Generated preset " + std::to_string(i), amp, effects);
+        }
+        return corpus;
+    }
+
+    void report(const std::string& name, std::size_t rows, std::size_t matches, Clock::duration elapsed)
+    {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::cout << name << ": " << matches << " of " << rows << " rows in " << seconds * 1000.0 << " ms, "
+                  << static_cast<double>(rows) / seconds / 1e6 << " M rows/s\n";
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    using namespace plug;
+    using namespace plug::preset;
+
+    const std::size_t count = (argc > 1 ? std::stoul(argv[1]) : 50000);
+    const std::size_t repeat{20};
+    const auto corpus = generateCorpus(count);
+
+    PresetColumns columns;
+    columns.reserve(corpus.size());
+
+    for (const auto& chain : corpus)
+    {
+        columns.append(chain);
+    }
+
+    // gain > 200 and sag == 2
+    std::size_t matches{0};
+    auto start = Clock::now();
+
+    for (std::size_t n = 0; n < repeat; ++n)
+    {
+        matches = 0;
+
+        for (const auto& chain : corpus)
+        {
+            const auto amp = chain.amp();
+            matches += ((amp.gain > 200) && (amp.sag == 2) ? 1 : 0);
+        }
+    }
+    report("row scan", count * repeat, matches * repeat, Clock::now() - start);
+
+    start = Clock::now();
+
+    for (std::size_t n = 0; n < repeat; ++n)
+    {
+        auto rows = columns.select(column::amp(offsetof(PackedAmp, gain)), Compare::greater, 200);
+        intersect(rows, columns.select(column::amp(offsetof(PackedAmp, sag)), Compare::equal, 2));
+        matches = preset::count(rows);
+    }
+    report("columns", count * repeat, matches * repeat, Clock::now() - start);
+
+    start = Clock::now();
+    std::size_t checksum{0};
+
+    for (std::size_t n = 0; n < repeat; ++n)
+    {
+        for (std::uint8_t model = 0; model < 12; ++model)
+        {
+            checksum += columns.median(column::effect(3, offsetof(PackedEffect, knob1)), columns.select(column::amp(offsetof(PackedAmp, amp_num)), Compare::equal, model)).value_or(0);
+        }
+    }
+    report("median per amp", count * repeat * 12, count * repeat, Clock::now() - start);
+    std::cout << "checksum: " << checksum << "\n";
+    return 0;
+}